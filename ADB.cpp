@@ -12,72 +12,158 @@
  */
 
 #include "ADB.h"
+#include "ADBDeviceCache.h"
+#include "ADBSampleDecoder.h"
+#include "ADBSniffer.h"
+#include "ADBTrace.h"
+#include "ADBWaveform.h"
 
 /**
  * Implémentation de la classe ADB - Gestion du bus Apple Desktop Bus
  */
 
-ADB::ADB(uint8_t dataPin) : dataPin(dataPin), useADBDevices(false) {}
+ADB::ADB(uint8_t dataPin)
+    : dataPin(dataPin), useADBDevices(false), responseStarted(true), commandAborted(false),
+      status(ADBProtocol::Status::OK), fault(ADBProtocol::LineFault::NONE), stats{},
+      currentAddress(0), busyWindowStart(0), busyWindowUs(0), totalBusyUsPerSecond(0), srqCount(0),
+      capture(nullptr), sniffer(nullptr), sampler(nullptr), transmitter(nullptr), profiles{},
+      adaptiveTiming(true), responseEdgeUs(0), responseEdgeLate(false), glitch{}, emitTiming(ADBHostTiming::DEFAULT),
+      irqPolicy{ADBProtocol::IrqMask::NONE, ADBProtocol::IRQ_MASK_MAX}, irqMasked(false), irqMaskedSince(0),
+      irqMaxMaskedUs(0) {}
 
-void ADB::init(uint8_t dataPin, bool useADBDevices) {
+bool ADB::init(uint8_t dataPin, bool useADBDevices) {
     // Mise à jour de la broche si spécifiée
     if (dataPin != 0xFF) {
         this->dataPin = dataPin;
     }
     this->useADBDevices = useADBDevices;
+    ADBClock::begin();
 
     // Configuration de la broche en mode open-drain
     pinMode(this->dataPin, OUTPUT_OPEN_DRAIN);
     digitalWrite(this->dataPin, HIGH);
 
-    // Attente que la ligne soit prête
-    while (digitalRead(this->dataPin) == LOW) {
-        // Attendre que la ligne remonte
+    // Attente bornée que la ligne soit prête
+    if (!waitLineHigh(ADBProtocol::LINE_RELEASE_TIMEOUT)) {
+        fault = ADBProtocol::LineFault::STUCK_LOW;
+        return false;
     }
 
     // Réinitialisation du bus
-    reset();
+    return reset();
 }
 
-void ADB::reset() {
+bool ADB::reset() {
+    if (sniffer) return false;
+    
     // Signal de réinitialisation: maintenir la ligne basse pendant 3ms
     digitalWrite(dataPin, LOW);
-    delayMicroseconds(3000);
+    delayMicroseconds(emitTiming.resetUs);
+    bool pulledLow = (digitalRead(dataPin) == LOW);
     digitalWrite(dataPin, HIGH);
+    
+    // La ligne doit avoir suivi l'impulsion puis être remontée
+    if (!pulledLow) {
+        fault = ADBProtocol::LineFault::STUCK_HIGH;
+        return false;
+    }
+    if (!waitLineHigh(ADBProtocol::LINE_RELEASE_TIMEOUT)) {
+        fault = ADBProtocol::LineFault::STUCK_LOW;
+        return false;
+    }
+    fault = ADBProtocol::LineFault::NONE;
+    return true;
+}
+
+bool ADB::waitLineHigh(uint32_t timeout) {
+    auto time_start = micros();
+    while (digitalRead(dataPin) == LOW) {
+        if (micros() - time_start > timeout)
+            return false;
+    }
+    return true;
+}
+
+bool ADB::checkLineIdle() {
+    if (waitLineHigh(ADBProtocol::LINE_IDLE_TIMEOUT)) return true;
+    fault = ADBProtocol::LineFault::STUCK_LOW;
+    return false;
 }
 
-void ADB::wait() {
+bool ADB::waitBusQuiet(uint32_t quietUs, uint32_t timeoutUs) {
+    uint32_t start = micros();
+    uint32_t highSince = start;
+    for (;;) {
+        uint32_t now = micros();
+        if (digitalRead(dataPin) == LOW) highSince = now;
+        else if (now - highSince >= quietUs) return true;
+        if (now - start > timeoutUs) return false;
+    }
+}
+
+void ADB::abortResponse() {
+    busyScope busy(*this);
+    digitalWrite(dataPin, LOW);
+    captureEdge(LOW);
+    delayMicroseconds(ADBProtocol::BIT_CELL_MAX);
+    digitalWrite(dataPin, HIGH);
+    captureEdge(HIGH);
+}
+
+void ADB_HOT ADB::wait() {
     // Signal d'attente: maintenir la ligne basse pendant 800µs
+    // Origine des échéances de la commande: les cellules suivantes s'enchaînent sans dérive
+    ADB_TRACE(ATTENTION, 0);
+    phaseClock.start();
     digitalWrite(dataPin, LOW);
-    delayMicroseconds(800);
+    captureEdge(LOW);
+    phaseClock.wait(emitTiming.attentionUs);
+    
+    // Une ligne restée haute alors qu'elle est tirée vers le bas est en court-circuit
+    if (digitalRead(dataPin) == HIGH) {
+        fault = ADBProtocol::LineFault::STUCK_HIGH;
+    }
     digitalWrite(dataPin, HIGH);
+    captureEdge(HIGH);
 }
 
-void ADB::sync() {
+void ADB_HOT ADB::sync() {
     // Signal de synchronisation pour les commandes
+    ADB_TRACE(SYNC, 0);
     digitalWrite(dataPin, HIGH);
-    delayMicroseconds(70);
+    captureEdge(HIGH);
+    maskInterrupts(emitTiming.syncUs + emitTiming.longPhaseUs);
+    phaseClock.wait(emitTiming.syncUs);
     digitalWrite(dataPin, LOW);
+    captureEdge(LOW);
 }
 
-void ADB::writeBit(uint16_t bit) {
+void ADB_HOT ADB::writeBit(uint16_t bit) {
     // Encodage Manchester modifié:
     // 1 = 35µs bas puis 65µs haut
     // 0 = 65µs bas puis 35µs haut
+    ADB_TRACE(WRITE_BIT, bit ? 1 : 0);
+    // Échéances absolues: l'écriture et la capture d'un front sont prises sur la phase en cours
     if (bit) {
         digitalWrite(dataPin, LOW);
-        delayMicroseconds(35);
+        captureEdge(LOW);
+        phaseClock.wait(emitTiming.shortPhaseUs);
         digitalWrite(dataPin, HIGH);
-        delayMicroseconds(65);
+        captureEdge(HIGH);
+        maskInterrupts(emitTiming.longPhaseUs + emitTiming.longPhaseUs);
+        phaseClock.wait(emitTiming.longPhaseUs);
     } else {
         digitalWrite(dataPin, LOW);
-        delayMicroseconds(65);
+        captureEdge(LOW);
+        phaseClock.wait(emitTiming.longPhaseUs);
         digitalWrite(dataPin, HIGH);
-        delayMicroseconds(35);
+        captureEdge(HIGH);
+        maskInterrupts(emitTiming.shortPhaseUs + emitTiming.longPhaseUs);
+        phaseClock.wait(emitTiming.shortPhaseUs);
     }
 }
 
-void ADB::writeBits(uint16_t bits, uint8_t length) {
+void ADB_HOT ADB::writeBits(uint16_t bits, uint8_t length) {
     // Écrit plusieurs bits, du MSB au LSB
     uint16_t mask = 1 << (length - 1);
     while (mask) {
@@ -86,81 +172,512 @@ void ADB::writeBits(uint16_t bits, uint8_t length) {
     }
 }
 
-void ADB::writeDataPacket(uint16_t bits, uint8_t length) {
+void ADB_HOT ADB::writeDataPacket(uint16_t bits, uint8_t length) {
+    if (commandAborted) return;
+    busyScope busy(*this);
+    
+    if (transmitter) {
+        awaitTransmitter();
+        transmitter->waveform().setTiming(emitTiming);
+        transmitter->waveform().dataPacket(bits, length);
+        commandAborted = !shiftWaveform();
+        return;
+    }
+    
     // Format du paquet: bit de début (1), données, bit de fin (0)
+    irqScope masked(*this);
+    maskInterrupts(emitTiming.shortPhaseUs);
+    phaseClock.start();
     writeBit(1);
     writeBits(bits, length);
     writeBit(0);
 }
 
-bool ADB::waitTLT(bool responseExpected) {
+bool ADB_HOT ADB::waitTLT(bool responseExpected) {
+    busyScope busy(*this);
+    
     // Attend la réponse d'un périphérique après une commande
+    ADB_TRACE(TLT_START, responseExpected);
+    
+    // Aucune réponse possible si la commande n'a pas été émise
+    if (commandAborted) {
+        responseStarted = false;
+        status = ADBProtocol::Status::BUS_FAULT;
+        return false;
+    }
+    awaitTransmitter();
     digitalWrite(dataPin, HIGH);
-    delayMicroseconds(140);
+    
+    // Un SRQ maintient le bit d'arrêt bas jusqu'à 300µs: Tlt court à partir de sa fin
+    uint32_t srqUs = micros();
+    if (digitalRead(dataPin) == LOW && (!glitch.minPulseUs || confirmLevel(LOW, srqUs))) {
+        ADB_TRACE(TLT_SRQ, 0);
+        srqCount++;
+        waitLineHigh(ADBProtocol::SRQ_TIMEOUT);
+        phaseClock.start();
+    }
+    // Sans SRQ, Tlt est compté depuis l'échéance du bit d'arrêt
+    phaseClock.wait(emitTiming.tltUs);
     
     // Si une réponse est attendue, attendre jusqu'à 240µs
+    responseStarted = true;
     if (responseExpected) {
-        uint8_t timeout = 0;
-        while (digitalRead(dataPin) == HIGH && timeout < 240) {
-            delayMicroseconds(1);
-            timeout++;
+        // Lecture unique par itération: un parasite ne peut pas à la fois sortir de l'attente et être démenti
+        uint32_t deadline = phaseClock.deadline() + ADBClock::ticks(240);
+        responseStarted = false;
+        // Par paquet, une routine pendant la scrutation ne retarde pas la date du bit de début, référence des
+        // cellules; par cellule, la scrutation reste ouverte et seule une routine en cours au front la décale
+        if (irqPolicy.mode == ADBProtocol::IrqMask::PER_PACKET) maskInterrupts(240);
+        // Dernière lecture de la ligne: l'échéance de Tlt tant que la scrutation n'a pas commencé
+        uint32_t polled = phaseClock.deadline();
+        while (!ADBClock::reached(deadline)) {
+            if (digitalRead(dataPin) == LOW) {
+                // Début de la première cellule, repris par readDataPacket
+                responseEdgeUs = micros();
+                responseEdgeLate = ADBClock::now() - polled > ADBClock::ticks(ADBProtocol::POLL_GAP_MAX);
+                if (!glitch.minPulseUs || confirmLevel(LOW, responseEdgeUs)) {
+                    // Section masquée ouverte dès le bit de début, refermée par readDataPacket
+                    maskInterrupts(2 * (adaptiveTiming ? phaseLimit(adb_timing_profile{}) : ADBProtocol::BIT_PHASE_MAX));
+                    responseStarted = true;
+                    break;
+                }
+                // Parasite: la fenêtre Tlt se poursuit jusqu'à son échéance
+            }
+            polled = ADBClock::now();
         }
+        if (!responseStarted) releaseInterrupts();
+        if (responseStarted && capture) capture->edge(responseEdgeUs, LOW);
+    } else {
+        responseEdgeUs = micros();
+        responseEdgeLate = false;
     }
-    return true;
+    ADB_TRACE(TLT_END, responseStarted);
+    return responseStarted;
 }
 
-uint8_t ADB::readBit() {
-    // Lecture d'un bit avec détection de timeout
-    const unsigned long MAX_WAIT = 85; // Microseconds
-    
+bool ADB_HOT ADB::readCell(uint32_t& edgeUs, uint32_t maxPhaseUs, uint32_t& lowUs, uint32_t& highUs) {
     // Attente du front montant
-    auto time_start = micros();
-    while (digitalRead(dataPin) == LOW) {
-        if (micros() - time_start > MAX_WAIT)
-            return ADBProtocol::BIT_ERROR;
+    uint32_t now = micros();
+    uint32_t rise = 0;
+    uint32_t rejectedUs = 0;
+    bool seen = false;
+    for (;;) {
+        while (digitalRead(dataPin) == LOW) {
+            now = micros();
+            if (now - edgeUs > maxPhaseUs) {
+                ADB_TRACE(BIT_TIMEOUT, 0);
+                return false;
+            }
+        }
+        // Front refusé par des parasites bas juste après lui: la ligne revenue haute aussitôt garde sa date
+        now = micros();
+        if (!seen || now - rejectedUs > glitch.minPulseUs) rise = now;
+        seen = true;
+        if (!glitch.minPulseUs || confirmLevel(HIGH, rise)) break;
+        rejectedUs = micros();
     }
-    auto low_time = micros() - time_start;
+    lowUs = rise - edgeUs;
+    
+    // Dates déjà mesurées: la capture ne relit ni l'horloge ni la ligne
+    if (capture) capture->edge(rise, HIGH);
 
     // Attente du front descendant
-    time_start = micros();
-    while (digitalRead(dataPin) == HIGH) {
-        if (micros() - time_start > MAX_WAIT)
-            return ADBProtocol::BIT_ERROR;
+    do {
+        while (digitalRead(dataPin) == HIGH) {
+            now = micros();
+            if (now - rise > maxPhaseUs) {
+                ADB_TRACE(BIT_TIMEOUT, 1);
+                return false;
+            }
+        }
+        edgeUs = micros();
+    } while (glitch.minPulseUs && !confirmLevel(LOW, edgeUs));
+    highUs = edgeUs - rise;
+    if (capture) capture->edge(edgeUs, LOW);
+    return true;
+}
+
+bool ADB_HOT ADB::confirmLevel(bool level, uint32_t& edgeUs) {
+    // Lectures réparties sur 2 × minPulseUs: une impulsion plus courte n'en couvre pas la majorité
+    uint8_t votes = glitch.votes;
+    uint8_t needed = votes / 2 + 1;
+    uint8_t agree = 0;
+    uint8_t disagree = 0;
+    uint32_t spanUs = 2u * glitch.minPulseUs;
+    bool released = false;  // Vote haut contre un front descendant: la lecture basse était un parasite
+    uint8_t k = 1;
+    while (agree < needed && disagree <= votes - needed) {
+        uint32_t atUs = k * spanUs / (votes + 1u);
+        bool restarted = false;
+        while (micros() - edgeUs < atUs) {
+            if (released && digitalRead(dataPin) == LOW) {
+                // Lecture basse suivante soumise au vote depuis sa propre date
+                ADB_TRACE(GLITCH, level);
+                stats[currentAddress].glitches++;
+                edgeUs = micros();
+                released = false;
+                agree = 0;
+                disagree = 0;
+                k = 1;
+                restarted = true;
+                break;
+            }
+        }
+        if (restarted) continue;
+        bool high = digitalRead(dataPin) == HIGH;
+        if (high == level) {
+            agree++;
+        } else {
+            disagree++;
+            released = high;
+        }
+        k++;
+    }
+    if (agree >= needed) return true;
+    
+    ADB_TRACE(GLITCH, level);
+    stats[currentAddress].glitches++;
+    return false;
+}
+
+void ADB::setGlitchFilter(const adb_glitch_filter& filter) {
+    using namespace ADBProtocol;
+    glitch.minPulseUs = filter.minPulseUs > GLITCH_PULSE_MAX ? GLITCH_PULSE_MAX : filter.minPulseUs;
+    
+    // Nombre impair: la majorité est toujours définie
+    uint8_t votes = filter.votes ? filter.votes | 0x1 : 1;
+    glitch.votes = votes > GLITCH_VOTES_MAX ? GLITCH_VOTES_MAX : votes;
+    if (sniffer) sniffer->setGlitchFilter(glitch);
+}
+
+bool ADB::setHostTiming(const adb_host_timing& timing) {
+    if (!ADBHostTiming::conforms(timing)) return false;
+    emitTiming = timing;
+    return true;
+}
+
+void ADB::setInterruptPolicy(const adb_irq_policy& policy) {
+    releaseInterrupts();
+    irqPolicy.mode = policy.mode;
+    irqPolicy.maxMaskedUs = policy.maxMaskedUs > ADBProtocol::IRQ_MASK_MAX ? ADBProtocol::IRQ_MASK_MAX : policy.maxMaskedUs;
+}
+
+void ADB_HOT ADB::maskInterrupts(uint32_t nextUs) {
+    using namespace ADBProtocol;
+    if (irqPolicy.mode == IrqMask::NONE) return;
+    if (irqMasked) {
+        // Par paquet, la section se prolonge tant que la section suivante tient dans la durée maximale
+        uint32_t elapsedUs = (ADBClock::now() - irqMaskedSince) / ADBClock::ticksPerUs();
+        if (irqPolicy.mode == IrqMask::PER_PACKET && elapsedUs + nextUs <= irqPolicy.maxMaskedUs) return;
+        releaseInterrupts();
+    }
+    if (nextUs > irqPolicy.maxMaskedUs) return;
+    adbMaskInterrupts();
+    irqMasked = true;
+    irqMaskedSince = ADBClock::now();
+}
+
+void ADB_HOT ADB::releaseInterrupts() {
+    if (!irqMasked) return;
+    uint32_t elapsedUs = (ADBClock::now() - irqMaskedSince) / ADBClock::ticksPerUs();
+    irqMasked = false;
+    adbUnmaskInterrupts();
+    if (elapsedUs > irqMaxMaskedUs) irqMaxMaskedUs = elapsedUs;
+}
+
+void ADB_HOT ADB::calibrate(adb_timing_profile& profile, uint32_t lowUs, uint32_t highUs) {
+    using namespace ADBProtocol;
+    uint32_t cellUs = lowUs + highUs;
+    if (cellUs < BIT_CELL_MIN || cellUs > BIT_CELL_MAX) {
+        profile.rejected++;
+        return;
+    }
+    
+    // Seuil entre la part basse d'un 1 (celle du bit de début) et celle d'un 0, décalée d'autant
+    uint16_t cell16 = static_cast<uint16_t>(cellUs * 16);
+    uint16_t threshold = static_cast<uint16_t>(lowUs * 1000 / cellUs + BIT_DECISION_OFFSET);
+    if (profile.cellUs16 == 0) {
+        profile.cellUs16 = cell16;
+        profile.thresholdPermille = threshold;
+        profile.minMargin = 100;
+    } else {
+        // Moyenne glissante sur quatre réponses: la gigue de scrutation est lissée
+        profile.cellUs16 = static_cast<uint16_t>(profile.cellUs16 + (static_cast<int32_t>(cell16) - profile.cellUs16) / 4);
+        profile.thresholdPermille = static_cast<uint16_t>(
+            profile.thresholdPermille + (static_cast<int32_t>(threshold) - profile.thresholdPermille) / 4);
     }
-    auto high_time = micros() - time_start;
+    profile.calibrations++;
+}
+
+uint32_t ADB_HOT ADB::phaseLimit(const adb_timing_profile& profile) const {
+    using namespace ADBProtocol;
+    constexpr uint32_t NOMINAL_LONG = 500 + BIT_DECISION_OFFSET;   // 65 µs sur 100
+    if (profile.cellUs16 == 0) return BIT_CELL_MAX * (NOMINAL_LONG + BIT_PHASE_SLACK) / 1000;
+    
+    // Plus longue demi-cellule attendue: partie basse d'un 0 ou partie haute d'un 1
+    uint32_t zeroLow = profile.thresholdPermille + BIT_DECISION_OFFSET;
+    uint32_t oneHigh = 1000 + BIT_DECISION_OFFSET - profile.thresholdPermille;
+    uint32_t longest = zeroLow > oneHigh ? zeroLow : oneHigh;
+    return static_cast<uint32_t>(profile.cellUs16) * (longest + BIT_PHASE_SLACK) / (16 * 1000);
+}
+
+uint8_t ADB_HOT ADB::decideBit(adb_timing_profile& profile, uint32_t lowUs, uint32_t highUs) {
+    using namespace ADBProtocol;
+    if (!adaptiveTiming || profile.cellUs16 == 0) return decodeBitCell(lowUs, highUs);
+    
+    // Part basse de la cellule comparée au seuil appris; marge rapportée à l'écart nominal 1/0
+    uint32_t lowPermille = lowUs * 1000 / (lowUs + highUs);
+    uint32_t distance = lowPermille > profile.thresholdPermille ? lowPermille - profile.thresholdPermille
+                                                                : profile.thresholdPermille - lowPermille;
+    uint32_t margin = distance * 100 / BIT_DECISION_OFFSET;
+    if (margin > 100) margin = 100;
+    if (margin < profile.lastMargin) profile.lastMargin = static_cast<uint8_t>(margin);
+    if (margin < profile.minMargin) profile.minMargin = static_cast<uint8_t>(margin);
+    if (margin < 25) profile.lowMarginBits++;
+    return lowPermille < profile.thresholdPermille ? 0x1 : 0x0;
+}
 
-    // Décodage Manchester modifié
-    return (low_time < high_time) ? 0x1 : 0x0;
+void ADB::resetTimingProfile(uint8_t addr) {
+    profiles[addr & 0x0F] = adb_timing_profile{};
 }
 
-bool ADB::readDataPacket(uint16_t* buffer, uint8_t length) {
-    // Vérifie le bit de début
-    if (readBit() != 0x1) {
+bool ADB_HOT ADB::readDataPacket(uint16_t* buffer, uint8_t length) {
+    using namespace ADBProtocol;
+    
+    // Aucune réponse possible si la commande n'a pas été émise
+    if (commandAborted) {
+        status = Status::BUS_FAULT;
         return false;
     }
+    busyScope busy(*this);
+    adb_address_stats& counters = stats[currentAddress];
+    
+    if (sampler) {
+        // Paquet capturé d'un bloc puis décodé: aucun front à dater pendant la réception
+        status = readSampledPacket(buffer, length);
+        if (status == Status::NO_RESPONSE && responseStarted) status = Status::BIT_ERROR;
+        if (status == Status::OK) counters.talks++;
+        else if (status == Status::BIT_ERROR) counters.bitErrors++;
+        else counters.noResponse++;
+        return status == Status::OK;
+    }
+    
+    // Première cellule datée par waitTLT (front du bit de début, ou fin du Tlt sans réponse attendue)
+    uint32_t edgeUs = responseStarted ? responseEdgeUs : micros();
+    uint32_t lowUs = 0;
+    uint32_t highUs = 0;
+    adb_timing_profile& profile = profiles[currentAddress];
+    
+    // Bit de début mesuré avec la tolérance la plus large: il sert de référence aux suivants
+    uint32_t maxPhaseUs = adaptiveTiming ? phaseLimit(adb_timing_profile{}) : BIT_PHASE_MAX;
+    irqScope masked(*this);
+    bool started = readCell(edgeUs, maxPhaseUs, lowUs, highUs);
+    if (started) {
+        // Un câble long rapproche la part basse du bit de début de la moitié: le seuil appris fait foi
+        uint32_t limit = profile.cellUs16 ? profile.thresholdPermille : 500 + BIT_DECISION_OFFSET;
+        started = adaptiveTiming ? lowUs * 1000 < limit * (lowUs + highUs) : decodeBitCell(lowUs, highUs) == 0x1;
+        ADB_TRACE(READ_BIT, adbTraceCell(started, lowUs, highUs));
+    }
+    if (!started) {
+        if (responseStarted) {
+            status = Status::BIT_ERROR;
+            counters.bitErrors++;
+        } else {
+            status = Status::NO_RESPONSE;
+            counters.noResponse++;
+        }
+        return false;
+    }
+    if (adaptiveTiming) {
+        // Bit de début raccourci par une routine servie entre deux lectures de la scrutation: le seuil appris reste en place
+        if (!responseEdgeLate) calibrate(profile, lowUs, highUs);
+        maxPhaseUs = phaseLimit(profile);
+        profile.lastMargin = 100;
+    }
 
     // Lecture bit par bit des données
     *buffer = 0;
     for (uint8_t i = 0; i < length; i++) {
-        uint8_t current_bit = readBit();
-        if (current_bit == ADBProtocol::BIT_ERROR) {
+        // Fenêtre juste après le front descendant: la partie basse laisse place aux routines en attente
+        maskInterrupts(2 * maxPhaseUs);
+        if (!readCell(edgeUs, maxPhaseUs, lowUs, highUs)) {
+            status = Status::BIT_ERROR;
+            counters.bitErrors++;
             return false;
         }
-        *buffer = (*buffer << 1) | current_bit;
+        uint8_t bit = decideBit(profile, lowUs, highUs);
+        *buffer = (*buffer << 1) | bit;
+        ADB_TRACE(READ_BIT, adbTraceCell(bit, lowUs, highUs));
     }
 
-    // Lecture du bit de fin (ignoré)
-    readBit();
+    // Lecture du bit de fin (ignoré, 0 par définition)
+    maskInterrupts(2 * maxPhaseUs);
+    if (readCell(edgeUs, maxPhaseUs, lowUs, highUs)) ADB_TRACE(READ_BIT, adbTraceCell(0, lowUs, highUs));
+    status = Status::OK;
+    counters.talks++;
     return true;
 }
 
-void ADB::writeCommand(uint8_t command) {
+ADBProtocol::Status ADB::readSampledPacket(uint16_t* buffer, uint8_t length) {
+    const ADBSampleDecoder& decoder = sampler->decoder();
+    size_t samples = sampler->capture(decoder.packetSamples(length));
+    if (samples == 0) return ADBProtocol::Status::NO_RESPONSE;
+    return decoder.decodePacket(sampler->samples(), samples, buffer, length);
+}
+
+bool ADB::shiftWaveform() {
+    ADBWaveform& pattern = transmitter->waveform();
+    // Motif trop long pour le tampon, ou durées que la cadence de décalage ne peut pas restituer
+    if (pattern.overflowed() || pattern.distorted()) return false;
+    
+    // Fronts capturés d'après le motif, avant que le périphérique ne consomme le tampon
+    uint32_t startUs = micros();
+    if (capture) {
+        ADBRunReader runs(pattern.data(), pattern.bits(), pattern.order());
+        uint64_t position = 0;
+        bool level = runs.level();
+        for (uint32_t run = runs.next(); run; run = runs.next()) {
+            capture->edge(startUs + static_cast<uint32_t>(position * 1000000 / pattern.shiftRate()), level);
+            position += run;
+            level = !level;
+        }
+    }
+    
+    // Tlt est compté depuis la fin du motif: échéance posée avant le démarrage, sans attendre le périphérique
+    phaseClock.start();
+    phaseClock.advance(static_cast<uint32_t>(static_cast<uint64_t>(pattern.bits()) * 1000000 / pattern.shiftRate()));
+    return transmitter->start(pattern.data(), pattern.bits());
+}
+
+void ADB::awaitTransmitter() {
+    // Le processeur reste libre pendant le décalage: l'attente n'a lieu qu'au moment de lire ou reprendre la ligne
+    if (transmitter) {
+        while (transmitter->busy()) {}
+    }
+}
+
+void ADB_HOT ADB::writeCommand(uint8_t command) {
+    // En écoute passive, la ligne appartient à un autre hôte
+    commandAborted = sniffer != nullptr;
+    if (commandAborted) return;
+    
+    busyScope busy(*this);
+    currentAddress = (command >> 4) & 0x0F;
+    stats[currentAddress].transactions++;
+    awaitTransmitter();
+    
+    // Une ligne bloquée basse au repos ne permet aucune transaction
+    commandAborted = !checkLineIdle();
+    if (commandAborted) return;
+    
+    if (transmitter) {
+        // Motif complet confié au périphérique; un motif qui ne tient pas dans le tampon n'est pas émis
+        transmitter->waveform().setTiming(emitTiming);
+        transmitter->waveform().command(command);
+        commandAborted = !shiftWaveform();
+        return;
+    }
+    
+    // Section laissée ouverte par une réponse qui n'a pas été lue
+    irqScope masked(*this);
+    releaseInterrupts();
     wait();
     sync();
     writeBits(static_cast<uint16_t>(command), 8);
     writeBit(0);
 }
 
+void ADB::noteBusy(uint32_t startUs) {
+    uint32_t now = micros();
+    uint32_t elapsed = now - startUs;
+    stats[currentAddress].busyWindowUs += elapsed;
+    busyWindowUs += elapsed;
+    rollBusyWindow(now);
+}
+
+void ADB::rollBusyWindow(uint32_t now) {
+    uint32_t span = now - busyWindowStart;
+    if (span < 1000000UL) return;
+    
+    // Ramène l'occupation de la fenêtre écoulée à une seconde
+    for (adb_address_stats& counters : stats) {
+        counters.busyUsPerSecond = static_cast<uint32_t>(static_cast<uint64_t>(counters.busyWindowUs) * 1000000UL / span);
+        counters.busyWindowUs = 0;
+    }
+    totalBusyUsPerSecond = static_cast<uint32_t>(static_cast<uint64_t>(busyWindowUs) * 1000000UL / span);
+    busyWindowUs = 0;
+    busyWindowStart = now;
+}
+
+void ADB::countRetry(uint8_t addr) {
+    stats[addr & 0x0F].retries++;
+}
+
+void ADB::resetStats() {
+    memset(stats, 0, sizeof(stats));
+    irqMaxMaskedUs = 0;
+    busyWindowStart = micros();
+    busyWindowUs = 0;
+    totalBusyUsPerSecond = 0;
+    srqCount = 0;
+}
+
+size_t ADB::exportStats(uint8_t* buffer, size_t size) {
+    if (size < sizeof(adb_stats_header)) return 0;
+    rollBusyWindow(micros());
+    
+    adb_stats_header header = {};
+    header.version = ADBProtocol::STATS_VERSION;
+    header.uptimeMs = millis();
+    header.busyUsPerSecond = totalBusyUsPerSecond;
+    header.srqs = srqCount;
+    
+    size_t offset = sizeof(header);
+    for (uint8_t addr = 0; addr < ADBProtocol::MAX_ADDRESSES; addr++) {
+        const adb_address_stats& counters = stats[addr];
+        if (counters.transactions == 0) continue;
+        if (offset + sizeof(adb_stats_record) > size) break;
+        
+        adb_stats_record record = {};
+        record.address = addr;
+        record.transactions = counters.transactions;
+        record.talks = counters.talks;
+        record.noResponse = counters.noResponse;
+        record.bitErrors = counters.bitErrors;
+        record.retries = counters.retries;
+        record.busyUsPerSecond = counters.busyUsPerSecond;
+        memcpy(buffer + offset, &record, sizeof(record));
+        offset += sizeof(record);
+        header.count++;
+    }
+    
+    memcpy(buffer, &header, sizeof(header));
+    return offset;
+}
+
+bool ADB::beginSniffing(ADBSniffer& sniffer) {
+    if (this->sniffer) endSniffing();
+    
+    // Entrée haute impédance: la résistance de tirage est celle de l'hôte observé
+    pinMode(dataPin, INPUT);
+    sniffer.setGlitchFilter(glitch);
+    if (!sniffer.begin(dataPin)) {
+        pinMode(dataPin, OUTPUT_OPEN_DRAIN);
+        digitalWrite(dataPin, HIGH);
+        return false;
+    }
+    this->sniffer = &sniffer;
+    return true;
+}
+
+void ADB::endSniffing() {
+    if (!sniffer) return;
+    sniffer->end();
+    sniffer = nullptr;
+    pinMode(dataPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(dataPin, HIGH);
+}
+
 void ADB::setPin(uint8_t dataPin) {
     this->dataPin = dataPin;
     pinMode(dataPin, OUTPUT_OPEN_DRAIN);
@@ -172,6 +689,12 @@ void ADB::setPin(uint8_t dataPin) {
  */
 
 bool ADBDevices::initializeDevice(uint8_t address, uint8_t handler_id, bool& present) {
+    // Talk registre 3 obligatoire: la présence est constatée sur le bus, pas dans la copie locale
+    shadows[address & 0x0F].reg3Valid = false;
+    return applyHandler(address, handler_id, present);
+}
+
+bool ADBDevices::applyHandler(uint8_t address, uint8_t handler_id, bool& present) {
     bool error = false;
     
     // Préparer les données pour le registre 3
@@ -189,24 +712,51 @@ bool ADBDevices::initializeDevice(uint8_t address, uint8_t handler_id, bool& pre
 adb_data<adb_kb_modifiers> ADBDevices::keyboardReadModifiers(bool* error) {
     adb_data<adb_kb_modifiers> modifiers = {0};
     
-    // Envoi d'une commande Talk au registre 2 du clavier
-    adb.writeCommand(ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(2));
-    adb.waitTLT(true);
+    // Talk registre 2 du clavier
+    *error = !talkRegister(ADBKey::Address::KEYBOARD, 2, &modifiers.raw, true);
+    
+    // Mise à jour de la copie locale du registre 2
+    if (!*error) {
+        adb_register_shadow& shadow = shadows[ADBKey::Address::KEYBOARD];
+        shadow.reg2 = modifiers.raw;
+        shadow.reg2Valid = true;
+        
+        state.modifiers = modifiers.raw;
+        state.leds = ~modifiers.raw & ADBProtocol::REG2_LED_MASK;
+        publishState(ADBKey::Address::KEYBOARD);
+    }
+    notePresence(ADBKey::Address::KEYBOARD, true);
     
-    // Lecture des données et mise à jour du statut d'erreur
-    *error = !adb.readDataPacket(&modifiers.raw, 16);
+    flushPendingWrites();
     return modifiers;
 }
 
 adb_data<adb_kb_keypress> ADBDevices::keyboardReadKeyPress(bool* error) {
     adb_data<adb_kb_keypress> keyPress = {0};
+    uint32_t polledAt = latency ? micros() : 0;
     
-    // Envoi d'une commande Talk au registre 0 du clavier
-    adb.writeCommand(ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(0));
-    adb.waitTLT(true);
+    // Talk registre 0 du clavier: chaque lecture retire les touches transmises
+    *error = !talkRegister(ADBKey::Address::KEYBOARD, 0, &keyPress.raw, false);
     
-    // Lecture des touches pressées et mise à jour du statut d'erreur
-    *error = !adb.readDataPacket(&keyPress.raw, 16);
+    // Mise à jour de l'état publié
+    if (!*error) {
+        if (recorder) {
+            recorder->record(ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(0),
+                             keyPress.raw, micros());
+        }
+        if (keyPress.raw == ADBKey::KeyCode::POWER_UP) {
+            updateKeyState(0x7F, true);
+        } else {
+            // 0xFF signale un emplacement vide
+            if ((keyPress.raw >> 8) != 0xFF) updateKeyState(keyPress.data.key0, keyPress.data.released0);
+            if ((keyPress.raw & 0xFF) != 0xFF) updateKeyState(keyPress.data.key1, keyPress.data.released1);
+        }
+        publishState(ADBKey::Address::KEYBOARD);
+    }
+    notePresence(ADBKey::Address::KEYBOARD, false);
+    if (latency) latency->polled(ADBLatencyPath::KEYBOARD, polledAt, !*error);
+    
+    flushPendingWrites();
     return keyPress;
 }
 
@@ -218,61 +768,554 @@ void ADBDevices::keyboardWriteLEDs(bool num, bool caps, bool scroll) {
     modifiers.data.led_caps = !caps;
     modifiers.data.led_scroll = !scroll;
 
+    // Aucune écriture si le clavier a déjà cet état (une écriture en attente est annulée)
+    const adb_register_shadow& shadow = shadows[ADBKey::Address::KEYBOARD];
+    if (shadow.reg2Valid &&
+        (shadow.reg2 & ADBProtocol::REG2_LED_MASK) == (modifiers.raw & ADBProtocol::REG2_LED_MASK)) {
+        ledsPending = false;
+        return;
+    }
+
+    // L'écriture sera émise au prochain créneau libre du bus
+    pendingLEDs = modifiers.raw;
+    ledsPending = true;
+}
+
+bool ADBDevices::flushPendingWrites() {
+    if (!ledsPending) return false;
+    ledsPending = false;
 
     // Envoi d'une commande Listen au registre 2 du clavier
     adb.writeCommand(ADBProtocol::CMD_LISTEN | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(2));
     adb.waitTLT(false);
     
     // Envoi des données de configuration des LEDs
-    adb.writeDataPacket(modifiers.raw, 16);
+    adb.writeDataPacket(pendingLEDs, 16);
+    if (recorder) {
+        recorder->record(ADBProtocol::CMD_LISTEN | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(2),
+                         pendingLEDs, micros());
+    }
+    
+    // Seuls les bits des LEDs sont connus après une écriture
+    adb_register_shadow& shadow = shadows[ADBKey::Address::KEYBOARD];
+    shadow.reg2 = (shadow.reg2 & ~ADBProtocol::REG2_LED_MASK) | (pendingLEDs & ADBProtocol::REG2_LED_MASK);
+    shadow.reg2Valid = true;
+    
+    state.leds = ~pendingLEDs & ADBProtocol::REG2_LED_MASK;
+    publishState(ADBKey::Address::KEYBOARD);
+    return true;
+}
+
+void ADBDevices::invalidateShadow(uint8_t addr) {
+    shadows[addr & 0x0F] = adb_register_shadow{};
+}
+
+void ADBDevices::invalidateAllShadows() {
+    for (uint8_t addr = 0; addr < ADBProtocol::MAX_ADDRESSES; addr++) {
+        invalidateShadow(addr);
+    }
+    ledsPending = false;
+}
+
+void ADBDevices::updateKeyState(uint8_t code, bool released) {
+    uint8_t bit = 1 << (code & 0x07);
+    if (released) {
+        state.keys[code >> 3] &= ~bit;
+    } else {
+        state.keys[code >> 3] |= bit;
+    }
+}
+
+void ADBDevices::publishState(uint8_t addr, bool present) {
+    if (present) {
+        state.presentMask |= 1 << (addr & 0x0F);
+    } else {
+        state.presentMask &= ~(1 << (addr & 0x0F));
+    }
+    state.updates++;
+    state.updatedAt = millis();
+    published.write(state);
 }
 
 adb_data<adb_mouse_data> ADBDevices::mouseReadData(bool* error) {
     adb_data<adb_mouse_data> mouseData = {0};
+    uint32_t polledAt = latency ? micros() : 0;
     
-    // Envoi d'une commande Talk au registre 0 de la souris
-    adb.writeCommand(ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::MOUSE) | ADBProtocol::REGISTER(0));
-    adb.waitTLT(true);
+    // Talk registre 0 de la souris: chaque lecture retire le mouvement transmis
+    *error = !talkRegister(ADBKey::Address::MOUSE, 0, &mouseData.raw, false);
     
-    // Lecture des données de la souris et mise à jour du statut d'erreur
-    *error = !adb.readDataPacket(&mouseData.raw, 16);
+    // Cumul du mouvement dans l'état publié
+    if (!*error) {
+        if (recorder) {
+            recorder->record(ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::MOUSE) | ADBProtocol::REGISTER(0),
+                             mouseData.raw, micros());
+        }
+        // Valeur signée sur 7 bits: adbMouseConvertAxis rend le double du déplacement
+        state.mouseX += adbMouseConvertAxis(mouseData.data.x_offset) >> 1;
+        state.mouseY += adbMouseConvertAxis(mouseData.data.y_offset) >> 1;
+        state.mouseButton = mouseData.data.button;
+        publishState(ADBKey::Address::MOUSE);
+    }
+    notePresence(ADBKey::Address::MOUSE, false);
+    if (latency) latency->polled(ADBLatencyPath::MOUSE, polledAt, !*error);
+    
+    flushPendingWrites();
     return mouseData;
 }
 
 adb_data<adb_register3> ADBDevices::deviceReadRegister3(uint8_t addr, bool* error) {
     adb_data<adb_register3> reg3 = {0};
-    
-    // Envoi d'une commande Talk au registre 3 du périphérique
-    adb.writeCommand(ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(3));
-    adb.waitTLT(true);
+    adb_register_shadow& shadow = shadows[addr & 0x0F];
     
     // Lecture de la configuration du périphérique
-    *error = !adb.readDataPacket(&reg3.raw, 16);
+    *error = !talkRegister(addr, 3, &reg3.raw, true);
+    
+    // Mise à jour de la copie locale du registre 3
+    shadow.reg3 = reg3.raw;
+    shadow.reg3Valid = !*error;
+    if (!*error) publishState(addr);
+    notePresence(addr, true);
     return reg3;
 }
 
+bool ADBDevices::talkRegister(uint8_t addr, uint8_t reg, uint16_t* value, bool stable) {
+    using namespace ADBProtocol;
+    uint8_t command = CMD_TALK | ADDRESS(addr) | REGISTER(reg);
+    uint32_t retryCostUs = 0;
+    
+    for (uint8_t attempt = 0;; attempt++) {
+        uint32_t start = micros();
+        adb.writeCommand(command);
+        adb.waitTLT(true);
+        bool ok = adb.readDataPacket(value, 16);
+        if (ok && stable && retryConfig.readTwice) {
+            // Deux réceptions identiques: une erreur non détectée ne se reproduit pas à l'identique
+            uint16_t again = 0;
+            adb.writeCommand(command);
+            adb.waitTLT(true);
+            ok = adb.readDataPacket(&again, 16) && again == *value;
+        }
+        uint32_t costUs = micros() - start;
+        if (attempt > 0) {
+            retryCostUs += costUs;
+            retryUsedUs += costUs;
+        }
+        if (ok) return true;
+        
+        // Sans réponse (aucune donnée, périphérique absent) ou bus en défaut: rien à reprendre
+        Status status = adb.lastStatus();
+        if (status != Status::BIT_ERROR && status != Status::OK) return false;
+        if (attempt >= retryConfig.maxRetries) return false;
+        
+        // Renouvellement du budget de temps de bus chaque seconde
+        uint32_t now = millis();
+        if (now - retryWindowStart >= 1000) {
+            retryWindowStart = now;
+            retryUsedUs = 0;
+        }
+        // Reprise estimée au coût de la tentative qui vient d'échouer
+        if (retryCostUs + costUs > retryConfig.callBudgetUs) return false;
+        if (retryUsedUs + costUs > retryConfig.budgetUsPerSecond) return false;
+        
+        // Réponse interrompue (données conservées par le périphérique), puis écart minimal avant la commande suivante
+        uint32_t quietStart = micros();
+        if (status == Status::BIT_ERROR) adb.abortResponse();
+        bool quiet = adb.waitBusQuiet(TLT_MIN, LINE_RELEASE_TIMEOUT);
+        uint32_t quietUs = micros() - quietStart;
+        retryCostUs += quietUs;
+        retryUsedUs += quietUs;
+        if (!quiet) return false;
+        adb.countRetry(addr);
+    }
+}
+
+void ADBDevices::settle() {
+    uint8_t ms = starting ? 0 : adb.hostTiming().settleMs;
+    if (ms) delay(ms);
+}
+
 bool ADBDevices::deviceUpdateRegister3(uint8_t addr, adb_data<adb_register3> newReg3, uint16_t mask, bool* error) {
-    // Lecture de la configuration actuelle
-    adb_data<adb_register3> reg3 = deviceReadRegister3(addr, error);
-    if (*error) return false;
+    adb_data<adb_register3> reg3 = {0};
+    adb_register_shadow& shadow = shadows[addr & 0x0F];
     
-    // Attente entre les opérations
-    delay(ADBProtocol::POLL_DELAY);
+    // Lecture de la configuration actuelle, inutile si la copie locale est valide
+    if (shadow.reg3Valid) {
+        reg3.raw = shadow.reg3;
+        *error = false;
+    } else {
+        reg3 = deviceReadRegister3(addr, error);
+        if (*error) return false;
+        
+        // Attente entre les opérations
+        settle();
+    }
+    
+    // Aucune écriture si les bits masqués ont déjà la valeur souhaitée
+    if ((reg3.raw & mask) == (newReg3.raw & mask)) {
+        return true;
+    }
 
     // Application du masque pour ne modifier que les bits souhaités
     reg3.raw = (reg3.raw & ~mask) | (newReg3.raw & mask);
 
     // Envoi d'une commande Listen pour mettre à jour la configuration
-    adb.writeCommand(ADBProtocol::CMD_LISTEN | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(3));
+    adb.writeCommand(ADBProtocol::CMD_LISTEN | ADBProtocol::ADDRESS(addr) | ADBProtocol::REGISTER(3));
     adb.waitTLT(false);
     adb.writeDataPacket(reg3.raw, 16);
+    if (recorder) {
+        recorder->record(ADBProtocol::CMD_LISTEN | ADBProtocol::ADDRESS(addr) | ADBProtocol::REGISTER(3), reg3.raw, micros());
+    }
+    invalidateShadow(addr);
     
     // Attente entre les opérations
-    delay(ADBProtocol::POLL_DELAY);
+    settle();
 
-    // Vérification que la mise à jour a été prise en compte
-    reg3 = deviceReadRegister3(addr, error);
-    if (*error) return false;
+    // Vérification à la nouvelle adresse si celle-ci a été modifiée
+    uint8_t verifyAddr = (mask & ADBProtocol::REG3_ADDRESS_MASK) ? reg3.data.device_address : addr;
+    if (retryConfig.readTwice) {
+        // Lecture unique: la valeur écrite tient lieu de première lecture, copie locale seulement si identique
+        uint16_t written = reg3.raw;
+        *error = !talkRegister(verifyAddr, 3, &reg3.raw, false);
+        notePresence(verifyAddr, true);
+        if (*error) return false;
+        if (reg3.raw == written) {
+            adb_register_shadow& verified = shadows[verifyAddr & 0x0F];
+            verified.reg3 = written;
+            verified.reg3Valid = true;
+            publishState(verifyAddr);
+        }
+    } else {
+        reg3 = deviceReadRegister3(verifyAddr, error);
+        if (*error) return false;
+    }
 
     return (reg3.raw & mask) == (newReg3.raw & mask);
 }
+
+/**
+ * Gestionnaire de présence - détection des débranchements et rebranchements
+ */
+
+void ADBDevices::monitorDevice(uint8_t addr, uint8_t handler_id) {
+    adb_presence& entry = presence[addr & 0x0F];
+    entry = adb_presence{};
+    entry.handlerId = handler_id;
+    entry.monitored = true;
+    entry.nextProbeAt = millis();
+}
+
+void ADBDevices::notePresence(uint8_t addr, bool alwaysAnswers) {
+    adb_presence& entry = presence[addr & 0x0F];
+    
+    switch (adb.lastStatus()) {
+        case ADBProtocol::Status::OK:
+            entry.failures = 0;
+            entry.lastSeenAt = millis();
+            if (entry.monitored && !entry.present) markPresent(addr);
+            return;
+        case ADBProtocol::Status::NO_RESPONSE:
+            // Un Talk registre 0 sans réponse signifie seulement "aucune donnée"
+            if (!alwaysAnswers) return;
+            break;
+        case ADBProtocol::Status::BIT_ERROR:
+            errorCount++;
+            break;
+        case ADBProtocol::Status::BUS_FAULT:
+            // Défaut commun à tout le bus, traité par serviceBusHealth()
+            return;
+    }
+    
+    // Les erreurs transitoires ne font perdre le périphérique qu'après plusieurs échecs
+    if (entry.monitored && entry.present && ++entry.failures >= presenceConfig.failuresBeforeLost) {
+        markLost(addr);
+    }
+}
+
+bool ADBDevices::probeDevice(uint8_t addr) {
+    bool error = false;
+    uint32_t start = micros();
+    deviceReadRegister3(addr, &error);
+    budgetUsedUs += micros() - start;
+    return !error;
+}
+
+void ADBDevices::markPresent(uint8_t addr) {
+    adb_presence& entry = presence[addr & 0x0F];
+    entry.present = true;
+    entry.probed = true;
+    entry.verified = true;
+    entry.failures = 0;
+    entry.backoffShift = 0;
+    
+    // Un périphérique rebranché repart de sa configuration par défaut
+    if (entry.handlerId != 0) {
+        bool initialized = false;
+        applyHandler(addr, entry.handlerId, initialized);
+    }
+    
+    // Restauration des LEDs connues avant la déconnexion
+    adb_register_shadow& shadow = shadows[addr & 0x0F];
+    if (addr == ADBKey::Address::KEYBOARD && shadow.reg2Valid) {
+        pendingLEDs = shadow.reg2 & ADBProtocol::REG2_LED_MASK;
+        ledsPending = true;
+        shadow.reg2Valid = false;
+    }
+    
+    // Mémorisation de la table des périphériques (écrite par serviceCache ou en fin de démarrage)
+    if (cache) cache->set(addr, entry.handlerId);
+    
+    publishState(addr);
+    if (presenceCallback) presenceCallback(addr, true);
+    updateStartup();
+}
+
+void ADBDevices::markLost(uint8_t addr) {
+    adb_presence& entry = presence[addr & 0x0F];
+    entry.present = false;
+    entry.failures = 0;
+    entry.backoffShift = 0;
+    entry.nextProbeAt = millis() + presenceConfig.backoffMinMs;
+    
+    // Le registre 2 est conservé pour restaurer les LEDs au rebranchement
+    shadows[addr & 0x0F].reg3Valid = false;
+    
+    // Le périphérique rebranché peut être un autre modèle, à l'horloge différente
+    adb.resetTimingProfile(addr);
+    
+    publishState(addr, false);
+    if (presenceCallback) presenceCallback(addr, false);
+}
+
+bool ADBDevices::servicePresence() {
+    uint32_t now = millis();
+    
+    // Renouvellement du budget de temps de bus chaque seconde
+    if (now - budgetWindowStart >= 1000) {
+        budgetWindowStart = now;
+        budgetUsedUs = 0;
+    }
+    if (!starting && budgetUsedUs >= presenceConfig.budgetUsPerSecond) return false;
+    
+    // Parcours en tourniquet: au plus un sondage par appel
+    for (uint8_t i = 0; i < ADBProtocol::MAX_ADDRESSES; i++) {
+        uint8_t addr = (presenceCursor + i) & 0x0F;
+        adb_presence& entry = presence[addr];
+        if (!entry.monitored) continue;
+        
+        if (entry.present && !entry.verified) {
+            // Vérification différée d'un périphérique restauré depuis le cache
+            verifyCachedDevice(addr);
+        } else if (entry.present) {
+            // Vérification d'un périphérique resté silencieux trop longtemps
+            if (now - entry.lastSeenAt < presenceConfig.checkIntervalMs) continue;
+            probeDevice(addr);
+        } else {
+            // Re-sondage d'une adresse vide avec backoff exponentiel
+            if (static_cast<int32_t>(now - entry.nextProbeAt) < 0) continue;
+            bool found = probeDevice(addr);
+            entry.probed = true;
+            if (!found) {
+                uint32_t interval = static_cast<uint32_t>(presenceConfig.backoffMinMs) << entry.backoffShift;
+                if (interval >= presenceConfig.backoffMaxMs) {
+                    interval = presenceConfig.backoffMaxMs;
+                } else {
+                    entry.backoffShift++;
+                }
+                entry.nextProbeAt = millis() + interval;
+            }
+        }
+        
+        presenceCursor = (addr + 1) & 0x0F;
+        updateStartup();
+        return true;
+    }
+    updateStartup();
+    return false;
+}
+
+/**
+ * Surveillance électrique du bus - détection des blocages et récupération
+ */
+
+bool ADBDevices::serviceBusHealth() {
+    uint32_t now = millis();
+    
+    if (!health.degraded) {
+        // Comptage des erreurs de bit sur une fenêtre d'une seconde
+        bool noisy = false;
+        if (now - errorWindowStart >= 1000) {
+            noisy = errorCount >= healthConfig.noisyErrorsPerSecond;
+            errorWindowStart = now;
+            errorCount = 0;
+        }
+        
+        ADBProtocol::LineFault fault = adb.lineFault();
+        if (fault == ADBProtocol::LineFault::NONE && !noisy) return false;
+        
+        if (fault == ADBProtocol::LineFault::STUCK_LOW) health.stuckLowEvents++;
+        else if (fault == ADBProtocol::LineFault::STUCK_HIGH) health.stuckHighEvents++;
+        else health.noisyEvents++;
+        
+        health.degraded = true;
+        health.degradedSince = now;
+        health.backoffShift = 0;
+        nextRecoveryAt = now;
+    }
+    
+    if (static_cast<int32_t>(now - nextRecoveryAt) < 0) return false;
+    
+    // Tentative de récupération: réinitialisation puis vérification de la ligne
+    health.recoveryAttempts++;
+    adb.clearLineFault();
+    if (!adb.reset()) {
+        uint32_t interval = static_cast<uint32_t>(healthConfig.recoveryMinMs) << health.backoffShift;
+        if (interval >= healthConfig.recoveryMaxMs) {
+            interval = healthConfig.recoveryMaxMs;
+        } else {
+            health.backoffShift++;
+        }
+        nextRecoveryAt = millis() + interval;
+        return true;
+    }
+    
+    // Bus rétabli: les périphériques sont revenus à leur configuration par défaut
+    reenumerateDevices();
+    now = millis();
+    health.degraded = false;
+    health.recoveries++;
+    health.lastRecoveryMs = now - health.degradedSince;
+    health.totalDegradedMs += health.lastRecoveryMs;
+    errorWindowStart = now;
+    errorCount = 0;
+    return true;
+}
+
+void ADBDevices::reenumerateDevices() {
+    for (uint8_t addr = 0; addr < ADBProtocol::MAX_ADDRESSES; addr++) {
+        shadows[addr].reg3Valid = false;
+        
+        adb_presence& entry = presence[addr];
+        if (!entry.monitored) continue;
+        if (entry.present) markLost(addr);
+        
+        // Re-sondage immédiat par servicePresence()
+        entry.backoffShift = 0;
+        entry.nextProbeAt = millis();
+    }
+    budgetUsedUs = 0;
+}
+
+void ADBDevices::service() {
+    if (serviceBusHealth() || health.degraded) return;
+    flushPendingWrites();
+    servicePresence();
+    serviceCache();
+}
+
+void ADBDevices::serviceCache() {
+    // EEPROM émulée en flash (STM32): chaque écriture efface une page, au plus une par intervalle
+    uint32_t now = millis();
+    if (!cache || starting || now - cacheSavedAt < ADBProtocol::CACHE_SAVE_INTERVAL_MS) return;
+    cacheSavedAt = now;
+    
+    // Retrait des périphériques absents depuis tout un intervalle: une perte passagère n'est pas mémorisée
+    for (uint8_t addr = 0; addr < ADBProtocol::MAX_ADDRESSES; addr++) {
+        const adb_presence& entry = presence[addr];
+        if (entry.monitored && !entry.present && now - entry.lastSeenAt >= ADBProtocol::CACHE_SAVE_INTERVAL_MS) {
+            cache->remove(addr);
+        }
+    }
+    cache->save();
+}
+
+/**
+ * Démarrage non bloquant - détection progressive et cache persistant
+ */
+
+void ADBDevices::beginStartup(ADBDeviceCache* deviceCache) {
+    uint32_t now = millis();
+    boot = adb_boot_timings{};
+    boot.startedAt = now;
+    boot.firstDeviceMs = ADBProtocol::BOOT_PENDING;
+    boot.keyboardReadyMs = ADBProtocol::BOOT_PENDING;
+    boot.completeMs = ADBProtocol::BOOT_PENDING;
+    cache = deviceCache;
+    starting = true;
+    
+    // Démarrage à chaud: les périphériques mémorisés sont utilisables immédiatement
+    if (cache && cache->load()) {
+        for (uint8_t i = 0; i < cache->count(); i++) {
+            const adb_cached_device& cached = cache->device(i);
+            uint8_t addr = cached.address & 0x0F;
+            if (!presence[addr].monitored) monitorDevice(addr, cached.handlerId);
+            
+            adb_presence& entry = presence[addr];
+            entry.present = true;
+            entry.probed = true;
+            entry.verified = false;
+            entry.lastSeenAt = now;
+            boot.cachedDevices++;
+            
+            publishState(addr);
+            if (presenceCallback) presenceCallback(addr, true);
+        }
+        boot.warmBoot = boot.cachedDevices > 0;
+    }
+    
+    // Les autres adresses surveillées sont sondées dès le premier appel à service()
+    for (uint8_t addr = 0; addr < ADBProtocol::MAX_ADDRESSES; addr++) {
+        adb_presence& entry = presence[addr];
+        if (!entry.monitored || entry.present) continue;
+        entry.probed = false;
+        entry.backoffShift = 0;
+        entry.nextProbeAt = now;
+    }
+    presenceCursor = 0;
+    updateStartup();
+}
+
+void ADBDevices::verifyCachedDevice(uint8_t addr) {
+    adb_presence& entry = presence[addr & 0x0F];
+    bool error = false;
+    
+    uint32_t start = micros();
+    adb_data<adb_register3> reg3 = deviceReadRegister3(addr, &error);
+    budgetUsedUs += micros() - start;
+    
+    // En cas d'échec, notePresence() décompte les erreurs jusqu'à la perte
+    if (error) return;
+    entry.verified = true;
+    
+    // Après une coupure d'alimentation, le périphérique a perdu son handler ID
+    if (entry.handlerId != 0 && reg3.data.device_handler_id != entry.handlerId) {
+        bool initialized = false;
+        applyHandler(addr, entry.handlerId, initialized);
+    }
+}
+
+void ADBDevices::updateStartup() {
+    if (!starting) return;
+    uint32_t elapsed = millis() - boot.startedAt;
+    
+    bool complete = true;
+    for (uint8_t addr = 0; addr < ADBProtocol::MAX_ADDRESSES; addr++) {
+        const adb_presence& entry = presence[addr];
+        if (!entry.monitored) continue;
+        
+        if (entry.present && boot.firstDeviceMs == ADBProtocol::BOOT_PENDING) {
+            boot.firstDeviceMs = elapsed;
+        }
+        if (!entry.probed || (entry.present && !entry.verified)) complete = false;
+    }
+    
+    if (presence[ADBKey::Address::KEYBOARD].present && boot.keyboardReadyMs == ADBProtocol::BOOT_PENDING) {
+        boot.keyboardReadyMs = elapsed;
+    }
+    
+    if (!complete) return;
+    boot.completeMs = elapsed;
+    boot.complete = true;
+    starting = false;
+    if (cache) cache->save();
+    cacheSavedAt = millis();
+}
@@ -10,6 +10,16 @@
 #include <cstdint>
 #include "ADBKeymap.h"
 #include "ADBKeyCodes.h"
+#include "ADBSnapshot.h"
+#include "ADBLatency.h"
+#include "ADBCapture.h"
+#include "ADBRecorder.h"
+#include "ADBTiming.h"
+
+class ADBDeviceCache;
+class ADBSniffer;
+class ADBLineSampler;
+class ADBShiftDriver;
 
 namespace ADBProtocol {
     // Commandes ADB
@@ -20,10 +30,83 @@ namespace ADBProtocol {
     // Constantes diverses
     constexpr uint8_t BIT_ERROR  = 0xFF;
     constexpr uint8_t POLL_DELAY = 5;
+    constexpr uint8_t MAX_ADDRESSES = 16;
+    constexpr uint16_t LINE_RELEASE_TIMEOUT = 10000; // Attente maximale de remontée de la ligne (µs)
+    constexpr uint16_t LINE_IDLE_TIMEOUT = 1000;     // Attente maximale de la ligne au repos avant une commande (µs)
+    constexpr uint16_t SRQ_TIMEOUT = 300;            // Prolongation maximale du bit d'arrêt par un SRQ (µs)
+    constexpr uint32_t BOOT_PENDING = 0xFFFFFFFF;    // Phase de démarrage non encore atteinte
+    constexpr uint32_t CACHE_SAVE_INTERVAL_MS = 60000; // Écart minimal entre deux écritures de la table persistante
+    constexpr uint8_t STATS_VERSION = 2;             // Version du format d'export des statistiques
+    
+    // Fenêtres de décodage des signaux (µs), tolérance de ±30% sur les durées nominales
+    constexpr uint16_t BIT_CELL_MIN = 70;      // Cellule de bit (nominale 100µs)
+    constexpr uint16_t BIT_CELL_MAX = 130;
+    constexpr uint16_t SYNC_MIN = 45;          // Synchronisation (nominale 70µs)
+    constexpr uint16_t SYNC_MAX = 95;
+    constexpr uint16_t ATTENTION_MIN = 560;    // Attention (nominale 800µs)
+    constexpr uint16_t ATTENTION_MAX = 1040;
+    constexpr uint16_t RESET_MIN = 2000;       // Reset global (nominal 3ms)
+    constexpr uint16_t SRQ_MIN = 140;          // Bit d'arrêt prolongé par un SRQ (nominal 300µs)
+    constexpr uint16_t TLT_MIN = 140;          // Fin du bit d'arrêt -> bit de début (Tlt)
+    constexpr uint16_t TLT_MAX = 260;
+    constexpr uint16_t BIT_PHASE_MAX = 85;     // Demi-cellule la plus longue acceptée en réception
+    constexpr uint16_t BIT_DECISION_OFFSET = 150; // Seuil de décision au-dessus de la part basse du bit de début (‰)
+    constexpr uint16_t BIT_PHASE_SLACK = 200;  // Marge au-delà de la demi-cellule la plus longue attendue (‰ de la cellule)
+    constexpr uint16_t TLT_WINDOW = 400;       // Au-delà, la transaction est close sans données
+    constexpr uint8_t GLITCH_PULSE_MAX = 20;   // Filtre anti-parasites le plus large (partie courte d'un bit: 35µs -30%)
+    constexpr uint8_t GLITCH_VOTES_MAX = 7;    // Lectures de confirmation d'un front au plus
+    constexpr uint8_t POLL_GAP_MAX = 10;       // Écart entre deux lectures au-delà duquel un front n'est pas daté (routine)
+    
+    // Durées émises par l'hôte: tolérance de ±3% sur les valeurs nominales
+    constexpr uint16_t HOST_TOLERANCE_PERMILLE = 30;
+    constexpr uint16_t HOST_ATTENTION_US = 800;
+    constexpr uint16_t HOST_SYNC_US = 70;
+    constexpr uint16_t HOST_CELL_US = 100;
+    constexpr uint16_t HOST_SHORT_PHASE_MIN = 300; // Part courte d'une cellule (nominale 350‰)
+    constexpr uint16_t HOST_SHORT_PHASE_MAX = 400;
+    constexpr uint16_t HOST_RESET_MIN = 3000;      // Reset global émis (3ms au moins)
+    constexpr uint16_t IRQ_MASK_MAX = 1000;        // Masquage le plus long accepté (timer 0 d'un AVR à 16MHz: 1024µs)
+    
+    // Masques des champs de registres
+    constexpr uint16_t REG2_LED_MASK     = 0x0007; // LEDs du registre 2 du clavier
+    constexpr uint16_t REG3_ADDRESS_MASK = 0x0F00; // Adresse du registre 3
+    constexpr uint16_t REG3_HANDLER_MASK = 0x00FF; // Handler ID du registre 3
     
     // Macros de conversion pour les adresses et registres ADB
     constexpr uint8_t ADDRESS(uint8_t addr) { return (addr << 4); }
     constexpr uint8_t REGISTER(uint8_t reg) { return reg; }
+    
+    /**
+     * @brief Décodage Manchester modifié d'une cellule de bit
+     *
+     * Un 1 est court en bas puis long en haut (35/65µs), un 0 l'inverse.
+     * @param lowUs Durée de la partie basse
+     * @param highUs Durée de la partie haute
+     * @return Valeur du bit
+     */
+    constexpr uint8_t decodeBitCell(uint32_t lowUs, uint32_t highUs) { return (lowUs < highUs) ? 0x1 : 0x0; }
+    
+    // Résultat de la dernière réception
+    enum class Status : uint8_t {
+        OK = 0,       // Paquet reçu correctement
+        NO_RESPONSE,  // Aucun bit de début pendant la fenêtre Tlt
+        BIT_ERROR,    // Réponse commencée mais bit mal formé
+        BUS_FAULT     // Transaction abandonnée, ligne bloquée
+    };
+    
+    // Masquage des interruptions pendant les cellules émises et reçues
+    enum class IrqMask : uint8_t {
+        NONE = 0,     // Interruptions jamais masquées
+        PER_BIT,      // Fenêtre ouverte à chaque cellule
+        PER_PACKET    // Fenêtre ouverte seulement lorsque la durée maximale serait dépassée
+    };
+    
+    // Défaut électrique observé sur la ligne
+    enum class LineFault : uint8_t {
+        NONE = 0,     // Ligne saine
+        STUCK_LOW,    // Ligne maintenue basse au repos (court-circuit, périphérique bloqué)
+        STUCK_HIGH    // Ligne impossible à tirer vers le bas
+    };
 }
 
 /**
@@ -69,6 +152,243 @@ struct adb_register3 {
     uint8_t reserved0 : 1;         // Bit réservé
 };
 
+/**
+ * @brief Copie locale (shadow) des registres 2 et 3 d'un périphérique
+ *
+ * Permet d'éviter les transactions redondantes sur le bus: une écriture n'est
+ * émise que si la valeur diffère de la copie, et la lecture préalable d'un
+ * read-modify-write est omise lorsque la copie est valide.
+ */
+struct adb_register_shadow {
+    uint16_t reg2;        // Dernière valeur connue du registre 2
+    uint16_t reg3;        // Dernière valeur connue du registre 3
+    bool reg2Valid : 1;   // Le registre 2 reflète l'état du périphérique
+    bool reg3Valid : 1;   // Le registre 3 reflète l'état du périphérique
+};
+
+/**
+ * @brief Paramètres du suivi de présence des périphériques
+ */
+struct adb_presence_config {
+    uint8_t failuresBeforeLost;    // Échecs consécutifs avant de déclarer un périphérique perdu
+    uint16_t checkIntervalMs;      // Silence maximal avant une vérification par Talk registre 3
+    uint16_t backoffMinMs;         // Intervalle initial de re-sondage d'une adresse vide
+    uint16_t backoffMaxMs;         // Intervalle maximal de re-sondage
+    uint32_t budgetUsPerSecond;    // Temps de bus maximal consacré aux sondages par seconde
+};
+
+/**
+ * @brief État de présence d'une adresse surveillée
+ */
+struct adb_presence {
+    uint8_t handlerId;        // Handler ID appliqué à la (ré)apparition (0 = inchangé)
+    uint8_t failures;         // Échecs consécutifs
+    uint8_t backoffShift;     // Exposant courant du backoff
+    bool monitored : 1;       // Adresse suivie par le gestionnaire de présence
+    bool present : 1;         // Périphérique considéré comme présent
+    bool probed : 1;          // Adresse sondée au moins une fois depuis le démarrage
+    bool verified : 1;        // Présence confirmée sur le bus (et non seulement issue du cache)
+    uint32_t lastSeenAt;      // Dernière réponse valide (millis)
+    uint32_t nextProbeAt;     // Date du prochain sondage d'une adresse vide (millis)
+};
+
+/**
+ * @brief Paramètres de la surveillance électrique du bus
+ */
+struct adb_health_config {
+    uint16_t noisyErrorsPerSecond; // Erreurs de bit par seconde au-delà desquelles la ligne est jugée bruitée
+    uint16_t recoveryMinMs;        // Délai initial entre deux tentatives de récupération
+    uint16_t recoveryMaxMs;        // Délai maximal entre deux tentatives
+};
+
+/**
+ * @brief Reprise des lectures en erreur (ADBDevices::setRetryConfig)
+ *
+ * Seule une erreur de bit est reprise: un Talk sans réponse signifie
+ * « aucune donnée » ou « périphérique absent » et n'est jamais répété.
+ * Chaque reprise est estimée au coût de la tentative précédente et doit
+ * tenir dans les deux budgets de temps de bus.
+ */
+struct adb_retry_config {
+    uint8_t maxRetries;            // Reprises au plus par appel (0 = aucune)
+    uint16_t callBudgetUs;         // Temps de bus maximal consacré aux reprises d'un appel
+    uint32_t budgetUsPerSecond;    // Temps de bus maximal consacré aux reprises par seconde
+    bool readTwice;                // Registres 2 et 3: deux lectures identiques exigées
+};
+
+/**
+ * @brief Métriques de santé du bus et de récupération
+ */
+struct adb_bus_health {
+    uint16_t stuckLowEvents;       // Détections de ligne bloquée basse
+    uint16_t stuckHighEvents;      // Détections de ligne bloquée haute
+    uint16_t noisyEvents;          // Détections de ligne bruitée
+    uint16_t recoveryAttempts;     // Tentatives de récupération (reset + ré-énumération)
+    uint16_t recoveries;           // Récupérations réussies
+    uint8_t backoffShift;          // Exposant courant du délai entre tentatives
+    bool degraded;                 // Bus en cours de récupération
+    uint32_t degradedSince;        // Début de la période dégradée (millis)
+    uint32_t lastRecoveryMs;       // Durée de la dernière période dégradée
+    uint32_t totalDegradedMs;      // Durée cumulée des périodes dégradées
+};
+
+// Compteurs de statistiques: 16 bits sur AVR pour économiser la RAM (à exploiter par différences)
+#if defined(__AVR__)
+typedef uint16_t adb_counter_t;
+#else
+typedef uint32_t adb_counter_t;
+#endif
+
+/**
+ * @brief Profil temporel appris d'un périphérique
+ *
+ * Le bit de début de chaque réponse vaut toujours 1: sa durée donne la
+ * période de cellule réelle du périphérique et sa part basse (35% nominal,
+ * davantage si les fronts montants s'étalent sur un câble long) place le
+ * seuil de décision des bits suivants.
+ */
+struct adb_timing_profile {
+    uint16_t cellUs16;            // Période de cellule apprise, en 1/16 µs (0 = non calibré)
+    uint16_t thresholdPermille;   // Part basse d'une cellule au-delà de laquelle le bit vaut 0 (‰)
+    uint8_t lastMargin;           // Plus faible marge de décision du dernier paquet (%)
+    uint8_t minMargin;            // Plus faible marge observée depuis la calibration (%)
+    adb_counter_t calibrations;   // Bits de début mesurés
+    adb_counter_t rejected;       // Bits de début hors tolérance, ignorés
+    adb_counter_t lowMarginBits;  // Bits décidés avec une marge inférieure à 25%
+};
+
+/**
+ * @brief Durées des phases émises par l'hôte (µs, sauf settleMs)
+ */
+struct adb_host_timing {
+    uint16_t attentionUs;   // Attention précédant chaque commande
+    uint8_t syncUs;         // Synchronisation avant le premier bit
+    uint8_t shortPhaseUs;   // Partie courte d'une cellule (basse pour un 1)
+    uint8_t longPhaseUs;    // Partie longue d'une cellule (basse pour un 0)
+    uint8_t tltUs;          // Fin du bit d'arrêt -> bit de début d'un Listen, ouverture de la fenêtre Talk
+    uint16_t resetUs;       // Reset global
+    uint8_t settleMs;       // Pause entre les opérations de ADBDevices sur le registre 3
+
+    constexpr uint16_t cellUs() const { return shortPhaseUs + longPhaseUs; }
+};
+
+namespace ADBHostTiming {
+    /**
+     * @brief Vrai si les durées restent dans les tolérances de la spécification
+     *
+     * Attention, synchronisation et cellule à ±3% des valeurs nominales, part
+     * courte d'une cellule entre 30 et 40%, Tlt dans [TLT_MIN, TLT_MAX], reset
+     * d'au moins 3ms.
+     */
+    constexpr bool withinTolerance(uint32_t us, uint32_t nominal) {
+        return us * 1000 >= nominal * (1000 - ADBProtocol::HOST_TOLERANCE_PERMILLE) &&
+               us * 1000 <= nominal * (1000 + ADBProtocol::HOST_TOLERANCE_PERMILLE);
+    }
+    constexpr bool conforms(const adb_host_timing& t) {
+        return withinTolerance(t.attentionUs, ADBProtocol::HOST_ATTENTION_US) &&
+               withinTolerance(t.syncUs, ADBProtocol::HOST_SYNC_US) &&
+               withinTolerance(t.cellUs(), ADBProtocol::HOST_CELL_US) &&
+               t.shortPhaseUs * 1000U >= t.cellUs() * ADBProtocol::HOST_SHORT_PHASE_MIN &&
+               t.shortPhaseUs * 1000U <= t.cellUs() * ADBProtocol::HOST_SHORT_PHASE_MAX &&
+               t.tltUs >= ADBProtocol::TLT_MIN && t.tltUs <= ADBProtocol::TLT_MAX &&
+               t.resetUs >= ADBProtocol::HOST_RESET_MIN;
+    }
+
+    // Valeurs nominales, 5ms entre les opérations sur le registre 3
+    constexpr adb_host_timing DEFAULT = {800, 70, 35, 65, 140, 3000, ADBProtocol::POLL_DELAY};
+
+    // Bornes basses de la spécification moins la gigue d'émission (cellule de 98µs), sans pause entre les opérations sur le registre 3
+    constexpr adb_host_timing FAST = {780, 69, 34, 64, 140, 3000, 0};
+
+    static_assert(conforms(DEFAULT), "Profil DEFAULT hors tolérance");
+    static_assert(conforms(FAST), "Profil FAST hors tolérance");
+}
+
+/**
+ * @brief Politique de masquage des interruptions
+ *
+ * Les interruptions restent masquées d'une fenêtre à la suivante. Une
+ * fenêtre s'ouvre juste après un front, où au moins une partie courte de
+ * cellule (35µs) sépare du front suivant: les routines en attente s'y
+ * exécutent sans décaler de front tant qu'elles sont plus courtes. Une
+ * section qui dépasserait maxMaskedUs n'est pas masquée.
+ */
+struct adb_irq_policy {
+    ADBProtocol::IrqMask mode;
+    uint16_t maxMaskedUs;      // Durée maximale d'une section masquée (IRQ_MASK_MAX au plus)
+};
+
+/**
+ * @brief Paramètres du filtre anti-parasites de la réception
+ *
+ * Un front n'est retenu que si le nouveau niveau l'emporte à la majorité
+ * des lectures réparties sur les 2 × minPulseUs qui le suivent: une impulsion
+ * plus courte que minPulseUs ne peut pas obtenir la majorité, et un parasite
+ * isolé pendant la confirmation ne fait pas rejeter un front réel.
+ */
+struct adb_glitch_filter {
+    uint8_t minPulseUs;   // Impulsion la plus courte retenue (0 = filtre désactivé, GLITCH_PULSE_MAX au plus)
+    uint8_t votes;        // Lectures de confirmation, nombre impair (1 = lecture unique après minPulseUs)
+};
+
+/**
+ * @brief Compteurs d'activité du bus pour une adresse
+ */
+struct adb_address_stats {
+    adb_counter_t transactions;    // Commandes émises vers l'adresse
+    adb_counter_t talks;           // Réponses reçues sans erreur
+    adb_counter_t noResponse;      // Talk restés sans réponse (Tlt expiré)
+    adb_counter_t bitErrors;       // Réponses interrompues par une erreur de bit
+    adb_counter_t retries;         // Transactions répétées par l'appelant
+    adb_counter_t glitches;        // Parasites rejetés par le filtre pendant une transaction
+    uint32_t busyUsPerSecond;      // Occupation du bus sur la dernière fenêtre d'une seconde
+    uint32_t busyWindowUs;         // Occupation accumulée dans la fenêtre courante
+};
+
+/**
+ * @brief En-tête de l'export des statistiques (format de transmission, petit-boutiste)
+ */
+struct __attribute__((packed)) adb_stats_header {
+    uint8_t version;               // Version du format (ADBProtocol::STATS_VERSION)
+    uint8_t count;                 // Nombre d'enregistrements adb_stats_record qui suivent
+    uint32_t uptimeMs;             // Date de l'export (millis)
+    uint32_t busyUsPerSecond;      // Occupation totale du bus (µs par seconde)
+    uint32_t srqs;                 // SRQ observés sur le bus, tous demandeurs confondus
+};
+
+/**
+ * @brief Statistiques d'une adresse (format de transmission, petit-boutiste)
+ */
+struct __attribute__((packed)) adb_stats_record {
+    uint8_t address;
+    uint32_t transactions;
+    uint32_t talks;
+    uint32_t noResponse;
+    uint32_t bitErrors;
+    uint32_t retries;
+    uint32_t busyUsPerSecond;
+};
+
+/**
+ * @brief Durées des phases de démarrage (ms depuis beginStartup())
+ */
+struct adb_boot_timings {
+    uint32_t startedAt;        // Date d'appel de beginStartup() (millis depuis la mise sous tension)
+    uint32_t firstDeviceMs;    // Première réponse d'un périphérique
+    uint32_t keyboardReadyMs;  // Clavier utilisable
+    uint32_t completeMs;       // Toutes les adresses surveillées sondées ou vérifiées
+    uint8_t cachedDevices;     // Périphériques restaurés depuis le cache persistant
+    bool warmBoot;             // Démarrage à partir du cache
+    bool complete;             // Phase de démarrage terminée
+};
+
+/**
+ * @brief Fonction appelée lors de l'apparition ou de la disparition d'un périphérique
+ * @param addr Adresse du périphérique
+ * @param present true si le périphérique vient d'apparaître
+ */
+typedef void (*ADBPresenceCallback)(uint8_t addr, bool present);
+
 /**
  * @brief Union pour faciliter l'accès aux données ADB sous forme brute ou structurée
  */
@@ -93,13 +413,15 @@ public:
      * @brief Initialisation du bus ADB
      * @param dataPin Broche optionnelle pour reconfigurer la pin (0xFF pour conserver l'existante)
      * @param useADBDevices Indique si la classe ADBDevices sera utilisée
+     * @return false si la ligne n'est pas remontée dans le délai imparti
      */
-    void init(uint8_t dataPin = 0xFF, bool useADBDevices = false);
+    bool init(uint8_t dataPin = 0xFF, bool useADBDevices = false);
     
     /**
      * @brief Réinitialise le bus ADB
+     * @return false si un défaut de ligne a été détecté pendant la réinitialisation
      */
-    void reset();
+    bool reset();
     
     /**
      * @brief Envoi d'une commande sur le bus ADB
@@ -128,23 +450,364 @@ public:
      */
     void setPin(uint8_t dataPin);
     
+    uint8_t pin() const { return dataPin; }
+    
     /**
      * @brief Attente de réponse du périphérique ADB
      * @param responseExpected Indique si une réponse est attendue
-     * @return true si l'attente s'est bien déroulée
+     * @return false si une réponse était attendue et qu'aucun bit de début n'est arrivé
+     *
+     * Avec une politique de masquage, une réponse commencée laisse les
+     * interruptions masquées jusqu'à la fin de readDataPacket.
      */
     bool waitTLT(bool responseExpected);
+    
+    /**
+     * @brief Résultat de la dernière réception
+     *
+     * Distingue un périphérique qui ne répond pas (normal pour un Talk registre 0
+     * sans nouvelle donnée) d'une réponse corrompue.
+     */
+    ADBProtocol::Status lastStatus() const { return status; }
+    
+    /**
+     * @brief Dernier défaut de ligne détecté (mémorisé jusqu'à clearLineFault())
+     */
+    ADBProtocol::LineFault lineFault() const { return fault; }
+    
+    /**
+     * @brief Efface le défaut de ligne mémorisé
+     */
+    void clearLineFault() { fault = ADBProtocol::LineFault::NONE; }
+    
+    /**
+     * @brief Vérifie que la ligne est au repos (haute), sans transaction
+     * @return true si la ligne est haute ou remonte dans le délai imparti
+     */
+    bool checkLineIdle();
+    
+    /**
+     * @brief Attend que la ligne reste haute pendant quietUs (fin d'une réponse interrompue)
+     * @param quietUs Durée minimale de repos, plus longue que toute demi-cellule
+     * @param timeoutUs Attente maximale
+     * @return false si la ligne n'a pas connu ce repos dans le délai imparti
+     */
+    bool waitBusQuiet(uint32_t quietUs, uint32_t timeoutUs);
+    
+    /**
+     * @brief Interrompt une réponse reçue en erreur
+     *
+     * La ligne est tenue basse pendant une cellule: le périphérique qui émet
+     * encore détecte une collision, abandonne sa réponse et conserve ses
+     * données pour le Talk suivant.
+     */
+    void abortResponse();
+    
+    /**
+     * @brief Compteurs d'activité d'une adresse
+     * @param addr Adresse du périphérique
+     */
+    const adb_address_stats& addressStats(uint8_t addr) const { return stats[addr & 0x0F]; }
+    
+    /**
+     * @brief Occupation totale du bus sur la dernière fenêtre d'une seconde (µs)
+     */
+    uint32_t busyUsPerSecond() const { return totalBusyUsPerSecond; }
+    
+    /**
+     * @brief SRQ observés sur le bus depuis resetStats
+     *
+     * Un SRQ vient d'un autre périphérique que celui interrogé: le bit
+     * d'arrêt ne dit pas lequel, le compteur est donc global.
+     */
+    adb_counter_t srqs() const { return srqCount; }
+    
+    /**
+     * @brief Active la calibration des cellules par adresse (active par défaut)
+     *
+     * Désactivée, readDataPacket revient à la demi-cellule maximale fixe
+     * (BIT_PHASE_MAX) et à la comparaison directe des parties basse et haute.
+     */
+    void setAdaptiveTiming(bool enabled) { adaptiveTiming = enabled; }
+    
+    /**
+     * @brief Profil temporel appris d'une adresse et marges de décodage
+     * @param addr Adresse du périphérique
+     */
+    const adb_timing_profile& timingProfile(uint8_t addr) const { return profiles[addr & 0x0F]; }
+    
+    /**
+     * @brief Restaure un profil mémorisé (par exemple depuis une mémoire persistante)
+     */
+    void setTimingProfile(uint8_t addr, const adb_timing_profile& profile) { profiles[addr & 0x0F] = profile; }
+    
+    /**
+     * @brief Oublie le profil d'une adresse (périphérique remplacé)
+     */
+    void resetTimingProfile(uint8_t addr);
+    
+    /**
+     * @brief Filtre les parasites de la ligne pendant les réceptions (désactivé par défaut)
+     *
+     * S'applique au bit de début attendu par waitTLT, au SRQ et aux cellules
+     * lues par readDataPacket, ainsi qu'à l'écoute passive démarrée par
+     * beginSniffing. Chaque front retenu est confirmé pendant minPulseUs: à
+     * 10µs, la partie courte d'un bit reste décodable jusqu'à -30%.
+     * @param filter Largeur minimale et lectures de confirmation (bornées)
+     */
+    void setGlitchFilter(const adb_glitch_filter& filter);
+    
+    const adb_glitch_filter& glitchFilter() const { return glitch; }
+    
+    /**
+     * @brief Choisit les durées émises (ADBHostTiming::DEFAULT par défaut)
+     *
+     * ADBHostTiming::FAST raccourcit chaque commande d'environ 2% et supprime
+     * les pauses de ADBDevices entre les opérations sur le registre 3. S'applique
+     * aussi à l'émission par décalage et à ADBMultiBus.
+     * @param timing Durées à appliquer
+     * @return false si les durées sortent des tolérances (profil inchangé)
+     */
+    bool setHostTiming(const adb_host_timing& timing);
+    
+    const adb_host_timing& hostTiming() const { return emitTiming; }
+    
+    /**
+     * @brief Masque les interruptions pendant les cellules (désactivé par défaut)
+     *
+     * Une interruption au milieu d'une cellule allonge la phase émise ou
+     * retarde la date d'un front reçu. PER_BIT protège chaque cellule et
+     * sert les interruptions à chaque bit; PER_PACKET les diffère sur
+     * plusieurs cellules, au plus maxMaskedUs. Le masquage commence à la
+     * synchronisation d'une commande et au bit de début d'un paquet émis ou
+     * reçu; l'attention et Tlt restent ouverts. PER_PACKET masque aussi la
+     * scrutation du bit de début d'une réponse (240 µs après Tlt, à compter
+     * dans maxMaskedUs); PER_BIT la laisse ouverte et ne masque jamais plus
+     * de deux phases, au prix d'un bit de début daté en retard d'une routine
+     * en cours à son front. Les routines servies dans une fenêtre doivent
+     * tenir ensemble dans la partie courte d'une cellule: deux routines
+     * déclenchées coup sur coup s'y succèdent.
+     * @param policy Mode et durée maximale (bornée à IRQ_MASK_MAX)
+     */
+    void setInterruptPolicy(const adb_irq_policy& policy);
+    
+    const adb_irq_policy& interruptPolicy() const { return irqPolicy; }
+    
+    /**
+     * @brief Plus longue section masquée mesurée depuis resetStats (µs)
+     */
+    uint32_t maxMaskedUs() const { return irqMaxMaskedUs; }
+    
+    /**
+     * @brief Signale qu'une transaction vers une adresse a été répétée
+     * @param addr Adresse du périphérique
+     */
+    void countRetry(uint8_t addr);
+    
+    /**
+     * @brief Remet tous les compteurs à zéro
+     */
+    void resetStats();
+    
+    /**
+     * @brief Exporte les statistiques sous forme binaire compacte
+     *
+     * Écrit un adb_stats_header suivi d'un adb_stats_record par adresse ayant vu
+     * au moins une transaction, prêts à être transmis tels quels (série, USB, BLE).
+     * @param buffer Tampon de destination
+     * @param size Taille du tampon
+     * @return Nombre d'octets écrits (0 si le tampon ne contient pas l'en-tête)
+     */
+    size_t exportStats(uint8_t* buffer, size_t size);
+    
+    /**
+     * @brief Attache une capture des fronts de la ligne (nullptr pour l'arrêter)
+     *
+     * Les fronts émis par writeCommand et writeDataPacket, et ceux reçus par
+     * readDataPacket, sont ajoutés au tampon de la capture jusqu'à ce qu'il soit plein.
+     * @param capture Tampon de capture préalloué
+     */
+    void setCapture(ADBCapture* capture) { this->capture = capture; }
+    
+    /**
+     * @brief Reçoit les paquets de données par échantillonnage (nullptr pour revenir à readCell)
+     *
+     * Après le bit de début détecté par waitTLT, readDataPacket capture le paquet
+     * à cadence fixe puis le décode hors ligne (ADBSampleDecoder) au lieu de
+     * scruter la ligne bit par bit. Les fronts reçus ne sont alors pas capturés.
+     * @param sampler Source d'échantillons reliée à la ligne
+     */
+    void setSampler(ADBLineSampler* sampler) { this->sampler = sampler; }
+    
+    /**
+     * @brief Émet commandes et paquets de données par un périphérique de décalage (nullptr pour revenir à writeBit)
+     *
+     * writeCommand et writeDataPacket construisent le motif complet de la
+     * transaction (ADBWaveform), le confient au périphérique et rendent la main
+     * sans attendre sa fin: waitTLT et la transaction suivante n'attendent le
+     * périphérique qu'au moment de lire ou de reprendre la ligne. Un motif que
+     * la cadence de décalage ne restitue pas à ±3% n'est pas émis (BUS_FAULT).
+     * Le court-circuit à l'état haut (STUCK_HIGH) n'est plus détecté pendant
+     * l'attention.
+     * @param transmitter Périphérique relié à la ligne
+     */
+    void setTransmitter(ADBShiftDriver* transmitter) { this->transmitter = transmitter; }
+    
+    /**
+     * @brief Passe en écoute passive du bus (la ligne n'est plus jamais pilotée)
+     *
+     * La broche est placée en entrée et les transactions d'un autre hôte sont
+     * décodées par interruption dans la file de l'écoute. Tant que l'écoute est
+     * active, les commandes et réinitialisations sont refusées (BUS_FAULT).
+     * @param sniffer Écoute et sa file de transactions
+     * @return false si une autre écoute est déjà active
+     */
+    bool beginSniffing(ADBSniffer& sniffer);
+    
+    /**
+     * @brief Quitte l'écoute passive et reprend le rôle d'hôte (ligne relâchée, haute)
+     */
+    void endSniffing();
+    
+    bool isSniffing() const { return sniffer != nullptr; }
 
 private:
+    ADBProtocol::Status readSampledPacket(uint16_t* buffer, uint8_t length);
+    bool shiftWaveform();
+    void awaitTransmitter();
+
     uint8_t dataPin;        // Broche de données
     bool useADBDevices;     // Utilisation de la classe ADBDevices
+    bool responseStarted;   // Un bit de début a été détecté par waitTLT
+    bool commandAborted;    // La dernière commande n'a pas pu être émise
+    ADBProtocol::Status status; // Résultat de la dernière réception
+    ADBProtocol::LineFault fault; // Défaut de ligne mémorisé
+    adb_address_stats stats[ADBProtocol::MAX_ADDRESSES]; // Compteurs par adresse
+    uint8_t currentAddress;        // Adresse de la dernière commande
+    uint32_t busyWindowStart;      // Début de la fenêtre d'occupation (micros)
+    uint32_t busyWindowUs;         // Occupation totale dans la fenêtre courante
+    uint32_t totalBusyUsPerSecond; // Occupation totale sur la dernière fenêtre
+    adb_counter_t srqCount;        // SRQ observés sur le bus
+    ADBCapture* capture;           // Capture optionnelle des fronts
+    ADBSniffer* sniffer;           // Écoute passive en cours
+    ADBLineSampler* sampler;       // Réception par échantillonnage optionnelle
+    ADBShiftDriver* transmitter;   // Émission par décalage optionnelle
+    adb_timing_profile profiles[ADBProtocol::MAX_ADDRESSES]; // Profils temporels appris
+    bool adaptiveTiming;           // Calibration des cellules par adresse
+    uint32_t responseEdgeUs;       // Front descendant du bit de début détecté par waitTLT
+    bool responseEdgeLate;         // Scrutation interrompue juste avant ce front: date non retenue pour la calibration
+    adb_glitch_filter glitch;      // Filtre anti-parasites de la réception
+    ADBClock phaseClock;           // Échéances des phases émises et de Tlt
+    adb_host_timing emitTiming;    // Durées des phases émises
+    adb_irq_policy irqPolicy;      // Masquage des interruptions
+    bool irqMasked;                // Section masquée en cours
+    uint32_t irqMaskedSince;       // Début de la section (unités d'ADBClock)
+    uint32_t irqMaxMaskedUs;       // Plus longue section mesurée
+    
+    /**
+     * @brief Ajoute la durée d'une phase au temps d'occupation du bus à sa destruction
+     */
+    class busyScope {
+    public:
+        explicit busyScope(ADB& adb) : adb(adb), start(micros()) {}
+        ~busyScope() { adb.noteBusy(start); }
+    private:
+        ADB& adb;
+        uint32_t start;
+    };
+    
+    /**
+     * @brief Rétablit les interruptions à la fin d'une émission ou d'une réception
+     */
+    class irqScope {
+    public:
+        explicit irqScope(ADB& adb) : adb(adb) {}
+        ~irqScope() { adb.releaseInterrupts(); }
+    private:
+        ADB& adb;
+    };
+    
+    /**
+     * @brief Point de fenêtre: appelé juste après un front, avant une section critique
+     * @param nextUs Durée maximale jusqu'à la fenêtre suivante
+     */
+    void maskInterrupts(uint32_t nextUs);
+    
+    /**
+     * @brief Termine la section masquée en cours et mesure sa durée
+     */
+    void releaseInterrupts();
+    
+    /**
+     * @brief Comptabilise le temps de bus d'une phase de transaction
+     * @param startUs Début de la phase (micros)
+     */
+    void noteBusy(uint32_t startUs);
+    
+    /**
+     * @brief Clôt la fenêtre d'occupation si elle dure depuis au moins une seconde
+     */
+    void rollBusyWindow(uint32_t now);
+    
+    /**
+     * @brief Enregistre un front émis par l'hôte si une capture est attachée
+     * @param level Niveau imposé à la ligne
+     */
+    void captureEdge(bool level) {
+        if (capture) capture->edge(micros(), level);
+    }
+    
+    /**
+     * @brief Attente bornée du retour de la ligne à l'état haut
+     * @param timeout Délai maximal en microsecondes
+     * @return true si la ligne est haute
+     */
+    bool waitLineHigh(uint32_t timeout);
 
     // Méthodes de bas niveau pour la communication ADB
     void wait();           // Signal d'attente (anciennement attention)
     void sync();            // Signal de synchronisation
     void writeBit(uint16_t bit); // Écriture d'un bit
     void writeBits(uint16_t bits, uint8_t length); // Écriture de plusieurs bits
-    uint8_t readBit();      // Lecture d'un bit
+    
+    /**
+     * @brief Mesure d'une cellule de bit reçue
+     * @param edgeUs Date du front descendant qui ouvre la cellule, remplacée par celle du front qui la ferme
+     * @param maxPhaseUs Durée maximale de chaque demi-cellule
+     * @param lowUs Partie basse mesurée
+     * @param highUs Partie haute mesurée
+     * @return false si une demi-cellule dépasse maxPhaseUs
+     */
+    bool readCell(uint32_t& edgeUs, uint32_t maxPhaseUs, uint32_t& lowUs, uint32_t& highUs);
+    
+    /**
+     * @brief Confirme un changement de niveau vu à edgeUs par un vote majoritaire
+     *
+     * La ligne tirée vers le bas est en basse impédance: les parasites sont des
+     * impulsions basses sur la ligne relâchée. Un vote haut après un front
+     * descendant montre que la première lecture basse en était un: la lecture
+     * basse suivante est soumise à son tour au vote et date le front. Un vote
+     * bas après un front montant ne change pas sa date.
+     * @param level Nouveau niveau lu
+     * @param edgeUs Date de la première lecture du nouveau niveau, corrigée si besoin
+     * @return false pour un parasite (compté dans les statistiques de l'adresse)
+     */
+    bool confirmLevel(bool level, uint32_t& edgeUs);
+    
+    /**
+     * @brief Met à jour le profil d'une adresse à partir de son bit de début
+     */
+    void calibrate(adb_timing_profile& profile, uint32_t lowUs, uint32_t highUs);
+    
+    /**
+     * @brief Demi-cellule maximale d'après le profil (la plus large tolérée si non calibré)
+     */
+    uint32_t phaseLimit(const adb_timing_profile& profile) const;
+    
+    /**
+     * @brief Décide d'un bit d'après le profil et comptabilise sa marge
+     */
+    uint8_t decideBit(adb_timing_profile& profile, uint32_t lowUs, uint32_t highUs);
 };
 
 /**
@@ -156,10 +819,20 @@ public:
      * @brief Constructeur avec référence à un objet ADB
      * @param adb Référence à l'instance ADB utilisée pour la communication
      */
-    explicit ADBDevices(ADB& adb) : adb(adb) {}
+    explicit ADBDevices(ADB& adb)
+        : adb(adb), shadows{}, pendingLEDs(0), ledsPending(false), state{},
+          presence{}, presenceConfig{3, 500, 100, 5000, 20000},
+          presenceCallback(nullptr), presenceCursor(0), budgetWindowStart(0), budgetUsedUs(0),
+          health{}, healthConfig{20, 50, 5000}, nextRecoveryAt(0), errorWindowStart(0), errorCount(0),
+          cache(nullptr), cacheSavedAt(0), boot{}, starting(false),
+          latency(nullptr), recorder(nullptr), retryConfig{0, 6000, 20000, false},
+          retryWindowStart(0), retryUsedUs(0) {}
 
     /**
      * @brief Initialisation d'un périphérique ADB
+     *
+     * Relit toujours le registre 3 (copie locale ignorée): la présence
+     * rendue correspond à une réponse du périphérique.
      * @param address Adresse du périphérique
      * @param handler_id Identifiant du gestionnaire
      * @param present Référence pour indiquer si le périphérique est présent
@@ -183,12 +856,189 @@ public:
     
     /**
      * @brief Configuration des LEDs du clavier
+     *
+     * L'écriture est différée au prochain créneau libre du bus (fin de la
+     * prochaine lecture ou appel à flushPendingWrites()), et omise si les LEDs
+     * ont déjà l'état demandé.
+     *
      * @param scroll État de la LED de défilement
      * @param caps État de la LED de verrouillage majuscule
      * @param num État de la LED de verrouillage numérique
      */
     void keyboardWriteLEDs(bool num, bool caps, bool scrool);
     
+    /**
+     * @brief Envoie les écritures différées (LEDs) sur le bus
+     * @return true si une écriture a été émise
+     */
+    bool flushPendingWrites();
+    
+    /**
+     * @brief Indique si des écritures sont en attente d'un créneau libre
+     */
+    bool hasPendingWrites() const { return ledsPending; }
+    
+    /**
+     * @brief Accès à la copie locale des registres d'un périphérique
+     * @param addr Adresse du périphérique
+     */
+    const adb_register_shadow& registerShadow(uint8_t addr) const { return shadows[addr & 0x0F]; }
+    
+    /**
+     * @brief Invalide la copie locale des registres d'un périphérique
+     * @param addr Adresse du périphérique
+     */
+    void invalidateShadow(uint8_t addr);
+    
+    /**
+     * @brief Invalide toutes les copies locales (à appeler après ADB::reset())
+     */
+    void invalidateAllShadows();
+    
+    /**
+     * @brief Copie cohérente du dernier état décodé, sans transaction sur le bus
+     *
+     * Peut être appelée depuis une autre tâche ou un autre cœur que celui qui
+     * effectue les lectures.
+     *
+     * @param out Structure recevant l'état publié
+     */
+    void readSnapshot(adb_device_snapshot& out) const { published.read(out); }
+    
+    /**
+     * @brief Version non bloquante de readSnapshot()
+     * @param out Structure recevant l'état publié
+     * @return true si la copie est cohérente
+     */
+    bool tryReadSnapshot(adb_device_snapshot& out) const { return published.tryRead(out); }
+    
+    /**
+     * @brief Place une adresse sous la surveillance du gestionnaire de présence
+     *
+     * Le périphérique est considéré absent jusqu'au premier sondage réussi,
+     * effectué par servicePresence().
+     *
+     * @param addr Adresse du périphérique
+     * @param handler_id Handler ID appliqué par initializeDevice() à chaque apparition (0 = inchangé)
+     */
+    void monitorDevice(uint8_t addr, uint8_t handler_id = 0);
+    
+    /**
+     * @brief Définit la fonction appelée à chaque apparition ou disparition
+     */
+    void setPresenceCallback(ADBPresenceCallback callback) { presenceCallback = callback; }
+    
+    /**
+     * @brief Modifie les paramètres du gestionnaire de présence
+     */
+    void setPresenceConfig(const adb_presence_config& config) { presenceConfig = config; }
+    
+    /**
+     * @brief Indique si un périphérique surveillé est présent
+     * @param addr Adresse du périphérique
+     */
+    bool isDevicePresent(uint8_t addr) const { return presence[addr & 0x0F].present; }
+    
+    /**
+     * @brief Sonde au plus une adresse surveillée, dans la limite du budget de bus
+     *
+     * À appeler à chaque itération de la boucle principale. Les périphériques
+     * présents restés silencieux sont vérifiés par un Talk registre 3 ; les
+     * adresses vides sont re-sondées avec un backoff exponentiel.
+     *
+     * @return true si une transaction a été émise
+     */
+    bool servicePresence();
+    
+    /**
+     * @brief Écrit la table persistante modifiée, au plus une fois par CACHE_SAVE_INTERVAL_MS
+     *
+     * Une adresse n'en est retirée qu'après un intervalle entier sans réponse.
+     */
+    void serviceCache();
+    
+    /**
+     * @brief Surveille l'état électrique du bus et tente de le récupérer
+     *
+     * Une ligne bloquée (basse ou haute) ou trop bruitée fait passer le bus en
+     * mode dégradé. Les tentatives de récupération (ADB::reset puis
+     * ré-énumération des périphériques surveillés) sont espacées par un délai
+     * croissant.
+     *
+     * @return true si une tentative de récupération a été effectuée
+     */
+    bool serviceBusHealth();
+    
+    /**
+     * @brief Métriques de santé du bus
+     */
+    const adb_bus_health& busHealth() const { return health; }
+    
+    /**
+     * @brief Modifie les paramètres de surveillance du bus
+     */
+    void setHealthConfig(const adb_health_config& config) { healthConfig = config; }
+    
+    /**
+     * @brief Active la reprise des lectures en erreur de bit (désactivée par défaut)
+     *
+     * Concerne les lectures du clavier, de la souris et du registre 3. Une
+     * reprise suit la fin de la réponse interrompue et l'écart minimal
+     * entre deux transactions (Tlt). Avec readTwice, les registres 2 et 3
+     * sont lus deux fois et une différence est reprise comme une erreur: les
+     * bits réécrits par une mise à jour du registre 3 ne reposent plus sur
+     * une réception unique. La vérification qui suit l'écriture reste une
+     * lecture simple, comparée à la valeur écrite: une mise à jour coûte 4
+     * transactions sans copie locale valide, 2 avec.
+     */
+    void setRetryConfig(const adb_retry_config& config) { retryConfig = config; }
+    
+    /**
+     * @brief Démarre la détection non bloquante des périphériques surveillés
+     *
+     * À appeler après ADB::init() et monitorDevice(). Les adresses sont ensuite
+     * sondées par service(), clavier en premier, sans délai entre les
+     * transactions ni limite de budget. Si un cache est fourni et contient une
+     * table valide, les périphériques mémorisés sont immédiatement considérés
+     * présents puis vérifiés en arrière-plan.
+     *
+     * @param deviceCache Table persistante optionnelle, écrite en fin de démarrage puis au plus une
+     *        fois par minute par service() (un périphérique n'en sort qu'après une minute d'absence)
+     */
+    void beginStartup(ADBDeviceCache* deviceCache = nullptr);
+    
+    /**
+     * @brief Active l'horodatage des interrogations du registre 0 (clavier et souris)
+     *
+     * Le pont doit appeler ADBLatencyTracker::reportSent() après chaque rapport HID.
+     * @param tracker Suivi des latences, nullptr pour désactiver
+     */
+    void setLatencyTracker(ADBLatencyTracker* tracker) { latency = tracker; }
+    
+    /**
+     * @brief Consigne les registres 0 reçus du clavier et de la souris et les écritures Listen
+     * @param log Journal d'événements, nullptr pour désactiver
+     */
+    void setRecorder(ADBRecorder* log) { recorder = log; }
+    
+    /**
+     * @brief Indique si la phase de démarrage est terminée
+     */
+    bool isStartupComplete() const { return boot.complete; }
+    
+    /**
+     * @brief Durées des phases de démarrage
+     */
+    const adb_boot_timings& bootTimings() const { return boot; }
+    
+    /**
+     * @brief Tâches de fond à appeler à chaque itération de la boucle principale
+     *
+     * Enchaîne la surveillance du bus, les écritures différées, le suivi de présence et
+     * l'écriture de la table persistante.
+     */
+    void service();
+    
     /**
      * @brief Lecture des données de la souris
      * @param error Pointeur pour indiquer si une erreur s'est produite
@@ -208,6 +1058,105 @@ public:
 
 private:
     ADB& adb; // Référence à l'objet ADB utilisé pour la communication
+    adb_register_shadow shadows[ADBProtocol::MAX_ADDRESSES]; // Copies des registres 2 et 3
+    uint16_t pendingLEDs;   // Valeur du registre 2 en attente d'écriture
+    bool ledsPending;       // Une écriture des LEDs est en attente
+    adb_device_snapshot state;                   // État décodé en cours de construction
+    ADBSeqlock<adb_device_snapshot> published;   // État publié pour les lecteurs
+    adb_presence presence[ADBProtocol::MAX_ADDRESSES]; // Suivi de présence par adresse
+    adb_presence_config presenceConfig;          // Paramètres du suivi de présence
+    ADBPresenceCallback presenceCallback;        // Notification des changements de présence
+    uint8_t presenceCursor;                      // Prochaine adresse examinée (tourniquet)
+    uint32_t budgetWindowStart;                  // Début de la fenêtre de budget (millis)
+    uint32_t budgetUsedUs;                       // Temps de bus consommé par les sondages
+    adb_bus_health health;                       // Métriques de santé du bus
+    adb_health_config healthConfig;              // Paramètres de surveillance du bus
+    uint32_t nextRecoveryAt;                     // Date de la prochaine tentative de récupération
+    uint32_t errorWindowStart;                   // Début de la fenêtre de comptage des erreurs
+    uint16_t errorCount;                         // Erreurs de bit dans la fenêtre courante
+    ADBDeviceCache* cache;                       // Table persistante des périphériques
+    uint32_t cacheSavedAt;                       // Dernière écriture de la table (millis)
+    adb_boot_timings boot;                       // Durées des phases de démarrage
+    bool starting;                               // Phase de démarrage en cours
+    ADBLatencyTracker* latency;                  // Suivi optionnel des latences
+    ADBRecorder* recorder;                       // Journal optionnel des événements
+    adb_retry_config retryConfig;                // Reprise des lectures en erreur
+    uint32_t retryWindowStart;                   // Début de la fenêtre de budget des reprises (millis)
+    uint32_t retryUsedUs;                        // Temps de bus consommé par les reprises
+    
+    /**
+     * @brief Talk d'un registre de 16 bits, repris selon retryConfig
+     * @param addr Adresse du périphérique
+     * @param reg Registre lu
+     * @param value Valeur reçue
+     * @param stable Registre sans effet de bord à la lecture (lu deux fois si readTwice)
+     * @return true si la valeur est fiable
+     */
+    bool talkRegister(uint8_t addr, uint8_t reg, uint16_t* value, bool stable);
+    
+    /**
+     * @brief Met à jour le suivi de présence après une réception
+     * @param addr Adresse interrogée
+     * @param alwaysAnswers Le registre interrogé répond toujours (registres 2 et 3)
+     */
+    void notePresence(uint8_t addr, bool alwaysAnswers);
+    
+    /**
+     * @brief Applique un handler ID, sans relecture si la copie locale du registre 3 est valide
+     * @param present Mise à jour vérifiée
+     * @return true si la mise à jour a réussi
+     */
+    bool applyHandler(uint8_t address, uint8_t handler_id, bool& present);
+    
+    /**
+     * @brief Vérifie en arrière-plan un périphérique restauré depuis le cache
+     */
+    void verifyCachedDevice(uint8_t addr);
+    
+    /**
+     * @brief Met à jour les durées et la fin de la phase de démarrage
+     */
+    void updateStartup();
+    
+    /**
+     * @brief Pause entre deux opérations sur le registre 3 (aucune pendant le démarrage)
+     */
+    void settle();
+    
+    /**
+     * @brief Ré-énumère les périphériques surveillés après une réinitialisation du bus
+     */
+    void reenumerateDevices();
+    
+    /**
+     * @brief Sonde une adresse par un Talk registre 3 en comptant son coût
+     * @return true si le périphérique a répondu
+     */
+    bool probeDevice(uint8_t addr);
+    
+    /**
+     * @brief Gère l'apparition d'un périphérique (initialisation et notification)
+     */
+    void markPresent(uint8_t addr);
+    
+    /**
+     * @brief Gère la disparition d'un périphérique (invalidation et notification)
+     */
+    void markLost(uint8_t addr);
+    
+    /**
+     * @brief Met à jour le bitmap des touches
+     * @param code Code de touche ADB
+     * @param released Indicateur de relâchement
+     */
+    void updateKeyState(uint8_t code, bool released);
+    
+    /**
+     * @brief Publie l'état courant vers les lecteurs
+     * @param addr Adresse du périphérique concerné
+     * @param present Présence du périphérique
+     */
+    void publishState(uint8_t addr, bool present = true);
     
     /**
      * @brief Lecture du registre 3 d'un périphérique
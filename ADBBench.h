@@ -0,0 +1,257 @@
+/**
+ * @file ADBBench.h
+ * @brief Mesure du coût CPU et de l'occupation du bus des opérations ADB
+ *
+ * Chaque opération est répétée puis résumée par: cycles CPU consommés
+ * (adbCycleCount), durée de l'appel, temps d'occupation de la ligne et part
+ * bloquante de l'appel (temps de ligne / durée). L'occupation est mesurée par
+ * une interruption sur la broche de données (premier au dernier front de
+ * l'appel); elle fonctionne à l'identique sur cible et sur le simulateur natif.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_BENCH_h
+#define ADB_BENCH_h
+
+#include <Arduino.h>
+#include "ADB.h"
+#include "ADBPlatform.h"
+
+/**
+ * @brief Résultat d'une série de mesures
+ */
+struct adb_bench_result {
+    const char* name;          // Nom de l'opération
+    uint16_t iterations;       // Nombre d'appels mesurés
+    uint32_t cyclesAvg;        // Cycles CPU moyens par appel
+    uint32_t cyclesMin;        // Cycles CPU minimum
+    uint32_t cyclesMax;        // Cycles CPU maximum
+    uint32_t callUs;           // Durée moyenne d'un appel (µs)
+    uint32_t busUs;            // Occupation moyenne de la ligne (µs)
+    uint8_t blockingPercent;   // Part de l'appel liée aux temporisations du bus
+};
+
+/**
+ * @brief Banc de mesure des opérations de la bibliothèque
+ */
+class ADBBench {
+public:
+    /**
+     * @brief Constructeur
+     * @param dataPin Broche de données ADB (surveillée pendant les mesures)
+     */
+    explicit ADBBench(uint8_t dataPin) : dataPin(dataPin), overhead(0) {}
+
+    /**
+     * @brief Active le compteur de cycles, la sonde de bus et calibre la mesure à vide
+     * @param busProbe Surveille la ligne par interruption (ajoute quelques µs par front)
+     */
+    void begin(bool busProbe = true) {
+        adbCycleCounterInit();
+        probe().pin = dataPin;
+        if (busProbe) attachInterrupt(digitalPinToInterrupt(dataPin), onEdge, CHANGE);
+
+        // Coût de la mesure elle-même, retranché des résultats
+        overhead = 0;
+        adb_bench_result empty = run("", 32, [] {});
+        overhead = empty.cyclesMin;
+    }
+
+    /**
+     * @brief Retire la sonde de bus
+     */
+    void end() {
+        detachInterrupt(digitalPinToInterrupt(dataPin));
+    }
+
+    /**
+     * @brief Mesure une opération
+     * @param name Nom affiché
+     * @param iterations Nombre d'appels
+     * @param op Opération mesurée
+     */
+    template <typename Op>
+    adb_bench_result run(const char* name, uint16_t iterations, Op op) {
+        return run(name, iterations, [] {}, op);
+    }
+
+    /**
+     * @brief Mesure une opération précédée d'une préparation non mesurée
+     * @param setup Préparation exécutée avant chaque appel (hors mesure)
+     */
+    template <typename Setup, typename Op>
+    adb_bench_result run(const char* name, uint16_t iterations, Setup setup, Op op) {
+        adb_bench_result result = {name, iterations, 0, 0xFFFFFFFF, 0, 0, 0, 0};
+        uint64_t cyclesTotal = 0;
+        uint64_t callTotal = 0;
+        uint64_t busTotal = 0;
+
+        for (uint16_t i = 0; i < iterations; i++) {
+            setup();
+            probe().reset();
+
+            uint32_t startUs = micros();
+            uint32_t startCycles = adbCycleCount();
+            op();
+            uint32_t cycles = adbCycleCount() - startCycles;
+            uint32_t callUs = micros() - startUs;
+
+            cycles = cycles > overhead ? cycles - overhead : 0;
+            cyclesTotal += cycles;
+            callTotal += callUs;
+            busTotal += probe().span();
+            if (cycles < result.cyclesMin) result.cyclesMin = cycles;
+            if (cycles > result.cyclesMax) result.cyclesMax = cycles;
+        }
+
+        if (iterations > 0) {
+            result.cyclesAvg = static_cast<uint32_t>(cyclesTotal / iterations);
+            result.callUs = static_cast<uint32_t>(callTotal / iterations);
+            result.busUs = static_cast<uint32_t>(busTotal / iterations);
+        }
+        if (callTotal > 0) {
+            uint64_t percent = busTotal * 100 / callTotal;
+            result.blockingPercent = static_cast<uint8_t>(percent > 100 ? 100 : percent);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Mesure les opérations publiques de la bibliothèque
+     *
+     * Le clavier doit répondre à l'adresse 2 et la souris à l'adresse 3.
+     * @param adb Couche physique
+     * @param devices Couche périphériques
+     * @param iterations Nombre d'appels par opération
+     */
+    void runProtocolSuite(ADB& adb, ADBDevices& devices, uint16_t iterations = 100) {
+        using namespace ADBProtocol;
+        const uint8_t keyboard = ADBKey::Address::KEYBOARD;
+        bool error = false;
+        uint16_t value = 0;
+
+        printHeader();
+
+        // Commande seule: Flush, sans réponse du périphérique
+        print(run("writeCommand", iterations, [&] {
+            adb.writeCommand(CMD_FLUSH | ADDRESS(keyboard));
+        }));
+
+        // Lecture d'un paquet après une commande Talk R3 (commande hors mesure)
+        print(run("readDataPacket", iterations, [&] {
+            adb.writeCommand(CMD_TALK | ADDRESS(keyboard) | REGISTER(3));
+            adb.waitTLT(true);
+        }, [&] {
+            adb.readDataPacket(&value, 16);
+        }));
+
+        print(run("keyboardReadKeyPress", iterations, [&] {
+            devices.keyboardReadKeyPress(&error);
+        }));
+
+        print(run("mouseReadData", iterations, [&] {
+            devices.mouseReadData(&error);
+        }));
+
+        // Alternance des handlers 2 et 3 du clavier étendu, copie locale invalidée
+        // pour forcer le parcours complet (lecture, écriture, vérification)
+        adb_data<adb_register3> reg3 = {0};
+        reg3.data.device_handler_id = 0x02;
+        print(run("deviceUpdateRegister3", iterations, [&] {
+            devices.invalidateShadow(keyboard);
+            reg3.data.device_handler_id = (reg3.data.device_handler_id == 0x02) ? 0x03 : 0x02;
+        }, [&] {
+            devices.deviceUpdateRegister3(keyboard, reg3, REG3_HANDLER_MASK, &error);
+        }));
+
+        // Conversion seule, sans accès au bus
+        uint8_t code = 0;
+        volatile uint8_t sink = 0;
+        print(run("ADBKeymap::toHID", iterations, [&] {
+            sink = ADBKeymap::toHID(code);
+            code = (code + 1) & 0x7F;
+        }));
+        (void)sink;
+    }
+
+    /**
+     * @brief Imprime l'en-tête du tableau de résultats
+     */
+    static void printHeader() {
+        Serial.print(F("Compteur de cycles: "));
+        Serial.println(F(ADB_CYCLE_COUNTER_NAME));
+        Serial.println(F("operation               cycles moy       min       max  appel(us)  bus(us)  bloquant"));
+    }
+
+    /**
+     * @brief Imprime une ligne de résultats
+     */
+    static void print(const adb_bench_result& r) {
+        Serial.print(r.name);
+        for (size_t i = strlen(r.name); i < 22; i++) Serial.print(' ');
+        printColumn(r.cyclesAvg, 12);
+        printColumn(r.cyclesMin, 10);
+        printColumn(r.cyclesMax, 10);
+        printColumn(r.callUs, 11);
+        printColumn(r.busUs, 9);
+        printColumn(r.blockingPercent, 9);
+        Serial.println('%');
+    }
+
+private:
+    /**
+     * @brief État de la sonde de bus, partagé avec l'interruption
+     */
+    struct probeState {
+        uint8_t pin;
+        volatile bool active;
+        volatile uint32_t firstEdge;
+        volatile uint32_t lastEdge;
+
+        void reset() {
+            adbMaskInterrupts();
+            active = false;
+            firstEdge = 0;
+            lastEdge = 0;
+            adbUnmaskInterrupts();
+        }
+
+        uint32_t span() {
+            adbMaskInterrupts();
+            uint32_t us = active ? lastEdge - firstEdge : 0;
+            adbUnmaskInterrupts();
+            return us;
+        }
+    };
+
+    static void printColumn(uint32_t value, uint8_t width) {
+        // Alignement à droite sans formatage printf (indisponible pour %lu sur certaines cibles)
+        uint8_t digits = 1;
+        for (uint32_t v = value; v >= 10; v /= 10) digits++;
+        for (uint8_t i = digits; i < width; i++) Serial.print(' ');
+        Serial.print(value);
+    }
+
+    static probeState& probe() {
+        static probeState instance = {0, false, 0, 0};
+        return instance;
+    }
+
+    static void onEdge() {
+        probeState& p = probe();
+        uint32_t now = micros();
+        if (!p.active) {
+            p.firstEdge = now;
+            p.active = true;
+        }
+        p.lastEdge = now;
+    }
+
+    uint8_t dataPin;
+    uint32_t overhead;
+};
+
+#endif // ADB_BENCH_h
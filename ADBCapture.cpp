@@ -0,0 +1,86 @@
+/**
+ * @file ADBCapture.cpp
+ * @brief Export VCD et binaire des captures de la ligne ADB
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBCapture.h"
+
+namespace {
+
+// Marge avant le premier front pour montrer la ligne au repos
+constexpr uint32_t VCD_LEAD_US = 10;
+
+void writeLE16(Print& out, uint16_t value) {
+    out.write(static_cast<uint8_t>(value));
+    out.write(static_cast<uint8_t>(value >> 8));
+}
+
+void writeLE32(Print& out, uint32_t value) {
+    writeLE16(out, static_cast<uint16_t>(value));
+    writeLE16(out, static_cast<uint16_t>(value >> 16));
+}
+
+uint32_t readLE32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+} // namespace
+
+void ADBCapture::writeVCD(Print& out) const {
+    out.println(F("$timescale 1us $end"));
+    out.println(F("$scope module adb $end"));
+    out.println(F("$var wire 1 ! data $end"));
+    out.println(F("$upscope $end"));
+    out.println(F("$enddefinitions $end"));
+    out.println(F("#0"));
+    out.println(F("1!"));
+
+    if (edgeCount == 0) return;
+
+    // Dates relatives au premier front (les écarts restent justes après un débordement de micros)
+    uint32_t origin = edgeTime(0) - VCD_LEAD_US;
+    for (uint16_t i = 0; i < edgeCount; i++) {
+        out.print('#');
+        out.println((edgeTime(i) - origin) & 0x7FFFFFFFUL);
+        out.print(edgeLevel(i) ? '1' : '0');
+        out.println('!');
+    }
+}
+
+size_t ADBCapture::writeBinary(Print& out) const {
+    out.write('A');
+    out.write('D');
+    out.write('B');
+    out.write('C');
+    out.write(FORMAT_VERSION);
+    out.write(static_cast<uint8_t>(0));
+    writeLE16(out, edgeCount);
+    for (uint16_t i = 0; i < edgeCount; i++) {
+        writeLE32(out, edges[i]);
+    }
+    return HEADER_SIZE + static_cast<size_t>(edgeCount) * sizeof(uint32_t);
+}
+
+bool ADBCapture::loadBinary(const uint8_t* data, size_t size) {
+    if (size < HEADER_SIZE || data[0] != 'A' || data[1] != 'D' || data[2] != 'B' || data[3] != 'C' ||
+        data[4] != FORMAT_VERSION) {
+        return false;
+    }
+
+    uint16_t stored = static_cast<uint16_t>(data[6] | (data[7] << 8));
+    if (size < HEADER_SIZE + static_cast<size_t>(stored) * sizeof(uint32_t)) return false;
+
+    clear();
+    for (uint16_t i = 0; i < stored && i < capacity; i++) {
+        edges[i] = readLE32(data + HEADER_SIZE + i * sizeof(uint32_t));
+        edgeCount++;
+    }
+    dropped = stored - edgeCount;
+    if (edgeCount > 0) lastLevel = edgeLevel(edgeCount - 1);
+    return true;
+}
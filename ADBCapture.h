@@ -0,0 +1,116 @@
+/**
+ * @file ADBCapture.h
+ * @brief Capture des fronts de la ligne ADB et export VCD
+ *
+ * Lorsqu'une capture est attachée (ADB::setCapture), ADB enregistre chaque
+ * front émis (writeCommand, writeDataPacket) et reçu (readDataPacket) dans un
+ * tampon préalloué. Les fronts reçus réutilisent les dates déjà mesurées par
+ * readCell: la capture n'ajoute aucune lecture de la ligne et ne modifie pas les
+ * temporisations de réception. Chaque front émis coûte une lecture de micros().
+ *
+ * Le tampon se restitue en VCD (GTKWave, PulseView...) ou sous une forme
+ * binaire compacte, convertible en VCD sur l'hôte (capture2vcd).
+ *
+ * Format binaire (petit-boutiste):
+ *   "ADBC", version (1 octet), réservé (1 octet), nombre de fronts (2 octets),
+ *   puis un mot de 32 bits par front: (date en µs << 1) | niveau.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_CAPTURE_h
+#define ADB_CAPTURE_h
+
+#include <Arduino.h>
+#include <cstdint>
+
+/**
+ * @brief Tampon de fronts de la ligne ADB
+ */
+class ADBCapture {
+public:
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+
+    /**
+     * @brief Constructeur
+     * @param storage Tampon préalloué (un mot par front)
+     * @param capacity Nombre de fronts que peut contenir le tampon
+     */
+    ADBCapture(uint32_t* storage, uint16_t capacity)
+        : edges(storage), capacity(capacity), edgeCount(0), dropped(0), lastLevel(true) {}
+
+    /**
+     * @brief Vide le tampon (la ligne est supposée au repos, haute)
+     */
+    void clear() {
+        edgeCount = 0;
+        dropped = 0;
+        lastLevel = true;
+    }
+
+    /**
+     * @brief Enregistre un front (ignoré si le niveau ne change pas)
+     * @param us Date du front (micros)
+     * @param level Nouveau niveau de la ligne
+     */
+    void edge(uint32_t us, bool level) {
+        if (level == lastLevel) return;
+        lastLevel = level;
+        if (edgeCount < capacity) {
+            edges[edgeCount++] = (us << 1) | (level ? 1u : 0u);
+        } else {
+            dropped++;
+        }
+    }
+
+    uint16_t count() const { return edgeCount; }
+    uint16_t droppedEdges() const { return dropped; }
+    bool isFull() const { return edgeCount >= capacity; }
+    uint32_t edgeTime(uint16_t index) const { return edges[index] >> 1; }
+    bool edgeLevel(uint16_t index) const { return edges[index] & 0x01; }
+
+    /**
+     * @brief Écrit la capture au format VCD (résolution 1µs, origine au premier front)
+     * @param out Sortie (Serial, fichier...)
+     */
+    void writeVCD(Print& out) const;
+
+    /**
+     * @brief Écrit la capture au format binaire compact
+     * @return Nombre d'octets écrits
+     */
+    size_t writeBinary(Print& out) const;
+
+    /**
+     * @brief Recharge une capture binaire (outil de conversion sur l'hôte)
+     * @param data Données au format binaire
+     * @param size Taille des données
+     * @return false si l'en-tête est invalide
+     */
+    bool loadBinary(const uint8_t* data, size_t size);
+
+private:
+    uint32_t* edges;
+    uint16_t capacity;
+    uint16_t edgeCount;
+    uint16_t dropped;
+    bool lastLevel;
+};
+
+/**
+ * @brief Capture avec tampon intégré
+ * @tparam N Nombre de fronts (une transaction Talk complète en compte environ 44)
+ */
+template <uint16_t N>
+class ADBCaptureBuffer : public ADBCapture {
+public:
+    ADBCaptureBuffer() : ADBCapture(storage, N), storage{} {}
+
+private:
+    uint32_t storage[N];
+};
+
+#endif // ADB_CAPTURE_h
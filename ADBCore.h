@@ -10,7 +10,20 @@
 #include "HIDTables.h"      // Définitions des codes HID
 #include "ADBKeyCodes.h"    // Définitions des constantes ADB
 #include "ADBKeymap.h"      // Mappage ADB vers HID
+#include "ADBSnapshot.h"    // Publication de l'état des périphériques
+#include "ADBLatency.h"     // Histogrammes de latence événement -> rapport HID
+#include "ADBCapture.h"     // Capture des fronts de la ligne (VCD)
 #include "ADB.h"            // Interface principale du protocole ADB
+#include "ADBDeviceCache.h" // Table persistante des périphériques
+#include "ADBFrameDecoder.h" // Décodage des trames à partir des fronts
+#include "ADBRecorder.h"    // Journal binaire des événements
+#include "ADBHIDReport.h"   // Construction des rapports HID
+#include "ADBSniffer.h"     // Écoute passive du bus
+#include "ADBDeviceEmulator.h" // Mode périphérique (clavier et souris émulés)
+#include "ADBSampleDecoder.h" // Réception par échantillonnage (décodage mot par mot)
+#include "ADBWaveform.h"      // Émission par décalage (motif SPI/DMA)
+#include "ADBMultiBus.h"      // Plusieurs bus entrelacés sur un seul cœur
+#include "ADBTiming.h"        // Échéances absolues des phases émises
 #include "ADBUtils.h"       // Utilitaires supplémentaires
 
 #endif // ADB_CORE_h
@@ -0,0 +1,127 @@
+/**
+ * @file ADBDeviceCache.cpp
+ * @brief Implémentation de la table persistante des périphériques ADB
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <stddef.h>
+#include "ADBDeviceCache.h"
+#include "ADBPlatform.h"
+
+// Sélection du support persistant selon la plateforme
+#if defined(ADB_PLATFORM_ESP32)
+    #include <Preferences.h>
+    #define ADB_CACHE_NVS
+#elif defined(ADB_PLATFORM_AVR) || defined(ADB_PLATFORM_STM32) || defined(ADB_PLATFORM_TEENSY)
+    #include <EEPROM.h>
+    #define ADB_CACHE_EEPROM
+#endif
+
+uint8_t ADBDeviceCache::checksum(const record& rec) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&rec);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < offsetof(record, checksum); i++) {
+        sum = static_cast<uint8_t>((sum << 1) | (sum >> 7)) ^ bytes[i];
+    }
+    return sum;
+}
+
+bool ADBDeviceCache::readRecord(record& rec) {
+#if defined(ADB_CACHE_NVS)
+    Preferences prefs;
+    if (!prefs.begin("adb", true)) return false;
+    size_t length = prefs.getBytes("devices", &rec, sizeof(rec));
+    prefs.end();
+    return length == sizeof(rec);
+#elif defined(ADB_CACHE_EEPROM)
+    EEPROM.get(offset, rec);
+    return true;
+#else
+    // Aucune mémoire persistante: la table ne survit pas au redémarrage
+    (void)rec;
+    return false;
+#endif
+}
+
+void ADBDeviceCache::writeRecord(const record& rec) {
+#if defined(ADB_CACHE_NVS)
+    Preferences prefs;
+    if (!prefs.begin("adb", false)) return;
+    prefs.putBytes("devices", &rec, sizeof(rec));
+    prefs.end();
+#elif defined(ADB_CACHE_EEPROM)
+    // EEPROM.put n'écrit que les octets modifiés
+    EEPROM.put(offset, rec);
+#else
+    (void)rec;
+#endif
+}
+
+bool ADBDeviceCache::load() {
+    record rec;
+    entryCount = 0;
+    dirty = false;
+
+    if (!readRecord(rec)) return false;
+    if (rec.magic != MAGIC || rec.version != VERSION || rec.count > MAX_DEVICES) return false;
+    if (rec.checksum != checksum(rec)) return false;
+
+    entryCount = rec.count;
+    memcpy(entries, rec.entries, sizeof(entries));
+    return true;
+}
+
+bool ADBDeviceCache::save() {
+    if (!dirty) return false;
+
+    record rec = {};
+    rec.magic = MAGIC;
+    rec.version = VERSION;
+    rec.count = entryCount;
+    memcpy(rec.entries, entries, sizeof(entries));
+    rec.checksum = checksum(rec);
+
+    writeRecord(rec);
+    dirty = false;
+    return true;
+}
+
+void ADBDeviceCache::set(uint8_t address, uint8_t handlerId) {
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (entries[i].address == address) {
+            if (entries[i].handlerId != handlerId) {
+                entries[i].handlerId = handlerId;
+                dirty = true;
+            }
+            return;
+        }
+    }
+
+    if (entryCount < MAX_DEVICES) {
+        entries[entryCount].address = address;
+        entries[entryCount].handlerId = handlerId;
+        entryCount++;
+        dirty = true;
+    }
+}
+
+void ADBDeviceCache::remove(uint8_t address) {
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (entries[i].address == address) {
+            entries[i] = entries[--entryCount];
+            entries[entryCount] = adb_cached_device{};
+            dirty = true;
+            return;
+        }
+    }
+}
+
+void ADBDeviceCache::clear() {
+    if (entryCount == 0) return;
+    entryCount = 0;
+    memset(entries, 0, sizeof(entries));
+    dirty = true;
+}
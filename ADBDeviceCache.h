@@ -0,0 +1,98 @@
+/**
+ * @file ADBDeviceCache.h
+ * @brief Mémorisation persistante de la table des périphériques ADB
+ *
+ * La dernière table connue (adresse, handler ID) est conservée en NVS (ESP32)
+ * ou en EEPROM (AVR, STM32, Teensy). Au redémarrage, ADBDevices peut ainsi
+ * considérer les périphériques comme présents sans attendre leur détection,
+ * puis les vérifier en arrière-plan.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_DEVICE_CACHE_h
+#define ADB_DEVICE_CACHE_h
+
+#include <Arduino.h>
+#include <cstdint>
+
+/**
+ * @brief Entrée de la table des périphériques
+ */
+struct adb_cached_device {
+    uint8_t address;    // Adresse du périphérique
+    uint8_t handlerId;  // Handler ID appliqué au périphérique (0 = par défaut)
+};
+
+/**
+ * @brief Table des périphériques persistante
+ */
+class ADBDeviceCache {
+public:
+    static constexpr uint8_t MAX_DEVICES = 8;
+
+    /**
+     * @brief Constructeur
+     * @param offset Position de l'enregistrement en EEPROM (ignoré sur ESP32)
+     */
+    explicit ADBDeviceCache(uint16_t offset = 0) : offset(offset), entryCount(0), dirty(false), entries{} {}
+
+    /**
+     * @brief Charge la table depuis la mémoire persistante
+     * @return true si un enregistrement valide a été trouvé
+     */
+    bool load();
+
+    /**
+     * @brief Enregistre la table si elle a été modifiée depuis le dernier chargement
+     * @return true si la mémoire persistante a été écrite
+     */
+    bool save();
+
+    /**
+     * @brief Ajoute ou met à jour un périphérique
+     * @param address Adresse du périphérique
+     * @param handlerId Handler ID du périphérique
+     */
+    void set(uint8_t address, uint8_t handlerId);
+
+    /**
+     * @brief Retire un périphérique de la table
+     * @param address Adresse du périphérique
+     */
+    void remove(uint8_t address);
+
+    /**
+     * @brief Vide la table
+     */
+    void clear();
+
+    uint8_t count() const { return entryCount; }
+    const adb_cached_device& device(uint8_t index) const { return entries[index]; }
+
+private:
+    // Format de l'enregistrement persistant
+    static constexpr uint8_t MAGIC = 0xAD;
+    static constexpr uint8_t VERSION = 1;
+
+    struct record {
+        uint8_t magic;
+        uint8_t version;
+        uint8_t count;
+        adb_cached_device entries[MAX_DEVICES];
+        uint8_t checksum;
+    };
+
+    uint16_t offset;
+    uint8_t entryCount;
+    bool dirty;
+    adb_cached_device entries[MAX_DEVICES];
+
+    static uint8_t checksum(const record& rec);
+    bool readRecord(record& rec);
+    void writeRecord(const record& rec);
+};
+
+#endif // ADB_DEVICE_CACHE_h
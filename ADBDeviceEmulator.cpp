@@ -0,0 +1,598 @@
+/**
+ * @file ADBDeviceEmulator.cpp
+ * @brief Implémentation du mode périphérique
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBDeviceEmulator.h"
+#include "ADBKeyCodes.h"
+
+using namespace ADBProtocol;
+
+namespace {
+    constexpr uint8_t BIT_LOW_THRESHOLD = 50;   // Bit à 1 si l'état bas dure moins (µs)
+    constexpr uint8_t BIT_ONE_LOW = 35;         // Émission: état bas d'un bit à 1 (µs)
+    constexpr uint8_t BIT_ZERO_LOW = 65;        // Émission: état bas d'un bit à 0 (µs)
+    constexpr uint8_t BIT_CELL = 100;
+    constexpr uint8_t REG3_SELF_TEST = 0xFF;    // Handlers réservés du Listen R3
+    constexpr uint8_t REG3_USER_LOCK = 0xFD;
+    constexpr uint8_t REG3_MOVE_IF_ALONE = 0xFE;
+    constexpr uint8_t REG3_SET_ADDRESS = 0x00;
+    constexpr uint16_t REG3_SRQ_ENABLE = 0x2000;
+    constexpr uint8_t POWER_KEY = 0x7F;         // Code transmis pour la touche Power
+}
+
+// Minuterie à comparaison de l'émission (voir ADBDeviceEmulator.h)
+#if defined(ADB_PLATFORM_AVR)
+    #define ADB_EMULATOR_TIMER1
+#elif !defined(ADB_PLATFORM_NATIVE)
+    #define ADB_EMULATOR_INLINE
+#endif
+
+namespace {
+#if defined(ADB_EMULATOR_TIMER1)
+    void (*compareHandler)() = nullptr;
+    uint32_t refUs;        // Date de la dernière échéance (µs de micros())
+    uint16_t refTicks;     // Valeur du timer 1 à cette date
+
+    uint16_t usToTicks(uint32_t us) {
+        return static_cast<uint16_t>(us * (F_CPU / 8000UL) / 1000UL);
+    }
+
+    void compareBegin(void (*handler)()) {
+        compareHandler = handler;
+        TIMSK1 &= ~_BV(OCIE1A);
+        TCCR1A = 0;
+        TCCR1B = _BV(CS11);
+    }
+
+    void compareStop() {
+        TIMSK1 &= ~_BV(OCIE1A);
+    }
+
+    // Première échéance datée par micros() (pas de 4 µs), les suivantes enchaînées au tick près
+    void compareSync() {
+        refTicks = TCNT1;
+        refUs = micros();
+    }
+
+    void compareArm(uint32_t atUs) {
+        int32_t ahead = static_cast<int32_t>(atUs - refUs);
+        refTicks = static_cast<uint16_t>(refTicks + usToTicks(ahead > 0 ? ahead : 0));
+        refUs = atUs;
+        // Échéance dépassée: interruption au plus tôt, l'échéance de référence reste la date théorique
+        uint16_t earliest = static_cast<uint16_t>(TCNT1 + 2);
+        OCR1A = static_cast<int16_t>(refTicks - earliest) < 0 ? earliest : refTicks;
+        TIFR1 = _BV(OCF1A);
+        TIMSK1 |= _BV(OCIE1A);
+    }
+#elif defined(ADB_PLATFORM_NATIVE)
+    void compareBegin(void (*handler)()) { attachCompareInterrupt(handler); }
+    void compareStop() { disarmCompare(); }
+    void compareSync() {}
+    void compareArm(uint32_t atUs) { armCompare(atUs); }
+#else
+    void compareSync() {}
+#endif
+}
+
+#if defined(ADB_EMULATOR_TIMER1)
+ISR(TIMER1_COMPA_vect) {
+    // Une échéance à la fois: la routine réarme la suivante
+    TIMSK1 &= ~_BV(OCIE1A);
+    if (compareHandler) compareHandler();
+}
+#endif
+
+/**
+ * Périphérique émulé
+ */
+
+ADBEmulatedDevice::ADBEmulatedDevice(uint8_t defaultAddress, uint8_t defaultHandler)
+    : response{0, 0, 0}, ready(0), defaultAddr(defaultAddress), defaultHandler(defaultHandler),
+      addr(defaultAddress), handler(defaultHandler), srqEnable(true), collided(false) {}
+
+void ADBEmulatedDevice::setResponse(uint8_t reg, uint16_t value) {
+    if (reg > 2) return;
+    response[reg] = value;
+    ready |= static_cast<uint8_t>(1 << reg);
+}
+
+void ADBEmulatedDevice::clearResponse(uint8_t reg) {
+    if (reg > 2) return;
+    ready &= static_cast<uint8_t>(~(1 << reg));
+}
+
+void ADBEmulatedDevice::powerOn() {
+    addr = defaultAddr;
+    handler = defaultHandler;
+    srqEnable = true;
+    collided = false;
+    reset();
+}
+
+/**
+ * Clavier
+ */
+
+ADBEmulatedKeyboard::ADBEmulatedKeyboard()
+    : ADBEmulatedDevice(ADBKey::Address::KEYBOARD, 2), queue{}, head(0), count(0), inFlight(0), sent(0),
+      reg2(0xFFFF), ledWriteCount(0) {
+    setResponse(2, reg2);
+}
+
+bool ADBEmulatedKeyboard::keyEvent(uint8_t adbCode, bool released) {
+    adbMaskInterrupts();
+    bool queued = count < QUEUE_SIZE;
+    if (queued) {
+        queue[(head + count) % QUEUE_SIZE] = static_cast<uint8_t>((adbCode & 0x7F) | (released ? 0x80 : 0x00));
+        count++;
+        prepare();
+    }
+    adbUnmaskInterrupts();
+    return queued;
+}
+
+void ADBEmulatedKeyboard::prepare() {
+    if (count == 0) {
+        inFlight = 0;
+        clearResponse(0);
+        return;
+    }
+
+    // Registre 0: jusqu'à deux événements, 0xFF pour un emplacement vide
+    uint8_t first = queue[head];
+    if ((first & 0x7F) == POWER_KEY) {
+        // La touche Power occupe seule le registre
+        inFlight = 1;
+        setResponse(0, (first & 0x80) ? ADBKey::KeyCode::POWER_UP : ADBKey::KeyCode::POWER_DOWN);
+        return;
+    }
+    uint8_t second = 0xFF;
+    inFlight = 1;
+    if (count > 1) {
+        uint8_t next = queue[(head + 1) % QUEUE_SIZE];
+        if ((next & 0x7F) != POWER_KEY) {
+            second = next;
+            inFlight = 2;
+        }
+    }
+    setResponse(0, static_cast<uint16_t>((first << 8) | second));
+}
+
+void ADBEmulatedKeyboard::sending(uint8_t reg) {
+    if (reg == 0) sent = inFlight;
+}
+
+void ADBEmulatedKeyboard::delivered(uint8_t reg) {
+    if (reg != 0) return;
+    while (sent > 0 && count > 0) {
+        uint8_t event = queue[head];
+        applyModifier(event & 0x7F, event & 0x80);
+        head = (head + 1) % QUEUE_SIZE;
+        count--;
+        sent--;
+    }
+    prepare();
+}
+
+void ADBEmulatedKeyboard::applyModifier(uint8_t code, bool released) {
+    // Bits du registre 2, actifs à l'état bas
+    uint8_t bit;
+    switch (code) {
+        case 0x37: bit = 8; break;              // Command
+        case 0x3A: case 0x7C: bit = 9; break;   // Option
+        case 0x38: case 0x7B: bit = 10; break;  // Shift
+        case 0x36: case 0x7D: bit = 11; break;  // Control
+        case 0x39: bit = 13; break;             // Caps Lock
+        case 0x33: bit = 14; break;             // Delete
+        default: return;
+    }
+    if (released) reg2 = static_cast<uint16_t>(reg2 | (1u << bit));
+    else reg2 = static_cast<uint16_t>(reg2 & ~(1u << bit));
+    setResponse(2, reg2);
+}
+
+void ADBEmulatedKeyboard::listen(uint8_t reg, uint16_t value) {
+    if (reg != 2) return;
+    // Seules les LEDs sont modifiables par l'hôte
+    reg2 = static_cast<uint16_t>((reg2 & ~REG2_LED_MASK) | (value & REG2_LED_MASK));
+    ledWriteCount++;
+    setResponse(2, reg2);
+}
+
+void ADBEmulatedKeyboard::flush() {
+    head = 0;
+    count = 0;
+    prepare();
+}
+
+void ADBEmulatedKeyboard::reset() {
+    reg2 = 0xFFFF;
+    setResponse(2, reg2);
+    flush();
+}
+
+/**
+ * Souris
+ */
+
+ADBEmulatedMouse::ADBEmulatedMouse()
+    : ADBEmulatedDevice(ADBKey::Address::MOUSE, 1), dx(0), dy(0), button(false), reportedButton(false),
+      inFlightX(0), inFlightY(0), inFlightButton(false), sentX(0), sentY(0), sentButton(false) {}
+
+void ADBEmulatedMouse::move(int16_t moveX, int16_t moveY) {
+    adbMaskInterrupts();
+    dx += moveX;
+    dy += moveY;
+    prepare();
+    adbUnmaskInterrupts();
+}
+
+void ADBEmulatedMouse::setButton(bool pressed) {
+    adbMaskInterrupts();
+    button = pressed;
+    prepare();
+    adbUnmaskInterrupts();
+}
+
+void ADBEmulatedMouse::prepare() {
+    if (dx == 0 && dy == 0 && button == reportedButton) {
+        clearResponse(0);
+        return;
+    }
+
+    // Mouvement limité à 7 bits signés, le reste est transmis au Talk suivant
+    inFlightX = static_cast<int8_t>(dx < -64 ? -64 : (dx > 63 ? 63 : dx));
+    inFlightY = static_cast<int8_t>(dy < -64 ? -64 : (dy > 63 ? 63 : dy));
+    inFlightButton = button;
+    setResponse(0, static_cast<uint16_t>((inFlightButton ? 0x0000 : 0x8000) |
+                                         ((inFlightY & 0x7F) << 8) | 0x0080 | (inFlightX & 0x7F)));
+}
+
+void ADBEmulatedMouse::sending(uint8_t reg) {
+    if (reg != 0) return;
+    sentX = inFlightX;
+    sentY = inFlightY;
+    sentButton = inFlightButton;
+}
+
+void ADBEmulatedMouse::delivered(uint8_t reg) {
+    if (reg != 0) return;
+    dx -= sentX;
+    dy -= sentY;
+    reportedButton = sentButton;
+    prepare();
+}
+
+void ADBEmulatedMouse::flush() {
+    dx = 0;
+    dy = 0;
+    reportedButton = button;
+    prepare();
+}
+
+void ADBEmulatedMouse::reset() {
+    button = false;
+    flush();
+}
+
+/**
+ * Moteur du mode périphérique
+ */
+
+ADBDeviceEmulator* ADBDeviceEmulator::instance = nullptr;
+
+ADBDeviceEmulator::ADBDeviceEmulator(uint8_t dataPin)
+    : dataPin(dataPin), deviceCount(0), devices{}, tltUs(DEFAULT_TLT), phase(Phase::IDLE), lineLevel(true),
+      lastEdgeUs(0), bitCount(0), command(0), listenValue(0), listenTarget(nullptr), lfsr(0xACE1),
+      emit(Emit::NONE), emitAtUs(0), frame(0), frameBit(0), cellUs(0), talkDevice(nullptr), talkReg(0),
+      counters{} {}
+
+bool ADBDeviceEmulator::attach(ADBEmulatedDevice& device) {
+    if (deviceCount >= MAX_DEVICES) return false;
+    devices[deviceCount++] = &device;
+    return true;
+}
+
+bool ADBDeviceEmulator::begin() {
+    if (instance && instance != this) return false;
+
+    pinMode(dataPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(dataPin, HIGH);
+    for (uint8_t i = 0; i < deviceCount; i++) devices[i]->powerOn();
+
+    phase = Phase::IDLE;
+    emit = Emit::NONE;
+    lineLevel = digitalRead(dataPin) == HIGH;
+    lastEdgeUs = micros();
+    lfsr ^= static_cast<uint16_t>(lastEdgeUs) | 1;
+    instance = this;
+#if !defined(ADB_EMULATOR_INLINE)
+    compareBegin(onCompare);
+#endif
+    attachInterrupt(digitalPinToInterrupt(dataPin), onEdge, CHANGE);
+    return true;
+}
+
+void ADBDeviceEmulator::end() {
+    if (instance != this) return;
+    detachInterrupt(digitalPinToInterrupt(dataPin));
+#if !defined(ADB_EMULATOR_INLINE)
+    compareStop();
+#endif
+    emit = Emit::NONE;
+    digitalWrite(dataPin, HIGH);
+    instance = nullptr;
+}
+
+void ADBDeviceEmulator::setTlt(uint16_t us) {
+    tltUs = us < TLT_MIN ? TLT_MIN : (us > TLT_MAX ? TLT_MAX : us);
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::waitUntil(uint32_t us) {
+    while (static_cast<int32_t>(micros() - us) < 0) {}
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::onEdge() {
+    ADBDeviceEmulator* self = instance;
+    if (!self) return;
+
+    // Fronts de notre propre réponse: la collision est contrôlée à chaque cellule
+    if (self->emit == Emit::CELL_LOW || self->emit == Emit::CELL_HIGH) return;
+
+    // Le niveau est relu: les fronts produits par nos propres émissions sont ignorés
+    uint32_t now = micros();
+    self->edge(now, digitalRead(self->dataPin) == HIGH);
+
+#if defined(ADB_EMULATOR_INLINE)
+    // Sans minuterie dédiée, les fronts armés sont attendus ici
+    while (self->emit != Emit::NONE) {
+        waitUntil(self->emitAtUs);
+        self->emitStep();
+    }
+#endif
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::onCompare() {
+    ADBDeviceEmulator* self = instance;
+    if (self) self->emitStep();
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::edge(uint32_t us, bool level) {
+    if (level == lineLevel) return;
+    uint32_t duration = us - lastEdgeUs;
+    lastEdgeUs = us;
+    lineLevel = level;
+
+    if (!level) {
+        // Début du bit d'arrêt de la commande: dernier instant pour un SRQ
+        if (phase == Phase::COMMAND && bitCount == 8) commandStopBit(us);
+        return;
+    }
+
+    // Remontée: la durée de l'état bas classe l'impulsion
+    if (duration >= RESET_MIN) {
+        phase = Phase::IDLE;
+        resetDevices();
+        return;
+    }
+    if (duration >= ATTENTION_MIN) {
+        phase = Phase::COMMAND;
+        bitCount = 0;
+        command = 0;
+        return;
+    }
+
+    uint8_t bit = duration < BIT_LOW_THRESHOLD ? 1 : 0;
+    switch (phase) {
+        case Phase::COMMAND:
+            if (bitCount < 8) {
+                command = static_cast<uint8_t>((command << 1) | bit);
+                bitCount++;
+            } else {
+                commandEnd(us, duration);
+            }
+            break;
+
+        case Phase::LISTEN:
+            // Bit de début, 16 bits de données; le bit d'arrêt n'est pas attendu
+            if (bitCount > 0) listenValue = static_cast<uint16_t>((listenValue << 1) | bit);
+            if (++bitCount < 17) break;
+            phase = Phase::IDLE;
+            counters.listens++;
+            if ((command & 0x03) == 3) {
+                listenRegister3(*listenTarget, listenValue);
+            } else {
+                listenTarget->listen(command & 0x03, listenValue);
+            }
+            break;
+
+        case Phase::IDLE:
+            break;
+    }
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::commandStopBit(uint32_t fallUs) {
+    // SRQ: un autre de nos périphériques a des données, l'hôte doit l'interroger
+    uint8_t target = command >> 4;
+    bool request = false;
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        const ADBEmulatedDevice* dev = devices[i];
+        if (dev->addr != target && dev->srqEnable && dev->hasPendingData()) request = true;
+    }
+    if (!request) return;
+
+    // Bit d'arrêt tenu bas jusqu'à SRQ_DURATION, relâché par la minuterie
+    digitalWrite(dataPin, LOW);
+    compareSync();
+    arm(Emit::SRQ_END, fallUs + SRQ_DURATION);
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::commandEnd(uint32_t riseUs, uint32_t stopLowUs) {
+    phase = Phase::IDLE;
+
+    // SendReset: 0000 dans les quatre bits de poids faible, quelle que soit l'adresse
+    if ((command & 0x0F) == 0) {
+        resetDevices();
+        return;
+    }
+
+    ADBEmulatedDevice* dev = find(command >> 4);
+    if (!dev) return;
+    counters.commands++;
+
+    uint8_t reg = command & 0x03;
+    switch (command & 0x0C) {
+        case CMD_TALK: {
+            uint16_t value;
+            if (reg == 3) {
+                // Adresse aléatoire: deux périphériques à la même adresse finissent par se distinguer
+                value = static_cast<uint16_t>((dev->srqEnable ? REG3_SRQ_ENABLE : 0) |
+                                              (randomAddress() << 8) | dev->handler);
+            } else if (dev->ready & (1 << reg)) {
+                value = dev->response[reg];
+                dev->sending(reg);
+            } else {
+                return;
+            }
+
+            // Tlt compté depuis la fin nominale de la cellule du bit d'arrêt
+            uint32_t start = riseUs + (stopLowUs < BIT_CELL ? BIT_CELL - stopLowUs : 0) + tltUs;
+            if (static_cast<int32_t>(micros() - start) > 0) counters.lateResponses++;
+
+            // Bit de début (1), 16 bits de données, bit d'arrêt (0), une cellule par paire d'échéances
+            frame = (1UL << 17) | (static_cast<uint32_t>(value) << 1);
+            frameBit = 17;
+            cellUs = start;
+            talkDevice = dev;
+            talkReg = reg;
+            compareSync();
+            arm(Emit::CELL_LOW, start);
+            break;
+        }
+
+        case CMD_LISTEN:
+            phase = Phase::LISTEN;
+            bitCount = 0;
+            listenValue = 0;
+            listenTarget = dev;
+            break;
+
+        case CMD_FLUSH:
+            // Valeur de la bibliothèque hôte (type 01, registre 0)
+            if (reg == 0) dev->flush();
+            break;
+
+        default:
+            // Flush de la spécification: type 00, registre 01
+            if (reg == 1) dev->flush();
+            break;
+    }
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::arm(Emit step, uint32_t atUs) {
+    emit = step;
+    emitAtUs = atUs;
+#if !defined(ADB_EMULATOR_INLINE)
+    compareArm(atUs);
+#endif
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::emitStep() {
+    switch (emit) {
+        case Emit::SRQ_END:
+            emit = Emit::NONE;
+            digitalWrite(dataPin, HIGH);
+            counters.srqs++;
+            break;
+
+        case Emit::CELL_LOW: {
+            // Ligne déjà basse: un autre périphérique répond
+            if (digitalRead(dataPin) == LOW) {
+                talkEnd(false);
+                break;
+            }
+            digitalWrite(dataPin, LOW);
+            uint8_t low = (frame >> frameBit) & 1 ? BIT_ONE_LOW : BIT_ZERO_LOW;
+            arm(Emit::CELL_HIGH, cellUs + low);
+            break;
+        }
+
+        case Emit::CELL_HIGH:
+            digitalWrite(dataPin, HIGH);
+            // Ligne maintenue basse par un autre périphérique: il a émis un 0 là où nous émettions un 1
+            waitUntil(emitAtUs + COLLISION_CHECK_DELAY);
+            if (digitalRead(dataPin) == LOW) {
+                talkEnd(false);
+            } else if (frameBit-- == 0) {
+                talkEnd(true);
+            } else {
+                cellUs += BIT_CELL;
+                arm(Emit::CELL_LOW, cellUs);
+            }
+            break;
+
+        case Emit::NONE:
+            break;
+    }
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::talkEnd(bool delivered) {
+    emit = Emit::NONE;
+    if (delivered) {
+        counters.talks++;
+        if (talkReg == 3) talkDevice->collided = false;
+        else talkDevice->delivered(talkReg);
+    } else {
+        counters.collisions++;
+        if (talkReg == 3) talkDevice->collided = true;
+    }
+    // Les fronts de notre propre émission sont encore en attente: niveau resynchronisé
+    lineLevel = digitalRead(dataPin) == HIGH;
+    lastEdgeUs = micros();
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::listenRegister3(ADBEmulatedDevice& device, uint16_t value) {
+    uint8_t newAddress = static_cast<uint8_t>((value & REG3_ADDRESS_MASK) >> 8);
+    uint8_t newHandler = static_cast<uint8_t>(value & REG3_HANDLER_MASK);
+
+    switch (newHandler) {
+        case REG3_MOVE_IF_ALONE:
+            // Résolution des conflits: seul le périphérique dont la réponse est passée se déplace
+            if (!device.collided) device.addr = newAddress;
+            device.collided = false;
+            break;
+        case REG3_SET_ADDRESS:
+            device.addr = newAddress;
+            device.srqEnable = value & REG3_SRQ_ENABLE;
+            break;
+        case REG3_USER_LOCK:
+        case REG3_SELF_TEST:
+            break;
+        default:
+            if (device.supportsHandler(newHandler)) device.handler = newHandler;
+            break;
+    }
+}
+
+void ADB_ISR_ATTR ADBDeviceEmulator::resetDevices() {
+    counters.resets++;
+    for (uint8_t i = 0; i < deviceCount; i++) devices[i]->powerOn();
+}
+
+ADBEmulatedDevice* ADB_ISR_ATTR ADBDeviceEmulator::find(uint8_t address) {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i]->addr == address) return devices[i];
+    }
+    return nullptr;
+}
+
+uint8_t ADB_ISR_ATTR ADBDeviceEmulator::randomAddress() {
+    // LFSR de Galois 16 bits (polynôme 0xB400)
+    lfsr = static_cast<uint16_t>((lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u));
+    return static_cast<uint8_t>(0x08 | (lfsr & 0x07));
+}
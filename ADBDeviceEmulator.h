@@ -0,0 +1,320 @@
+/**
+ * @file ADBDeviceEmulator.h
+ * @brief Mode périphérique: émulation d'un clavier et d'une souris ADB face à un Macintosh
+ *
+ * Le reste de la bibliothèque joue le rôle de l'hôte. Ici, l'adaptateur se
+ * comporte comme un ou plusieurs périphériques branchés sur le bus d'un
+ * Macintosh (ou de tout autre hôte ADB): il reconnaît attention et
+ * synchronisation, décode les commandes destinées à ses adresses, répond aux
+ * Talk dans la fenêtre Tlt de 140 à 260 µs, émet un SRQ lorsqu'un périphérique
+ * émulé a des données en attente, reçoit les Listen (LEDs du registre 2,
+ * registre 3 avec changement d'adresse, de handler et détection de collision).
+ *
+ * Le décodage se fait par interruption sur la broche de données. Le paquet de
+ * chaque registre est préparé à l'avance (setResponse), au moment où les
+ * données changent: à la fin d'une commande Talk il ne reste qu'à choisir le
+ * paquet et à l'émettre. L'émission (Tlt puis 18 cellules, 2 ms au plus) et
+ * le SRQ (300 µs) sont découpés en fronts datés sur des échéances absolues,
+ * un front par interruption d'une minuterie à comparaison:
+ *   - AVR: timer 1 (prescaler 8), réservé à l'émulation (PWM des broches 9
+ *     et 10, bibliothèque Servo). Aucune routine ne dure plus de quelques
+ *     µs: micros() ne perd pas de débordement du timer 0 (1024 µs);
+ *   - simulateur natif: minuterie simulée (armCompare);
+ *   - autres plateformes: sans minuterie dédiée, les mêmes fronts sont
+ *     attendus dans la routine de la broche, qui reste active jusqu'à 2 ms
+ *     pour une réponse et 300 µs pour un SRQ. micros() y reste juste (ESP32:
+ *     compteur 64 bits de esp_timer; STM32 et Teensy: SysTick prioritaire
+ *     sur les interruptions de broche), mais les autres interruptions de
+ *     même priorité attendent d'autant.
+ *
+ * Une seule instance peut être active à la fois (routines d'interruption uniques).
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_DEVICE_EMULATOR_h
+#define ADB_DEVICE_EMULATOR_h
+
+#include <Arduino.h>
+#include <cstdint>
+#include "ADB.h"
+#include "ADBPlatform.h"
+
+/**
+ * @brief Périphérique émulé: registres et configuration (registre 3)
+ *
+ * Les classes dérivées préparent les réponses des registres 0 à 2 avec
+ * setResponse() et reçoivent les notifications de l'émulateur. Ces méthodes
+ * virtuelles sont appelées depuis la routine d'interruption.
+ */
+class ADBEmulatedDevice {
+public:
+    /**
+     * @brief Constructeur
+     * @param defaultAddress Adresse à la mise sous tension
+     * @param defaultHandler Handler ID à la mise sous tension
+     */
+    ADBEmulatedDevice(uint8_t defaultAddress, uint8_t defaultHandler);
+    virtual ~ADBEmulatedDevice() {}
+
+    uint8_t address() const { return addr; }
+    uint8_t handlerId() const { return handler; }
+    bool srqEnabled() const { return srqEnable; }
+
+    /**
+     * @brief Le registre 0 a une réponse prête (condition du SRQ)
+     */
+    bool hasPendingData() const { return ready & 0x01; }
+
+protected:
+    /**
+     * @brief Prépare la réponse d'un registre (0 à 2) aux prochains Talk
+     *
+     * Appelée depuis la boucle principale, interruptions masquées.
+     */
+    void setResponse(uint8_t reg, uint16_t value);
+
+    /**
+     * @brief Retire la réponse d'un registre (le Talk reste sans réponse)
+     */
+    void clearResponse(uint8_t reg);
+
+    /**
+     * @brief Une réponse commence (registres 0 à 2)
+     *
+     * Le paquet émis est figé jusqu'à delivered() ou jusqu'à la réponse
+     * suivante: la boucle principale peut en préparer un autre entre-temps.
+     */
+    virtual void sending(uint8_t reg) { (void)reg; }
+
+    /**
+     * @brief Une réponse a été transmise en entier (aucune collision)
+     */
+    virtual void delivered(uint8_t reg) { (void)reg; }
+
+    /**
+     * @brief Registre 0 à 2 reçu par Listen
+     */
+    virtual void listen(uint8_t reg, uint16_t value) { (void)reg; (void)value; }
+
+    /**
+     * @brief Commande Flush: abandon des données en attente
+     */
+    virtual void flush() {}
+
+    /**
+     * @brief Reset global ou SendReset
+     */
+    virtual void reset() {}
+
+    virtual bool supportsHandler(uint8_t id) const { return id == defaultHandler; }
+
+private:
+    friend class ADBDeviceEmulator;
+
+    void powerOn();
+
+    uint16_t response[3];    // Paquets préparés des registres 0 à 2
+    volatile uint8_t ready;  // Bit n: le registre n a une réponse
+    uint8_t defaultAddr;
+    uint8_t defaultHandler;
+    uint8_t addr;
+    uint8_t handler;
+    bool srqEnable;
+    bool collided;           // Collision pendant la dernière réponse au Talk R3
+};
+
+/**
+ * @brief Clavier ADB étendu émulé (adresse 2, handler 2, handlers 1 à 3 acceptés)
+ */
+class ADBEmulatedKeyboard : public ADBEmulatedDevice {
+public:
+    static constexpr uint8_t QUEUE_SIZE = 16;
+
+    ADBEmulatedKeyboard();
+
+    /**
+     * @brief Ajoute un événement de touche à transmettre
+     * @param adbCode Code ADB (0x7F = Power)
+     * @param released Touche relâchée
+     * @return false si la file est pleine
+     */
+    bool keyEvent(uint8_t adbCode, bool released);
+
+    /**
+     * @brief LEDs écrites par l'hôte, au format HID (bit 0 Num Lock, bit 1 Caps Lock, bit 2 Scroll Lock)
+     */
+    uint8_t leds() const { return ~reg2 & ADBProtocol::REG2_LED_MASK; }
+
+    uint16_t register2() const { return reg2; }
+    uint32_t ledWrites() const { return ledWriteCount; }
+    uint8_t pendingEvents() const { return count; }
+
+protected:
+    void sending(uint8_t reg) override;
+    void delivered(uint8_t reg) override;
+    void listen(uint8_t reg, uint16_t value) override;
+    void flush() override;
+    void reset() override;
+    bool supportsHandler(uint8_t id) const override { return id >= 1 && id <= 3; }
+
+private:
+    void prepare();
+    void applyModifier(uint8_t code, bool released);
+
+    uint8_t queue[QUEUE_SIZE];   // Événements (bit 7 = relâchement)
+    uint8_t head;
+    uint8_t count;
+    uint8_t inFlight;            // Événements contenus dans le paquet préparé
+    uint8_t sent;                // Événements contenus dans le paquet en cours d'émission
+    uint16_t reg2;               // Modificateurs et LEDs, actifs à l'état bas
+    uint32_t ledWriteCount;
+};
+
+/**
+ * @brief Souris ADB émulée (adresse 3, handler 1, handlers 1 et 2 acceptés)
+ */
+class ADBEmulatedMouse : public ADBEmulatedDevice {
+public:
+    ADBEmulatedMouse();
+
+    /**
+     * @brief Ajoute un déplacement (transmis par pas de 7 bits signés)
+     */
+    void move(int16_t dx, int16_t dy);
+
+    void setButton(bool pressed);
+
+protected:
+    void sending(uint8_t reg) override;
+    void delivered(uint8_t reg) override;
+    void flush() override;
+    void reset() override;
+    bool supportsHandler(uint8_t id) const override { return id == 1 || id == 2; }
+
+private:
+    void prepare();
+
+    int32_t dx;
+    int32_t dy;
+    bool button;
+    bool reportedButton;
+    int8_t inFlightX;            // Contenu du paquet préparé
+    int8_t inFlightY;
+    bool inFlightButton;
+    int8_t sentX;                // Contenu du paquet en cours d'émission
+    int8_t sentY;
+    bool sentButton;
+};
+
+/**
+ * @brief Compteurs du mode périphérique
+ */
+struct adb_emulator_stats {
+    uint32_t commands;       // Commandes adressées à un périphérique émulé
+    uint32_t talks;          // Réponses transmises en entier
+    uint32_t listens;        // Registres reçus
+    uint32_t srqs;           // SRQ émis
+    uint32_t collisions;     // Réponses abandonnées sur collision
+    uint32_t resets;         // Resets globaux et SendReset
+    uint32_t lateResponses;  // Réponses commencées après l'échéance Tlt
+};
+
+/**
+ * @brief Moteur du mode périphérique
+ */
+class ADBDeviceEmulator {
+public:
+    static constexpr uint8_t MAX_DEVICES = 4;
+    static constexpr uint16_t DEFAULT_TLT = 180;         // Délai de réponse (µs)
+    static constexpr uint16_t SRQ_DURATION = 300;        // Prolongation du bit d'arrêt (µs)
+    static constexpr uint8_t COLLISION_CHECK_DELAY = 4;  // Lecture de la ligne après un relâchement (µs)
+
+    /**
+     * @brief Constructeur
+     * @param dataPin Broche reliée à la ligne de données du Macintosh
+     */
+    explicit ADBDeviceEmulator(uint8_t dataPin);
+
+    /**
+     * @brief Ajoute un périphérique émulé (avant begin())
+     * @return false au-delà de MAX_DEVICES
+     */
+    bool attach(ADBEmulatedDevice& device);
+
+    /**
+     * @brief Met les périphériques sous tension et commence à écouter le bus
+     * @return false si une autre instance est déjà active
+     */
+    bool begin();
+
+    /**
+     * @brief Arrête l'émulation (la ligne est relâchée)
+     */
+    void end();
+
+    /**
+     * @brief Délai entre la fin nominale du bit d'arrêt et le début de la réponse
+     * @param us Tlt, borné à [TLT_MIN, TLT_MAX]
+     */
+    void setTlt(uint16_t us);
+
+    const adb_emulator_stats& stats() const { return counters; }
+
+private:
+    enum class Phase : uint8_t {
+        IDLE,      // Attente d'une attention
+        COMMAND,   // Bits de commande
+        LISTEN     // Registre transmis par l'hôte après un Listen
+    };
+
+    // Prochain front de l'émission, armé sur la minuterie
+    enum class Emit : uint8_t {
+        NONE,
+        SRQ_END,   // Relâchement du bit d'arrêt prolongé
+        CELL_LOW,  // Début de cellule: ligne tirée vers le bas
+        CELL_HIGH  // Fin de la partie basse, puis contrôle de collision
+    };
+
+    static void onEdge();
+    static void onCompare();
+    static void waitUntil(uint32_t us);
+
+    void edge(uint32_t us, bool level);
+    void commandStopBit(uint32_t fallUs);
+    void commandEnd(uint32_t riseUs, uint32_t stopLowUs);
+    void listenRegister3(ADBEmulatedDevice& device, uint16_t value);
+    void arm(Emit step, uint32_t atUs);
+    void emitStep();
+    void talkEnd(bool delivered);
+    void resetDevices();
+    ADBEmulatedDevice* find(uint8_t address);
+    uint8_t randomAddress();
+
+    static ADBDeviceEmulator* instance;   // Instance reliée à l'interruption
+
+    uint8_t dataPin;
+    uint8_t deviceCount;
+    ADBEmulatedDevice* devices[MAX_DEVICES];
+    uint16_t tltUs;
+    Phase phase;
+    bool lineLevel;                 // Dernier niveau traité
+    uint32_t lastEdgeUs;
+    uint8_t bitCount;
+    uint8_t command;
+    uint16_t listenValue;
+    ADBEmulatedDevice* listenTarget;
+    uint16_t lfsr;                  // Adresses aléatoires du Talk R3
+    volatile Emit emit;             // Front armé (NONE: aucune émission en cours)
+    uint32_t emitAtUs;              // Échéance du front armé
+    uint32_t frame;                 // Bit de début, 16 bits de données, bit d'arrêt
+    int8_t frameBit;                // Bit de la cellule en cours (17 à 0)
+    uint32_t cellUs;                // Début de la cellule en cours
+    ADBEmulatedDevice* talkDevice;  // Périphérique qui répond
+    uint8_t talkReg;
+    adb_emulator_stats counters;
+};
+
+#endif // ADB_DEVICE_EMULATOR_h
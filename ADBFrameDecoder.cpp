@@ -0,0 +1,286 @@
+/**
+ * @file ADBFrameDecoder.cpp
+ * @brief Implémentation du décodeur de trames ADB
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBFrameDecoder.h"
+#include <string.h>
+
+using namespace ADBProtocol;
+
+namespace {
+
+// Durée nominale d'une cellule de bit (µs)
+constexpr uint32_t BIT_CELL_NOMINAL = 100;
+
+uint16_t saturate16(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(value);
+}
+
+} // namespace
+
+const char* adb_frame::commandName() const {
+    switch (command & 0x0C) {
+        case CMD_TALK:   return "Talk";
+        case CMD_LISTEN: return "Listen";
+        case CMD_FLUSH:  return "Flush";
+        default:         return (command & 0x0F) == 0 ? "SendReset" : "Reserve";
+    }
+}
+
+ADBFrameDecoder::ADBFrameDecoder(FrameHandler handler, void* context)
+    : handler(handler), context(context), frame{}, state(State::IDLE), level(true),
+      lastEdgeUs(0), pendingLowUs(0), cells(0), heldBit(0), heldCellValid(false), bitHeld(false),
+      tltHighUs(0), stopLowUs(0), minPulseUs(0), edgeHeld(false), heldLevel(true), heldUs(0),
+      spikeHeld(false), spikeUs(0), glitchCount(0) {}
+
+void ADBFrameDecoder::reset() {
+    state = State::IDLE;
+    level = true;
+    pendingLowUs = 0;
+    edgeHeld = false;
+    spikeHeld = false;
+}
+
+void ADBFrameDecoder::setGlitchFilter(uint8_t minPulse) {
+    releaseHeld();
+    minPulseUs = minPulse;
+}
+
+void ADB_HOT ADBFrameDecoder::edge(uint32_t us, bool newLevel) {
+    if (!minPulseUs) {
+        apply(us, newLevel);
+        return;
+    }
+    if (!edgeHeld) {
+        if (newLevel == level) return;
+        edgeHeld = true;
+        heldLevel = newLevel;
+        heldUs = us;
+        return;
+    }
+    if (spikeHeld) {
+        if (!newLevel) return;
+        spikeHeld = false;
+        glitchCount++;
+        // Impulsion basse brève: parasite, le front montant garde sa date
+        if (us - spikeUs < minPulseUs) return;
+        // Sinon c'est la partie haute qui était brève: seul le nouveau front montant compte
+        heldUs = us;
+        return;
+    }
+    if (newLevel == heldLevel) return;
+
+    // Retour au niveau précédent trop tôt: l'impulsion entière est un parasite
+    if (us - heldUs < minPulseUs) {
+        if (heldLevel) {
+            // Après un front montant, la partie basse est jugée à son tour
+            spikeHeld = true;
+            spikeUs = us;
+            return;
+        }
+        edgeHeld = false;
+        glitchCount++;
+        return;
+    }
+    apply(heldUs, heldLevel);
+    heldLevel = newLevel;
+    heldUs = us;
+}
+
+void ADB_HOT ADBFrameDecoder::releaseHeld() {
+    if (!edgeHeld) return;
+    edgeHeld = false;
+    apply(heldUs, heldLevel);
+    if (spikeHeld) {
+        spikeHeld = false;
+        apply(spikeUs, false);
+    }
+}
+
+void ADB_HOT ADBFrameDecoder::apply(uint32_t us, bool newLevel) {
+    if (newLevel == level) return;
+    uint32_t duration = us - lastEdgeUs;
+    lastEdgeUs = us;
+    level = newLevel;
+
+    // Un front montant clôt une impulsion basse, un front descendant une phase haute
+    if (newLevel) {
+        onLow(us, duration);
+    } else {
+        onHigh(us, duration);
+    }
+}
+
+void ADBFrameDecoder::idle(uint32_t nowUs) {
+    if (spikeHeld) {
+        // Ligne restée basse: la partie haute précédente était le parasite
+        if (nowUs - spikeUs < minPulseUs) return;
+        spikeHeld = false;
+        edgeHeld = false;
+        glitchCount++;
+    }
+    if (edgeHeld && nowUs - heldUs >= minPulseUs) releaseHeld();
+    if (state == State::IDLE || !level) return;
+    uint32_t limit = (state == State::TLT) ? TLT_WINDOW : BIT_CELL_MAX;
+    if (nowUs - lastEdgeUs > limit) {
+        commitDataBit();
+        emit(lastEdgeUs);
+    }
+}
+
+void ADBFrameDecoder::finish() {
+    releaseHeld();
+    if (state == State::IDLE) return;
+    if (level) commitDataBit();
+    emit(lastEdgeUs);
+}
+
+void ADB_HOT ADBFrameDecoder::onLow(uint32_t riseUs, uint32_t lowUs) {
+    uint32_t fallUs = riseUs - lowUs;
+
+    // Les impulsions longues interrompent toute trame en cours
+    if (lowUs >= RESET_MIN) {
+        if (state != State::IDLE) emit(fallUs);
+        startFrame(ADBFrameType::RESET, fallUs, lowUs);
+        emit(riseUs);
+        return;
+    }
+    if (lowUs >= ATTENTION_MIN) {
+        if (state != State::IDLE) emit(fallUs);
+        startFrame(ADBFrameType::COMMAND, fallUs, lowUs);
+        if (lowUs > ATTENTION_MAX) frame.flags |= ADBFrameFlag::ATTENTION_TIMING;
+        state = State::SYNC;
+        return;
+    }
+
+    switch (state) {
+        case State::IDLE:
+            startFrame(ADBFrameType::STRAY, fallUs, lowUs);
+            emit(riseUs);
+            break;
+
+        case State::COMMAND_STOP:
+            // Un périphérique ayant des données prolonge le bit d'arrêt (SRQ)
+            stopLowUs = lowUs;
+            if (lowUs >= SRQ_MIN) frame.srqUs = saturate16(lowUs);
+            state = State::TLT;
+            break;
+
+        default:
+            pendingLowUs = lowUs;
+            break;
+    }
+}
+
+void ADB_HOT ADBFrameDecoder::onHigh(uint32_t fallUs, uint32_t highUs) {
+    switch (state) {
+        case State::SYNC:
+            frame.syncUs = saturate16(highUs);
+            if (highUs < SYNC_MIN || highUs > SYNC_MAX) frame.flags |= ADBFrameFlag::SYNC_TIMING;
+            state = State::COMMAND;
+            break;
+
+        case State::COMMAND:
+            // Une phase haute plus longue qu'une cellule termine la commande prématurément
+            if (highUs > BIT_CELL_MAX) {
+                emit(fallUs - highUs);
+                break;
+            }
+            if (!cellValid(pendingLowUs, highUs)) frame.flags |= ADBFrameFlag::BIT_TIMING;
+            frame.command = static_cast<uint8_t>((frame.command << 1) | decodeBitCell(pendingLowUs, highUs));
+            if (++frame.commandBits == 8) state = State::COMMAND_STOP;
+            break;
+
+        case State::TLT:
+            if (highUs > TLT_WINDOW) {
+                emit(fallUs - highUs);
+                break;
+            }
+            tltHighUs = highUs;
+            cells = 0;
+            state = State::DATA;
+            break;
+
+        case State::DATA:
+            // Après le bit d'arrêt, la ligne reste haute au-delà d'une cellule
+            if (highUs > BIT_CELL_MAX) {
+                commitDataBit();
+                emit(fallUs - highUs);
+                break;
+            }
+            if (cells++ == 0) {
+                if (!cellValid(pendingLowUs, highUs)) frame.flags |= ADBFrameFlag::BIT_TIMING;
+                // Bit de début: Tlt compté depuis la fin nominale du bit d'arrêt
+                uint32_t pad = stopLowUs < BIT_CELL_NOMINAL ? BIT_CELL_NOMINAL - stopLowUs : 0;
+                uint32_t tlt = tltHighUs > pad ? tltHighUs - pad : 0;
+                frame.tltUs = saturate16(tlt);
+                if (tlt < TLT_MIN || tlt > TLT_MAX) frame.flags |= ADBFrameFlag::TLT_TIMING;
+                if (decodeBitCell(pendingLowUs, highUs) != 0x1) frame.flags |= ADBFrameFlag::BAD_START_BIT;
+            } else {
+                // La cellule n'est un bit de données que si une autre la suit:
+                // la dernière est le bit d'arrêt lorsqu'une attention l'interrompt
+                commitDataBit();
+                heldBit = decodeBitCell(pendingLowUs, highUs);
+                heldCellValid = cellValid(pendingLowUs, highUs);
+                bitHeld = true;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ADB_HOT ADBFrameDecoder::commitDataBit() {
+    if (!bitHeld) return;
+    bitHeld = false;
+    if (!heldCellValid) frame.flags |= ADBFrameFlag::BIT_TIMING;
+    if (frame.dataBits >= sizeof(frame.data) * 8) {
+        frame.flags |= ADBFrameFlag::PARTIAL_PACKET;
+        return;
+    }
+    if (heldBit) frame.data[frame.dataBits / 8] |= 0x80 >> (frame.dataBits % 8);
+    frame.dataBits++;
+}
+
+void ADB_HOT ADBFrameDecoder::startFrame(ADBFrameType type, uint32_t startUs, uint32_t lowUs) {
+    memset(&frame, 0, sizeof(frame));
+    frame.type = type;
+    frame.startUs = startUs;
+    frame.attentionUs = saturate16(lowUs);
+    cells = 0;
+    bitHeld = false;
+    tltHighUs = 0;
+    stopLowUs = 0;
+}
+
+void ADB_HOT ADBFrameDecoder::emit(uint32_t endUs) {
+    frame.durationUs = endUs - frame.startUs;
+
+    if (frame.type == ADBFrameType::COMMAND) {
+        if (frame.commandBits < 8) {
+            frame.flags |= ADBFrameFlag::COMMAND_TRUNCATED;
+        } else {
+            uint8_t kind = frame.command & 0x0C;
+            bool takesData = kind == CMD_TALK || kind == CMD_LISTEN;
+            if (cells > 0 && (frame.dataBits < 16 || frame.dataBits % 8 != 0)) {
+                frame.flags |= ADBFrameFlag::PARTIAL_PACKET;
+            }
+            if (cells > 0 && !takesData) frame.flags |= ADBFrameFlag::UNEXPECTED_DATA;
+            if (cells == 0 && kind == CMD_LISTEN) frame.flags |= ADBFrameFlag::MISSING_DATA;
+        }
+    }
+
+    state = State::IDLE;
+    if (handler) handler(context, frame);
+}
+
+bool ADB_HOT ADBFrameDecoder::cellValid(uint32_t lowUs, uint32_t highUs) {
+    uint32_t cell = lowUs + highUs;
+    return cell >= BIT_CELL_MIN && cell <= BIT_CELL_MAX;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file ADBFrameDecoder.h
+ * @brief Décodage des transactions ADB à partir des fronts de la ligne
+ *
+ * Le décodeur reconstruit les transactions (attention, synchronisation,
+ * commande, SRQ, Tlt, paquet de données) à partir de la seule chronologie des
+ * fronts, avec la classification Manchester de ADB::readDataPacket sans calibration. Il ne pilote pas
+ * la ligne: il s'alimente aussi bien depuis une capture hors ligne (outil
+ * adbdecode) que depuis une interruption sur la broche de données.
+ *
+ * La mémoire utilisée est constante, quelle que soit la longueur du flux.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_FRAME_DECODER_h
+#define ADB_FRAME_DECODER_h
+
+#include <Arduino.h>
+#include <cstdint>
+#include "ADB.h"
+
+/**
+ * @brief Nature d'une trame décodée
+ */
+enum class ADBFrameType : uint8_t {
+    COMMAND,   // Attention, commande et éventuel paquet de données
+    RESET,     // Ligne basse au-delà de RESET_MIN
+    STRAY      // Impulsion basse isolée, hors transaction
+};
+
+/**
+ * @brief Anomalies relevées sur une trame (combinables)
+ */
+namespace ADBFrameFlag {
+    constexpr uint16_t ATTENTION_TIMING  = 0x0001; // Attention hors [ATTENTION_MIN, ATTENTION_MAX]
+    constexpr uint16_t SYNC_TIMING       = 0x0002; // Synchronisation hors [SYNC_MIN, SYNC_MAX]
+    constexpr uint16_t BIT_TIMING        = 0x0004; // Cellule de bit hors [BIT_CELL_MIN, BIT_CELL_MAX]
+    constexpr uint16_t COMMAND_TRUNCATED = 0x0008; // Moins de 8 bits de commande
+    constexpr uint16_t TLT_TIMING        = 0x0010; // Tlt hors [TLT_MIN, TLT_MAX]
+    constexpr uint16_t PARTIAL_PACKET    = 0x0020; // Données hors 2 à 8 octets entiers
+    constexpr uint16_t BAD_START_BIT     = 0x0040; // Bit de début à 0
+    constexpr uint16_t UNEXPECTED_DATA   = 0x0080; // Données après une commande qui n'en attend pas
+    constexpr uint16_t MISSING_DATA      = 0x0100; // Listen sans paquet de données
+}
+
+/**
+ * @brief Transaction décodée
+ */
+struct adb_frame {
+    uint32_t startUs;        // Début de la trame (front descendant de l'attention)
+    uint32_t durationUs;     // Jusqu'à la fin de la dernière impulsion
+    uint16_t attentionUs;    // Durée de l'attention (ou de l'impulsion pour RESET/STRAY)
+    uint16_t syncUs;         // Durée de la synchronisation
+    uint16_t srqUs;          // Durée du bit d'arrêt prolongé par un SRQ (0 sans SRQ)
+    uint16_t tltUs;          // Tlt mesuré depuis la fin nominale du bit d'arrêt (0 sans données)
+    uint16_t flags;          // ADBFrameFlag
+    ADBFrameType type;
+    uint8_t command;         // Octet de commande (adresse << 4 | type << 2 | registre)
+    uint8_t commandBits;     // Bits de commande reçus (8 pour une commande complète)
+    uint8_t dataBits;        // Bits de données reçus (hors bits de début et d'arrêt)
+    uint8_t data[8];         // Données, octet de poids fort en premier
+
+    uint8_t address() const { return command >> 4; }
+    uint8_t reg() const { return command & 0x03; }
+    bool srq() const { return srqUs != 0; }
+    bool hasData() const { return dataBits != 0; }
+    uint8_t dataBytes() const { return dataBits / 8; }
+
+    /**
+     * @brief Nom de la commande ("Talk", "Listen", "Flush", "SendReset" ou "Reserve")
+     */
+    const char* commandName() const;
+};
+
+/**
+ * @brief Décodeur de trames alimenté par les fronts de la ligne
+ */
+class ADBFrameDecoder {
+public:
+    /**
+     * @brief Appelé pour chaque trame terminée
+     */
+    typedef void (*FrameHandler)(void* context, const adb_frame& frame);
+
+    ADBFrameDecoder(FrameHandler handler, void* context);
+
+    /**
+     * @brief Oublie la trame en cours (la ligne est supposée au repos, haute)
+     */
+    void reset();
+
+    /**
+     * @brief Rejette les impulsions plus courtes que minPulseUs (0 = aucun filtre)
+     *
+     * Chaque front est retenu jusqu'au suivant: s'ils sont séparés de moins de
+     * minPulseUs, les deux disparaissent du flux décodé. Les trames sont alors
+     * closes avec un front de retard, sans effet sur les durées mesurées.
+     * La ligne relâchée, en haute impédance, ne reçoit que des parasites bas:
+     * une impulsion basse qui suit de près un front montant est jugée sur sa
+     * propre durée, et le front garde sa date si elle est brève.
+     */
+    void setGlitchFilter(uint8_t minPulseUs);
+
+    /**
+     * @brief Impulsions rejetées par le filtre
+     */
+    uint32_t glitches() const { return glitchCount; }
+
+    /**
+     * @brief Ajoute un front (ignoré si le niveau ne change pas)
+     * @param us Date du front en µs (les débordements de 32 bits sont tolérés)
+     * @param level Nouveau niveau de la ligne
+     */
+    void edge(uint32_t us, bool level);
+
+    /**
+     * @brief Clôt la trame en cours si la ligne est restée haute assez longtemps
+     *
+     * À appeler périodiquement lors d'un décodage en direct: sans nouveau front,
+     * la fin d'un paquet de données ne se constate qu'au front suivant.
+     * @param nowUs Date courante en µs
+     */
+    void idle(uint32_t nowUs);
+
+    /**
+     * @brief Clôt la trame en cours (fin du flux)
+     */
+    void finish();
+
+private:
+    enum class State : uint8_t {
+        IDLE,          // Ligne au repos, pas de trame en cours
+        SYNC,          // Attention terminée, attente du premier bit de commande
+        COMMAND,       // Bits de commande
+        COMMAND_STOP,  // Bit d'arrêt de la commande (SRQ éventuel)
+        TLT,           // Attente du bit de début des données
+        DATA           // Bits de données
+    };
+
+    void apply(uint32_t us, bool level);
+    void releaseHeld();
+    void onLow(uint32_t riseUs, uint32_t lowUs);
+    void onHigh(uint32_t fallUs, uint32_t highUs);
+    void commitDataBit();
+    void startFrame(ADBFrameType type, uint32_t startUs, uint32_t lowUs);
+    void emit(uint32_t endUs);
+    static bool cellValid(uint32_t lowUs, uint32_t highUs);
+
+    FrameHandler handler;
+    void* context;
+    adb_frame frame;
+    State state;
+    bool level;            // Niveau actuel de la ligne
+    uint32_t lastEdgeUs;   // Date du dernier front
+    uint32_t pendingLowUs; // Partie basse de la cellule en cours
+    uint8_t cells;         // Cellules de données reçues (bit de début compris)
+    uint8_t heldBit;       // Dernière cellule, en attente de la suivante
+    bool heldCellValid;    // Durée de la cellule en attente conforme
+    bool bitHeld;          // Une cellule est en attente
+    uint32_t tltHighUs;    // Durée haute avant le bit de début
+    uint32_t stopLowUs;    // Durée basse du bit d'arrêt de la commande
+    uint8_t minPulseUs;    // Impulsion la plus courte retenue (0 = sans filtre)
+    bool edgeHeld;         // Un front attend le suivant pour être confirmé
+    bool heldLevel;        // Niveau du front en attente
+    uint32_t heldUs;       // Date du front en attente
+    bool spikeHeld;        // Impulsion basse juste après le front montant en attente
+    uint32_t spikeUs;      // Début de cette impulsion
+    uint32_t glitchCount;  // Impulsions rejetées
+};
+
+#endif // ADB_FRAME_DECODER_h
@@ -0,0 +1,138 @@
+/**
+ * @file ADBHIDReport.cpp
+ * @brief Implémentation de la construction des rapports HID
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBHIDReport.h"
+#include "ADBKeymap.h"
+#include <string.h>
+
+namespace {
+
+// Valeur signée sur 7 bits d'un axe de la souris
+int8_t mouseAxis(uint16_t value) {
+    return static_cast<int8_t>(static_cast<uint8_t>(value << 1)) >> 1;
+}
+
+int8_t clampAxis(int32_t value) {
+    return static_cast<int8_t>(value > 127 ? 127 : (value < -127 ? -127 : value));
+}
+
+} // namespace
+
+void ADBHIDReport::reset() {
+    memset(&keyboard, 0, sizeof(keyboard));
+    memset(keysDown, 0, sizeof(keysDown));
+    orderCount = 0;
+    hiddenKeys = 0;
+    ledState = 0;
+    mouseX = 0;
+    mouseY = 0;
+    mouseButtons = 0;
+    reportedButtons = 0;
+}
+
+bool ADBHIDReport::keyboardRegister0(uint16_t raw) {
+    // Power relâchée occupe les deux emplacements; 0xFF signale un emplacement vide
+    if (raw == ADBKey::KeyCode::POWER_UP) return keyEvent(0x7F, true);
+
+    bool changed = false;
+    if ((raw >> 8) != 0xFF) changed |= keyEvent((raw >> 8) & 0x7F, raw & 0x8000);
+    if ((raw & 0xFF) != 0xFF) changed |= keyEvent(raw & 0x7F, raw & 0x0080);
+    return changed;
+}
+
+bool ADBHIDReport::keyEvent(uint8_t adbCode, bool released) {
+    adbCode &= 0x7F;
+
+    uint8_t modifier = ADBKeymap::getModifierMask(adbCode);
+    if (modifier) {
+        uint8_t previous = keyboard.modifiers;
+        if (released) {
+            keyboard.modifiers &= ~modifier;
+        } else {
+            keyboard.modifiers |= modifier;
+        }
+        return keyboard.modifiers != previous;
+    }
+    if (ADBKeymap::toHID(adbCode) == ADB_KEY_NONE) return false;
+
+    uint8_t bit = 1 << (adbCode & 0x07);
+    bool down = keysDown[adbCode >> 3] & bit;
+    if (down != released) return false;  // Répétition d'un état déjà connu
+
+    if (!released) {
+        keysDown[adbCode >> 3] |= bit;
+        if (orderCount < MAX_KEYS) {
+            order[orderCount++] = adbCode;
+        } else {
+            hiddenKeys++;
+        }
+    } else {
+        keysDown[adbCode >> 3] &= ~bit;
+        uint8_t i = 0;
+        while (i < orderCount && order[i] != adbCode) i++;
+        if (i == orderCount) {
+            // La touche relâchée n'était pas rapportée
+            hiddenKeys--;
+        } else {
+            memmove(&order[i], &order[i + 1], orderCount - i - 1);
+            orderCount--;
+            if (hiddenKeys > 0) {
+                // Une touche masquée prend la place libérée
+                for (uint8_t code = 0; code < 128; code++) {
+                    if (!(keysDown[code >> 3] & (1 << (code & 0x07)))) continue;
+                    if (memchr(order, code, orderCount)) continue;
+                    order[orderCount++] = code;
+                    hiddenKeys--;
+                    break;
+                }
+            }
+        }
+    }
+
+    uint8_t previous[MAX_KEYS];
+    memcpy(previous, keyboard.keys, MAX_KEYS);
+    rebuildKeys();
+    return memcmp(previous, keyboard.keys, MAX_KEYS) != 0;
+}
+
+void ADBHIDReport::rebuildKeys() {
+    if (hiddenKeys > 0) {
+        // Trop de touches: tous les emplacements signalent l'ErrorRollOver
+        memset(keyboard.keys, ADB_KEY_ERR_OVF, MAX_KEYS);
+        return;
+    }
+    for (uint8_t i = 0; i < MAX_KEYS; i++) {
+        keyboard.keys[i] = i < orderCount ? ADBKeymap::toHID(order[i]) : ADB_KEY_NONE;
+    }
+}
+
+void ADBHIDReport::keyboardRegister2Written(uint16_t raw) {
+    // LEDs actives à l'état bas, dans l'ordre HID (Num, Caps, Scroll)
+    ledState = ~raw & 0x07;
+}
+
+void ADBHIDReport::mouseRegister0(uint16_t raw) {
+    // Boutons actifs à l'état bas (bit 15 principal, bit 7 second bouton)
+    mouseButtons = ((raw & 0x8000) ? 0 : 0x01) | ((raw & 0x0080) ? 0 : 0x02);
+    mouseY += mouseAxis(raw >> 8);
+    mouseX += mouseAxis(raw);
+}
+
+bool ADBHIDReport::takeMouseReport(adb_hid_mouse_report& report) {
+    if (mouseX == 0 && mouseY == 0 && mouseButtons == reportedButtons) return false;
+
+    report.buttons = mouseButtons;
+    report.x = clampAxis(mouseX);
+    report.y = clampAxis(mouseY);
+    report.wheel = 0;
+    mouseX -= report.x;
+    mouseY -= report.y;
+    reportedButtons = mouseButtons;
+    return true;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file ADBHIDReport.h
+ * @brief Construction des rapports HID (protocole boot) à partir des registres ADB
+ *
+ * Logique commune aux ponts USB et BLE: suivi des touches enfoncées à partir
+ * des événements du registre 0 du clavier, conversion par ADBKeymap,
+ * modificateurs, saturation à 6 touches (ErrorRollOver), cumul des mouvements
+ * de la souris et état des LEDs écrit par Listen registre 2. Indépendante du
+ * bus, elle s'exécute à l'identique sur la cible et lors d'une relecture de
+ * journal (ADBRecorder) sur l'hôte.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_HID_REPORT_h
+#define ADB_HID_REPORT_h
+
+#include <Arduino.h>
+#include <cstdint>
+
+/**
+ * @brief Rapport clavier HID (protocole boot, 8 octets)
+ */
+struct adb_hid_keyboard_report {
+    uint8_t modifiers;   // Bits des modificateurs (ADB_KEY_MOD_*)
+    uint8_t reserved;
+    uint8_t keys[6];     // Codes HID des touches enfoncées, 0 = emplacement libre
+};
+
+/**
+ * @brief Rapport souris HID (protocole boot avec molette, 4 octets)
+ */
+struct adb_hid_mouse_report {
+    uint8_t buttons;     // Bit 0 = bouton principal, bit 1 = second bouton
+    int8_t x;
+    int8_t y;
+    int8_t wheel;
+};
+
+/**
+ * @brief Constructeur de rapports HID
+ */
+class ADBHIDReport {
+public:
+    static constexpr uint8_t MAX_KEYS = 6;
+
+    ADBHIDReport() { reset(); }
+
+    /**
+     * @brief Relâche toutes les touches et vide les mouvements en attente
+     */
+    void reset();
+
+    /**
+     * @brief Applique un registre 0 du clavier (deux événements au plus)
+     * @param raw Valeur du registre
+     * @return true si le rapport clavier a changé
+     */
+    bool keyboardRegister0(uint16_t raw);
+
+    /**
+     * @brief Applique un événement de touche
+     * @param adbCode Code ADB (7 bits)
+     * @param released Touche relâchée
+     * @return true si le rapport clavier a changé
+     */
+    bool keyEvent(uint8_t adbCode, bool released);
+
+    /**
+     * @brief Rapport clavier courant
+     */
+    const adb_hid_keyboard_report& keyboardReport() const { return keyboard; }
+
+    /**
+     * @brief Mémorise une écriture du registre 2 du clavier (Listen)
+     * @param raw Valeur écrite
+     */
+    void keyboardRegister2Written(uint16_t raw);
+
+    /**
+     * @brief LEDs du clavier au format HID (bit 0 Num Lock, bit 1 Caps Lock, bit 2 Scroll Lock)
+     */
+    uint8_t leds() const { return ledState; }
+
+    /**
+     * @brief Applique un registre 0 de la souris (mouvement cumulé)
+     * @param raw Valeur du registre
+     */
+    void mouseRegister0(uint16_t raw);
+
+    /**
+     * @brief Prend le prochain rapport souris
+     *
+     * Les mouvements au-delà de ±127 restent cumulés pour le rapport suivant.
+     * @param report Rapport à émettre
+     * @return false si aucun mouvement ni changement de bouton n'est en attente
+     */
+    bool takeMouseReport(adb_hid_mouse_report& report);
+
+private:
+    void rebuildKeys();
+
+    adb_hid_keyboard_report keyboard;
+    uint8_t keysDown[16];     // Touches non modificatrices enfoncées (codes ADB)
+    uint8_t order[MAX_KEYS];  // Codes ADB rapportés, dans l'ordre d'appui
+    uint8_t orderCount;       // Entrées valides de order
+    uint8_t hiddenKeys;       // Touches enfoncées au-delà de MAX_KEYS
+    uint8_t ledState;
+    int32_t mouseX;           // Mouvement non encore rapporté
+    int32_t mouseY;
+    uint8_t mouseButtons;
+    uint8_t reportedButtons;
+};
+
+#endif // ADB_HID_REPORT_h
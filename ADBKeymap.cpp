@@ -1,8 +1,10 @@
 #include "ADBKeymap.h"
 #include "HIDTables.h" 
+#include <Arduino.h>
+#include "ADBPlatform.h"
 
 // Définition du tableau de conversion ADB vers HID
-const uint8_t ADBKeymap::keyCodeTable[128] = {
+const uint8_t ADB_HOT_DATA ADBKeymap::keyCodeTable[128] = {
  /* 0x00 = */ ADB_KEY_A,
     /* 0x01 = */ ADB_KEY_S,
     /* 0x02 = */ ADB_KEY_D,
@@ -133,7 +135,7 @@ const uint8_t ADBKeymap::keyCodeTable[128] = {
     /* 0x7f = */ ADB_KEY_POWER, // Special key, repeated in both bytes of the register
 };
 
-bool ADBKeymap::isNumericKeypadKey(uint8_t hid_keycode) {
+bool ADB_HOT ADBKeymap::isNumericKeypadKey(uint8_t hid_keycode) {
     // Codes HID pour les touches du pavé numérique (0x52 à 0x63)
     return (hid_keycode >= ADB_KEY_KPSLASH && hid_keycode <= ADB_KEY_KPDOT) || 
            (hid_keycode == ADB_KEY_KPEQUAL);
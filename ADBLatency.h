@@ -0,0 +1,192 @@
+/**
+ * @file ADBLatency.h
+ * @brief Histogrammes de latence entre un événement ADB et le rapport HID émis
+ *
+ * ADBDevices horodate chaque interrogation du registre 0 (clavier et souris);
+ * le pont (BLE, USB) signale l'émission de chaque rapport HID. La latence d'un
+ * rapport est comptée depuis l'interrogation précédant le premier événement non
+ * encore rapporté: l'événement physique a eu lieu après elle, la valeur est donc
+ * une borne supérieure qui inclut l'attente due à la stratégie d'interrogation.
+ *
+ * Les histogrammes ont des classes logarithmiques fixes (puissances de 2 en µs),
+ * sans allocation.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_LATENCY_h
+#define ADB_LATENCY_h
+
+#include <Arduino.h>
+#include <cstdint>
+#include <string.h>
+
+/**
+ * @brief Chemin mesuré
+ */
+enum class ADBLatencyPath : uint8_t {
+    KEYBOARD = 0,
+    MOUSE = 1
+};
+
+/**
+ * @brief Histogramme à classes logarithmiques
+ *
+ * La classe i regroupe les latences de [2^i, 2^(i+1)) µs; la classe 0 inclut 0
+ * et la dernière classe toutes les valeurs au-delà de 2^19 µs (~0,5 s).
+ */
+class ADBLatencyHistogram {
+public:
+    static constexpr uint8_t BUCKETS = 20;
+
+    ADBLatencyHistogram() { reset(); }
+
+    void reset() {
+        memset(counts, 0, sizeof(counts));
+        samples = 0;
+        maxUs = 0;
+        totalUs = 0;
+    }
+
+    /**
+     * @brief Ajoute une mesure
+     * @param us Latence en microsecondes
+     */
+    void record(uint32_t us) {
+        uint8_t bucket = us ? static_cast<uint8_t>(sizeof(unsigned long) * 8 - 1 - __builtin_clzl(us)) : 0;
+        if (bucket >= BUCKETS) bucket = BUCKETS - 1;
+        if (counts[bucket] != UINT32_MAX) counts[bucket]++;
+        samples++;
+        totalUs += us;
+        if (us > maxUs) maxUs = us;
+    }
+
+    /**
+     * @brief Borne supérieure de la classe contenant le percentile demandé (limitée au maximum observé)
+     * @param percent Percentile (1-100)
+     * @return Latence en µs (0 si aucune mesure)
+     */
+    uint32_t percentile(uint8_t percent) const {
+        if (samples == 0) return 0;
+        uint64_t rank = (static_cast<uint64_t>(samples) * percent + 99) / 100;
+        uint64_t seen = 0;
+        for (uint8_t i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint32_t bound = (i == BUCKETS - 1) ? maxUs : (2UL << i);
+                return bound < maxUs ? bound : maxUs;
+            }
+        }
+        return maxUs;
+    }
+
+    uint32_t count() const { return samples; }
+    uint32_t max() const { return maxUs; }
+    uint32_t mean() const { return samples ? static_cast<uint32_t>(totalUs / samples) : 0; }
+    uint32_t bucket(uint8_t index) const { return index < BUCKETS ? counts[index] : 0; }
+
+private:
+    uint32_t counts[BUCKETS];  // Nombre de mesures par classe
+    uint32_t samples;          // Nombre total de mesures
+    uint32_t maxUs;            // Latence maximale observée
+    uint64_t totalUs;          // Somme des latences (moyenne)
+};
+
+/**
+ * @brief Suivi des latences clavier et souris
+ */
+class ADBLatencyTracker {
+public:
+    ADBLatencyTracker() : channels{} {}
+
+    /**
+     * @brief Interrogation du registre 0 (appelé par ADBDevices)
+     * @param path Clavier ou souris
+     * @param at Date de l'interrogation (micros)
+     * @param eventDecoded Le périphérique a répondu avec un événement
+     */
+    void polled(ADBLatencyPath path, uint32_t at, bool eventDecoded) {
+        channel& c = channels[static_cast<uint8_t>(path)];
+        if (eventDecoded && !c.pending) {
+            // L'événement est survenu après l'interrogation précédente
+            c.eventAt = c.polledBefore ? c.lastPoll : at;
+            c.pending = true;
+        }
+        c.lastPoll = at;
+        c.polledBefore = true;
+    }
+
+    /**
+     * @brief Émission d'un rapport HID par le pont
+     * @param path Clavier ou souris
+     */
+    void reportSent(ADBLatencyPath path) {
+        channel& c = channels[static_cast<uint8_t>(path)];
+        if (!c.pending) return;
+        c.histogram.record(micros() - c.eventAt);
+        c.pending = false;
+    }
+
+    const ADBLatencyHistogram& histogram(ADBLatencyPath path) const {
+        return channels[static_cast<uint8_t>(path)].histogram;
+    }
+
+    /**
+     * @brief Efface les mesures des deux chemins
+     */
+    void reset() {
+        for (channel& c : channels) {
+            c.histogram.reset();
+            c.pending = false;
+        }
+    }
+
+    /**
+     * @brief Imprime les deux histogrammes sur une ligne chacun
+     *
+     * Format: "K n=<mesures> moy=<µs> p50=<µs> p99=<µs> max=<µs> | <classe>:<nombre> ..."
+     * où seules les classes non vides apparaissent (classe i = [2^i, 2^(i+1)) µs).
+     */
+    void dump(Print& out) const {
+        dumpChannel(out, 'K', channels[0].histogram);
+        dumpChannel(out, 'M', channels[1].histogram);
+    }
+
+private:
+    struct channel {
+        ADBLatencyHistogram histogram;
+        uint32_t lastPoll;    // Date de la dernière interrogation
+        uint32_t eventAt;     // Début du premier événement non rapporté
+        bool polledBefore;    // lastPoll est valide
+        bool pending;         // Un événement attend son rapport
+    };
+
+    static void dumpChannel(Print& out, char tag, const ADBLatencyHistogram& h) {
+        out.print(tag);
+        out.print(F(" n="));
+        out.print(h.count());
+        out.print(F(" moy="));
+        out.print(h.mean());
+        out.print(F(" p50="));
+        out.print(h.percentile(50));
+        out.print(F(" p99="));
+        out.print(h.percentile(99));
+        out.print(F(" max="));
+        out.print(h.max());
+        out.print(F(" |"));
+        for (uint8_t i = 0; i < ADBLatencyHistogram::BUCKETS; i++) {
+            if (h.bucket(i) == 0) continue;
+            out.print(' ');
+            out.print(i);
+            out.print(':');
+            out.print(h.bucket(i));
+        }
+        out.println();
+    }
+
+    channel channels[2];
+};
+
+#endif // ADB_LATENCY_h
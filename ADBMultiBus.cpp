@@ -0,0 +1,446 @@
+/**
+ * @file ADBMultiBus.cpp
+ * @brief Implémentation de l'ordonnanceur multi-bus
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBMultiBus.h"
+
+namespace {
+    constexpr uint8_t PACKET_CELLS = 17;     // Bit de début et 16 bits de données
+
+    inline bool reached(uint32_t now, uint32_t due) { return static_cast<int32_t>(now - due) >= 0; }
+}
+
+ADBMultiBus::ADBMultiBus(ResultHandler handler, void* context)
+    : handler(handler), context(context), config{MAX_BUSES, 2000, 200}, lanes{}, count(0), active(0),
+      cursor(0), grants(0), activeSince(0), activeWindowUs(0), windowStart(0), last{} {}
+
+uint8_t ADBMultiBus::addBus(ADB& adb, uint8_t weight) {
+    if (count >= MAX_BUSES) return 0xFF;
+    Lane& lane = lanes[count];
+    lane = Lane{};
+    lane.adb = &adb;
+    lane.pin = adb.pin();
+    lane.weight = weight ? weight : 1;
+    lane.phase = Phase::IDLE;
+    return count++;
+}
+
+bool ADBMultiBus::begin() {
+    bool ok = true;
+    for (uint8_t i = 0; i < count; i++) {
+        Lane& lane = lanes[i];
+        if (!lane.adb->init()) ok = false;
+        lane.fault = lane.adb->lineFault();
+        lane.readyAt = micros();
+        lane.nextPollAt = lane.readyAt;
+    }
+    resetStats();
+    return ok;
+}
+
+void ADBMultiBus::setConfig(const adb_multibus_config& config) {
+    this->config = config;
+    if (this->config.maxActive == 0) this->config.maxActive = 1;
+}
+
+void ADBMultiBus::pollDevice(uint8_t bus, uint8_t addr, bool enabled) {
+    if (bus >= count) return;
+    Lane& lane = lanes[bus];
+    uint16_t bit = 1u << (addr & 0x0F);
+    if (enabled) {
+        lane.pollMask |= bit;
+        if (!(lane.pollMask & (1u << lane.activePoll))) lane.activePoll = addr & 0x0F;
+    } else {
+        lane.pollMask &= ~bit;
+    }
+}
+
+bool ADBMultiBus::enqueue(uint8_t bus, uint8_t command, uint16_t data) {
+    if (bus >= count) return false;
+    Lane& lane = lanes[bus];
+    if (lane.queued >= QUEUE_SIZE) return false;
+    lane.queue[(lane.head + lane.queued) % QUEUE_SIZE] = {command, data};
+    lane.queued++;
+    return true;
+}
+
+bool ADBMultiBus::talk(uint8_t bus, uint8_t addr, uint8_t reg) {
+    using namespace ADBProtocol;
+    return enqueue(bus, CMD_TALK | ADDRESS(addr & 0x0F) | REGISTER(reg & 0x03), 0);
+}
+
+bool ADBMultiBus::listen(uint8_t bus, uint8_t addr, uint8_t reg, uint16_t value) {
+    using namespace ADBProtocol;
+    return enqueue(bus, CMD_LISTEN | ADDRESS(addr & 0x0F) | REGISTER(reg & 0x03), value);
+}
+
+bool ADBMultiBus::flush(uint8_t bus, uint8_t addr) {
+    using namespace ADBProtocol;
+    return enqueue(bus, CMD_FLUSH | ADDRESS(addr & 0x0F), 0);
+}
+
+bool ADBMultiBus::idle() const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (lanes[i].phase != Phase::IDLE || lanes[i].queued) return false;
+    }
+    return true;
+}
+
+bool ADBMultiBus::hasWork(const Lane& lane, uint32_t now) const {
+    if (lane.phase != Phase::IDLE) return false;
+    return lane.queued || (lane.pollMask && reached(now, lane.nextPollAt));
+}
+
+void ADBMultiBus::poll() {
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < count; i++) {
+        if (lanes[i].phase != Phase::IDLE) step(lanes[i], now);
+    }
+    grant(now);
+    rollWindow(now);
+}
+
+uint32_t ADBMultiBus::service(uint32_t yieldUs) {
+    for (;;) {
+        poll();
+        uint32_t now = micros();
+        uint32_t wait = UINT32_MAX;
+        bool pressing = false;
+        for (uint8_t i = 0; i < count; i++) {
+            const Lane& lane = lanes[i];
+            uint32_t due;
+            if (lane.phase == Phase::SRQ || lane.phase == Phase::TLT || lane.phase == Phase::RECEIVE) {
+                due = now;   // Ligne à scruter en continu
+            } else if (lane.phase != Phase::IDLE) {
+                due = lane.due;
+            } else if (lane.queued) {
+                due = lane.readyAt;
+            } else if (lane.pollMask) {
+                due = static_cast<int32_t>(lane.nextPollAt - lane.readyAt) > 0 ? lane.nextPollAt : lane.readyAt;
+            } else {
+                continue;
+            }
+            uint32_t remaining = reached(now, due) ? 0 : due - now;
+            if (remaining < wait) wait = remaining;
+            // Seules les transactions en cours retiennent la boucle: un démarrage peut attendre le prochain appel
+            if (lane.phase != Phase::IDLE && remaining <= yieldUs) pressing = true;
+        }
+        if (!pressing) return wait;
+    }
+}
+
+void ADBMultiBus::grant(uint32_t now) {
+    while (active < config.maxActive && count) {
+        // Tourniquet pondéré: le bus du curseur garde la main tant que sa part n'est pas épuisée
+        int8_t chosen = -1;
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t bus = (cursor + i) % count;
+            if (i == 0 && grants >= lanes[bus].weight) continue;
+            if (hasWork(lanes[bus], now)) {
+                chosen = static_cast<int8_t>(bus);
+                break;
+            }
+        }
+        if (chosen < 0) {
+            if (!hasWork(lanes[cursor], now)) return;
+            chosen = static_cast<int8_t>(cursor);
+            grants = 0;
+        }
+        if (chosen != cursor) {
+            cursor = static_cast<uint8_t>(chosen);
+            grants = 0;
+        }
+
+        // La place reste réservée au bus choisi pendant le repos de sa ligne
+        Lane& lane = lanes[chosen];
+        if (!reached(now, lane.readyAt)) return;
+        startTransaction(lane, now);
+        grants++;
+    }
+}
+
+void ADBMultiBus::startTransaction(Lane& lane, uint32_t now) {
+    using namespace ADBProtocol;
+
+    // File explicite en priorité, sinon Talk R0 du périphérique interrogé par défaut
+    if (lane.queued) {
+        const Request& request = lane.queue[lane.head];
+        lane.command = request.command;
+        lane.data = request.data;
+        lane.head = (lane.head + 1) % QUEUE_SIZE;
+        lane.queued--;
+        lane.polledTransaction = false;
+    } else {
+        lane.command = CMD_TALK | ADDRESS(lane.activePoll) | REGISTER(0);
+        lane.data = 0;
+        lane.polledTransaction = true;
+        lane.nextPollAt = now + config.pollIntervalUs;
+    }
+
+    if (active++ == 0) activeSince = now;
+    lane.stats.transactions++;
+    lane.start = now;
+    lane.srq = false;
+
+    // Une ligne bloquée basse au repos ne permet aucune transaction
+    if (digitalRead(lane.pin) == LOW) {
+        lane.fault = LineFault::STUCK_LOW;
+        finish(lane, now, Status::BUS_FAULT);
+        return;
+    }
+    drive(lane, LOW);
+    lane.phase = Phase::ATTENTION;
+    lane.due = now + lane.adb->hostTiming().attentionUs;
+}
+
+void ADBMultiBus::beginCells(Lane& lane, uint32_t bits, uint8_t cells, bool packet) {
+    lane.shift = bits;
+    lane.cells = cells;
+    lane.packet = packet;
+    bool bit = (bits >> (cells - 1)) & 1;
+    const adb_host_timing& timing = lane.adb->hostTiming();
+    drive(lane, LOW);
+    lane.phase = Phase::CELL_LOW;
+    lane.due += bit ? timing.shortPhaseUs : timing.longPhaseUs;
+}
+
+void ADBMultiBus::drive(Lane& lane, bool level) {
+    digitalWrite(lane.pin, level ? HIGH : LOW);
+}
+
+void ADBMultiBus::step(Lane& lane, uint32_t now) {
+    using namespace ADBProtocol;
+
+    // Phases de réception: la ligne est lue à chaque passage
+    if (lane.phase == Phase::RECEIVE) {
+        bool level = digitalRead(lane.pin) == HIGH;
+        if (level != lane.line) receive(lane, now, level);
+        else if (now - lane.edgeAt > BIT_PHASE_MAX) finish(lane, now, Status::BIT_ERROR);
+        return;
+    }
+    if (lane.phase == Phase::TLT) {
+        if (digitalRead(lane.pin) == LOW) {
+            lane.phase = Phase::RECEIVE;
+            lane.line = false;
+            lane.edgeAt = now;
+            lane.received = 0;
+            lane.data = 0;
+        } else if (reached(now, lane.due)) {
+            finish(lane, now, Status::NO_RESPONSE);
+        }
+        return;
+    }
+
+    uint32_t reference = lane.due;
+    if (lane.phase == Phase::SRQ) {
+        if (digitalRead(lane.pin) == LOW) {
+            if (now - lane.edgeAt > SRQ_TIMEOUT) {
+                lane.fault = LineFault::STUCK_LOW;
+                finish(lane, now, Status::BUS_FAULT);
+            }
+            return;
+        }
+        // Fin du SRQ: le Tlt court à partir de la remontée de la ligne
+        reference = now;
+    } else {
+        // Phases d'émission: rien avant l'échéance
+        if (!reached(now, lane.due)) return;
+        uint32_t late = now - lane.due;
+        if (late > lane.stats.maxLateUs) lane.stats.maxLateUs = static_cast<uint16_t>(late > 0xFFFF ? 0xFFFF : late);
+    }
+
+    // Durées émises propres à chaque bus
+    const adb_host_timing& timing = lane.adb->hostTiming();
+    switch (lane.phase) {
+        case Phase::ATTENTION:
+            // Une ligne restée haute alors qu'elle est tirée vers le bas est en court-circuit
+            if (digitalRead(lane.pin) == HIGH) {
+                lane.fault = LineFault::STUCK_HIGH;
+                finish(lane, now, Status::BUS_FAULT);
+                return;
+            }
+            drive(lane, HIGH);
+            lane.phase = Phase::SYNC;
+            lane.due += timing.syncUs;
+            break;
+
+        case Phase::SYNC:
+            // Commande suivie du bit d'arrêt
+            beginCells(lane, static_cast<uint32_t>(lane.command) << 1, 9, false);
+            break;
+
+        case Phase::CELL_LOW: {
+            bool bit = (lane.shift >> (lane.cells - 1)) & 1;
+            drive(lane, HIGH);
+            if (lane.cells > 1) {
+                lane.phase = Phase::CELL_HIGH;
+                lane.due += bit ? timing.longPhaseUs : timing.shortPhaseUs;
+            } else if (lane.packet) {
+                finish(lane, now, Status::OK);
+            } else {
+                // Un SRQ se constate à la fin de la partie haute nominale du bit d'arrêt
+                lane.phase = Phase::STOP;
+                lane.edgeAt = lane.due;
+                lane.due += timing.shortPhaseUs;
+            }
+            break;
+        }
+
+        case Phase::CELL_HIGH: {
+            lane.cells--;
+            bool bit = (lane.shift >> (lane.cells - 1)) & 1;
+            drive(lane, LOW);
+            lane.phase = Phase::CELL_LOW;
+            lane.due += bit ? timing.shortPhaseUs : timing.longPhaseUs;
+            break;
+        }
+
+        case Phase::STOP:
+            if (digitalRead(lane.pin) == LOW) {
+                lane.srq = true;
+                lane.stats.srqs++;
+                lane.phase = Phase::SRQ;
+                return;
+            }
+            reference = lane.edgeAt;
+            // fallthrough
+        case Phase::SRQ:
+            if ((lane.command & 0x0C) == CMD_TALK) {
+                lane.phase = Phase::TLT;
+                lane.due = reference + TLT_WINDOW;
+            } else if ((lane.command & 0x0C) == CMD_LISTEN) {
+                lane.phase = Phase::LISTEN_TLT;
+                // Relâchement du bit d'arrêt -> bit de début, comme ADB::waitTLT
+                lane.due = reference + timing.shortPhaseUs + timing.tltUs;
+            } else {
+                finish(lane, now, Status::OK);
+            }
+            break;
+
+        case Phase::LISTEN_TLT:
+            // Bit de début, 16 bits de données, bit d'arrêt
+            beginCells(lane, (1UL << 17) | (static_cast<uint32_t>(lane.data) << 1), 18, true);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ADBMultiBus::receive(Lane& lane, uint32_t now, bool level) {
+    uint32_t elapsed = now - lane.edgeAt;
+    lane.edgeAt = now;
+    lane.line = level;
+    if (level) {
+        lane.lowUs = elapsed;
+        return;
+    }
+
+    // Front descendant: fin d'une cellule
+    uint8_t bit = ADBProtocol::decodeBitCell(lane.lowUs, elapsed);
+    if (lane.received == 0 && bit != 0x1) {
+        finish(lane, now, ADBProtocol::Status::BIT_ERROR);
+        return;
+    }
+    if (lane.received > 0) lane.data = static_cast<uint16_t>((lane.data << 1) | bit);
+
+    // Le bit d'arrêt qui commence n'est pas vérifié, comme dans ADB::readDataPacket
+    if (++lane.received == PACKET_CELLS) finish(lane, now, ADBProtocol::Status::OK);
+}
+
+void ADBMultiBus::finish(Lane& lane, uint32_t now, ADBProtocol::Status status) {
+    using namespace ADBProtocol;
+    uint8_t addr = (lane.command >> 4) & 0x0F;
+    bool isTalk = (lane.command & 0x0C) == CMD_TALK;
+    digitalWrite(lane.pin, HIGH);
+
+    switch (status) {
+        case Status::OK:
+            if (isTalk) {
+                lane.stats.talks++;
+                lane.present |= 1u << addr;
+            }
+            break;
+        case Status::NO_RESPONSE: lane.stats.noResponse++; break;
+        case Status::BIT_ERROR: lane.stats.bitErrors++; break;
+        case Status::BUS_FAULT: lane.stats.busFaults++; break;
+    }
+
+    // Interrogation suivante: le périphérique qui répond reste interrogé, un SRQ fait tourner les adresses
+    if (lane.srq && lane.pollMask) {
+        uint8_t next = lane.activePoll;
+        do {
+            next = (next + 1) & 0x0F;
+        } while (!(lane.pollMask & (1u << next)));
+        lane.activePoll = next;
+        lane.nextPollAt = now;
+    }
+
+    // Après un paquet reçu, la ligne est occupée jusqu'à la fin du bit d'arrêt
+    uint32_t rest = config.gapUs + (isTalk && status == Status::OK ? BIT_CELL_MAX : 0);
+    if (status == Status::BUS_FAULT) rest = LINE_RELEASE_TIMEOUT;
+    lane.readyAt = now + rest;
+    lane.phase = Phase::IDLE;
+    lane.stats.busyWindowUs += now - lane.start;
+    lane.stats.windowTransactions++;
+    if (--active == 0) activeWindowUs += now - activeSince;
+
+    if (handler) {
+        adb_multibus_result result = {};
+        result.bus = static_cast<uint8_t>(&lane - lanes);
+        result.command = lane.command;
+        result.status = status;
+        result.data = lane.data;
+        result.srq = lane.srq;
+        result.polled = lane.polledTransaction;
+        handler(context, result);
+    }
+}
+
+void ADBMultiBus::rollWindow(uint32_t now) {
+    uint32_t span = now - windowStart;
+    if (span < 1000000UL) return;
+
+    // Ramène les compteurs de la fenêtre écoulée à une seconde
+    adb_multibus_throughput total = {};
+    for (uint8_t i = 0; i < count; i++) {
+        adb_multibus_stats& counters = lanes[i].stats;
+        counters.busyUsPerSecond = static_cast<uint32_t>(static_cast<uint64_t>(counters.busyWindowUs) * 1000000UL / span);
+        counters.transactionsPerSecond =
+            static_cast<uint32_t>(static_cast<uint64_t>(counters.windowTransactions) * 1000000UL / span);
+        counters.busyWindowUs = 0;
+        counters.windowTransactions = 0;
+        total.transactionsPerSecond += counters.transactionsPerSecond;
+        total.busyUsPerSecond += counters.busyUsPerSecond;
+    }
+    if (active) {
+        activeWindowUs += now - activeSince;
+        activeSince = now;
+    }
+    total.activeUsPerSecond = static_cast<uint32_t>(static_cast<uint64_t>(activeWindowUs) * 1000000UL / span);
+    if (total.activeUsPerSecond) {
+        total.parallelism = static_cast<uint16_t>(static_cast<uint64_t>(total.busyUsPerSecond) * 100 / total.activeUsPerSecond);
+    }
+    last = total;
+    activeWindowUs = 0;
+    windowStart = now;
+}
+
+adb_multibus_throughput ADBMultiBus::throughput() {
+    rollWindow(micros());
+    return last;
+}
+
+void ADBMultiBus::resetStats() {
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < count; i++) lanes[i].stats = adb_multibus_stats{};
+    windowStart = now;
+    activeSince = now;
+    activeWindowUs = 0;
+    last = adb_multibus_throughput{};
+}
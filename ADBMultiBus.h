@@ -0,0 +1,256 @@
+/**
+ * @file ADBMultiBus.h
+ * @brief Pilotage de plusieurs bus ADB indépendants depuis un seul cœur
+ *
+ * Deux instances ADB bloquantes sérialisent leurs transactions: pendant les
+ * 800 µs d'attention ou le Tlt d'un bus, le processeur attend sans rien
+ * faire. ADBMultiBus découpe chaque transaction en phases datées (attention,
+ * synchronisation, demi-cellules, Tlt, réception) et les exécute sur toutes
+ * les lignes à la fois: un seul passage de scrutation date les fronts reçus
+ * et émet les fronts arrivés à échéance de chaque bus. Les échéances sont
+ * calculées à partir des dates nominales, un front émis en retard ne décale
+ * donc pas les suivants.
+ *
+ * Chaque bus possède sa table de périphériques interrogés (Talk R0 à la
+ * manière d'un Macintosh: dernier périphérique ayant répondu, rotation sur
+ * SRQ) et une petite file de transactions explicites. Le nombre de bus en
+ * transaction simultanée et la part de chaque bus sont réglables.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_MULTI_BUS_h
+#define ADB_MULTI_BUS_h
+
+#include <Arduino.h>
+#include <cstdint>
+#include "ADB.h"
+
+/**
+ * @brief Transaction terminée sur l'un des bus
+ */
+struct adb_multibus_result {
+    uint8_t bus;                   // Indice du bus (ordre d'addBus)
+    uint8_t command;               // Octet de commande
+    ADBProtocol::Status status;    // OK, NO_RESPONSE, BIT_ERROR ou BUS_FAULT
+    uint16_t data;                 // Registre reçu (Talk) ou émis (Listen)
+    bool srq;                      // Bit d'arrêt prolongé par un autre périphérique
+    bool polled;                   // Interrogation automatique (et non transaction demandée)
+};
+
+/**
+ * @brief Paramètres d'ordonnancement
+ */
+struct adb_multibus_config {
+    uint8_t maxActive;             // Bus simultanément en transaction (1 = transactions sérialisées)
+    uint16_t pollIntervalUs;       // Délai minimal entre deux interrogations automatiques d'un bus
+    uint16_t gapUs;                // Repos de la ligne entre deux transactions d'un bus
+};
+
+/**
+ * @brief Compteurs d'un bus
+ */
+struct adb_multibus_stats {
+    adb_counter_t transactions;    // Commandes émises
+    adb_counter_t talks;           // Réponses reçues sans erreur
+    adb_counter_t noResponse;      // Talk restés sans réponse
+    adb_counter_t bitErrors;       // Réponses interrompues par une erreur de bit
+    adb_counter_t srqs;            // SRQ observés
+    adb_counter_t busFaults;       // Transactions abandonnées, ligne bloquée
+    uint16_t maxLateUs;            // Plus grand retard d'un front émis sur sa date nominale
+    uint32_t busyUsPerSecond;      // Occupation sur la dernière fenêtre d'une seconde
+    uint32_t busyWindowUs;         // Occupation accumulée dans la fenêtre courante
+    uint32_t transactionsPerSecond; // Transactions terminées sur la dernière fenêtre
+    uint32_t windowTransactions;   // Transactions terminées dans la fenêtre courante
+};
+
+/**
+ * @brief Débit agrégé sur la dernière fenêtre d'une seconde
+ */
+struct adb_multibus_throughput {
+    uint32_t transactionsPerSecond; // Tous bus confondus
+    uint32_t busyUsPerSecond;      // Somme des occupations (dépasse une seconde si les bus se chevauchent)
+    uint32_t activeUsPerSecond;    // Durée pendant laquelle au moins un bus était en transaction
+    uint16_t parallelism;          // busyUsPerSecond / activeUsPerSecond, en centièmes
+};
+
+/**
+ * @brief Ordonnanceur de transactions entrelacées sur plusieurs lignes ADB
+ *
+ * Les instances ADB servent à l'initialisation électrique (init, reset) et
+ * fournissent la broche; leurs méthodes bloquantes ne doivent pas être
+ * appelées tant que l'ordonnanceur a des transactions en cours.
+ */
+class ADBMultiBus {
+public:
+    static constexpr uint8_t MAX_BUSES = 4;
+    static constexpr uint8_t QUEUE_SIZE = 4;   // Transactions explicites en attente par bus
+
+    typedef void (*ResultHandler)(void* context, const adb_multibus_result& result);
+
+    /**
+     * @brief Constructeur
+     * @param handler Fonction appelée à la fin de chaque transaction (peut être nullptr)
+     * @param context Pointeur transmis à la fonction
+     */
+    ADBMultiBus(ResultHandler handler, void* context);
+
+    /**
+     * @brief Ajoute un bus
+     * @param adb Instance dont la broche est pilotée
+     * @param weight Transactions consécutives accordées au bus avant de céder sa place (équité)
+     * @return Indice du bus, 0xFF si MAX_BUSES est atteint
+     */
+    uint8_t addBus(ADB& adb, uint8_t weight = 1);
+
+    /**
+     * @brief Initialise et réinitialise chaque bus (bloquant, environ 3 ms par bus)
+     * @return false si l'une des lignes est en défaut
+     */
+    bool begin();
+
+    /**
+     * @brief Ajoute ou retire une adresse de la table d'interrogation d'un bus
+     */
+    void pollDevice(uint8_t bus, uint8_t addr, bool enabled = true);
+
+    /**
+     * @brief Met en file un Talk (prioritaire sur les interrogations automatiques)
+     * @return false si la file du bus est pleine
+     */
+    bool talk(uint8_t bus, uint8_t addr, uint8_t reg);
+
+    /**
+     * @brief Met en file un Listen (paquet de 16 bits)
+     */
+    bool listen(uint8_t bus, uint8_t addr, uint8_t reg, uint16_t value);
+
+    /**
+     * @brief Met en file un Flush
+     */
+    bool flush(uint8_t bus, uint8_t addr);
+
+    /**
+     * @brief Un passage de scrutation: fronts reçus, fronts à émettre, transactions à démarrer
+     */
+    void poll();
+
+    /**
+     * @brief Enchaîne les passages tant qu'une échéance est proche
+     *
+     * Rend la main lorsqu'aucune transaction en cours n'est en réception ni
+     * n'a d'échéance à moins de yieldUs (attention en cours, repos entre
+     * transactions): la boucle principale peut alors faire autre chose.
+     * @param yieldUs Marge en deçà de laquelle la scrutation continue
+     * @return Temps restant avant la prochaine échéance, démarrages compris (µs, 0 si déjà atteinte)
+     */
+    uint32_t service(uint32_t yieldUs = 100);
+
+    /**
+     * @brief Aucune transaction en cours ni en file
+     */
+    bool idle() const;
+
+    /**
+     * @brief Modifie les paramètres d'ordonnancement (maxActive vaut au moins 1)
+     */
+    void setConfig(const adb_multibus_config& config);
+    const adb_multibus_config& getConfig() const { return config; }
+
+    uint8_t buses() const { return count; }
+    const adb_multibus_stats& busStats(uint8_t bus) const { return lanes[bus].stats; }
+
+    /**
+     * @brief Périphériques d'un bus ayant répondu au moins une fois (bitmap par adresse)
+     */
+    uint16_t presentDevices(uint8_t bus) const { return lanes[bus].present; }
+
+    /**
+     * @brief Dernier défaut de ligne d'un bus
+     */
+    ADBProtocol::LineFault lineFault(uint8_t bus) const { return lanes[bus].fault; }
+
+    /**
+     * @brief Débit agrégé, fenêtre close au plus tard à l'appel
+     */
+    adb_multibus_throughput throughput();
+
+    void resetStats();
+
+private:
+    enum class Phase : uint8_t {
+        IDLE,         // Pas de transaction
+        ATTENTION,    // Ligne tirée 800 µs
+        SYNC,         // Ligne relâchée 70 µs
+        CELL_LOW,     // Partie basse d'une cellule émise
+        CELL_HIGH,    // Partie haute d'une cellule émise
+        STOP,         // Bit d'arrêt de la commande relâché: SRQ éventuel
+        SRQ,          // Bit d'arrêt prolongé par un périphérique
+        TLT,          // Attente du bit de début de la réponse
+        RECEIVE,      // Réception des cellules
+        LISTEN_TLT    // Tlt avant le paquet d'un Listen
+    };
+
+    struct Request {
+        uint8_t command;
+        uint16_t data;
+    };
+
+    struct Lane {
+        ADB* adb;
+        uint8_t pin;
+        uint8_t weight;
+        Phase phase;
+        uint32_t due;             // Prochaine échéance (micros)
+        uint32_t start;           // Début de la transaction
+        uint32_t edgeAt;          // Dernier front reçu
+        uint32_t lowUs;           // Partie basse de la cellule reçue
+        bool line;                // Dernier niveau lu en réception
+        uint8_t command;
+        bool polledTransaction;
+        bool srq;
+        uint32_t shift;           // Cellules restant à émettre, premier bit en poids fort
+        uint8_t cells;
+        bool packet;              // Les cellules émises sont celles du paquet d'un Listen
+        uint16_t data;
+        uint8_t received;         // Cellules reçues, bit de début compris
+        uint16_t pollMask;        // Table d'interrogation
+        uint16_t present;         // Adresses ayant répondu
+        uint8_t activePoll;       // Adresse interrogée par défaut
+        uint32_t readyAt;         // Date de la prochaine transaction possible
+        uint32_t nextPollAt;      // Date de la prochaine interrogation automatique
+        Request queue[QUEUE_SIZE];
+        uint8_t head;             // Plus ancienne transaction en file
+        uint8_t queued;           // Transactions en file
+        ADBProtocol::LineFault fault;
+        adb_multibus_stats stats;
+    };
+
+    bool enqueue(uint8_t bus, uint8_t command, uint16_t data);
+    bool hasWork(const Lane& lane, uint32_t now) const;
+    void grant(uint32_t now);
+    void startTransaction(Lane& lane, uint32_t now);
+    void step(Lane& lane, uint32_t now);
+    void receive(Lane& lane, uint32_t now, bool level);
+    void beginCells(Lane& lane, uint32_t bits, uint8_t cells, bool packet);
+    void drive(Lane& lane, bool level);
+    void finish(Lane& lane, uint32_t now, ADBProtocol::Status status);
+    void rollWindow(uint32_t now);
+
+    ResultHandler handler;
+    void* context;
+    adb_multibus_config config;
+    Lane lanes[MAX_BUSES];
+    uint8_t count;
+    uint8_t active;               // Bus en transaction
+    uint8_t cursor;               // Prochain bus servi (tourniquet)
+    uint8_t grants;               // Transactions consécutives accordées au bus du curseur
+    uint32_t activeSince;         // Début de la période avec au moins un bus actif
+    uint32_t activeWindowUs;
+    uint32_t windowStart;
+    adb_multibus_throughput last;
+};
+
+#endif // ADB_MULTI_BUS_h
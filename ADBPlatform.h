@@ -46,6 +46,12 @@
     #define ADB_PLATFORM_NAME "Teensy"
     #define ADB_DEFAULT_PIN 3
     
+#elif defined(ADB_NATIVE)
+    // Exécution sur l'hôte avec le simulateur de bus (examples/platformio_native_simulator)
+    #define ADB_PLATFORM_NATIVE
+    #define ADB_PLATFORM_NAME "Simulateur natif"
+    #define ADB_DEFAULT_PIN 2
+    
 #else
     #define ADB_PLATFORM_UNKNOWN
     #define ADB_PLATFORM_NAME "Plateforme inconnue"
@@ -68,6 +74,122 @@
     #define ADB_SERIAL_BAUD 57600
 #endif
 
+// Compteur de cycles CPU pour les mesures de performance
+#if defined(ADB_PLATFORM_ESP32)
+    #define ADB_CYCLE_COUNTER_NAME "CCOUNT"
+#elif (defined(ADB_PLATFORM_STM32) && defined(DWT)) || defined(ADB_PLATFORM_TEENSY)
+    #define ADB_CYCLE_COUNTER_DWT
+    #define ADB_CYCLE_COUNTER_NAME "DWT_CYCCNT"
+#elif defined(ADB_PLATFORM_AVR)
+    #define ADB_CYCLE_COUNTER_NAME "micros x F_CPU"
+#elif defined(ADB_PLATFORM_NATIVE) && (defined(__x86_64__) || defined(__i386__))
+    #define ADB_CYCLE_COUNTER_NAME "TSC hôte"
+#else
+    #define ADB_CYCLE_COUNTER_NAME "micros"
+#endif
+
+// Routines d'interruption en mémoire interne (exécutables pendant les accès à la flash sur ESP32)
+#if defined(ADB_PLATFORM_ESP32)
+    #define ADB_ISR_ATTR IRAM_ATTR
+#else
+    #define ADB_ISR_ATTR
+#endif
+
+// Chemin critique (PHY, décodeurs, table du clavier) hors de la flash: un défaut de cache
+// au milieu d'une cellule décale un front. ADB_HOT_SECTION et ADB_HOT_DATA_SECTION imposent
+// une section du script d'édition de liens (".ccmram", ".itcm_text"...); ADB_NO_HOT_PLACEMENT
+// laisse tout en flash. Vérification: examples/platformio_native_simulator (env:mapcheck).
+#if defined(ADB_NO_HOT_PLACEMENT)
+    #define ADB_HOT
+    #define ADB_HOT_DATA
+#else
+    #if defined(ADB_HOT_SECTION)
+        #define ADB_HOT __attribute__((section(ADB_HOT_SECTION)))
+    #elif defined(ADB_PLATFORM_ESP32)
+        #define ADB_HOT IRAM_ATTR
+    #elif defined(ADB_PLATFORM_TEENSY)
+        // ITCM sur Teensy 4, RAM sur Teensy 3
+        #define ADB_HOT FASTRUN
+    #elif defined(ADB_PLATFORM_STM32)
+        // Copiée en RAM au démarrage par les scripts STM32Cube
+        #define ADB_HOT __attribute__((section(".RamFunc")))
+    #else
+        #define ADB_HOT
+    #endif
+    #if defined(ADB_HOT_DATA_SECTION)
+        #define ADB_HOT_DATA __attribute__((section(ADB_HOT_DATA_SECTION)))
+    #elif defined(ADB_PLATFORM_ESP32)
+        #define ADB_HOT_DATA DRAM_ATTR
+    #else
+        // Teensy: constantes déjà en DTCM ou en RAM; STM32: flash sans défaut de cache (ART)
+        #define ADB_HOT_DATA
+    #endif
+#endif
+
+/**
+ * @brief Active le compteur de cycles si la plateforme l'exige (DWT des Cortex-M3/M4/M7)
+ */
+inline void adbCycleCounterInit() {
+#if defined(ADB_CYCLE_COUNTER_DWT) && defined(ADB_PLATFORM_TEENSY)
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#elif defined(ADB_CYCLE_COUNTER_DWT)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * @brief Lecture du compteur de cycles CPU (32 bits, différences modulo 2^32)
+ *
+ * Sur AVR, faute de compteur matériel, la valeur est dérivée de micros()
+ * (résolution de 4µs). Sur l'hôte, c'est le compteur de l'hôte: il mesure le
+ * coût de la bibliothèque et du simulateur, pas celui d'une cible.
+ */
+inline uint32_t adbCycleCount() {
+#if defined(ADB_PLATFORM_ESP32)
+    return ESP.getCycleCount();
+#elif defined(ADB_CYCLE_COUNTER_DWT) && defined(ADB_PLATFORM_TEENSY)
+    return ARM_DWT_CYCCNT;
+#elif defined(ADB_CYCLE_COUNTER_DWT)
+    return DWT->CYCCNT;
+#elif defined(ADB_PLATFORM_AVR)
+    return micros() * clockCyclesPerMicrosecond();
+#elif defined(ADB_PLATFORM_NATIVE) && (defined(__x86_64__) || defined(__i386__))
+    return static_cast<uint32_t>(__builtin_ia32_rdtsc());
+#else
+    return micros();
+#endif
+}
+
+/**
+ * @brief Masque les interruptions du cœur courant
+ *
+ * Sur ESP32, noInterrupts()/interrupts() d'arduino-esp32 sont vides: le niveau
+ * d'interruption du cœur est relevé directement (portDISABLE_INTERRUPTS), ce qui
+ * écarte les interruptions Arduino et celles de la pile BLE sur ce cœur. L'autre
+ * cœur continue de tourner. Toujours apparier avec adbUnmaskInterrupts().
+ */
+inline __attribute__((always_inline)) void adbMaskInterrupts() {
+#if defined(ADB_PLATFORM_ESP32)
+    portDISABLE_INTERRUPTS();
+#else
+    noInterrupts();
+#endif
+}
+
+/**
+ * @brief Rétablit les interruptions masquées par adbMaskInterrupts()
+ */
+inline __attribute__((always_inline)) void adbUnmaskInterrupts() {
+#if defined(ADB_PLATFORM_ESP32)
+    portENABLE_INTERRUPTS();
+#else
+    interrupts();
+#endif
+}
+
 /**
  * Fonction pour afficher les informations de plateforme
  */
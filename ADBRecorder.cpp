@@ -0,0 +1,103 @@
+/**
+ * @file ADBRecorder.cpp
+ * @brief Implémentation du journal d'événements ADB
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBRecorder.h"
+
+namespace {
+
+const uint8_t MAGIC[4] = {'A', 'D', 'B', 'R'};
+
+} // namespace
+
+ADBRecorder::ADBRecorder(uint8_t* storage, size_t capacity)
+    : buffer(storage), capacity(capacity), used(0), lastUs(0), events(0), lost(0), started(false) {
+    clear();
+}
+
+void ADBRecorder::clear() {
+    for (uint8_t i = 0; i < 4; i++) buffer[i] = MAGIC[i];
+    buffer[4] = FORMAT_VERSION;
+    buffer[5] = 0;
+    used = HEADER_SIZE;
+    events = 0;
+    lost = 0;
+    started = false;
+}
+
+bool ADBRecorder::record(uint8_t command, uint16_t value, uint32_t atUs) {
+    if (capacity - used < MAX_EVENT_SIZE) {
+        lost++;
+        return false;
+    }
+
+    uint32_t delta = started ? atUs - lastUs : 0;
+    lastUs = atUs;
+    started = true;
+
+    uint8_t* p = buffer + used;
+    *p++ = command;
+    while (delta >= 0x80) {
+        *p++ = static_cast<uint8_t>(delta | 0x80);
+        delta >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(delta);
+    *p++ = static_cast<uint8_t>(value >> 8);
+    *p++ = static_cast<uint8_t>(value);
+    used = static_cast<size_t>(p - buffer);
+    events++;
+    return true;
+}
+
+size_t ADBRecorder::drain(Print& out) {
+    size_t written = out.write(buffer, used);
+    used = 0;
+    return written;
+}
+
+ADBRecordReader::ADBRecordReader(const uint8_t* data, size_t size)
+    : cursor(data), end(data + size), atUs(0), headerValid(false), cut(false) {
+    if (size < ADBRecorder::HEADER_SIZE) return;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (data[i] != MAGIC[i]) return;
+    }
+    if (data[4] != ADBRecorder::FORMAT_VERSION) return;
+    headerValid = true;
+    cursor += ADBRecorder::HEADER_SIZE;
+}
+
+bool ADBRecordReader::next(adb_recorded_event& event) {
+    if (!headerValid || cursor >= end) return false;
+
+    const uint8_t* p = cursor;
+    event.command = *p++;
+    uint32_t delta = 0;
+    uint8_t shift = 0;
+    for (;;) {
+        if (p >= end || shift > 28) {
+            cut = true;
+            return false;
+        }
+        uint8_t byte = *p++;
+        delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+    }
+    if (end - p < 2) {
+        cut = true;
+        return false;
+    }
+    event.value = static_cast<uint16_t>((p[0] << 8) | p[1]);
+    p += 2;
+
+    atUs += delta;
+    event.deltaUs = delta;
+    event.atUs = atUs;
+    cursor = p;
+    return true;
+}
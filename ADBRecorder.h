@@ -0,0 +1,147 @@
+/**
+ * @file ADBRecorder.h
+ * @brief Journal binaire compact des événements décodés et relecture
+ *
+ * Lorsqu'un journal est attaché (ADBDevices::setRecorder), ADBDevices y
+ * consigne chaque registre 0 reçu du clavier et de la souris ainsi que chaque
+ * écriture Listen, horodatés. Le journal se vide par blocs sur une sortie Print
+ * (liaison série, fichier) et se relit sur l'hôte avec ADBRecordReader, par
+ * exemple à travers ADBHIDReport pour rejouer un rapport d'utilisateur.
+ *
+ * Format (octets):
+ *   En-tête  "ADBR", version, réservé
+ *   Événement  commande ADB (adresse << 4 | type << 2 | registre),
+ *              écart depuis l'événement précédent en µs (entier variable, 7 bits
+ *              par octet, bit de poids fort = octet suivant), valeur sur 16 bits
+ *              (poids fort en premier, comme sur le bus)
+ *
+ * Un événement occupe 4 octets lorsqu'il suit le précédent de moins de
+ * 128 µs (deux lectures d'une même interrogation), 5 octets jusqu'à 16 ms
+ * (interrogations successives) et 6 octets jusqu'à 2 s.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_RECORDER_h
+#define ADB_RECORDER_h
+
+#include <Arduino.h>
+#include <cstdint>
+
+/**
+ * @brief Événement relu depuis un journal
+ */
+struct adb_recorded_event {
+    uint32_t atUs;       // Date depuis le premier événement (µs, modulo 2^32)
+    uint32_t deltaUs;    // Écart avec l'événement précédent
+    uint8_t command;     // Commande ADB (Talk registre 0 ou Listen)
+    uint16_t value;      // Valeur du registre
+};
+
+/**
+ * @brief Journal d'événements dans un tampon préalloué
+ */
+class ADBRecorder {
+public:
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 6;
+    static constexpr size_t MAX_EVENT_SIZE = 8;  // Commande, écart (5 octets au plus), valeur
+
+    /**
+     * @brief Constructeur
+     * @param storage Tampon préalloué
+     * @param capacity Taille du tampon (au moins HEADER_SIZE + MAX_EVENT_SIZE)
+     */
+    ADBRecorder(uint8_t* storage, size_t capacity);
+
+    /**
+     * @brief Recommence un journal (nouvel en-tête, origine des dates remise à zéro)
+     */
+    void clear();
+
+    /**
+     * @brief Consigne un événement
+     * @param command Commande ADB
+     * @param value Valeur du registre
+     * @param atUs Date (micros)
+     * @return false si le tampon est plein (événement perdu, compté)
+     */
+    bool record(uint8_t command, uint16_t value, uint32_t atUs);
+
+    /**
+     * @brief Écrit le contenu du tampon sur une sortie puis le vide
+     *
+     * Les blocs successifs forment un journal continu; l'en-tête n'est émis
+     * qu'une fois, avec le premier bloc.
+     * @return Nombre d'octets écrits
+     */
+    size_t drain(Print& out);
+
+    size_t pending() const { return used; }
+    const uint8_t* data() const { return buffer; }
+    uint32_t recorded() const { return events; }
+    uint32_t dropped() const { return lost; }
+
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t used;          // Octets en attente dans le tampon
+    uint32_t lastUs;      // Date du dernier événement consigné
+    uint32_t events;      // Événements consignés
+    uint32_t lost;        // Événements perdus faute de place
+    bool started;         // Au moins un événement consigné
+};
+
+/**
+ * @brief Journal avec tampon intégré
+ * @tparam N Taille du tampon en octets
+ */
+template <size_t N>
+class ADBRecorderBuffer : public ADBRecorder {
+public:
+    static_assert(N >= HEADER_SIZE + MAX_EVENT_SIZE, "Tampon de journal trop petit");
+    ADBRecorderBuffer() : ADBRecorder(storage, N) {}
+
+private:
+    uint8_t storage[N];
+};
+
+/**
+ * @brief Lecture séquentielle d'un journal
+ */
+class ADBRecordReader {
+public:
+    /**
+     * @brief Constructeur
+     * @param data Journal complet (en-tête compris)
+     * @param size Taille du journal
+     */
+    ADBRecordReader(const uint8_t* data, size_t size);
+
+    /**
+     * @brief L'en-tête est reconnu
+     */
+    bool valid() const { return headerValid; }
+
+    /**
+     * @brief Lit l'événement suivant
+     * @return false à la fin du journal ou sur un événement tronqué
+     */
+    bool next(adb_recorded_event& event);
+
+    /**
+     * @brief Le journal se termine par un événement incomplet
+     */
+    bool truncated() const { return cut; }
+
+private:
+    const uint8_t* cursor;
+    const uint8_t* end;
+    uint32_t atUs;
+    bool headerValid;
+    bool cut;
+};
+
+#endif // ADB_RECORDER_h
@@ -0,0 +1,102 @@
+/**
+ * @file ADBSampleDecoder.cpp
+ * @brief Implémentation du décodage par échantillonnage
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBSampleDecoder.h"
+
+using namespace ADBProtocol;
+
+/**
+ * Parcours des paliers
+ */
+
+ADBRunReader::ADBRunReader(const uint32_t* words, size_t samples, ADBSampleOrder order)
+    : words(words), samples(samples), position(0), order(order), current(true) {
+    if (samples == 0) return;
+    uint32_t first = order == ADBSampleOrder::MSB_FIRST ? words[0] >> 31 : words[0] & 1;
+    current = first != 0;
+}
+
+uint32_t ADB_HOT ADBRunReader::next() {
+    uint32_t run = 0;
+    // Comparé au niveau courant, le mot ne contient des 1 qu'à partir du changement de niveau
+    uint32_t fill = current ? 0xFFFFFFFFUL : 0;
+
+    while (position < samples) {
+        uint8_t bit = position & 31;
+        uint32_t diff = words[position >> 5] ^ fill;
+        diff = order == ADBSampleOrder::MSB_FIRST ? diff << bit : diff >> bit;
+
+        uint8_t available = 32 - bit;
+        uint8_t same = available;
+        if (diff) same = order == ADBSampleOrder::MSB_FIRST ? countLeadingZeros(diff) : countTrailingZeros(diff);
+        if (same > samples - position) same = static_cast<uint8_t>(samples - position);
+
+        run += same;
+        position += same;
+        if (same < available && position < samples) {
+            current = !current;
+            return run;
+        }
+    }
+    current = !current;
+    return run;
+}
+
+/**
+ * Décodeur
+ */
+
+ADBSampleDecoder::ADBSampleDecoder(uint32_t sampleRateHz, ADBSampleOrder order)
+    : rateHz(sampleRateHz), sampleOrder(order), phaseMax(samplesFor(BIT_PHASE_MAX)) {}
+
+uint32_t ADBSampleDecoder::samplesFor(uint32_t us) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(us) * rateHz + 999999) / 1000000);
+}
+
+size_t ADBSampleDecoder::packetSamples(uint8_t length) const {
+    // Bit de début et données aux cellules les plus longues, jusqu'au front du bit d'arrêt
+    return samplesFor(static_cast<uint32_t>(length + 1) * BIT_CELL_MAX) + 2;
+}
+
+ADBProtocol::Status ADB_HOT ADBSampleDecoder::decodePacket(const uint32_t* words, size_t samples, uint16_t* buffer,
+                                                   uint8_t length) const {
+    ADBRunReader runs(words, samples, sampleOrder);
+
+    // Fin du Tlt: la capture a commencé avant le bit de début
+    if (runs.level()) {
+        runs.next();
+        if (runs.exhausted()) return Status::NO_RESPONSE;
+    }
+
+    // Bit de début puis bits de données: état bas, état haut terminé par le front suivant
+    uint16_t value = 0;
+    for (uint8_t cell = 0; cell <= length; cell++) {
+        uint32_t low = runs.next();
+        if (runs.exhausted() || low > phaseMax) return cell ? Status::BIT_ERROR : Status::NO_RESPONSE;
+        uint32_t high = runs.next();
+        if (runs.exhausted() || high > phaseMax) return cell ? Status::BIT_ERROR : Status::NO_RESPONSE;
+
+        uint8_t bit = decodeBitCell(low, high);
+        if (cell == 0) {
+            if (bit != 0x1) return Status::NO_RESPONSE;
+        } else {
+            value = static_cast<uint16_t>((value << 1) | bit);
+        }
+    }
+
+    *buffer = value;
+    return Status::OK;
+}
+
+/**
+ * Source d'échantillons
+ */
+
+ADBLineSampler::ADBLineSampler(uint32_t* storage, size_t words, uint32_t sampleRateHz, ADBSampleOrder order)
+    : storage(storage), words(words), sampleDecoder(sampleRateHz, order) {}
@@ -0,0 +1,154 @@
+/**
+ * @file ADBSampleDecoder.h
+ * @brief Réception par échantillonnage de la ligne à cadence fixe
+ *
+ * Plutôt que de scruter la ligne avec digitalRead (ADB::readCell), un
+ * périphérique matériel (SPI en réception sur MISO, DMA déclenché par un
+ * timer) échantillonne la ligne à 1 ou 2 MHz dans un tampon de bits. Les
+ * dates des fronts ne dépendent alors plus des interruptions qui retardent
+ * la boucle de scrutation.
+ *
+ * Le décodage est une fonction pure du tampon: les durées des paliers sont
+ * extraites un mot de 32 échantillons à la fois (comptage des zéros de tête
+ * ou de queue du mot comparé au niveau courant), puis chaque cellule est
+ * classée comme dans ADB::readDataPacket sans calibration (état bas plus court que l'état haut: 1).
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SAMPLE_DECODER_h
+#define ADB_SAMPLE_DECODER_h
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+#include "ADB.h"
+
+/**
+ * @brief Rang des échantillons dans un mot du tampon
+ */
+enum class ADBSampleOrder : uint8_t {
+    MSB_FIRST,   // Premier échantillon au bit 31 (SPI, octets remis dans l'ordre du mot)
+    LSB_FIRST    // Premier échantillon au bit 0 (DMA vers un port GPIO, capture série LSB)
+};
+
+/**
+ * @brief Parcours des paliers d'un tampon d'échantillons (1 = ligne haute)
+ */
+class ADBRunReader {
+public:
+    /**
+     * @param words Tampon d'échantillons
+     * @param samples Nombre d'échantillons valides
+     * @param order Rang des échantillons dans un mot
+     */
+    ADBRunReader(const uint32_t* words, size_t samples, ADBSampleOrder order);
+
+    /**
+     * @brief Niveau du prochain palier
+     */
+    bool level() const { return current; }
+
+    /**
+     * @brief Durée du prochain palier, en échantillons
+     * @return 0 à la fin du tampon (un palier coupé par la fin du tampon est rendu tel quel)
+     */
+    uint32_t next();
+
+    /**
+     * @brief Le dernier palier rendu s'arrête à la fin du tampon
+     */
+    bool exhausted() const { return position >= samples; }
+
+    static uint8_t countLeadingZeros(uint32_t x) { return static_cast<uint8_t>(__builtin_clzl(x) - (sizeof(unsigned long) - 4) * 8); }
+    static uint8_t countTrailingZeros(uint32_t x) { return static_cast<uint8_t>(__builtin_ctzl(x)); }
+
+private:
+    const uint32_t* words;
+    size_t samples;
+    size_t position;
+    ADBSampleOrder order;
+    bool current;
+};
+
+/**
+ * @brief Décodage d'un paquet de données à partir d'un tampon d'échantillons
+ */
+class ADBSampleDecoder {
+public:
+    /**
+     * @brief Constructeur
+     * @param sampleRateHz Cadence d'échantillonnage (1 à 4 MHz en pratique)
+     * @param order Rang des échantillons dans un mot
+     */
+    explicit ADBSampleDecoder(uint32_t sampleRateHz, ADBSampleOrder order = ADBSampleOrder::MSB_FIRST);
+
+    /**
+     * @brief Échantillons couvrant un paquet aux cellules les plus longues, jusqu'au début du bit d'arrêt
+     * @param length Nombre de bits de données
+     */
+    size_t packetSamples(uint8_t length) const;
+
+    /**
+     * @brief Décode un paquet dont le bit de début commence au plus tard avec le tampon
+     *
+     * Un palier haut en tête du tampon (fin du Tlt) est ignoré. Chaque
+     * demi-cellule doit durer au plus BIT_PHASE_MAX, comme dans ADB::readCell sans calibration;
+     * le bit d'arrêt n'est pas vérifié.
+     * @param words Tampon d'échantillons
+     * @param samples Nombre d'échantillons valides
+     * @param buffer Valeur reçue, premier bit en poids fort
+     * @param length Nombre de bits de données (16 au plus)
+     * @return OK, NO_RESPONSE (pas de bit de début à 1) ou BIT_ERROR (cellule hors tolérance, tampon trop court)
+     */
+    ADBProtocol::Status decodePacket(const uint32_t* words, size_t samples, uint16_t* buffer, uint8_t length) const;
+
+    uint32_t sampleRate() const { return rateHz; }
+    ADBSampleOrder order() const { return sampleOrder; }
+
+private:
+    uint32_t samplesFor(uint32_t us) const;
+
+    uint32_t rateHz;
+    ADBSampleOrder sampleOrder;
+    uint32_t phaseMax;     // BIT_PHASE_MAX en échantillons
+};
+
+/**
+ * @brief Source d'échantillons de la ligne (SPI, DMA, simulateur)
+ *
+ * Utilisée par ADB::readDataPacket à la place de readCell lorsqu'elle est
+ * attachée avec ADB::setSampler: la capture commence au front descendant du
+ * bit de début détecté par waitTLT.
+ */
+class ADBLineSampler {
+public:
+    /**
+     * @param storage Tampon préalloué
+     * @param words Taille du tampon en mots de 32 échantillons
+     * @param sampleRateHz Cadence d'échantillonnage
+     * @param order Rang des échantillons dans un mot après capture
+     */
+    ADBLineSampler(uint32_t* storage, size_t words, uint32_t sampleRateHz, ADBSampleOrder order);
+    virtual ~ADBLineSampler() {}
+
+    /**
+     * @brief Échantillonne la ligne à partir de maintenant (bloquant)
+     * @param samples Nombre d'échantillons, borné à capacity()
+     * @return Nombre d'échantillons capturés (0 en cas d'échec)
+     */
+    virtual size_t capture(size_t samples) = 0;
+
+    const uint32_t* samples() const { return storage; }
+    size_t capacity() const { return words * 32; }
+    const ADBSampleDecoder& decoder() const { return sampleDecoder; }
+
+protected:
+    uint32_t* storage;
+    size_t words;
+    ADBSampleDecoder sampleDecoder;
+};
+
+#endif // ADB_SAMPLE_DECODER_h
@@ -0,0 +1,118 @@
+/**
+ * @file ADBSnapshot.h
+ * @brief Publication de l'état des périphériques ADB vers plusieurs lecteurs
+ *
+ * L'état décodé (touches, modificateurs, LEDs, mouvement, présence) est publié
+ * par la tâche qui pilote le bus au travers d'un seqlock. Les lecteurs (affichage,
+ * tâche BLE, diagnostic) obtiennent une copie cohérente sans bloquer l'écrivain
+ * et sans générer la moindre transaction sur le bus.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SNAPSHOT_h
+#define ADB_SNAPSHOT_h
+
+#include <cstdint>
+#include <string.h>
+
+// Compteur de séquence lisible atomiquement sur la plateforme cible
+#if defined(__AVR__)
+typedef uint8_t adb_seq_t;
+#else
+typedef uint32_t adb_seq_t;
+#endif
+
+/**
+ * @brief État publié des périphériques ADB
+ */
+struct adb_device_snapshot {
+    uint8_t keys[16];          // Bitmap des 128 codes ADB enfoncés (bit = code)
+    uint16_t modifiers;        // Dernière valeur brute du registre 2 du clavier
+    uint8_t leds;              // LEDs allumées (bit0 num, bit1 caps, bit2 scroll)
+    bool mouseButton;          // État du bouton de souris
+    int32_t mouseX;            // Mouvement horizontal cumulé depuis le démarrage
+    int32_t mouseY;            // Mouvement vertical cumulé depuis le démarrage
+    uint16_t presentMask;      // Périphériques présents (bit = adresse)
+    uint32_t updates;          // Nombre de publications
+    uint32_t updatedAt;        // Date de la dernière publication (millis)
+
+    /**
+     * @brief Indique si une touche ADB est enfoncée
+     * @param adbKeycode Code de touche ADB (0-127)
+     */
+    bool isKeyDown(uint8_t adbKeycode) const {
+        return (keys[(adbKeycode >> 3) & 0x0F] >> (adbKeycode & 0x07)) & 0x01;
+    }
+
+    /**
+     * @brief Indique si un périphérique a répondu à son adresse
+     * @param addr Adresse du périphérique
+     */
+    bool isPresent(uint8_t addr) const {
+        return (presentMask >> (addr & 0x0F)) & 0x01;
+    }
+};
+
+/**
+ * @brief Seqlock à écrivain unique
+ *
+ * L'écrivain ne bloque jamais: il rend le compteur impair pendant la copie puis
+ * pair à la fin. Un lecteur recommence sa copie si le compteur était impair ou
+ * a changé pendant la lecture.
+ *
+ * @tparam T Type copiable trivialement
+ */
+template <typename T>
+class ADBSeqlock {
+public:
+    ADBSeqlock() : sequence(0), value{} {}
+
+    /**
+     * @brief Publie une nouvelle valeur (écrivain unique)
+     */
+    void write(const T& newValue) {
+        sequence = sequence + 1;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        memcpy(const_cast<T*>(&value), &newValue, sizeof(T));
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        sequence = sequence + 1;
+    }
+
+    /**
+     * @brief Tente une lecture unique
+     * @param out Copie de la valeur publiée
+     * @return true si la copie est cohérente
+     */
+    bool tryRead(T& out) const {
+        adb_seq_t before = sequence;
+        if (before & 0x01) return false;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        memcpy(&out, const_cast<const T*>(&value), sizeof(T));
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        return sequence == before;
+    }
+
+    /**
+     * @brief Lecture cohérente, recommencée tant qu'une écriture est en cours
+     * @param out Copie de la valeur publiée
+     */
+    void read(T& out) const {
+        while (!tryRead(out)) {
+            // Une publication est en cours, elle dure le temps d'une copie
+        }
+    }
+
+    /**
+     * @brief Numéro de version de la valeur publiée (pair si stable)
+     */
+    adb_seq_t version() const { return sequence; }
+
+private:
+    volatile adb_seq_t sequence; // Compteur de séquence
+    volatile T value;            // Valeur publiée
+};
+
+#endif // ADB_SNAPSHOT_h
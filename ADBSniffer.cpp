@@ -0,0 +1,92 @@
+/**
+ * @file ADBSniffer.cpp
+ * @brief Implémentation de l'écoute passive du bus
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBSniffer.h"
+
+ADBSniffer* ADBSniffer::instance = nullptr;
+
+ADBSniffer::ADBSniffer(adb_frame* storage, uint8_t capacity)
+    : decoder(onFrame, this), queue(storage), capacity(capacity), pin(0), votes(1), head(0), tail(0),
+      edgeCount(0), frameCount(0), overrunCount(0) {}
+
+bool ADBSniffer::begin(uint8_t pin) {
+    if (instance && instance != this) return false;
+
+    this->pin = pin;
+    decoder.reset();
+    head = 0;
+    tail = 0;
+    instance = this;
+    attachInterrupt(digitalPinToInterrupt(pin), onEdge, CHANGE);
+    return true;
+}
+
+void ADBSniffer::end() {
+    if (instance != this) return;
+    detachInterrupt(digitalPinToInterrupt(pin));
+    instance = nullptr;
+}
+
+void ADBSniffer::setGlitchFilter(const adb_glitch_filter& filter) {
+    // Le décodeur est partagé avec l'interruption
+    adbMaskInterrupts();
+    votes = filter.votes ? filter.votes : 1;
+    decoder.setGlitchFilter(filter.minPulseUs);
+    adbUnmaskInterrupts();
+}
+
+void ADBSniffer::service() {
+    if (instance != this) return;
+    // Le décodeur est partagé avec l'interruption
+    adbMaskInterrupts();
+    decoder.idle(micros());
+    adbUnmaskInterrupts();
+}
+
+bool ADBSniffer::read(adb_frame& frame) {
+    uint8_t t = tail;
+    if (t == head) return false;
+    frame = queue[t];
+    tail = (t + 1 == capacity) ? 0 : t + 1;
+    return true;
+}
+
+uint8_t ADBSniffer::available() const {
+    uint8_t h = head;
+    uint8_t t = tail;
+    return h >= t ? h - t : capacity - t + h;
+}
+
+void ADB_ISR_ATTR ADBSniffer::onEdge() {
+    ADBSniffer* self = instance;
+    if (!self) return;
+
+    // Le niveau est relu plutôt que déduit: un front manqué ne décale pas le décodage
+    uint32_t now = micros();
+    self->edgeCount++;
+    uint8_t high = 0;
+    for (uint8_t i = 0; i < self->votes; i++) {
+        if (digitalRead(self->pin) == HIGH) high++;
+    }
+    self->decoder.edge(now, high * 2 > self->votes);
+}
+
+void ADBSniffer::onFrame(void* context, const adb_frame& frame) {
+    ADBSniffer* self = static_cast<ADBSniffer*>(context);
+    self->frameCount++;
+
+    uint8_t h = self->head;
+    uint8_t next = (h + 1 == self->capacity) ? 0 : h + 1;
+    if (next == self->tail) {
+        self->overrunCount++;
+        return;
+    }
+    self->queue[h] = frame;
+    self->head = next;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file ADBSniffer.h
+ * @brief Écoute passive d'un bus ADB existant
+ *
+ * Le mode écoute (ADB::beginSniffing) place la broche de données en entrée et
+ * décode le trafic d'un hôte tiers (Macintosh, autre adaptateur): attention et
+ * synchronisation, commandes, SRQ et paquets de données dans les deux sens
+ * (réponse à un Talk, données d'un Listen). Chaque front déclenche une
+ * interruption qui alimente un ADBFrameDecoder avec la classification des
+ * cellules de ADB::readDataPacket sans calibration; aucune boucle de scrutation de la ligne n'est
+ * nécessaire. Les transactions décodées, horodatées, sont déposées dans une
+ * file circulaire vidée par la boucle principale.
+ *
+ * Une seule écoute peut être active à la fois (routine d'interruption unique).
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SNIFFER_h
+#define ADB_SNIFFER_h
+
+#include <Arduino.h>
+#include <cstdint>
+#include "ADBFrameDecoder.h"
+#include "ADBPlatform.h"
+
+/**
+ * @brief Décodage par interruption et file des transactions observées
+ */
+class ADBSniffer {
+public:
+    /**
+     * @brief Constructeur
+     * @param storage Tampon préalloué de la file
+     * @param capacity Nombre d'emplacements (une transaction de moins est utilisable, 255 au plus)
+     */
+    ADBSniffer(adb_frame* storage, uint8_t capacity);
+
+    /**
+     * @brief Commence l'écoute de la broche (appelé par ADB::beginSniffing)
+     * @param pin Broche de données, déjà configurée en entrée
+     * @return false si une autre écoute est déjà active
+     */
+    bool begin(uint8_t pin);
+
+    /**
+     * @brief Arrête l'écoute (la trame en cours est abandonnée)
+     */
+    void end();
+
+    bool active() const { return instance == this; }
+
+    /**
+     * @brief Filtre les parasites de la ligne écoutée (appelé par ADB::beginSniffing)
+     *
+     * Le niveau relu à chaque interruption l'est à la majorité de votes
+     * lectures successives, puis le décodeur écarte les impulsions plus
+     * courtes que minPulseUs.
+     */
+    void setGlitchFilter(const adb_glitch_filter& filter);
+
+    /**
+     * @brief Impulsions rejetées par le décodeur
+     */
+    uint32_t glitches() const { return decoder.glitches(); }
+
+    /**
+     * @brief Clôt la transaction en cours lorsque la ligne est revenue au repos
+     *
+     * Sans front suivant, la fin d'un paquet de données ne se constate qu'à
+     * l'expiration d'une cellule: à appeler à chaque itération de la boucle.
+     */
+    void service();
+
+    /**
+     * @brief Retire la plus ancienne transaction de la file
+     * @param frame Transaction lue
+     * @return false si la file est vide
+     */
+    bool read(adb_frame& frame);
+
+    /**
+     * @brief Nombre de transactions en attente dans la file
+     */
+    uint8_t available() const;
+
+    uint32_t edges() const { return edgeCount; }
+    uint32_t frames() const { return frameCount; }
+
+    /**
+     * @brief Transactions perdues, file pleine
+     */
+    uint32_t overruns() const { return overrunCount; }
+
+private:
+    static void onEdge();
+    static void onFrame(void* context, const adb_frame& frame);
+
+    static ADBSniffer* instance;   // Écoute reliée à l'interruption
+
+    ADBFrameDecoder decoder;
+    adb_frame* queue;
+    uint8_t capacity;
+    uint8_t pin;
+    uint8_t votes;                    // Lectures du niveau à chaque interruption
+    volatile uint8_t head;            // Écrit par l'interruption
+    volatile uint8_t tail;            // Écrit par le lecteur
+    volatile uint32_t edgeCount;
+    volatile uint32_t frameCount;
+    volatile uint32_t overrunCount;
+};
+
+/**
+ * @brief Écoute avec file intégrée
+ * @tparam N Nombre d'emplacements de la file
+ */
+template <uint8_t N>
+class ADBSnifferBuffer : public ADBSniffer {
+public:
+    static_assert(N >= 2, "File d'écoute trop petite");
+    ADBSnifferBuffer() : ADBSniffer(storage, N) {}
+
+private:
+    adb_frame storage[N];
+};
+
+#endif // ADB_SNIFFER_h
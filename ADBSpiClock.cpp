@@ -0,0 +1,53 @@
+/**
+ * @file ADBSpiClock.cpp
+ * @brief Calcul de la fréquence d'horloge SPI obtenue
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBSpiClock.h"
+
+#if defined(ADB_PLATFORM_ESP32)
+#include <soc/soc.h>
+
+uint32_t adbSpiClock(uint32_t requestedHz) {
+    // Diviseur de l'horloge APB retenu par le pilote, rapport cyclique de 50%
+    return static_cast<uint32_t>(spi_get_actual_clock(APB_CLK_FREQ, static_cast<int>(requestedHz), 128));
+}
+
+#elif defined(ADB_PLATFORM_STM32)
+
+uint32_t adbSpiClock(const SPI_HandleTypeDef& spi, uint32_t requestedHz, uint32_t& prescaler) {
+    // SPI1 (et SPI4 à SPI6 lorsqu'ils existent) sur APB2, les autres sur APB1
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+#if defined(RCC_CFGR_PPRE2)
+    bool apb2 = spi.Instance == SPI1;
+#if defined(SPI4)
+    apb2 |= spi.Instance == SPI4;
+#endif
+#if defined(SPI5)
+    apb2 |= spi.Instance == SPI5;
+#endif
+#if defined(SPI6)
+    apb2 |= spi.Instance == SPI6;
+#endif
+    if (apb2) pclk = HAL_RCC_GetPCLK2Freq();
+#endif
+
+    // Diviseurs 2 à 256 de l'horloge du bus: le plus petit qui ne dépasse pas la fréquence demandée
+    static const uint32_t prescalers[] = {SPI_BAUDRATEPRESCALER_2,  SPI_BAUDRATEPRESCALER_4,  SPI_BAUDRATEPRESCALER_8,
+                                          SPI_BAUDRATEPRESCALER_16, SPI_BAUDRATEPRESCALER_32, SPI_BAUDRATEPRESCALER_64,
+                                          SPI_BAUDRATEPRESCALER_128, SPI_BAUDRATEPRESCALER_256};
+    for (uint8_t i = 0; i < sizeof(prescalers) / sizeof(prescalers[0]); i++) {
+        uint32_t rate = pclk >> (i + 1);
+        if (rate <= requestedHz) {
+            prescaler = prescalers[i];
+            return rate;
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * @file ADBSpiClock.h
+ * @brief Fréquence d'horloge SPI réellement obtenue sur la cible
+ *
+ * Le diviseur retenu est celui du pilote spi_master sur ESP32 et le plus
+ * petit qui ne dépasse pas la fréquence demandée sur STM32 (PCLK/2 à
+ * PCLK/256). Émission (ADBSpiTransmitter) et capture (ADBSpiSampler)
+ * construisent motifs et décodeur à cette fréquence, et non à la fréquence
+ * demandée: sur un STM32F103 à 72 MHz, 1 MHz donne 562,5 kHz sur SPI1.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SPI_CLOCK_h
+#define ADB_SPI_CLOCK_h
+
+#include <Arduino.h>
+#include "ADBPlatform.h"
+
+#if defined(ADB_PLATFORM_ESP32)
+#include <driver/spi_master.h>
+
+/**
+ * @brief Fréquence obtenue par le pilote pour une fréquence demandée
+ * @return Fréquence en Hz (0 si aucune)
+ */
+uint32_t adbSpiClock(uint32_t requestedHz);
+
+#elif defined(ADB_PLATFORM_STM32)
+
+/**
+ * @brief Plus grande fréquence PCLK/2^n qui ne dépasse pas la fréquence demandée
+ * @param spi SPI dont le bus (APB1 ou APB2) fixe l'horloge de référence
+ * @param prescaler SPI_BAUDRATEPRESCALER_x correspondant
+ * @return Fréquence en Hz (0 si la demande est sous PCLK/256)
+ */
+uint32_t adbSpiClock(const SPI_HandleTypeDef& spi, uint32_t requestedHz, uint32_t& prescaler);
+
+#endif
+
+#endif // ADB_SPI_CLOCK_h
@@ -0,0 +1,100 @@
+/**
+ * @file ADBSpiSampler.cpp
+ * @brief Implémentation de la capture par SPI
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBSpiSampler.h"
+
+#ifdef ADB_SPI_SAMPLER
+
+#if defined(ADB_PLATFORM_ESP32)
+ADBSpiSampler::ADBSpiSampler(spi_host_device_t host, int8_t misoPin, uint32_t* storage, size_t words,
+                             uint32_t sampleRateHz)
+    : ADBLineSampler(storage, words, sampleRateHz, ADBSampleOrder::MSB_FIRST), host(host), misoPin(misoPin),
+      device(nullptr), begun(false) {}
+
+bool ADBSpiSampler::begin() {
+    uint32_t rate = adbSpiClock(sampleDecoder.sampleRate());
+    if (rate < MIN_RATE) return false;
+
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = -1;
+    bus.miso_io_num = misoPin;
+    bus.sclk_io_num = -1;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = static_cast<int>(words * sizeof(uint32_t));
+    if (spi_bus_initialize(host, &bus, SPI_DMA_CH_AUTO) != ESP_OK) return false;
+
+    spi_device_interface_config_t config = {};
+    config.mode = 0;
+    config.clock_speed_hz = static_cast<int>(rate);
+    config.spics_io_num = -1;
+    config.queue_size = 1;
+    if (spi_bus_add_device(host, &config, &device) != ESP_OK) {
+        spi_bus_free(host);
+        return false;
+    }
+#else
+
+ADBSpiSampler::ADBSpiSampler(SPI_HandleTypeDef& spi, uint32_t* storage, size_t words, uint32_t sampleRateHz)
+    : ADBLineSampler(storage, words, sampleRateHz, ADBSampleOrder::MSB_FIRST), spi(spi),
+      prescaler(SPI_BAUDRATEPRESCALER_256), begun(false) {}
+
+bool ADBSpiSampler::begin() {
+    uint32_t rate = adbSpiClock(spi, sampleDecoder.sampleRate(), prescaler);
+    if (rate < MIN_RATE || !spi.hdmatx || !spi.hdmarx) return false;
+
+    spi.Init.Mode = SPI_MODE_MASTER;
+    spi.Init.Direction = SPI_DIRECTION_2LINES;
+    spi.Init.DataSize = SPI_DATASIZE_8BIT;
+    spi.Init.CLKPolarity = SPI_POLARITY_LOW;
+    spi.Init.CLKPhase = SPI_PHASE_1EDGE;
+    spi.Init.FirstBit = SPI_FIRSTBIT_MSB;
+    spi.Init.BaudRatePrescaler = prescaler;
+    if (HAL_SPI_Init(&spi) != HAL_OK) return false;
+#endif
+
+    // Durées des paliers converties à la fréquence obtenue et non à la fréquence demandée
+    sampleDecoder = ADBSampleDecoder(rate, ADBSampleOrder::MSB_FIRST);
+    begun = true;
+    return true;
+}
+
+size_t ADBSpiSampler::capture(size_t samples) {
+    if (!begun) return 0;
+    if (samples > capacity()) samples = capacity();
+    size_t count = (samples + 31) / 32;
+
+    // MOSI au repos (STM32: le tampon est aussi émis); chaque octet reçu contient 8 échantillons, le premier en poids fort
+    for (size_t i = 0; i < count; i++) storage[i] = 0xFFFFFFFFUL;
+#if defined(ADB_PLATFORM_ESP32)
+    spi_transaction_t transaction = {};
+    transaction.length = count * 32;
+    transaction.rxlength = count * 32;
+    transaction.tx_buffer = nullptr;
+    transaction.rx_buffer = storage;
+    // Transfert d'un seul tenant par le DMA; l'attente laisse les autres tâches s'exécuter
+    if (spi_device_transmit(device, &transaction) != ESP_OK) return 0;
+#else
+    if (HAL_SPI_Receive_DMA(&spi, reinterpret_cast<uint8_t*>(storage), static_cast<uint16_t>(count * sizeof(uint32_t))) !=
+        HAL_OK) {
+        return 0;
+    }
+    // Rendu prêt par la routine de fin du DMA de réception
+    while (HAL_SPI_GetState(&spi) == HAL_SPI_STATE_BUSY_RX || HAL_SPI_GetState(&spi) == HAL_SPI_STATE_BUSY_TX_RX) {
+    }
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Octets reçus dans l'ordre de la mémoire: premier échantillon remis au bit 31 du mot
+    for (size_t i = 0; i < count; i++) storage[i] = __builtin_bswap32(storage[i]);
+#endif
+    return samples;
+}
+
+#endif // ADB_SPI_SAMPLER
@@ -0,0 +1,120 @@
+/**
+ * @file ADBSpiSampler.h
+ * @brief Échantillonnage de la ligne ADB par le récepteur SPI
+ *
+ * La ligne de données est reliée, en plus de la broche ADB, à l'entrée MISO
+ * d'un bus SPI maître inutilisé par ailleurs (SCK et MOSI restent libres).
+ * La réception est confiée au DMA: l'horloge SPI ne s'arrête pas entre deux
+ * octets et chaque échantillon est pris à sa date, que le processeur serve
+ * ou non une interruption pendant la capture. capture() attend la fin du
+ * transfert, interruptions ouvertes.
+ * - ESP32: pilote spi_master d'ESP-IDF, tampon en mémoire interne (pas en
+ *   PSRAM). Le bus est réservé à la capture ADB.
+ * - STM32: HAL_SPI_Receive_DMA sur un SPI_HandleTypeDef dont les canaux DMA
+ *   d'émission et de réception sont initialisés et reliés (hdmatx, hdmarx)
+ *   par l'application, qui appelle aussi HAL_DMA_IRQHandler depuis leurs
+ *   routines (en maître, la réception émet le tampon sur MOSI).
+ *
+ * Le décodeur est construit à la fréquence réellement obtenue
+ * (adbSpiClock): 1 MHz demandé donne 562,5 kHz sur SPI1 d'un STM32F103 à
+ * 72 MHz. begin() refuse une fréquence inférieure à MIN_RATE.
+ *
+ * AVR n'a pas de DMA: l'horloge s'arrête entre deux octets, le temps de
+ * recharger le registre, et une interruption servie à ce moment retire des
+ * échantillons sans que le décodeur ne le voie. La réception reste alors
+ * celle d'ADB::readCell.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SPI_SAMPLER_h
+#define ADB_SPI_SAMPLER_h
+
+#include <Arduino.h>
+#include "ADBSampleDecoder.h"
+#include "ADBPlatform.h"
+#include "ADBSpiClock.h"
+
+#if defined(ADB_PLATFORM_ESP32) || defined(ADB_PLATFORM_STM32)
+
+#define ADB_SPI_SAMPLER
+
+/**
+ * @brief Capture par SPI et DMA, un échantillon par front d'horloge
+ */
+class ADBSpiSampler : public ADBLineSampler {
+public:
+    static constexpr uint32_t DEFAULT_RATE = 1000000;   // 1 MHz: 1 µs par échantillon
+    static constexpr uint32_t MIN_RATE = 250000;        // 4 µs par échantillon: demi-cellule courte (35 µs) sur 8 échantillons
+
+#if defined(ADB_PLATFORM_ESP32)
+    /**
+     * @brief Constructeur
+     * @param host Contrôleur SPI (SPI2_HOST, SPI3_HOST)
+     * @param misoPin Broche MISO reliée à la ligne
+     * @param storage Tampon préalloué (mémoire interne accessible au DMA)
+     * @param words Taille du tampon en mots de 32 échantillons
+     * @param sampleRateHz Fréquence d'horloge SPI demandée
+     */
+    ADBSpiSampler(spi_host_device_t host, int8_t misoPin, uint32_t* storage, size_t words,
+                  uint32_t sampleRateHz = DEFAULT_RATE);
+#else
+    /**
+     * @brief Constructeur
+     * @param spi SPI maître dont les canaux DMA sont reliés (hdmatx, hdmarx)
+     * @param storage Tampon préalloué
+     * @param words Taille du tampon en mots de 32 échantillons
+     * @param sampleRateHz Fréquence d'horloge SPI demandée
+     */
+    ADBSpiSampler(SPI_HandleTypeDef& spi, uint32_t* storage, size_t words, uint32_t sampleRateHz = DEFAULT_RATE);
+#endif
+
+    /**
+     * @brief Configure le SPI et reconstruit le décodeur à la fréquence obtenue
+     * @return false si le périphérique ne démarre pas ou si la fréquence obtenue est sous MIN_RATE
+     */
+    bool begin();
+
+    /**
+     * @brief Fréquence d'échantillonnage obtenue (0 avant begin)
+     */
+    uint32_t actualRate() const { return begun ? sampleDecoder.sampleRate() : 0; }
+
+    size_t capture(size_t samples) override;
+
+private:
+#if defined(ADB_PLATFORM_ESP32)
+    spi_host_device_t host;
+    int8_t misoPin;
+    spi_device_handle_t device;
+#else
+    SPI_HandleTypeDef& spi;
+    uint32_t prescaler;    // SPI_BAUDRATEPRESCALER_x retenu par adbSpiClock
+#endif
+    bool begun;
+};
+
+/**
+ * @brief Capture par SPI avec tampon intégré
+ * @tparam N Taille du tampon en mots (un paquet de 16 bits à 1 MHz occupe 70 mots)
+ */
+template <size_t N>
+class ADBSpiSamplerBuffer : public ADBSpiSampler {
+public:
+#if defined(ADB_PLATFORM_ESP32)
+    ADBSpiSamplerBuffer(spi_host_device_t host, int8_t misoPin, uint32_t sampleRateHz = DEFAULT_RATE)
+        : ADBSpiSampler(host, misoPin, storage, N, sampleRateHz) {}
+#else
+    explicit ADBSpiSamplerBuffer(SPI_HandleTypeDef& spi, uint32_t sampleRateHz = DEFAULT_RATE)
+        : ADBSpiSampler(spi, storage, N, sampleRateHz) {}
+#endif
+
+private:
+    uint32_t storage[N];
+};
+
+#endif // ADB_PLATFORM_ESP32 || ADB_PLATFORM_STM32
+
+#endif // ADB_SPI_SAMPLER_h
@@ -0,0 +1,116 @@
+/**
+ * @file ADBSpiTransmitter.cpp
+ * @brief Implémentation de l'émission par SPI
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBSpiTransmitter.h"
+
+#ifdef ADB_SPI_TRANSMITTER
+
+#if defined(ADB_PLATFORM_ESP32)
+ADBSpiTransmitter::ADBSpiTransmitter(spi_host_device_t host, int8_t mosiPin, uint32_t* storage, size_t words,
+                                     uint32_t shiftRateHz, bool inverted)
+    : ADBShiftDriver(storage, words, shiftRateHz, ADBSampleOrder::MSB_FIRST), host(host), mosiPin(mosiPin),
+      device(nullptr), transaction{}, queued(false), inverted(inverted), begun(false) {}
+
+bool ADBSpiTransmitter::begin() {
+    uint32_t rate = adbSpiClock(pattern.shiftRate());
+    if (!rate) return false;
+
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = mosiPin;
+    bus.miso_io_num = -1;
+    bus.sclk_io_num = -1;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = static_cast<int>(pattern.capacity() / 8);
+    if (spi_bus_initialize(host, &bus, SPI_DMA_CH_AUTO) != ESP_OK) return false;
+
+    spi_device_interface_config_t config = {};
+    config.mode = 0;
+    config.clock_speed_hz = static_cast<int>(rate);
+    config.spics_io_num = -1;
+    config.queue_size = 1;
+    if (spi_bus_add_device(host, &config, &device) != ESP_OK) {
+        spi_bus_free(host);
+        return false;
+    }
+#else
+
+ADBSpiTransmitter::ADBSpiTransmitter(SPI_HandleTypeDef& spi, uint32_t* storage, size_t words, uint32_t shiftRateHz,
+                                     bool inverted)
+    : ADBShiftDriver(storage, words, shiftRateHz, ADBSampleOrder::MSB_FIRST), spi(spi),
+      prescaler(SPI_BAUDRATEPRESCALER_256), inverted(inverted), begun(false) {}
+
+bool ADBSpiTransmitter::begin() {
+    uint32_t rate = adbSpiClock(spi, pattern.shiftRate(), prescaler);
+    if (!rate || !spi.hdmatx) return false;
+
+    spi.Init.Mode = SPI_MODE_MASTER;
+    spi.Init.DataSize = SPI_DATASIZE_8BIT;
+    spi.Init.CLKPolarity = SPI_POLARITY_LOW;
+    spi.Init.CLKPhase = SPI_PHASE_1EDGE;
+    spi.Init.FirstBit = SPI_FIRSTBIT_MSB;
+    spi.Init.BaudRatePrescaler = prescaler;
+    if (HAL_SPI_Init(&spi) != HAL_OK) return false;
+#endif
+
+    // Motif construit à la fréquence obtenue; une commande nominale doit rester dans les tolérances
+    pattern.setShiftRate(rate);
+    pattern.setTiming(ADBHostTiming::DEFAULT);
+    pattern.command(0);
+    begun = !pattern.distorted();
+    return begun;
+}
+
+bool ADBSpiTransmitter::start(uint32_t* words, size_t bits) {
+    if (!begun || !bits) return false;
+
+    size_t count = (bits + 31) / 32;
+    uint32_t mask = inverted ? 0xFFFFFFFFUL : 0;
+
+    // Bits au-delà du motif: ligne relâchée
+    uint8_t tail = bits & 31;
+    if (tail) words[count - 1] |= 0xFFFFFFFFUL >> tail;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t word = words[i] ^ mask;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // Octets émis dans l'ordre de la mémoire: poids fort du mot en premier
+        word = __builtin_bswap32(word);
+#endif
+        words[i] = word;
+    }
+
+#if defined(ADB_PLATFORM_ESP32)
+    // Longueur exacte en bits: la ligne est rendue dès la fin du motif
+    transaction = {};
+    transaction.length = bits;
+    transaction.tx_buffer = words;
+    queued = spi_device_queue_trans(device, &transaction, 0) == ESP_OK;
+    return queued;
+#else
+    // Octets entiers: au plus 7 bits de ligne relâchée après le motif
+    return HAL_SPI_Transmit_DMA(&spi, reinterpret_cast<uint8_t*>(words), static_cast<uint16_t>((bits + 7) / 8)) ==
+           HAL_OK;
+#endif
+}
+
+bool ADBSpiTransmitter::busy() {
+#if defined(ADB_PLATFORM_ESP32)
+    if (queued) {
+        spi_transaction_t* done = nullptr;
+        queued = spi_device_get_trans_result(device, &done, 0) != ESP_OK;
+    }
+    return queued;
+#else
+    // Rendu prêt par la routine de fin du DMA, une fois le dernier octet sorti du registre à décalage
+    return HAL_SPI_GetState(&spi) == HAL_SPI_STATE_BUSY_TX;
+#endif
+}
+
+#endif // ADB_SPI_TRANSMITTER
@@ -0,0 +1,130 @@
+/**
+ * @file ADBSpiTransmitter.h
+ * @brief Émission des commandes et paquets ADB par la sortie MOSI d'un SPI
+ *
+ * MOSI commande la ligne à travers un transistor N (MOSFET ou NPN, drain sur
+ * la ligne de données): la ligne reste en collecteur ouvert et le repos de
+ * MOSI à l'état bas la laisse relâchée. Le motif est donc inversé avant le
+ * décalage; sans transistor (MOSI configuré en drain ouvert par la
+ * plateforme), passer inverted = false.
+ *
+ * Le motif est confié au DMA: start() rend la main dès le transfert lancé et
+ * le processeur reste disponible pendant toute la transaction.
+ * - ESP32: pilote spi_master d'ESP-IDF (spi_device_queue_trans), tampon en
+ *   mémoire interne (pas en PSRAM). Le bus est réservé à l'émission ADB.
+ * - STM32: HAL_SPI_Transmit_DMA sur un SPI_HandleTypeDef dont le canal DMA
+ *   d'émission est initialisé et relié (hdmatx) par l'application, qui appelle
+ *   aussi HAL_DMA_IRQHandler depuis la routine du canal.
+ *
+ * La fréquence demandée n'est pas toujours disponible (STM32F103 à 72 MHz:
+ * 281,25 kHz au plus bas sur SPI1): le motif est construit à la fréquence
+ * réellement obtenue (adbSpiClock).
+ * begin() refuse une fréquence qui ne restitue pas les durées nominales à
+ * ±3%: il faut alors demander une fréquence plus élevée (1 MHz ou plus).
+ *
+ * AVR n'a ni DMA ni registre d'émission double: chaque octet attend la
+ * routine d'interruption et la ligne dérive d'autant. L'émission reste alors
+ * celle d'ADB::writeBit.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SPI_TRANSMITTER_h
+#define ADB_SPI_TRANSMITTER_h
+
+#include <Arduino.h>
+#include "ADBWaveform.h"
+#include "ADBPlatform.h"
+#include "ADBSpiClock.h"
+
+#if defined(ADB_PLATFORM_ESP32) || defined(ADB_PLATFORM_STM32)
+
+#define ADB_SPI_TRANSMITTER
+
+/**
+ * @brief Décalage du motif sur MOSI par DMA
+ */
+class ADBSpiTransmitter : public ADBShiftDriver {
+public:
+    static constexpr uint32_t DEFAULT_RATE = 200000;   // 5 µs par bit, multiple de toutes les phases
+
+#if defined(ADB_PLATFORM_ESP32)
+    /**
+     * @brief Constructeur
+     * @param host Contrôleur SPI (SPI2_HOST, SPI3_HOST)
+     * @param mosiPin Broche MOSI reliée à la ligne
+     * @param storage Tampon préalloué du motif (mémoire interne accessible au DMA)
+     * @param words Taille du tampon en mots de 32 bits
+     * @param shiftRateHz Fréquence d'horloge SPI demandée
+     * @param inverted MOSI à l'état haut tire la ligne vers le bas (transistor)
+     */
+    ADBSpiTransmitter(spi_host_device_t host, int8_t mosiPin, uint32_t* storage, size_t words,
+                      uint32_t shiftRateHz = DEFAULT_RATE, bool inverted = true);
+#else
+    /**
+     * @brief Constructeur
+     * @param spi SPI maître dont le canal DMA d'émission est relié (hdmatx)
+     * @param storage Tampon préalloué du motif
+     * @param words Taille du tampon en mots de 32 bits
+     * @param shiftRateHz Fréquence d'horloge SPI demandée
+     * @param inverted MOSI à l'état haut tire la ligne vers le bas (transistor)
+     */
+    ADBSpiTransmitter(SPI_HandleTypeDef& spi, uint32_t* storage, size_t words, uint32_t shiftRateHz = DEFAULT_RATE,
+                      bool inverted = true);
+#endif
+
+    /**
+     * @brief Configure le SPI à la fréquence la plus proche de celle demandée
+     * @return false si le périphérique ne démarre pas ou si la fréquence obtenue
+     *         ne restitue pas ADBHostTiming::DEFAULT à ±3% (aucun motif n'est alors émis)
+     */
+    bool begin();
+
+    /**
+     * @brief Fréquence d'horloge obtenue (0 avant begin)
+     */
+    uint32_t actualRate() const { return begun ? pattern.shiftRate() : 0; }
+
+    bool start(uint32_t* words, size_t bits) override;
+    bool busy() override;
+
+private:
+#if defined(ADB_PLATFORM_ESP32)
+    spi_host_device_t host;
+    int8_t mosiPin;
+    spi_device_handle_t device;
+    spi_transaction_t transaction;
+    bool queued;
+#else
+    SPI_HandleTypeDef& spi;
+    uint32_t prescaler;    // SPI_BAUDRATEPRESCALER_x retenu par adbSpiClock
+#endif
+    bool inverted;
+    bool begun;
+};
+
+/**
+ * @brief Émission par SPI avec tampon intégré
+ * @tparam N Taille du tampon en mots (une commande à 200 kHz occupe 12 mots)
+ */
+template <size_t N>
+class ADBSpiTransmitterBuffer : public ADBSpiTransmitter {
+public:
+#if defined(ADB_PLATFORM_ESP32)
+    ADBSpiTransmitterBuffer(spi_host_device_t host, int8_t mosiPin, uint32_t shiftRateHz = DEFAULT_RATE,
+                            bool inverted = true)
+        : ADBSpiTransmitter(host, mosiPin, storage, N, shiftRateHz, inverted) {}
+#else
+    explicit ADBSpiTransmitterBuffer(SPI_HandleTypeDef& spi, uint32_t shiftRateHz = DEFAULT_RATE, bool inverted = true)
+        : ADBSpiTransmitter(spi, storage, N, shiftRateHz, inverted) {}
+#endif
+
+private:
+    uint32_t storage[N];
+};
+
+#endif // ADB_PLATFORM_ESP32 || ADB_PLATFORM_STM32
+
+#endif // ADB_SPI_TRANSMITTER_h
@@ -0,0 +1,158 @@
+/**
+ * @file ADBTiming.cpp
+ * @brief Attente sur échéance absolue et auto-test des temporisations
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBTiming.h"
+
+#if defined(ADB_PLATFORM_AVR)
+#include <util/delay_basic.h>
+#endif
+
+uint32_t ADBClock::scale = 1;
+
+namespace {
+
+// Paquet de données de référence: bit de début, 16 bits alternés, bit d'arrêt
+constexpr uint8_t PACKET_CELLS = 18;
+constexpr uint8_t SELF_TEST_REPEATS = 8;
+
+int32_t ticksToNs(int32_t ticks, uint32_t repeats) {
+    return static_cast<int32_t>(static_cast<int64_t>(ticks) * 1000 / static_cast<int64_t>(ADBClock::ticksPerUs() * repeats));
+}
+
+/**
+ * @brief Dépassement moyen d'une attente isolée, en unités du compteur
+ */
+int32_t waitError(uint32_t us) {
+    int32_t total = 0;
+    for (uint8_t i = 0; i < SELF_TEST_REPEATS; i++) {
+        ADBClock clock;
+        clock.start();
+        clock.wait(us);
+        total += static_cast<int32_t>(ADBClock::now() - clock.deadline());
+    }
+    return total;
+}
+
+/**
+ * @brief Écart à la durée nominale d'un paquet, cumulé sur les répétitions
+ */
+int32_t packetDrift(uint8_t pin, bool deadlines) {
+    int32_t total = 0;
+    for (uint8_t i = 0; i < SELF_TEST_REPEATS; i++) {
+        ADBClock clock;
+        uint32_t startTicks = ADBClock::now();
+        clock.start();
+        for (uint8_t cell = 0; cell < PACKET_CELLS; cell++) {
+            // Bit de début à 1, bit d'arrêt à 0, données alternées
+            bool bit = cell == 0 || (cell < PACKET_CELLS - 1 && (cell & 1));
+            uint32_t lowUs = bit ? 35 : 65;
+            if (pin != 0xFF) digitalWrite(pin, LOW);
+            if (deadlines) clock.wait(lowUs);
+            else delayMicroseconds(lowUs);
+            if (pin != 0xFF) digitalWrite(pin, HIGH);
+            if (deadlines) clock.wait(100 - lowUs);
+            else delayMicroseconds(100 - lowUs);
+        }
+        total += static_cast<int32_t>(ADBClock::now() - startTicks - ADBClock::ticks(PACKET_CELLS * 100UL));
+    }
+    return total;
+}
+
+} // namespace
+
+void ADBClock::begin() {
+    adbCycleCounterInit();
+#if defined(ADB_PLATFORM_ESP32)
+    scale = ESP.getCpuFreqMHz();
+#elif defined(ADB_CYCLE_COUNTER_DWT) && defined(__IMXRT1062__)
+    scale = F_CPU_ACTUAL / 1000000UL;
+#elif defined(ADB_CYCLE_COUNTER_DWT) && defined(ADB_PLATFORM_TEENSY)
+    scale = F_CPU / 1000000UL;
+#elif defined(ADB_CYCLE_COUNTER_DWT)
+    scale = SystemCoreClock / 1000000UL;
+#else
+    scale = 1;
+#endif
+    if (scale == 0) scale = 1;
+}
+
+const char* ADBClock::source() {
+#if defined(ADB_PLATFORM_ESP32)
+    return "CCOUNT";
+#elif defined(ADB_CYCLE_COUNTER_DWT)
+    return "DWT_CYCCNT";
+#elif defined(ADB_PLATFORM_AVR)
+    return "micros + boucle calibrée";
+#elif defined(ADB_PLATFORM_NATIVE)
+    return "micros (temps virtuel)";
+#else
+    return "micros";
+#endif
+}
+
+void ADB_HOT ADBClock::waitUntil(uint32_t deadline) {
+#if defined(ADB_PLATFORM_NATIVE)
+    // Temps virtuel: l'attente active n'apporterait que le coût de micros()
+    int32_t remaining = static_cast<int32_t>(deadline - micros());
+    if (remaining > 0) delayMicroseconds(static_cast<unsigned int>(remaining));
+#elif defined(ADB_PLATFORM_AVR)
+    // micros() avance par pas de 64 cycles de l'horloge du timer 0 (4 µs à 16 MHz)
+    constexpr int32_t STEP_US = 64 / clockCyclesPerMicrosecond();
+    while (static_cast<int32_t>(deadline - micros()) > 2 * STEP_US) {}
+
+    // Le changement de pas date l'instant présent à quelques cycles près
+    uint32_t step = micros();
+    uint32_t now;
+    while ((now = micros()) == step) {}
+    int32_t remaining = static_cast<int32_t>(deadline - now);
+    if (remaining <= 0) return;
+
+    // Boucle de 4 cycles par itération, moins le coût de l'appel et du calcul (environ 8 itérations)
+    uint16_t loops = static_cast<uint16_t>(remaining * clockCyclesPerMicrosecond() / 4);
+    if (loops > 8) _delay_loop_2(loops - 8);
+#else
+    while (static_cast<int32_t>(now() - deadline) < 0) {}
+#endif
+}
+
+adb_timing_report ADBClock::selfTest(uint8_t pin) {
+    if (pin != 0xFF) {
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, HIGH);
+    }
+
+    adb_timing_report report = {};
+    report.source = source();
+    report.ticksPerUs = scale;
+    report.shortWaitErrorNs = ticksToNs(waitError(35), SELF_TEST_REPEATS);
+    report.longWaitErrorNs = ticksToNs(waitError(800), SELF_TEST_REPEATS);
+    report.delayDriftNs = ticksToNs(packetDrift(pin, false), SELF_TEST_REPEATS);
+    report.deadlineDriftNs = ticksToNs(packetDrift(pin, true), SELF_TEST_REPEATS);
+    return report;
+}
+
+void ADBClock::printReport(Print& out, const adb_timing_report& report) {
+    out.print(F("Temporisations: "));
+    out.print(report.source);
+    out.print(F(", "));
+    out.print(report.ticksPerUs);
+    out.println(F(" unités/µs"));
+    out.print(F("  Attente 35 µs  : "));
+    out.print(report.shortWaitErrorNs);
+    out.println(F(" ns"));
+    out.print(F("  Attente 800 µs : "));
+    out.print(report.longWaitErrorNs);
+    out.println(F(" ns"));
+    out.print(F("  Paquet de 18 cellules, delayMicroseconds : "));
+    out.print(report.delayDriftNs);
+    out.println(F(" ns"));
+    out.print(F("  Paquet de 18 cellules, échéances         : "));
+    out.print(report.deadlineDriftNs);
+    out.println(F(" ns"));
+}
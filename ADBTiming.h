@@ -0,0 +1,128 @@
+/**
+ * @file ADBTiming.h
+ * @brief Temporisations du protocole sur échéances absolues
+ *
+ * Les phases d'une transaction (attention, synchronisation, demi-cellules)
+ * s'enchaînent sur une horloge commune: chaque attente vise l'origine plus
+ * la somme des durées nominales, et non un délai compté depuis la fin de
+ * l'écriture précédente. Le coût des digitalWrite et des captures, qui
+ * s'ajoutait à chaque delayMicroseconds, est absorbé par l'attente suivante:
+ * l'écart ne se cumule plus sur les 9 cellules d'une commande ni sur les 18
+ * d'un paquet.
+ *
+ * Source de temps selon ADBPlatform.h:
+ *   ESP32      CCOUNT (cycles du cœur)
+ *   Cortex-M   DWT_CYCCNT (cycles du cœur)
+ *   AVR        micros() par pas de 4 µs (16 MHz), dernier pas complété par
+ *              une boucle de 4 cycles calibrée sur F_CPU
+ *   Natif      micros() du temps virtuel, attente en un seul pas
+ *   Autres     micros()
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_TIMING_h
+#define ADB_TIMING_h
+
+#include <Arduino.h>
+#include <cstdint>
+#include "ADBPlatform.h"
+
+/**
+ * @brief Erreurs mesurées par ADBClock::selfTest (ns, positives en retard)
+ */
+struct adb_timing_report {
+    const char* source;        // Compteur utilisé pour les échéances
+    uint32_t ticksPerUs;       // Résolution du compteur
+    int32_t shortWaitErrorNs;  // Attente isolée de 35 µs
+    int32_t longWaitErrorNs;   // Attente isolée de 800 µs
+    int32_t delayDriftNs;      // Paquet de 18 cellules rythmé par delayMicroseconds
+    int32_t deadlineDriftNs;   // Même paquet rythmé par échéances absolues
+};
+
+/**
+ * @brief Horloge de phases: échéances cumulées sur le compteur de la plateforme
+ */
+class ADBClock {
+public:
+    /**
+     * @brief Active le compteur de cycles et relève sa fréquence (appelé par ADB::init)
+     */
+    static void begin();
+
+    /**
+     * @brief Nom du compteur utilisé
+     */
+    static const char* source();
+
+    static uint32_t ticksPerUs() { return scale; }
+    static uint32_t ticks(uint32_t us) { return us * scale; }
+
+    /**
+     * @brief Date courante en unités du compteur (différences modulo 2^32)
+     */
+    static uint32_t now() {
+#if defined(ADB_PLATFORM_ESP32) || defined(ADB_CYCLE_COUNTER_DWT)
+        return adbCycleCount();
+#else
+        return micros();
+#endif
+    }
+
+    /**
+     * @brief L'échéance est atteinte ou dépassée
+     */
+    static bool reached(uint32_t deadline) { return static_cast<int32_t>(now() - deadline) >= 0; }
+
+    /**
+     * @brief Attente active jusqu'à une date absolue (retour immédiat si elle est passée)
+     */
+    static void waitUntil(uint32_t deadline);
+
+    /**
+     * @brief Prend la date courante comme origine des échéances
+     */
+    void start() { target = now(); }
+
+    /**
+     * @brief Attend la fin de la phase suivante, comptée depuis l'échéance précédente
+     * @param us Durée nominale de la phase
+     */
+    void wait(uint32_t us) {
+        target += ticks(us);
+        waitUntil(target);
+    }
+
+    /**
+     * @brief Avance l'échéance sans attendre (phase confiée à un périphérique)
+     */
+    void advance(uint32_t us) { target += ticks(us); }
+
+    /**
+     * @brief Dernière échéance visée
+     */
+    uint32_t deadline() const { return target; }
+
+    /**
+     * @brief Mesure la précision des attentes sur la plateforme courante
+     *
+     * Dure quelques dizaines de millisecondes. Les écritures de broche d'un
+     * paquet sont reproduites sur la broche donnée, qui doit être libre: la
+     * broche ADB émettrait des impulsions sur le bus.
+     * @param pin Broche libre pilotée pendant le test (0xFF = aucune écriture)
+     */
+    static adb_timing_report selfTest(uint8_t pin = 0xFF);
+
+    /**
+     * @brief Affiche un rapport de selfTest
+     */
+    static void printReport(Print& out, const adb_timing_report& report);
+
+private:
+    static uint32_t scale;   // Unités du compteur par µs
+    uint32_t target = 0;     // Échéance courante
+};
+
+#endif // ADB_TIMING_h
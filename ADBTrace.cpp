@@ -0,0 +1,75 @@
+/**
+ * @file ADBTrace.cpp
+ * @brief Restitution de la chronologie des points de trace ADB
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBTrace.h"
+
+#if defined(ADB_ENABLE_TRACE)
+ADBTraceBuffer adbTraceBuffer;
+#endif
+
+const char* ADBTraceBuffer::phaseName(uint8_t phase) {
+    switch (static_cast<ADBTracePhase>(phase)) {
+        case ADBTracePhase::ATTENTION:   return "attention";
+        case ADBTracePhase::SYNC:        return "sync";
+        case ADBTracePhase::WRITE_BIT:   return "bit émis";
+        case ADBTracePhase::TLT_START:   return "tlt début";
+        case ADBTracePhase::TLT_SRQ:     return "tlt srq";
+        case ADBTracePhase::TLT_END:     return "tlt fin";
+        case ADBTracePhase::READ_BIT:    return "bit reçu";
+        case ADBTracePhase::BIT_TIMEOUT: return "bit hors délai";
+        case ADBTracePhase::GLITCH:      return "parasite";
+        default:                         return "?";
+    }
+}
+
+void ADBTraceBuffer::dump(Print& out, uint32_t cyclesPerUs) const {
+    // Entrées valides: les plus anciennes ont pu être écrasées
+    uint16_t count = total < ADB_TRACE_SIZE ? static_cast<uint16_t>(total) : ADB_TRACE_SIZE;
+    uint16_t first = (next - count) & (ADB_TRACE_SIZE - 1);
+
+    out.print(F("Trace ADB: "));
+    out.print(count);
+    out.print(F(" entrées sur "));
+    out.print(total);
+    out.println(cyclesPerUs ? F(" (t en µs)") : F(" (t en cycles)"));
+    if (count == 0) return;
+
+    uint32_t origin = entries[first].cycles;
+    uint32_t previous = origin;
+    for (uint16_t i = 0; i < count; i++) {
+        const adb_trace_entry& entry = entries[(first + i) & (ADB_TRACE_SIZE - 1)];
+        uint32_t t = entry.cycles - origin;
+        uint32_t delta = entry.cycles - previous;
+        previous = entry.cycles;
+        if (cyclesPerUs) {
+            t /= cyclesPerUs;
+            delta /= cyclesPerUs;
+        }
+
+        // t  +delta  phase  argument (décodé pour les bits reçus)
+        out.print(t);
+        out.print(F("\t+"));
+        out.print(delta);
+        out.print('\t');
+        out.print(phaseName(entry.phase));
+        out.print('\t');
+        if (entry.phase == static_cast<uint8_t>(ADBTracePhase::READ_BIT)) {
+            // Bit retenu par l'hôte, qui peut différer de la comparaison des durées (seuil appris)
+            uint8_t low = (entry.argument >> 8) & 0x7F;
+            uint8_t high = entry.argument & 0xFF;
+            out.print(entry.argument & 0x8000 ? '1' : '0');
+            out.print(F(" bas="));
+            out.print(low);
+            out.print(F(" haut="));
+            out.println(high);
+        } else {
+            out.println(entry.argument);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file ADBTrace.h
+ * @brief Points de trace des phases du protocole ADB
+ *
+ * Activés par l'option de compilation ADB_ENABLE_TRACE (build_flags = -D ADB_ENABLE_TRACE),
+ * les points de trace enregistrent (phase, horodatage en cycles, argument) dans
+ * un tampon circulaire de taille fixe. Sans cette option, ADB_TRACE() ne génère
+ * aucun code et les temporisations du protocole sont inchangées.
+ *
+ * Après un échec, adbTraceDump() restitue la chronologie des dernières phases:
+ * attention, synchronisation, bits de commande, Tlt et bits de données.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_TRACE_h
+#define ADB_TRACE_h
+
+#include <Arduino.h>
+#include <cstdint>
+#include "ADBPlatform.h"
+
+// Nombre d'entrées du tampon (puissance de 2)
+#ifndef ADB_TRACE_SIZE
+    #if defined(__AVR__)
+        #define ADB_TRACE_SIZE 32
+    #else
+        #define ADB_TRACE_SIZE 256
+    #endif
+#endif
+
+/**
+ * @brief Phases tracées
+ */
+enum class ADBTracePhase : uint8_t {
+    ATTENTION,       // Début du signal d'attention (argument: 0)
+    SYNC,            // Signal de synchronisation (argument: 0)
+    WRITE_BIT,       // Bit émis (argument: valeur du bit)
+    TLT_START,       // Début de l'attente Tlt (argument: réponse attendue)
+    TLT_SRQ,         // Ligne maintenue basse par un SRQ (argument: 0)
+    TLT_END,         // Fin de l'attente Tlt (argument: bit de début détecté)
+    READ_BIT,        // Bit reçu (argument: adbTraceCell, bit retenu par l'hôte et durées de la cellule)
+    BIT_TIMEOUT,     // Bit reçu hors délai (argument: 0 = front montant, 1 = front descendant)
+    GLITCH,          // Parasite rejeté par le filtre (argument: niveau de l'impulsion)
+    PHASE_COUNT
+};
+
+/**
+ * @brief Argument de READ_BIT: bit retenu << 15 | durée basse << 8 | durée haute
+ *
+ * Le bit est celui décidé par l'hôte (seuil appris par adresse avec
+ * setAdaptiveTiming), et non une comparaison des deux durées. Durées en µs,
+ * saturées à 127 (basse) et 255 (haute).
+ */
+inline uint16_t adbTraceCell(uint8_t bit, uint32_t lowUs, uint32_t highUs) {
+    return static_cast<uint16_t>((bit ? 0x8000 : 0) | (lowUs < 127 ? lowUs : 127) << 8 | (highUs < 255 ? highUs : 255));
+}
+
+/**
+ * @brief Entrée du tampon de trace
+ */
+struct adb_trace_entry {
+    uint32_t cycles;     // Horodatage (adbCycleCount)
+    uint16_t argument;   // Argument propre à la phase
+    uint8_t phase;       // ADBTracePhase
+};
+
+/**
+ * @brief Tampon circulaire des points de trace
+ */
+class ADBTraceBuffer {
+public:
+    static_assert((ADB_TRACE_SIZE & (ADB_TRACE_SIZE - 1)) == 0, "ADB_TRACE_SIZE doit être une puissance de 2");
+
+    ADBTraceBuffer() : next(0), total(0), entries{} {}
+
+    /**
+     * @brief Enregistre un point de trace (écrase la plus ancienne entrée)
+     */
+    void record(ADBTracePhase phase, uint16_t argument) {
+        adb_trace_entry& entry = entries[next];
+        entry.cycles = adbCycleCount();
+        entry.argument = argument;
+        entry.phase = static_cast<uint8_t>(phase);
+        next = (next + 1) & (ADB_TRACE_SIZE - 1);
+        total++;
+    }
+
+    /**
+     * @brief Vide le tampon
+     */
+    void clear() { next = 0; total = 0; }
+
+    /**
+     * @brief Nombre de points enregistrés depuis le dernier clear() (y compris écrasés)
+     */
+    uint32_t recorded() const { return total; }
+
+    /**
+     * @brief Imprime la chronologie, de la plus ancienne à la plus récente entrée
+     * @param out Sortie (Serial...)
+     * @param cyclesPerUs Cycles par microseconde pour afficher des µs (0 = cycles bruts)
+     */
+    void dump(Print& out, uint32_t cyclesPerUs = 0) const;
+
+    /**
+     * @brief Nom lisible d'une phase
+     */
+    static const char* phaseName(uint8_t phase);
+
+private:
+    uint16_t next;      // Prochaine entrée écrite
+    uint32_t total;     // Nombre total d'enregistrements
+    adb_trace_entry entries[ADB_TRACE_SIZE];
+};
+
+#if defined(ADB_ENABLE_TRACE)
+    extern ADBTraceBuffer adbTraceBuffer;
+
+    #define ADB_TRACE(phase, argument) adbTraceBuffer.record(ADBTracePhase::phase, (argument))
+    #define adbTraceDump(out, ...) adbTraceBuffer.dump((out), ##__VA_ARGS__)
+    #define adbTraceClear() adbTraceBuffer.clear()
+#else
+    #define ADB_TRACE(phase, argument) do {} while (0)
+    #define adbTraceDump(out, ...) do {} while (0)
+    #define adbTraceClear() do {} while (0)
+#endif
+
+#endif // ADB_TRACE_h
@@ -94,8 +94,72 @@ public:
         return true;
     }
     
+    /**
+     * @brief Imprime le dernier état publié, sans transaction sur le bus
+     *
+     * Utilisable depuis une tâche de diagnostic concurrente de la boucle de
+     * lecture des périphériques.
+     */
+    void printSnapshot() {
+        adb_device_snapshot snapshot;
+        devices.readSnapshot(snapshot);
+        
+        Serial.println(F("ADB Snapshot:"));
+        Serial.print(F("  Keyboard: "));
+        Serial.println(snapshot.isPresent(ADBKey::Address::KEYBOARD) ? F("present") : F("absent"));
+        Serial.print(F("  Keys down:"));
+        for (uint8_t code = 0; code < 128; code++) {
+            if (snapshot.isKeyDown(code)) {
+                Serial.print(F(" 0x"));
+                Serial.print(code, HEX);
+            }
+        }
+        Serial.println();
+        Serial.print(F("  LEDs (num/caps/scroll): "));
+        Serial.print(snapshot.leds & 0x01 ? F("ON ") : F("OFF "));
+        Serial.print(snapshot.leds & 0x02 ? F("ON ") : F("OFF "));
+        Serial.println(snapshot.leds & 0x04 ? F("ON") : F("OFF"));
+        Serial.print(F("  Mouse: "));
+        Serial.println(snapshot.isPresent(ADBKey::Address::MOUSE) ? F("present") : F("absent"));
+        Serial.print(F("  Mouse position: "));
+        Serial.print(snapshot.mouseX);
+        Serial.print(F(", "));
+        Serial.println(snapshot.mouseY);
+        Serial.print(F("  Updates: "));
+        Serial.println(snapshot.updates);
+    }
+    
+    /**
+     * @brief Imprime les durées des phases de démarrage
+     */
+    void printBootTimings() {
+        const adb_boot_timings& boot = devices.bootTimings();
+        
+        Serial.println(F("ADB Boot:"));
+        Serial.print(F("  Mode: "));
+        Serial.println(boot.warmBoot ? F("warm (cache)") : F("cold"));
+        Serial.print(F("  Started at: "));
+        Serial.print(boot.startedAt);
+        Serial.println(F(" ms"));
+        printBootPhase(F("  First device: "), boot.firstDeviceMs);
+        printBootPhase(F("  Keyboard ready: "), boot.keyboardReadyMs);
+        printBootPhase(F("  Discovery complete: "), boot.completeMs);
+    }
+    
 private:
     ADBDevices& devices;
+    
+    template <typename Label>
+    static void printBootPhase(Label label, uint32_t elapsed) {
+        Serial.print(label);
+        if (elapsed == ADBProtocol::BOOT_PENDING) {
+            Serial.println(F("-"));
+        } else {
+            Serial.print(F("+"));
+            Serial.print(elapsed);
+            Serial.println(F(" ms"));
+        }
+    }
 };
 
 #endif // ADB_UTILS_h
@@ -0,0 +1,83 @@
+/**
+ * @file ADBWaveform.cpp
+ * @brief Implémentation du motif d'émission
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBWaveform.h"
+
+ADBWaveform::ADBWaveform(uint32_t* storage, size_t words, uint32_t shiftRateHz, ADBSampleOrder order)
+    : storage(storage), words(words), rateHz(shiftRateHz), bitOrder(order), count(0), elapsedUs(0),
+      overflow(false), distortion(false), phases(ADBHostTiming::DEFAULT) {}
+
+void ADBWaveform::clear() {
+    count = 0;
+    elapsedUs = 0;
+    overflow = false;
+    distortion = false;
+}
+
+void ADBWaveform::setShiftRate(uint32_t shiftRateHz) {
+    rateHz = shiftRateHz;
+    clear();
+}
+
+bool ADBWaveform::append(bool level, uint32_t us) {
+    if (overflow) return false;
+
+    // Fin du palier arrondie à partir de la durée cumulée: pas de dérive
+    elapsedUs += us;
+    size_t target = static_cast<size_t>((static_cast<uint64_t>(elapsedUs) * rateHz + 500000) / 1000000);
+    if (target > capacity()) {
+        overflow = true;
+        return false;
+    }
+
+    // Durée restituée du palier comparée à la durée demandée
+    int64_t emittedNs = static_cast<int64_t>((static_cast<uint64_t>(target - count) * 1000000000ULL) / rateHz);
+    int64_t errorNs = emittedNs - static_cast<int64_t>(us) * 1000;
+    if (errorNs < 0) errorNs = -errorNs;
+    if (static_cast<uint64_t>(errorNs) * 1000 > static_cast<uint64_t>(us) * 1000 * ADBProtocol::HOST_TOLERANCE_PERMILLE) {
+        distortion = true;
+    }
+
+    // Remplissage par mots entiers ou fractions de mot
+    while (count < target) {
+        uint8_t bit = count & 31;
+        uint8_t take = static_cast<uint8_t>(target - count < 32u - bit ? target - count : 32u - bit);
+        uint32_t& word = storage[count >> 5];
+        if (bit == 0) word = 0;
+        if (level) {
+            uint32_t ones = take == 32 ? 0xFFFFFFFFUL : (1UL << take) - 1;
+            word |= bitOrder == ADBSampleOrder::MSB_FIRST ? ones << (32 - bit - take) : ones << bit;
+        }
+        count += take;
+    }
+    return true;
+}
+
+bool ADBWaveform::cell(uint8_t bit) {
+    append(false, bit ? phases.shortPhaseUs : phases.longPhaseUs);
+    return append(true, bit ? phases.longPhaseUs : phases.shortPhaseUs);
+}
+
+bool ADBWaveform::command(uint8_t command) {
+    clear();
+    append(false, phases.attentionUs);
+    append(true, phases.syncUs);
+    for (int8_t i = 7; i >= 0; i--) cell((command >> i) & 0x01);
+    return cell(0);
+}
+
+bool ADBWaveform::dataPacket(uint16_t bits, uint8_t length) {
+    clear();
+    cell(1);
+    for (int8_t i = length - 1; i >= 0; i--) cell((bits >> i) & 0x01);
+    return cell(0);
+}
+
+ADBShiftDriver::ADBShiftDriver(uint32_t* storage, size_t words, uint32_t shiftRateHz, ADBSampleOrder order)
+    : pattern(storage, words, shiftRateHz, order) {}
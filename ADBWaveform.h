@@ -0,0 +1,150 @@
+/**
+ * @file ADBWaveform.h
+ * @brief Émission par décalage d'un motif binaire (SPI, UART, DMA)
+ *
+ * Les phases d'une transaction ADB (attention 800 µs, synchronisation 70 µs,
+ * cellules de 100 µs découpées en 35/65 µs) sont converties en un motif de
+ * bits à cadence fixe: 1 = ligne relâchée, 0 = ligne tirée vers le bas. Un
+ * périphérique de décalage (MOSI d'un SPI, DMA vers un port) restitue ce
+ * motif sans intervention du processeur: les durées ne dépendent plus des
+ * interruptions qui retardent les fronts émis par ADB::writeBit.
+ *
+ * Le motif utilise le format des tampons d'ADBSampleDecoder: il se relit avec
+ * ADBRunReader, ce qui permet de vérifier les temporisations sur l'hôte.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_WAVEFORM_h
+#define ADB_WAVEFORM_h
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+#include "ADBSampleDecoder.h"
+
+/**
+ * @brief Construction du motif d'une commande ou d'un paquet de données
+ *
+ * Les durées sont cumulées avant arrondi: l'erreur sur la date de chaque
+ * front reste inférieure à une demi-période de décalage, quelle que soit la
+ * longueur du motif.
+ */
+class ADBWaveform {
+public:
+    /**
+     * @param storage Tampon préalloué
+     * @param words Taille du tampon en mots de 32 bits
+     * @param shiftRateHz Cadence de décalage (200 kHz suffisent à ADBHostTiming::DEFAULT, dont toutes les phases sont multiples de 5 µs)
+     * @param order Rang des bits dans un mot, selon le périphérique
+     */
+    ADBWaveform(uint32_t* storage, size_t words, uint32_t shiftRateHz, ADBSampleOrder order = ADBSampleOrder::MSB_FIRST);
+
+    void clear();
+
+    /**
+     * @brief Ajoute un palier
+     * @param level Niveau (true = ligne relâchée)
+     * @param us Durée en microsecondes
+     * @return false si le tampon est plein (le motif est alors inutilisable)
+     */
+    bool append(bool level, uint32_t us);
+
+    /**
+     * @brief Durées des phases (ADBHostTiming::DEFAULT par défaut), fixées par ADB avant chaque motif
+     */
+    void setTiming(const adb_host_timing& timing) { phases = timing; }
+
+    /**
+     * @brief Cellule de bit: 1 = partie courte basse puis longue haute, 0 l'inverse (35/65 µs par défaut)
+     */
+    bool cell(uint8_t bit);
+
+    /**
+     * @brief Motif complet d'une commande: attention, synchronisation, 8 bits, bit d'arrêt
+     */
+    bool command(uint8_t command);
+
+    /**
+     * @brief Motif complet d'un paquet de données: bit de début, données, bit d'arrêt
+     * @param bits Données, premier bit émis en poids fort
+     * @param length Nombre de bits de données
+     */
+    bool dataPacket(uint16_t bits, uint8_t length);
+
+    const uint32_t* data() const { return storage; }
+    uint32_t* data() { return storage; }
+    size_t bits() const { return count; }
+    size_t capacity() const { return words * 32; }
+    uint32_t durationUs() const { return elapsedUs; }
+    bool overflowed() const { return overflow; }
+
+    /**
+     * @brief Un palier du dernier motif s'écarte de sa durée de plus de la tolérance d'émission (±3%)
+     *
+     * L'arrondi à la période de décalage déplace chaque front d'au plus une
+     * demi-période: une cadence trop lente ou sans rapport avec les durées
+     * émises ne peut pas les restituer.
+     */
+    bool distorted() const { return distortion; }
+
+    uint32_t shiftRate() const { return rateHz; }
+
+    /**
+     * @brief Change la cadence de décalage (celle réellement obtenue du périphérique), le motif est effacé
+     */
+    void setShiftRate(uint32_t shiftRateHz);
+    ADBSampleOrder order() const { return bitOrder; }
+
+private:
+    uint32_t* storage;
+    size_t words;
+    uint32_t rateHz;
+    ADBSampleOrder bitOrder;
+    size_t count;          // Bits du motif
+    uint32_t elapsedUs;    // Durée nominale cumulée
+    bool overflow;
+    bool distortion;       // Palier hors tolérance depuis clear()
+    adb_host_timing phases;   // Durées des phases émises
+};
+
+/**
+ * @brief Périphérique qui restitue un motif sur la ligne
+ *
+ * Utilisé par ADB::writeCommand et ADB::writeDataPacket à la place de
+ * writeBit lorsqu'il est attaché avec ADB::setTransmitter. L'implémentation
+ * se limite à démarrer le décalage et à signaler sa fin.
+ */
+class ADBShiftDriver {
+public:
+    /**
+     * @param storage Tampon préalloué du motif
+     * @param words Taille du tampon en mots de 32 bits (une commande à 200 kHz occupe 12 mots)
+     * @param shiftRateHz Cadence de décalage du périphérique
+     * @param order Rang des bits dans un mot attendu par le périphérique
+     */
+    ADBShiftDriver(uint32_t* storage, size_t words, uint32_t shiftRateHz, ADBSampleOrder order);
+    virtual ~ADBShiftDriver() {}
+
+    /**
+     * @brief Démarre l'émission du motif sans en attendre la fin (le contenu du tampon peut être consommé)
+     * @param words Motif
+     * @param bits Nombre de bits à émettre
+     * @return false si le périphérique n'a pas pu démarrer
+     */
+    virtual bool start(uint32_t* words, size_t bits) = 0;
+
+    /**
+     * @brief Émission en cours, jusqu'à la sortie du dernier bit (toujours false pour un périphérique bloquant)
+     */
+    virtual bool busy() { return false; }
+
+    ADBWaveform& waveform() { return pattern; }
+
+protected:
+    ADBWaveform pattern;
+};
+
+#endif // ADB_WAVEFORM_h
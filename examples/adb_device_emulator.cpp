@@ -0,0 +1,124 @@
+/**
+ * @file adb_device_emulator.cpp
+ * @brief Clavier et souris ADB émulés, branchés sur le port ADB d'un Macintosh
+ *
+ * L'adaptateur se comporte comme un clavier (adresse 2) et une souris
+ * (adresse 3). Les caractères reçus sur le port série sont tapés sur le
+ * clavier émulé; les lettres h, j, k, l précédées de '~' déplacent la souris.
+ * Les LEDs écrites par le Macintosh sont affichées à chaque changement.
+ *
+ * La ligne de données est reliée au Macintosh (masse commune); la résistance
+ * de tirage est celle de l'hôte.
+ *
+ * Sur AVR, les réponses sont cadencées par le timer 1: la PWM des broches 9
+ * et 10 et la bibliothèque Servo ne sont pas disponibles.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include "ADBDeviceEmulator.h"
+#include "ADBPlatform.h"
+
+// Initialisation des objets
+ADBEmulatedKeyboard keyboard;
+ADBEmulatedMouse mouse;
+ADBDeviceEmulator emulator(ADB_DEFAULT_PIN);
+
+/**
+ * @brief Code ADB d'une lettre ou d'un chiffre (clavier QWERTY US)
+ * @return 0xFF si le caractère n'a pas de touche
+ */
+uint8_t adbCodeFor(char c) {
+  static const uint8_t letters[26] = {
+    0x00, 0x0B, 0x08, 0x02, 0x0E, 0x03, 0x05, 0x04, 0x22, 0x26, 0x28, 0x25, 0x2E,  // a-m
+    0x2D, 0x1F, 0x23, 0x0C, 0x0F, 0x01, 0x11, 0x20, 0x09, 0x0D, 0x07, 0x10, 0x06   // n-z
+  };
+  static const uint8_t digits[10] = {0x1D, 0x12, 0x13, 0x14, 0x15, 0x17, 0x16, 0x1A, 0x1C, 0x19};
+
+  if (c >= 'a' && c <= 'z') return letters[c - 'a'];
+  if (c >= '0' && c <= '9') return digits[c - '0'];
+  if (c == ' ') return 0x31;
+  if (c == '\n' || c == '\r') return 0x24;
+  return 0xFF;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial && millis() < 3000);
+
+  Serial.println(F("=== Clavier et souris ADB émulés ==="));
+  printPlatformInfo();
+
+  emulator.attach(keyboard);
+  emulator.attach(mouse);
+  if (!emulator.begin()) {
+    Serial.println(F("Émulation impossible"));
+  }
+}
+
+void loop() {
+  static bool mouseMode = false;
+
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '~') {
+      mouseMode = true;
+      continue;
+    }
+    if (mouseMode) {
+      mouseMode = false;
+      switch (c) {
+        case 'h': mouse.move(-20, 0); break;
+        case 'l': mouse.move(20, 0); break;
+        case 'k': mouse.move(0, -20); break;
+        case 'j': mouse.move(0, 20); break;
+        case ' ':
+          mouse.setButton(true);
+          delay(50);
+          mouse.setButton(false);
+          break;
+      }
+      continue;
+    }
+
+    // Appui puis relâchement; le Macintosh interroge le clavier toutes les 11 ms environ
+    uint8_t code = adbCodeFor(c);
+    if (code == 0xFF) continue;
+    keyboard.keyEvent(code, false);
+    keyboard.keyEvent(code, true);
+  }
+
+  static uint8_t reportedLeds = 0;
+  if (keyboard.leds() != reportedLeds) {
+    reportedLeds = keyboard.leds();
+    Serial.print(F("LEDs: Num "));
+    Serial.print(reportedLeds & 0x01 ? F("on") : F("off"));
+    Serial.print(F(", Caps "));
+    Serial.print(reportedLeds & 0x02 ? F("on") : F("off"));
+    Serial.print(F(", Scroll "));
+    Serial.println(reportedLeds & 0x04 ? F("on") : F("off"));
+  }
+
+  static uint32_t lastReport = 0;
+  if (millis() - lastReport > 10000) {
+    lastReport = millis();
+    const adb_emulator_stats& stats = emulator.stats();
+    Serial.print(F("Adresses clavier/souris: "));
+    Serial.print(keyboard.address());
+    Serial.print('/');
+    Serial.print(mouse.address());
+    Serial.print(F(", commandes "));
+    Serial.print(stats.commands);
+    Serial.print(F(", réponses "));
+    Serial.print(stats.talks);
+    Serial.print(F(", SRQ "));
+    Serial.print(stats.srqs);
+    Serial.print(F(", collisions "));
+    Serial.print(stats.collisions);
+    Serial.print(F(", tardives "));
+    Serial.println(stats.lateResponses);
+  }
+}
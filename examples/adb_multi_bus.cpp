@@ -0,0 +1,84 @@
+/**
+ * @file adb_multi_bus.cpp
+ * @brief Deux ports ADB indépendants interrogés en parallèle (ADBMultiBus)
+ *
+ * Chaque port reçoit son propre clavier et sa propre souris (poste de KVM,
+ * ou clavier et souris sur des connecteurs séparés). Les touches et
+ * mouvements sont affichés avec le numéro du port; le débit agrégé est
+ * affiché toutes les 10 secondes.
+ *
+ * Chaque ligne de données a sa propre résistance de tirage de 1 kΩ à +5 V.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include "ADBMultiBus.h"
+#include "ADBPlatform.h"
+
+#ifndef ADB_SECOND_PIN
+#define ADB_SECOND_PIN (ADB_DEFAULT_PIN + 1)
+#endif
+
+void onResult(void* context, const adb_multibus_result& result);
+
+// Initialisation des objets
+ADB port0(ADB_DEFAULT_PIN);
+ADB port1(ADB_SECOND_PIN);
+ADBMultiBus buses(onResult, nullptr);
+
+void onResult(void* context, const adb_multibus_result& result) {
+  (void)context;
+  if (!result.polled || result.status != ADBProtocol::Status::OK) return;
+
+  uint8_t addr = (result.command >> 4) & 0x0F;
+  Serial.print(F("Port "));
+  Serial.print(result.bus);
+  if (addr == ADBKey::Address::KEYBOARD) {
+    Serial.print(F(" touches 0x"));
+    Serial.println(result.data, HEX);
+  } else {
+    Serial.print(F(" souris dx="));
+    Serial.print(adbMouseConvertAxis(result.data & 0x7F) / 2);
+    Serial.print(F(" dy="));
+    Serial.println(adbMouseConvertAxis((result.data >> 8) & 0x7F) / 2);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial && millis() < 3000);
+
+  Serial.println(F("=== Deux ports ADB en parallèle ==="));
+  printPlatformInfo();
+
+  for (ADB* port : {&port0, &port1}) {
+    uint8_t bus = buses.addBus(*port);
+    buses.pollDevice(bus, ADBKey::Address::KEYBOARD);
+    buses.pollDevice(bus, ADBKey::Address::MOUSE);
+  }
+  // Interrogation toutes les 10 ms par port, comme un Macintosh
+  buses.setConfig({ADBMultiBus::MAX_BUSES, 10000, 200});
+  if (!buses.begin()) {
+    Serial.println(F("Défaut de ligne sur l'un des ports"));
+  }
+}
+
+void loop() {
+  // Scrutation tant qu'une échéance est proche, puis retour à la boucle
+  buses.service();
+
+  static uint32_t lastReport = 0;
+  if (millis() - lastReport > 10000) {
+    lastReport = millis();
+    adb_multibus_throughput throughput = buses.throughput();
+    Serial.print(F("Transactions/s: "));
+    Serial.print(throughput.transactionsPerSecond);
+    Serial.print(F(", occupation cumulée (µs/s): "));
+    Serial.print(throughput.busyUsPerSecond);
+    Serial.print(F(", parallélisme x"));
+    Serial.println(throughput.parallelism / 100.0);
+  }
+}
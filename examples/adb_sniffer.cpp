@@ -0,0 +1,85 @@
+/**
+ * @file adb_sniffer.cpp
+ * @brief Écoute passive d'un bus ADB entre un Macintosh et ses périphériques
+ *
+ * L'adaptateur est branché en dérivation sur la ligne de données (masse
+ * commune, sans résistance de tirage supplémentaire). Il ne pilote jamais la
+ * ligne: chaque transaction de l'hôte est décodée par interruption puis
+ * affichée sur le port série (commande, adresse, registre, données, SRQ et
+ * anomalies de temporisation).
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include "ADB.h"
+#include "ADBSniffer.h"
+#include "ADBPlatform.h"
+
+// Initialisation des objets
+ADB adb(ADB_DEFAULT_PIN);
+ADBSnifferBuffer<32> sniffer;  // File des transactions décodées
+
+void printFrame(const adb_frame& frame) {
+  Serial.print(frame.startUs);
+  Serial.print(' ');
+  if (frame.type == ADBFrameType::RESET) {
+    Serial.print(F("Reset "));
+    Serial.print(frame.attentionUs);
+    Serial.print(F("us"));
+  } else if (frame.type == ADBFrameType::STRAY) {
+    Serial.print(F("Impulsion "));
+    Serial.print(frame.attentionUs);
+    Serial.print(F("us"));
+  } else {
+    Serial.print(frame.commandName());
+    Serial.print(F(" adr "));
+    Serial.print(frame.address());
+    Serial.print(F(" R"));
+    Serial.print(frame.reg());
+    for (uint8_t i = 0; i < frame.dataBytes(); i++) {
+      Serial.print(' ');
+      if (frame.data[i] < 0x10) Serial.print('0');
+      Serial.print(frame.data[i], HEX);
+    }
+    if (frame.srq()) Serial.print(F(" SRQ"));
+  }
+  if (frame.flags) {
+    Serial.print(F(" anomalies 0x"));
+    Serial.print(frame.flags, HEX);
+  }
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial && millis() < 3000);
+
+  Serial.println(F("=== Écoute passive du bus ADB ==="));
+  printPlatformInfo();
+
+  // Aucune initialisation du bus: la ligne appartient à l'hôte observé
+  if (!adb.beginSniffing(sniffer)) {
+    Serial.println(F("Écoute impossible"));
+  }
+}
+
+void loop() {
+  // Clôture des paquets terminés puis affichage des transactions en attente
+  sniffer.service();
+
+  adb_frame frame;
+  while (sniffer.read(frame)) {
+    printFrame(frame);
+  }
+
+  // Transactions perdues: la liaison série est trop lente pour le trafic observé
+  static uint32_t reportedOverruns = 0;
+  if (sniffer.overruns() != reportedOverruns) {
+    reportedOverruns = sniffer.overruns();
+    Serial.print(F("Transactions perdues: "));
+    Serial.println(reportedOverruns);
+  }
+}
@@ -13,6 +13,8 @@
 #include <Arduino.h>
 #include <ADB.h>
 #include <ADBUtils.h>
+#include <ADBDeviceCache.h>
+#include <ADBHIDReport.h>
 #include <BLEDevice.h>
 #include <BLEHIDDevice.h>
 #include <HIDTypes.h>
@@ -26,6 +28,8 @@ constexpr const char* DEVICE_NAME = "ADB2BLE Adapter";
 ADB adb(ADB_PIN);
 ADBDevices devices(adb);
 ADBUtils utils(devices);
+ADBDeviceCache deviceCache;  // Table des périphériques conservée en NVS
+ADBLatencyTracker latency;   // Latences événement ADB -> rapport BLE ('l' sur le port série)
 
 // BLE HID
 BLEHIDDevice* hid;
@@ -33,15 +37,11 @@ BLECharacteristic* inputKeyboard;
 BLECharacteristic* inputMouse;
 bool connected = false;
 
-// États
-bool keyboardConnected = false;
-bool mouseConnected = false;
-uint8_t keyboardReport[8] = {0};  // Modificateurs + touches
-uint8_t mouseReport[4] = {0};     // Bouton, X, Y, Wheel
+// Handler ID du clavier (3 = distinction des modificateurs gauche/droite)
+constexpr uint8_t KEYBOARD_HANDLER_ID = 0x03;
 
-// Variables pour le suivi des mouvements de souris
-int16_t accumulatedX = 0;
-int16_t accumulatedY = 0;
+// Construction des rapports HID (touches enfoncées, modificateurs, mouvements cumulés)
+ADBHIDReport hidReport;
 
 // Callback pour la connexion BLE
 class ServerCallbacks : public BLEServerCallbacks {
@@ -146,194 +146,69 @@ void setupBLE() {
   Serial.println(F("BLE HID prêt, en attente de connexion"));
 }
 
+// Notification des branchements et débranchements ADB
+void onPresenceChange(uint8_t addr, bool present) {
+  Serial.print(addr == ADBKey::Address::KEYBOARD ? F("Clavier ADB ") : F("Souris ADB "));
+  Serial.println(present ? F("connecté") : F("déconnecté"));
+}
+
 void setup() {
-  // Initialisation de la communication série
+  // Initialisation de la communication série (UART, aucune attente nécessaire)
   Serial.begin(115200);
-  delay(1000);
   
   Serial.println(F("ADB2BLE pour ESP32 - PlatformIO"));
   Serial.println(F("Bibliothèque ADB multiplateforme"));
   
-  // Initialisation du bus ADB
+  // Initialisation du bus ADB avant le BLE, dont le démarrage est long
   adb.init();
   
+  // Surveillance des périphériques ADB (détection et rebranchement à chaud),
+  // démarrage immédiat à partir de la table mémorisée au démarrage précédent
+  devices.setPresenceCallback(onPresenceChange);
+  devices.monitorDevice(ADBKey::Address::KEYBOARD, KEYBOARD_HANDLER_ID);
+  devices.monitorDevice(ADBKey::Address::MOUSE);
+  devices.setLatencyTracker(&latency);
+  devices.beginStartup(&deviceCache);
+  
   // Configuration BLE
   setupBLE();
   
-  // Détection des périphériques ADB
-  bool error;
-  
-  // Test du clavier
-  auto kbData = devices.keyboardReadModifiers(&error);
-  keyboardConnected = !error;
-  
-  // Test de la souris
-  error = false;
-  auto mouseData = devices.mouseReadData(&error);
-  mouseConnected = !error;
-  
-  Serial.print(F("Périphériques détectés - Clavier: "));
-  Serial.print(keyboardConnected ? F("Oui") : F("Non"));
-  Serial.print(F(", Souris: "));
-  Serial.println(mouseConnected ? F("Oui") : F("Non"));
-  
   Serial.println(F("Conversion ADB->BLE active"));
 }
 
 void handleKeyboard() {
-  if (!keyboardConnected || !connected) return;
+  if (!devices.isDevicePresent(ADBKey::Address::KEYBOARD) || !connected) return;
   
   bool error = false;
-  static uint8_t lastModifiers = 0;
-  static uint8_t lastKeys[6] = {0};
-  bool reportChanged = false;
   
-  // Lecture des touches
+  // Lecture des touches (une absence de réponse signifie qu'aucune touche n'a changé)
   auto keyPress = devices.keyboardReadKeyPress(&error);
-  if (error) {
-    keyboardConnected = false;
-    Serial.println(F("Clavier ADB déconnecté"));
-    return;
-  }
-  
-  // Lecture des modificateurs
-  auto modifiers = devices.keyboardReadModifiers(&error);
   if (error) return;
   
-  // Construction du rapport clavier BLE HID
-  uint8_t modByte = 0;
-  if (modifiers.data.shift) modByte |= KEY_MOD_LSHIFT;
-  if (modifiers.data.control) modByte |= KEY_MOD_LCTRL;
-  if (modifiers.data.option) modByte |= KEY_MOD_LALT;
-  if (modifiers.data.command) modByte |= KEY_MOD_LMETA;
-  
-  if (modByte != lastModifiers) {
-    lastModifiers = modByte;
-    reportChanged = true;
-  }
-  
-  // Effacement des touches
-  memset(&keyboardReport[2], 0, 6);
-  
-  // Ajout des touches
-  uint8_t keyIdx = 0;
-  
-  if (keyPress.data.key0 && !keyPress.data.released0) {
-    uint8_t hidCode = ADBKeymap::toHID(keyPress.data.key0);
-    if (hidCode != KEY_NONE && !ADBKeymap::isModifier(keyPress.data.key0)) {
-      keyboardReport[2 + keyIdx++] = hidCode;
-    }
-  }
-  
-  if (keyPress.data.key1 && !keyPress.data.released1) {
-    uint8_t hidCode = ADBKeymap::toHID(keyPress.data.key1);
-    if (hidCode != KEY_NONE && !ADBKeymap::isModifier(keyPress.data.key1)) {
-      keyboardReport[2 + keyIdx++] = hidCode;
-    }
-  }
-  
-  // Vérification des changements
-  for (uint8_t i = 0; i < 6; i++) {
-    if (keyboardReport[2 + i] != lastKeys[i]) {
-      lastKeys[i] = keyboardReport[2 + i];
-      reportChanged = true;
-    }
-  }
-  
-  // Envoi du rapport si nécessaire
-  if (reportChanged) {
-    keyboardReport[0] = modByte;
-    keyboardReport[1] = 0; // Reserved byte
-    inputKeyboard->setValue(keyboardReport, 8);
+  // Suivi des touches enfoncées et des modificateurs, envoi si le rapport a changé
+  if (hidReport.keyboardRegister0(keyPress.raw)) {
+    inputKeyboard->setValue((uint8_t*)&hidReport.keyboardReport(), sizeof(adb_hid_keyboard_report));
     inputKeyboard->notify();
+    latency.reportSent(ADBLatencyPath::KEYBOARD);
   }
 }
 
 void handleMouse() {
-  if (!mouseConnected || !connected) return;
+  if (!devices.isDevicePresent(ADBKey::Address::MOUSE) || !connected) return;
   
   bool error = false;
-  static bool lastButton = false;
   
   // Lecture des données de la souris
   auto mouseData = devices.mouseReadData(&error);
-  if (error) {
-    mouseConnected = false;
-    Serial.println(F("Souris ADB déconnectée"));
-    return;
-  }
-  
-  // Conversion des valeurs
-  int8_t deltaX = adbMouseConvertAxis(mouseData.data.x_offset);
-  int8_t deltaY = adbMouseConvertAxis(mouseData.data.y_offset);
-  bool button = mouseData.data.button;
-  
-  // Accumulation des petits mouvements
-  accumulatedX += deltaX;
-  accumulatedY += deltaY;
+  if (error) return;
   
-  // Envoi du rapport souris si mouvement ou changement de bouton
-  if (accumulatedX != 0 || accumulatedY != 0 || button != lastButton) {
-    // Limitation des valeurs
-    int8_t reportX = (accumulatedX > 127) ? 127 : ((accumulatedX < -127) ? -127 : accumulatedX);
-    int8_t reportY = (accumulatedY > 127) ? 127 : ((accumulatedY < -127) ? -127 : accumulatedY);
-    
-    // Construction du rapport
-    mouseReport[0] = button ? 1 : 0;  // Bouton gauche
-    mouseReport[1] = reportX;
-    mouseReport[2] = reportY;
-    mouseReport[3] = 0;  // Molette
-    
-    // Envoi du rapport
-    inputMouse->setValue(mouseReport, 4);
+  // Cumul du mouvement; les déplacements au-delà de ±127 partent au rapport suivant
+  hidReport.mouseRegister0(mouseData.raw);
+  adb_hid_mouse_report report;
+  if (hidReport.takeMouseReport(report)) {
+    inputMouse->setValue((uint8_t*)&report, sizeof(report));
     inputMouse->notify();
-    
-    // Mise à jour de l'état
-    lastButton = button;
-    
-    // Réinitialisation des accumulateurs après envoi
-    accumulatedX -= reportX;
-    accumulatedY -= reportY;
-  }
-}
-
-void reconnectDevices() {
-  static uint32_t lastReconnectAttempt = 0;
-  uint32_t now = millis();
-  
-  // Tentative de reconnexion toutes les 3 secondes
-  if (now - lastReconnectAttempt > 3000) {
-    lastReconnectAttempt = now;
-    
-    bool shouldReconnect = false;
-    
-    if (!keyboardConnected) {
-      bool error = false;
-      devices.keyboardReadModifiers(&error);
-      if (!error) {
-        keyboardConnected = true;
-        Serial.println(F("Clavier ADB reconnecté"));
-        shouldReconnect = true;
-      }
-    }
-    
-    if (!mouseConnected) {
-      bool error = false;
-      devices.mouseReadData(&error);
-      if (!error) {
-        mouseConnected = true;
-        Serial.println(F("Souris ADB reconnectée"));
-        shouldReconnect = true;
-      }
-    }
-    
-    if (shouldReconnect) {
-      Serial.println(F("Périphériques ADB actifs:"));
-      Serial.print(F("- Clavier: "));
-      Serial.println(keyboardConnected ? F("Connecté") : F("Déconnecté"));
-      Serial.print(F("- Souris: "));
-      Serial.println(mouseConnected ? F("Connectée") : F("Déconnectée"));
-    }
+    latency.reportSent(ADBLatencyPath::MOUSE);
   }
 }
 
@@ -342,9 +217,19 @@ void loop() {
   handleKeyboard();
   handleMouse();
   
-  // Reconnexion si nécessaire
-  if (!keyboardConnected || !mouseConnected) {
-    reconnectDevices();
+  // Surveillance du bus, écritures différées et rebranchements (coût borné)
+  devices.service();
+  
+  // Histogrammes de latence sur demande
+  if (Serial.available() && Serial.read() == 'l') {
+    latency.dump(Serial);
+  }
+  
+  // Rapport unique des durées de démarrage
+  static bool bootReported = false;
+  if (!bootReported && devices.isStartupComplete()) {
+    utils.printBootTimings();
+    bootReported = true;
   }
   
   // Délai de polling optimal
@@ -25,6 +25,8 @@ void setup() {
   Serial.println(F("ADB2USB pour ESP32 - PlatformIO"));
   adb.init();
   USBHID_begin(true, true);
+  // Lectures en erreur de bit reprises (3 fois, 6 ms par appel, 20 ms par seconde au plus)
+  devices.setRetryConfig({3, 6000, 20000, false});
 
   bool error;
   keyboardConnected = !devices.keyboardReadModifiers(&error);
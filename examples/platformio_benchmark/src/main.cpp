@@ -0,0 +1,47 @@
+/**
+ * @file main.cpp
+ * @brief Mesure sur cible du coût CPU et de l'occupation du bus des opérations ADB
+ *
+ * Un clavier (adresse 2) et une souris (adresse 3) doivent être branchés.
+ * Les résultats sont imprimés sur le port série à chaque appui sur Entrée,
+ * précédés du rapport d'auto-test des temporisations (ADBClock).
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADB.h>
+#include <ADBBench.h>
+#include <ADBTiming.h>
+#include <ADBPlatform.h>
+
+ADB adb(ADB_DEFAULT_PIN);
+ADBDevices devices(adb);
+ADBBench bench(ADB_DEFAULT_PIN);
+
+void runBench() {
+    printPlatformInfo();
+    ADBClock::printReport(Serial, ADBClock::selfTest());
+    bench.begin();
+    bench.runProtocolSuite(adb, devices, 100);
+    bench.end();
+    Serial.println();
+}
+
+void setup() {
+    Serial.begin(ADB_SERIAL_BAUD);
+    while (!Serial && millis() < 3000) {}
+
+    if (!adb.init(ADB_DEFAULT_PIN, true)) {
+        Serial.println(F("Ligne ADB bloquée"));
+    }
+    runBench();
+}
+
+void loop() {
+    if (Serial.available() && Serial.read() == '\n') {
+        runBench();
+    }
+}
@@ -0,0 +1,1089 @@
+/**
+ * @file ADBSim.cpp
+ * @brief Implémentation du simulateur de bus ADB et de l'API Arduino sur l'hôte
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include "ADBSim.h"
+#include "Arduino.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ADBSim {
+
+namespace {
+
+/**
+ * @brief Broche Arduino vue par le simulateur
+ */
+struct PinState {
+    Bus* bus;
+    Device* driver;     // Sortie open-drain de la broche
+    void (*isr)();
+    int mode;
+    bool pending;       // Interruption survenue pendant un masquage
+    bool spiked;        // Parasite en cours sur l'entrée de la broche
+};
+
+/**
+ * @brief Sortie open-drain pilotée par digitalWrite()
+ */
+class PinDriver : public Device {
+public:
+    void set(bool level) { driveNow(level); }
+};
+
+struct Simulator {
+    uint64_t clock = 0;
+    uint64_t nextEvent = UINT64_MAX;
+    CallCosts costs = {500, 500, 100};
+    std::vector<Bus*> buses;
+    PinState pins[256] = {};
+    bool interruptsEnabled = true;
+    bool inIsr = false;
+    void (*compareIsr)() = nullptr;     // Minuterie à comparaison
+    uint64_t compareAt = UINT64_MAX;    // Échéance armée (ns)
+    bool comparePending = false;
+};
+
+Simulator& sim() {
+    static Simulator instance;
+    return instance;
+}
+
+void schedule(uint64_t t) {
+    Simulator& s = sim();
+    if (t < s.nextEvent) s.nextEvent = t;
+}
+
+void runPendingInterrupts() {
+    Simulator& s = sim();
+    bool again = true;
+    while (again && s.interruptsEnabled && !s.inIsr) {
+        // Une routine peut en déclencher une autre: on reparcourt jusqu'à épuisement
+        again = false;
+        for (PinState& p : s.pins) {
+            if (p.pending && p.isr) {
+                p.pending = false;
+                s.inIsr = true;
+                p.isr();
+                s.inIsr = false;
+                again = true;
+            }
+        }
+        if (s.comparePending && s.compareIsr) {
+            s.comparePending = false;
+            s.inIsr = true;
+            s.compareIsr();
+            s.inIsr = false;
+            again = true;
+        }
+    }
+}
+
+/**
+ * @brief Niveau lu par une broche: celui de la ligne, sauf parasite sur une ligne haute
+ */
+bool pinLevel(uint8_t pin, bool line) {
+    return line && !sim().pins[pin].spiked;
+}
+
+void raiseInterrupt(uint8_t pin, bool level) {
+    Simulator& s = sim();
+    PinState& p = s.pins[pin];
+    if (!p.isr) return;
+    bool match = p.mode == CHANGE || (p.mode == RISING && level) || (p.mode == FALLING && !level);
+    if (!match) return;
+
+    p.pending = true;
+    runPendingInterrupts();
+}
+
+} // namespace
+
+Bus* busForPin(uint8_t pin) {
+    return sim().pins[pin].bus;
+}
+
+Device* pinDriver(uint8_t pin) {
+    return sim().pins[pin].driver;
+}
+
+void processUntil(uint64_t target) {
+    Simulator& s = sim();
+    while (s.nextEvent <= target) {
+        // Recherche de l'événement le plus proche parmi tous les participants
+        Device* next = nullptr;
+        uint64_t nextTime = UINT64_MAX;
+        for (Bus* bus : s.buses) {
+            for (Device* device : bus->devices) {
+                if (!device->events.empty() && device->events.front().t < nextTime) {
+                    nextTime = device->events.front().t;
+                    next = device;
+                }
+            }
+        }
+        if (s.compareAt < nextTime) {
+            // Échéance de la minuterie, servie comme une interruption de broche
+            nextTime = s.compareAt;
+            next = nullptr;
+        }
+        s.nextEvent = nextTime;
+        if (nextTime > target) break;
+        if (!next) {
+            if (s.clock < nextTime) s.clock = nextTime;
+            s.compareAt = UINT64_MAX;
+            s.comparePending = true;
+            runPendingInterrupts();
+            continue;
+        }
+
+        Device::Event event = next->events.front();
+        next->events.pop_front();
+        if (s.clock < event.t) s.clock = event.t;
+
+        if (event.level < 0) {
+            next->onTimer(s.clock);
+        } else if (next->driving != (event.level != 0)) {
+            next->driving = event.level != 0;
+            next->bus->update(s.clock);
+        }
+    }
+    if (s.clock < target) s.clock = target;
+}
+
+uint64_t now() {
+    return sim().clock;
+}
+
+void advance(uint64_t ns) {
+    processUntil(sim().clock + ns);
+}
+
+void setCallCosts(const CallCosts& costs) {
+    sim().costs = costs;
+}
+
+/**
+ * Participants
+ */
+
+Device::~Device() {}
+
+void Device::drive(uint64_t t, bool level) {
+    // Les événements sont presque toujours programmés dans l'ordre chronologique
+    Event event = {t, static_cast<int8_t>(level ? 1 : 0)};
+    auto it = events.end();
+    while (it != events.begin() && (it - 1)->t > t) --it;
+    events.insert(it, event);
+    schedule(t);
+}
+
+void Device::wakeAt(uint64_t t) {
+    Event event = {t, -1};
+    auto it = events.end();
+    while (it != events.begin() && (it - 1)->t > t) --it;
+    events.insert(it, event);
+    schedule(t);
+}
+
+void Device::cancelScheduled() {
+    events.clear();
+}
+
+void Device::driveNow(bool level) {
+    if (driving == level) return;
+    driving = level;
+    if (bus) bus->update(now());
+}
+
+Bus::Bus(uint8_t pin) {
+    sim().buses.push_back(this);
+    addPin(pin);
+}
+
+Bus::~Bus() {
+    Simulator& s = sim();
+    for (uint8_t pin : pins) {
+        s.pins[pin].bus = nullptr;
+        s.pins[pin].driver = nullptr;
+        s.pins[pin].spiked = false;
+    }
+    for (Device* driver : ownedDrivers) delete driver;
+    s.buses.erase(std::remove(s.buses.begin(), s.buses.end(), this), s.buses.end());
+}
+
+void Bus::addPin(uint8_t pin) {
+    PinDriver* driver = new PinDriver();
+    ownedDrivers.push_back(driver);
+    attach(*driver);
+    pins.push_back(pin);
+    sim().pins[pin].bus = this;
+    sim().pins[pin].driver = driver;
+}
+
+void Bus::attach(Device& device) {
+    device.bus = this;
+    devices.push_back(&device);
+    for (const Device::Event& event : device.events) schedule(event.t);
+}
+
+void Bus::setEdgeObserver(EdgeObserver newObserver, void* context) {
+    observer = newObserver;
+    observerContext = context;
+}
+
+void Bus::update(uint64_t t) {
+    // Ligne open-drain: haute seulement si aucun participant ne la tire vers le bas
+    bool newLevel = true;
+    for (Device* device : devices) newLevel = newLevel && device->driving;
+    if (newLevel == level) return;
+
+    level = newLevel;
+    edges++;
+    if (observer) observer(observerContext, t, level);
+    for (Device* device : devices) device->onLineEdge(t, level);
+    for (uint8_t pin : pins) {
+        // Une ligne qui remonte pendant un parasite ne produit pas de front sur la broche
+        if (!sim().pins[pin].spiked) raiseInterrupt(pin, level);
+    }
+}
+
+Noise::Noise(uint8_t pin, uint32_t seed) : pin(pin), rng(seed) {}
+
+void Noise::setSpikes(uint32_t perSecond, uint64_t minWidthNs, uint64_t maxWidthNs) {
+    rate = perSecond;
+    minWidth = minWidthNs;
+    maxWidth = maxWidthNs < minWidthNs ? minWidthNs : maxWidthNs;
+    cancelScheduled();
+    if (active) spike(false);
+    if (rate) wakeAt(now() + gapNs());
+}
+
+void Noise::onTimer(uint64_t t) {
+    spike(!active);
+    if (active) {
+        wakeAt(t + std::uniform_int_distribution<uint64_t>(minWidth, maxWidth)(rng));
+    } else if (rate) {
+        wakeAt(t + gapNs());
+    }
+}
+
+void Noise::spike(bool on) {
+    PinState& p = sim().pins[pin];
+    active = on;
+    p.spiked = on;
+    if (on) count++;
+    // Sur une ligne basse, le parasite reste invisible
+    if (!p.bus || p.bus->line()) raiseInterrupt(pin, !on);
+}
+
+uint64_t Noise::gapNs() {
+    return static_cast<uint64_t>(std::exponential_distribution<double>(rate)(rng) * 1e9);
+}
+
+namespace {
+std::vector<Load*>& loads() {
+    static std::vector<Load*> instances;
+    return instances;
+}
+}
+
+Load::Load(uint8_t pin, uint32_t seed) : pin(pin), rng(seed) {
+    PinState& p = sim().pins[pin];
+    p.isr = onInterrupt;
+    p.mode = CHANGE;
+    loads().push_back(this);
+}
+
+Load::~Load() {
+    PinState& p = sim().pins[pin];
+    p.isr = nullptr;
+    p.pending = false;
+    loads().erase(std::remove(loads().begin(), loads().end(), this), loads().end());
+}
+
+void Load::setLoad(uint32_t perSecond, uint64_t isrNs, uint64_t minGapNs) {
+    rate = perSecond;
+    isrDuration = isrNs;
+    minGap = minGapNs;
+    cancelScheduled();
+    if (rate) wakeAt(now() + gapNs());
+}
+
+void Load::onTimer(uint64_t t) {
+    if (rate) wakeAt(t + gapNs());
+    if (waiting) return;
+    waiting = true;
+    raisedAt = t;
+    raisedCount++;
+    raiseInterrupt(pin, true);
+}
+
+void Load::onInterrupt() {
+    // Une seule routine par broche: chaque charge vérifie son propre déclenchement
+    for (Load* load : loads()) {
+        if (load->waiting) load->service();
+    }
+}
+
+void Load::service() {
+    waiting = false;
+    servedCount++;
+    uint64_t latency = now() - raisedAt;
+    if (latency > maxLatency) maxLatency = latency;
+    advance(isrDuration);
+}
+
+uint64_t Load::gapNs() {
+    // Période moyenne conservée: l'attente exponentielle couvre ce qui dépasse l'écart minimal
+    double meanNs = 1e9 / rate - static_cast<double>(minGap);
+    return minGap + static_cast<uint64_t>(std::exponential_distribution<double>(1.0 / meanNs)(rng));
+}
+
+bool VcdWriter::open(const char* path, Bus& target) {
+    close();
+    file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "$timescale 1ns $end\n");
+    fprintf(file, "$scope module adb $end\n");
+    fprintf(file, "$var wire 1 ! data $end\n");
+    fprintf(file, "$upscope $end\n");
+    fprintf(file, "$enddefinitions $end\n");
+    fprintf(file, "#%llu\n%c!\n", static_cast<unsigned long long>(now()), target.line() ? '1' : '0');
+    bus = &target;
+    written = 0;
+    bus->setEdgeObserver(onEdge, this);
+    return true;
+}
+
+void VcdWriter::close() {
+    if (bus) bus->setEdgeObserver(nullptr, nullptr);
+    if (file) fclose(file);
+    bus = nullptr;
+    file = nullptr;
+}
+
+void VcdWriter::onEdge(void* context, uint64_t t, bool level) {
+    VcdWriter* writer = static_cast<VcdWriter*>(context);
+    fprintf(writer->file, "#%llu\n%c!\n", static_cast<unsigned long long>(t), level ? '1' : '0');
+    writer->written++;
+}
+
+/**
+ * Modèle générique de périphérique
+ */
+
+DeviceModel::DeviceModel(uint8_t defaultAddress, uint8_t defaultHandler)
+    : defaultAddr(defaultAddress), defaultHandler(defaultHandler),
+      addr(defaultAddress), handler(defaultHandler) {}
+
+void DeviceModel::resetDevice() {
+    addr = defaultAddr;
+    handler = defaultHandler;
+    srqEnable = true;
+    collided = false;
+    phase = Phase::IDLE;
+    bitCount = 0;
+    onReset();
+}
+
+void DeviceModel::setConnected(bool isConnected) {
+    if (isConnected == connected) return;
+    connected = isConnected;
+
+    // Abandon de toute émission en cours
+    cancelScheduled();
+    transmitting = false;
+    if (!driveLevel()) drive(now(), true);
+
+    // Un rebranchement équivaut à une mise sous tension
+    if (connected) resetDevice();
+}
+
+void DeviceModel::onLineEdge(uint64_t t, bool level) {
+    if (!connected) return;
+
+    if (transmitting) {
+        // Pendant une réponse, seule une collision nous intéresse
+        if (!level && driveLevel()) {
+            cancelScheduled();
+            transmitting = false;
+            collided = true;
+            counters.collisions++;
+            phase = Phase::IDLE;
+            lowStart = t;
+        }
+        return;
+    }
+
+    if (!level) {
+        lowStart = t;
+        if (phase == Phase::COMMAND && bitCount == 8) commandStopBit(t);
+        return;
+    }
+
+    uint64_t low = t - lowStart;
+    if (low >= 2000 * NS_PER_US) {
+        // Reset global du bus
+        resetDevice();
+        counters.resets++;
+        return;
+    }
+    if (low >= 400 * NS_PER_US) {
+        // Attention: une commande suit
+        phase = Phase::COMMAND;
+        bitCount = 0;
+        command = 0;
+        return;
+    }
+
+    bool bit = low < 50 * NS_PER_US;
+    switch (phase) {
+        case Phase::COMMAND:
+            if (bitCount < 8) {
+                command = static_cast<uint8_t>((command << 1) | bit);
+                bitCount++;
+            } else {
+                commandEnd(t);
+            }
+            break;
+
+        case Phase::LISTEN:
+            if (bitCount == 0) {
+                // Bit de début
+                listenValue = 0;
+                bitCount = 1;
+            } else {
+                listenValue = static_cast<uint16_t>((listenValue << 1) | bit);
+                if (++bitCount == 17) {
+                    phase = Phase::IDLE;
+                    counters.listens++;
+                    uint8_t reg = command & 0x03;
+                    if (reg == 3) listenRegister3(listenValue);
+                    else listen(reg, listenValue);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void DeviceModel::commandStopBit(uint64_t t) {
+    // SRQ: prolonge le bit d'arrêt d'une commande destinée à un autre périphérique
+    uint8_t target = command >> 4;
+    if (target != addr && srqEnable && hasPendingData()) {
+        drive(t, false);
+        drive(t + 300 * NS_PER_US, true);
+        counters.srqs++;
+    }
+}
+
+void DeviceModel::commandEnd(uint64_t t) {
+    uint8_t target = command >> 4;
+    uint8_t type = (command >> 2) & 0x03;
+    uint8_t reg = command & 0x03;
+    phase = Phase::IDLE;
+    bitCount = 0;
+
+    // SendReset: commande 0000 quelle que soit l'adresse
+    if ((command & 0x0F) == 0x00) {
+        resetDevice();
+        counters.resets++;
+        return;
+    }
+    if (target != addr) return;
+    counters.commands++;
+
+    switch (type) {
+        case 3: {
+            // Talk: réponse après Tlt, comptée depuis la fin de la cellule du bit d'arrêt
+            uint16_t value;
+            if (reg == 3) {
+                value = static_cast<uint16_t>((srqEnable ? 0x2000 : 0) | (addr << 8) | handler);
+            } else if (!talk(reg, value)) {
+                return;
+            }
+            transmittingReg = reg;
+            sendPacket(t + 35 * NS_PER_US + tltNs, value);
+            break;
+        }
+        case 2:
+            // Listen: le registre suit après Tlt
+            phase = Phase::LISTEN;
+            break;
+        case 1:
+            if (reg == 0) {
+                flush();
+                counters.flushes++;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void DeviceModel::listenRegister3(uint16_t value) {
+    uint8_t newHandler = value & 0xFF;
+    uint8_t newAddr = (value >> 8) & 0x0F;
+    bool newSrq = value & 0x2000;
+
+    switch (newHandler) {
+        case 0xFE:
+            // Changement d'adresse sauf si une collision a été détectée
+            if (!collided) addr = newAddr;
+            collided = false;
+            break;
+        case 0x00:
+            addr = newAddr;
+            srqEnable = newSrq;
+            break;
+        case 0xFD:
+        case 0xFF:
+            // Activation par l'utilisateur / auto-test: non modélisés
+            break;
+        default:
+            if (supportsHandler(newHandler)) handler = newHandler;
+            break;
+    }
+}
+
+void DeviceModel::sendPacket(uint64_t t, uint16_t value) {
+    transmitting = true;
+
+    auto cell = [&](bool bit) {
+        uint64_t release = t + (bit ? 35 : 65) * cellPeriodNs / 100 + skewNs;
+        drive(t, false);
+        drive(release, true);
+        // Vérification de collision peu après chaque relâchement
+        wakeAt(release + NS_PER_US);
+        t += cellPeriodNs;
+    };
+
+    cell(true);
+    for (int8_t i = 15; i >= 0; i--) cell((value >> i) & 0x01);
+    cell(false);
+
+    txEnd = t;
+    wakeAt(txEnd);
+}
+
+void DeviceModel::onTimer(uint64_t t) {
+    if (!transmitting) return;
+
+    if (t >= txEnd) {
+        transmitting = false;
+        counters.talks++;
+        talkDelivered(transmittingReg);
+        return;
+    }
+
+    // Ligne basse alors que nous l'avons relâchée: un autre périphérique émet
+    if (driveLevel() && bus && !bus->line()) {
+        cancelScheduled();
+        transmitting = false;
+        collided = true;
+        counters.collisions++;
+    }
+}
+
+/**
+ * Hôte
+ */
+
+void HostModel::talk(uint8_t addr, uint8_t reg) {
+    enqueue({static_cast<uint8_t>((addr << 4) | 0x0C | (reg & 0x03)), 0, false});
+}
+
+void HostModel::listen(uint8_t addr, uint8_t reg, uint16_t value) {
+    enqueue({static_cast<uint8_t>((addr << 4) | 0x08 | (reg & 0x03)), value, false});
+}
+
+void HostModel::flush(uint8_t addr) {
+    enqueue({static_cast<uint8_t>((addr << 4) | 0x04), 0, false});
+}
+
+void HostModel::resetBus() {
+    enqueue({0xFF, 0, true});
+}
+
+void HostModel::setPolling(uint32_t intervalUs, const std::vector<uint8_t>& addresses) {
+    pollIntervalNs = intervalUs * NS_PER_US;
+    pollAddresses = addresses;
+    activePoll = 0;
+    nextPoll = 0;
+    nextPollAt = now();
+    if (phase == Phase::IDLE) wakeAt(now());
+}
+
+void HostModel::enqueue(const Request& request) {
+    queue.push_back(request);
+    if (phase == Phase::IDLE) wakeAt(now());
+}
+
+void HostModel::start(uint64_t t, const Request& request) {
+    // Réveils superflus programmés pendant l'attente (plusieurs requêtes, interrogation)
+    cancelScheduled();
+    current = {};
+    current.at = t;
+    current.command = request.command;
+    current.value = request.value;
+
+    if (request.reset) {
+        phase = Phase::RESET;
+        drive(t, false);
+        drive(t + 3000 * NS_PER_US, true);
+        wakeAt(t + 3000 * NS_PER_US);
+        return;
+    }
+
+    // Attention 800 µs, synchronisation 70 µs, 8 bits de commande, bit d'arrêt
+    phase = Phase::COMMAND;
+    drive(t, false);
+    drive(t + 800 * NS_PER_US, true);
+    t += 870 * NS_PER_US;
+    for (int8_t i = 7; i >= 0; i--) t = sendCell(t, (request.command >> i) & 0x01);
+    stopRelease = t + 65 * NS_PER_US;
+    stopEnd = t + 100 * NS_PER_US;
+    drive(t, false);
+    drive(stopRelease, true);
+    wakeAt(stopRelease + NS_PER_US);
+}
+
+uint64_t HostModel::sendCell(uint64_t t, bool bit) {
+    drive(t, false);
+    drive(t + (bit ? 35 : 65) * NS_PER_US, true);
+    return t + 100 * NS_PER_US;
+}
+
+void HostModel::afterCommand(uint64_t t) {
+    uint8_t type = (current.command >> 2) & 0x03;
+    // Un SRQ prolonge le bit d'arrêt: le Tlt est compté depuis la remontée de la ligne
+    uint64_t reference = t > stopEnd ? t : stopEnd;
+    responseReference = reference;
+
+    if (type == 3) {
+        // Talk: bit de début attendu dans la fenêtre Tlt
+        phase = Phase::RESPONSE;
+        cells = 0;
+        wakeAt(reference + 300 * NS_PER_US);
+    } else if (type == 2) {
+        // Listen: le registre suit après un Tlt nominal de 200 µs
+        phase = Phase::LISTEN_DATA;
+        uint64_t cell = reference + 200 * NS_PER_US;
+        cell = sendCell(cell, true);
+        for (int8_t i = 15; i >= 0; i--) cell = sendCell(cell, (current.value >> i) & 0x01);
+        cell = sendCell(cell, false);
+        wakeAt(cell);
+    } else {
+        finish(t);
+    }
+}
+
+void HostModel::finish(uint64_t t) {
+    done.push_back(current);
+    if (polling) {
+        // Le périphérique qui répond devient l'interlocuteur; un SRQ fait tourner les adresses
+        uint8_t polled = nextPoll;
+        if (current.responded) activePoll = polled;
+        nextPoll = current.srq ? static_cast<uint8_t>((polled + 1) % pollAddresses.size()) : activePoll;
+        polling = false;
+    }
+    phase = Phase::GAP;
+    cancelScheduled();
+    wakeAt(t + 200 * NS_PER_US);
+}
+
+void HostModel::onLineEdge(uint64_t t, bool level) {
+    switch (phase) {
+        case Phase::SRQ:
+            // Fin du SRQ: la ligne remonte
+            if (level) afterCommand(t);
+            break;
+
+        case Phase::RESPONSE:
+            if (!level) {
+                if (cells == 0) current.tltUs = static_cast<uint32_t>((t - responseReference) / NS_PER_US);
+                lowStart = t;
+                return;
+            }
+            {
+                bool bit = t - lowStart < 50 * NS_PER_US;
+                cells++;
+                if (cells == 1) {
+                    if (!bit) current.error = true;
+                    current.value = 0;
+                } else if (cells <= 17) {
+                    current.value = static_cast<uint16_t>((current.value << 1) | bit);
+                } else {
+                    current.responded = !current.error;
+                    finish(t);
+                    return;
+                }
+                // Une cellule manquante interrompt la réponse
+                cancelScheduled();
+                wakeAt(t + 200 * NS_PER_US);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void HostModel::onTimer(uint64_t t) {
+    switch (phase) {
+        case Phase::IDLE: {
+            if (!queue.empty()) {
+                Request request = queue.front();
+                queue.pop_front();
+                start(t, request);
+            } else if (pollIntervalNs && !pollAddresses.empty()) {
+                if (t < nextPollAt) {
+                    wakeAt(nextPollAt);
+                    break;
+                }
+                nextPollAt = t + pollIntervalNs;
+                polling = true;
+                uint8_t addr = pollAddresses[nextPoll % pollAddresses.size()];
+                start(t, {static_cast<uint8_t>((addr << 4) | 0x0C), 0, false});
+            }
+            break;
+        }
+
+        case Phase::RESET:
+            finish(t);
+            break;
+
+        case Phase::COMMAND:
+            // La ligne reste basse après notre relâchement: un périphérique émet un SRQ
+            if (bus && !bus->line()) {
+                current.srq = true;
+                phase = Phase::SRQ;
+            } else {
+                afterCommand(stopRelease);
+            }
+            break;
+
+        case Phase::RESPONSE:
+            // Pas de bit de début (aucune réponse) ou réponse interrompue
+            if (cells > 0) current.error = true;
+            finish(t);
+            break;
+
+        case Phase::LISTEN_DATA:
+            finish(t);
+            break;
+
+        case Phase::GAP:
+            phase = Phase::IDLE;
+            onTimer(t);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * Clavier
+ */
+
+void Keyboard::script(uint64_t atUs, uint8_t code, bool released) {
+    scripted.push_back({atUs * NS_PER_US, static_cast<uint8_t>(code & 0x7F), released});
+}
+
+void Keyboard::pump() {
+    while (!scripted.empty() && scripted.front().at <= now()) {
+        pending.push_back(scripted.front());
+        scripted.pop_front();
+    }
+}
+
+bool Keyboard::hasPendingData() {
+    pump();
+    return !pending.empty();
+}
+
+bool Keyboard::talk(uint8_t reg, uint16_t& value) {
+    if (reg == 2) {
+        value = reg2;
+        return true;
+    }
+    if (reg != 0) return false;
+
+    // Registre 0: jusqu'à deux événements, 0xFF pour un emplacement vide
+    pump();
+    if (pending.empty()) return false;
+
+    const KeyEvent& first = pending[0];
+    uint16_t high = static_cast<uint16_t>((first.released ? 0x80 : 0x00) | first.code);
+    uint16_t low = 0xFF;
+    inFlight = 1;
+    if (pending.size() > 1) {
+        const KeyEvent& second = pending[1];
+        low = static_cast<uint16_t>((second.released ? 0x80 : 0x00) | second.code);
+        inFlight = 2;
+    }
+    value = static_cast<uint16_t>((high << 8) | low);
+    return true;
+}
+
+void Keyboard::talkDelivered(uint8_t reg) {
+    if (reg != 0) return;
+    while (inFlight > 0 && !pending.empty()) {
+        applyModifier(pending.front().code, pending.front().released);
+        sent.push_back(pending.front());
+        pending.pop_front();
+        inFlight--;
+    }
+    inFlight = 0;
+}
+
+void Keyboard::applyModifier(uint8_t code, bool released) {
+    // Bits du registre 2, actifs à l'état bas
+    uint8_t bit;
+    switch (code) {
+        case 0x37: bit = 8; break;              // Command
+        case 0x3A: case 0x7C: bit = 9; break;   // Option
+        case 0x38: case 0x7B: bit = 10; break;  // Shift
+        case 0x36: case 0x7D: bit = 11; break;  // Control
+        case 0x39: bit = 13; break;             // Caps Lock
+        case 0x33: bit = 14; break;             // Delete
+        default: return;
+    }
+    if (released) reg2 = static_cast<uint16_t>(reg2 | (1u << bit));
+    else reg2 = static_cast<uint16_t>(reg2 & ~(1u << bit));
+}
+
+void Keyboard::listen(uint8_t reg, uint16_t value) {
+    if (reg != 2) return;
+    // Seules les LEDs sont modifiables par l'hôte
+    reg2 = static_cast<uint16_t>((reg2 & ~0x0007) | (value & 0x0007));
+    ledWriteCount++;
+}
+
+void Keyboard::flush() {
+    pending.clear();
+    inFlight = 0;
+}
+
+void Keyboard::onReset() {
+    pending.clear();
+    inFlight = 0;
+    reg2 = 0xFFFF;
+}
+
+/**
+ * Souris
+ */
+
+void Mouse::script(uint64_t atUs, int16_t moveX, int16_t moveY, bool buttonDown) {
+    scripted.push_back({atUs * NS_PER_US, moveX, moveY, buttonDown});
+}
+
+void Mouse::pump() {
+    while (!scripted.empty() && scripted.front().at <= now()) {
+        dx += scripted.front().dx;
+        dy += scripted.front().dy;
+        button = scripted.front().button;
+        scripted.pop_front();
+    }
+}
+
+bool Mouse::hasPendingData() {
+    pump();
+    return dx != 0 || dy != 0 || button != reportedButton;
+}
+
+bool Mouse::talk(uint8_t reg, uint16_t& value) {
+    if (reg != 0 || !hasPendingData()) return false;
+
+    // Mouvement limité à 7 bits signés, le reste est transmis au Talk suivant
+    inFlightX = static_cast<int8_t>(std::max(-64, std::min(63, static_cast<int>(dx))));
+    inFlightY = static_cast<int8_t>(std::max(-64, std::min(63, static_cast<int>(dy))));
+    inFlightButton = button;
+
+    value = static_cast<uint16_t>((inFlightButton ? 0x0000 : 0x8000) |
+                                  ((inFlightY & 0x7F) << 8) | 0x0080 | (inFlightX & 0x7F));
+    return true;
+}
+
+void Mouse::talkDelivered(uint8_t reg) {
+    if (reg != 0) return;
+    dx -= inFlightX;
+    dy -= inFlightY;
+    sentX += inFlightX;
+    sentY += inFlightY;
+    reportedButton = inFlightButton;
+}
+
+void Mouse::flush() {
+    dx = 0;
+    dy = 0;
+}
+
+void Mouse::onReset() {
+    dx = 0;
+    dy = 0;
+    button = false;
+    reportedButton = false;
+}
+
+} // namespace ADBSim
+
+/**
+ * API Arduino
+ */
+
+using ADBSim::sim;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    // Une broche en entrée ne tire plus la ligne
+    ADBSim::Device* driver = ADBSim::pinDriver(pin);
+    if (driver && mode != OUTPUT && mode != OUTPUT_OPEN_DRAIN) {
+        static_cast<ADBSim::PinDriver*>(driver)->set(true);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    ADBSim::advance(sim().costs.digitalWriteNs);
+    ADBSim::Device* driver = ADBSim::pinDriver(pin);
+    if (driver) static_cast<ADBSim::PinDriver*>(driver)->set(val != LOW);
+}
+
+int digitalRead(uint8_t pin) {
+    ADBSim::advance(sim().costs.digitalReadNs);
+    ADBSim::Bus* bus = ADBSim::busForPin(pin);
+    return ADBSim::pinLevel(pin, !bus || bus->line()) ? HIGH : LOW;
+}
+
+unsigned long micros() {
+    ADBSim::advance(sim().costs.microsNs);
+    return static_cast<unsigned long>(ADBSim::now() / ADBSim::NS_PER_US);
+}
+
+unsigned long millis() {
+    return static_cast<unsigned long>(ADBSim::now() / (1000 * ADBSim::NS_PER_US));
+}
+
+void delay(unsigned long ms) {
+    ADBSim::advance(static_cast<uint64_t>(ms) * 1000 * ADBSim::NS_PER_US);
+}
+
+void delayMicroseconds(unsigned int us) {
+    ADBSim::advance(static_cast<uint64_t>(us) * ADBSim::NS_PER_US);
+}
+
+void noInterrupts() {
+    sim().interruptsEnabled = false;
+}
+
+void interrupts() {
+    sim().interruptsEnabled = true;
+    ADBSim::runPendingInterrupts();
+}
+
+void attachCompareInterrupt(void (*isr)()) {
+    ADBSim::Simulator& s = ADBSim::sim();
+    s.compareIsr = isr;
+    s.compareAt = UINT64_MAX;
+    s.comparePending = false;
+}
+
+void armCompare(unsigned long atUs) {
+    // Échéance dépassée: l'interruption survient au prochain pas de temps
+    ADBSim::Simulator& s = ADBSim::sim();
+    uint64_t t = static_cast<uint64_t>(atUs) * ADBSim::NS_PER_US;
+    s.compareAt = t > s.clock ? t : s.clock;
+    s.comparePending = false;
+    ADBSim::schedule(s.compareAt);
+}
+
+void disarmCompare() {
+    ADBSim::sim().compareAt = UINT64_MAX;
+    ADBSim::sim().comparePending = false;
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+    return pin;
+}
+
+void attachInterrupt(int interruptNum, void (*isr)(), int mode) {
+    ADBSim::PinState& p = sim().pins[interruptNum & 0xFF];
+    p.isr = isr;
+    p.mode = mode;
+    p.pending = false;
+}
+
+void detachInterrupt(int interruptNum) {
+    ADBSim::PinState& p = sim().pins[interruptNum & 0xFF];
+    p.isr = nullptr;
+    p.pending = false;
+}
+
+/**
+ * Sortie série
+ */
+
+HardwareSerial Serial;
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::printNumber(unsigned long long value, int base) {
+    char buffer[8 * sizeof(value) + 1];
+    char* str = &buffer[sizeof(buffer) - 1];
+    *str = '\0';
+    if (base < 2) base = 10;
+    do {
+        char digit = static_cast<char>(value % base);
+        *--str = static_cast<char>(digit < 10 ? digit + '0' : digit + 'A' - 10);
+        value /= base;
+    } while (value);
+    return write(str);
+}
+
+size_t Print::printSigned(long long value, int base) {
+    if (base == 10 && value < 0) {
+        size_t n = print('-');
+        return n + printNumber(static_cast<unsigned long long>(-value), base);
+    }
+    return printNumber(static_cast<unsigned long long>(value), base);
+}
+
+size_t Print::print(double value, int digits) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+size_t FileOutput::write(uint8_t c) {
+    return fputc(c, file) == EOF ? 0 : 1;
+}
+
+size_t FileOutput::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, file);
+}
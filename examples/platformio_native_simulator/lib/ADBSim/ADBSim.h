@@ -0,0 +1,578 @@
+/**
+ * @file ADBSim.h
+ * @brief Simulateur de bus ADB sur l'hôte (horloge virtuelle et périphériques)
+ *
+ * Le bus est une ligne open-drain: son niveau est le ET logique de tous les
+ * participants (broches pilotées par digitalWrite et modèles de périphériques).
+ * Les modèles réagissent aux fronts de la ligne et programment leurs propres
+ * transitions dans le temps virtuel, avec les temporisations de la spécification
+ * ADB (attention, synchronisation, cellules de 100 µs, Tlt, SRQ, collisions).
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SIM_h
+#define ADB_SIM_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace ADBSim {
+
+constexpr uint64_t NS_PER_US = 1000;
+
+/**
+ * @brief Coût en temps virtuel des appels de l'API Arduino
+ */
+struct CallCosts {
+    uint32_t digitalReadNs;
+    uint32_t digitalWriteNs;
+    uint32_t microsNs;
+};
+
+/**
+ * @brief Date courante de l'horloge virtuelle (ns)
+ */
+uint64_t now();
+
+/**
+ * @brief Avance l'horloge virtuelle en traitant les événements programmés
+ * @param ns Durée en nanosecondes
+ */
+void advance(uint64_t ns);
+
+/**
+ * @brief Modifie le coût des appels de l'API Arduino
+ */
+void setCallCosts(const CallCosts& costs);
+
+class Bus;
+
+/**
+ * @brief Participant au bus capable de tirer la ligne vers le bas
+ */
+class Device {
+public:
+    virtual ~Device();
+
+    /**
+     * @brief Notification d'un front de la ligne (après combinaison de tous les participants)
+     * @param t Date du front (ns)
+     * @param level Nouveau niveau de la ligne
+     */
+    virtual void onLineEdge(uint64_t t, bool level) { (void)t; (void)level; }
+
+    /**
+     * @brief Réveil programmé par wakeAt()
+     */
+    virtual void onTimer(uint64_t t) { (void)t; }
+
+    bool driveLevel() const { return driving; }
+
+protected:
+    /**
+     * @brief Programme une transition de la sortie du participant
+     * @param t Date de la transition (ns)
+     * @param level Niveau piloté (false = ligne tirée vers le bas)
+     */
+    void drive(uint64_t t, bool level);
+
+    /**
+     * @brief Programme un appel à onTimer()
+     */
+    void wakeAt(uint64_t t);
+
+    /**
+     * @brief Annule toutes les transitions et réveils programmés
+     */
+    void cancelScheduled();
+
+    /**
+     * @brief Applique immédiatement un niveau (utilisé par les broches)
+     */
+    void driveNow(bool level);
+
+    Bus* bus = nullptr;
+
+private:
+    friend class Bus;
+    friend void processUntil(uint64_t);
+
+    struct Event {
+        uint64_t t;
+        int8_t level;   // 0/1 = transition, -1 = réveil
+    };
+    std::deque<Event> events;
+    bool driving = true;
+};
+
+/**
+ * @brief Ligne ADB partagée par des broches et des modèles de périphériques
+ */
+class Bus {
+public:
+    /**
+     * @brief Crée une ligne reliée à une broche Arduino
+     * @param pin Broche utilisée par le code sous test
+     */
+    explicit Bus(uint8_t pin);
+    ~Bus();
+
+    /**
+     * @brief Relie une broche supplémentaire à la même ligne
+     */
+    void addPin(uint8_t pin);
+
+    /**
+     * @brief Connecte un participant au bus
+     */
+    void attach(Device& device);
+
+    /**
+     * @brief Niveau actuel de la ligne
+     */
+    bool line() const { return level; }
+
+    /**
+     * @brief Nombre de fronts observés depuis la création
+     */
+    uint64_t edgeCount() const { return edges; }
+
+    /**
+     * @brief Observateur appelé à chaque front (capture, vérification des temporisations)
+     */
+    typedef void (*EdgeObserver)(void* context, uint64_t t, bool level);
+    void setEdgeObserver(EdgeObserver observer, void* context);
+
+private:
+    friend class Device;
+    friend void processUntil(uint64_t);
+    friend Bus* busForPin(uint8_t pin);
+    friend Device* pinDriver(uint8_t pin);
+
+    void update(uint64_t t);
+
+    std::vector<uint8_t> pins;
+    std::vector<Device*> devices;
+    std::vector<Device*> ownedDrivers;
+    EdgeObserver observer = nullptr;
+    void* observerContext = nullptr;
+    bool level = true;
+    uint64_t edges = 0;
+};
+
+/**
+ * @brief Parasites captés par un câble long, vus par une broche du code sous test
+ *
+ * Chaque impulsion tire brièvement vers le bas le niveau lu par la broche
+ * (digitalRead et interruptions) lorsque la ligne est haute: seule la
+ * résistance de tirage y est sensible, une ligne tirée par un transistor ne
+ * l'est pas. Les périphériques et les autres broches voient la ligne intacte,
+ * ce qui isole le récepteur mesuré. Le participant doit être attaché au bus.
+ */
+class Noise : public Device {
+public:
+    Noise(uint8_t pin, uint32_t seed);
+
+    /**
+     * @brief Règle le débit et la largeur des impulsions
+     * @param perSecond Nombre moyen d'impulsions par seconde (arrivées poissonniennes, 0 = aucune)
+     * @param minWidthNs Largeur minimale (tirage uniforme)
+     * @param maxWidthNs Largeur maximale
+     */
+    void setSpikes(uint32_t perSecond, uint64_t minWidthNs, uint64_t maxWidthNs);
+
+    /**
+     * @brief Impulsions injectées
+     */
+    uint64_t spikes() const { return count; }
+
+    void onTimer(uint64_t t) override;
+
+private:
+    void spike(bool on);
+    uint64_t gapNs();
+
+    uint8_t pin;
+    std::mt19937 rng;
+    uint32_t rate = 0;
+    uint64_t minWidth = 0;
+    uint64_t maxWidth = 0;
+    bool active = false;
+    uint64_t count = 0;
+};
+
+/**
+ * @brief Charge d'interruptions concurrente (USB, BLE, SysTick)
+ *
+ * Déclenche à dates aléatoires une routine qui occupe le processeur
+ * pendant une durée fixe, sur une broche réservée hors du bus. Deux
+ * déclenchements sont séparés d'un écart minimal suivi d'une attente
+ * exponentielle (trames USB, événements BLE). Masquée, la
+ * routine attend les interruptions() suivantes: sa latence mesure le coût
+ * des sections masquées pour la pile qui en dépend. Un déclenchement qui
+ * survient alors que le précédent attend encore est perdu. Le participant
+ * doit être attaché à un bus pour être cadencé.
+ */
+class Load : public Device {
+public:
+    Load(uint8_t pin, uint32_t seed);
+    ~Load();
+
+    /**
+     * @brief Règle le débit et la durée des routines
+     * @param perSecond Nombre moyen de déclenchements par seconde (0 = aucun)
+     * @param isrNs Durée d'exécution de chaque routine
+     * @param minGapNs Écart minimal entre deux déclenchements (inférieur à la période moyenne)
+     */
+    void setLoad(uint32_t perSecond, uint64_t isrNs, uint64_t minGapNs = 0);
+
+    uint64_t raised() const { return raisedCount; }
+    uint64_t served() const { return servedCount; }
+
+    /**
+     * @brief Plus longue attente entre déclenchement et exécution (ns)
+     */
+    uint64_t maxLatencyNs() const { return maxLatency; }
+
+    void onTimer(uint64_t t) override;
+
+private:
+    static void onInterrupt();
+    void service();
+    uint64_t gapNs();
+
+    uint8_t pin;
+    std::mt19937 rng;
+    uint32_t rate = 0;
+    uint64_t isrDuration = 0;
+    uint64_t minGap = 0;
+    bool waiting = false;
+    uint64_t raisedAt = 0;
+    uint64_t raisedCount = 0;
+    uint64_t servedCount = 0;
+    uint64_t maxLatency = 0;
+};
+
+/**
+ * @brief Enregistre les fronts d'une ligne dans un fichier VCD (résolution 1 ns)
+ *
+ * Vue de référence du bus, indépendante du code sous test: tous les fronts,
+ * y compris ceux des périphériques, à leur date exacte dans le temps virtuel.
+ */
+class VcdWriter {
+public:
+    ~VcdWriter() { close(); }
+
+    /**
+     * @brief Crée le fichier et commence l'enregistrement (remplace l'observateur du bus)
+     * @return false si le fichier ne peut pas être créé
+     */
+    bool open(const char* path, Bus& bus);
+
+    /**
+     * @brief Arrête l'enregistrement et ferme le fichier
+     */
+    void close();
+
+    uint64_t edges() const { return written; }
+
+private:
+    static void onEdge(void* context, uint64_t t, bool level);
+
+    FILE* file = nullptr;
+    Bus* bus = nullptr;
+    uint64_t written = 0;
+};
+
+/**
+ * @brief Modèle comportemental d'un périphérique ADB (côté périphérique du protocole)
+ *
+ * Décode attention, synchronisation et commandes à partir des fronts de la
+ * ligne, répond aux Talk après Tlt, reçoit les Listen, émet un SRQ pendant le
+ * bit d'arrêt d'une commande destinée à un autre périphérique lorsqu'il a des
+ * données en attente, et gère le registre 3 (adresse, handler ID, collisions).
+ */
+class DeviceModel : public Device {
+public:
+    struct Stats {
+        uint32_t commands;    // Commandes adressées à ce périphérique
+        uint32_t talks;       // Réponses émises
+        uint32_t listens;     // Registres reçus
+        uint32_t flushes;     // Commandes Flush reçues
+        uint32_t resets;      // Réinitialisations (globales ou SendReset)
+        uint32_t srqs;        // Demandes de service émises
+        uint32_t collisions;  // Collisions détectées pendant une réponse
+    };
+
+    DeviceModel(uint8_t defaultAddress, uint8_t defaultHandler);
+
+    uint8_t address() const { return addr; }
+    uint8_t handlerId() const { return handler; }
+    bool srqEnabled() const { return srqEnable; }
+    const Stats& stats() const { return counters; }
+
+    /**
+     * @brief Délai entre la fin du bit d'arrêt et le début de la réponse (140-260 µs)
+     */
+    void setTlt(uint32_t us) { tltNs = us * NS_PER_US; }
+
+    /**
+     * @brief Horloge de bits des réponses et étalement de leurs fronts montants
+     * @param cellNs Période de cellule (100 µs nominal, ±30% pour certains périphériques)
+     * @param lowSkewNs Allongement de chaque partie basse (front montant retardé par un câble long)
+     */
+    void setTransmitTiming(uint64_t cellNs, uint64_t lowSkewNs) {
+        cellPeriodNs = cellNs;
+        skewNs = lowSkewNs;
+    }
+
+    /**
+     * @brief Branche ou débranche le périphérique (rebranchement = mise sous tension)
+     */
+    void setConnected(bool connected);
+    bool isConnected() const { return connected; }
+
+    void onLineEdge(uint64_t t, bool level) override;
+    void onTimer(uint64_t t) override;
+
+protected:
+    // Comportement spécifique au type de périphérique
+    virtual bool talk(uint8_t reg, uint16_t& value) = 0;   // false = pas de réponse
+    virtual void talkDelivered(uint8_t reg) { (void)reg; }
+    virtual void listen(uint8_t reg, uint16_t value) { (void)reg; (void)value; }
+    virtual void flush() {}
+    virtual bool hasPendingData() { return false; }
+    virtual bool supportsHandler(uint8_t id) const { (void)id; return false; }
+    virtual void onReset() {}
+
+private:
+    enum class Phase : uint8_t { IDLE, COMMAND, LISTEN };
+
+    void resetDevice();
+    void commandStopBit(uint64_t t);
+    void commandEnd(uint64_t t);
+    void listenRegister3(uint16_t value);
+    void sendPacket(uint64_t t, uint16_t value);
+
+    uint8_t defaultAddr;
+    uint8_t defaultHandler;
+    uint8_t addr;
+    uint8_t handler;
+    bool srqEnable = true;
+    bool collided = false;
+    bool connected = true;
+
+    Phase phase = Phase::IDLE;
+    uint64_t lowStart = 0;
+    uint8_t bitCount = 0;
+    uint8_t command = 0;
+    uint16_t listenValue = 0;
+    bool transmitting = false;
+    uint8_t transmittingReg = 0;
+    uint64_t txEnd = 0;
+    uint64_t tltNs = 180 * NS_PER_US;
+    uint64_t cellPeriodNs = 100 * NS_PER_US;
+    uint64_t skewNs = 0;
+    Stats counters = {};
+};
+
+/**
+ * @brief Modèle comportemental d'un hôte ADB (côté hôte du protocole)
+ *
+ * Émet les commandes d'une file (Talk, Listen, Flush, reset) avec les
+ * temporisations nominales, décode les réponses et les SRQ à partir des fronts
+ * de la ligne et mesure le Tlt de chaque réponse. En l'absence de commande en
+ * file, il peut interroger les périphériques comme un Macintosh: Talk R0 du
+ * dernier périphérique ayant répondu, puis des adresses suivantes tant qu'un
+ * SRQ est signalé. Il sert d'interlocuteur au mode périphérique de la
+ * bibliothèque (ADBDeviceEmulator), qui s'exécute sur la broche du bus.
+ */
+class HostModel : public Device {
+public:
+    /**
+     * @brief Transaction terminée
+     */
+    struct Transaction {
+        uint64_t at;          // Début de l'attention (ns)
+        uint8_t command;      // Octet de commande (0xFF pour un reset global)
+        bool srq;             // Bit d'arrêt prolongé par un périphérique
+        bool responded;       // Paquet complet reçu (Talk)
+        bool error;           // Réponse commencée puis interrompue ou mal formée
+        uint16_t value;       // Valeur reçue (Talk) ou émise (Listen)
+        uint32_t tltUs;       // Fin nominale du bit d'arrêt -> bit de début de la réponse
+    };
+
+    HostModel() = default;
+
+    void talk(uint8_t addr, uint8_t reg);
+    void listen(uint8_t addr, uint8_t reg, uint16_t value);
+    void flush(uint8_t addr);
+
+    /**
+     * @brief Reset global (ligne basse 3 ms)
+     */
+    void resetBus();
+
+    /**
+     * @brief Interrogation automatique lorsque la file est vide
+     * @param intervalUs Période entre deux interrogations (0 = arrêt)
+     * @param addresses Adresses interrogées, dans l'ordre de rotation sur SRQ
+     */
+    void setPolling(uint32_t intervalUs, const std::vector<uint8_t>& addresses);
+
+    /**
+     * @brief Aucune commande en file ni en cours
+     */
+    bool idle() const { return phase == Phase::IDLE && queue.empty(); }
+
+    std::vector<Transaction>& transactions() { return done; }
+
+    void onLineEdge(uint64_t t, bool level) override;
+    void onTimer(uint64_t t) override;
+
+private:
+    enum class Phase : uint8_t { IDLE, RESET, COMMAND, SRQ, RESPONSE, LISTEN_DATA, GAP };
+
+    struct Request {
+        uint8_t command;
+        uint16_t value;
+        bool reset;
+    };
+
+    void enqueue(const Request& request);
+    void start(uint64_t t, const Request& request);
+    void afterCommand(uint64_t t);
+    uint64_t sendCell(uint64_t t, bool bit);
+    void finish(uint64_t t);
+
+    std::deque<Request> queue;
+    std::vector<Transaction> done;
+    Transaction current = {};
+    Phase phase = Phase::IDLE;
+    uint64_t stopRelease = 0;    // Relâchement du bit d'arrêt par l'hôte
+    uint64_t stopEnd = 0;        // Fin nominale de la cellule du bit d'arrêt
+    uint64_t responseReference = 0;  // Origine du Tlt (fin du bit d'arrêt ou du SRQ)
+    uint64_t lowStart = 0;
+    uint8_t cells = 0;           // Cellules de réponse reçues
+    uint32_t pollIntervalNs = 0;
+    uint64_t nextPollAt = 0;
+    std::vector<uint8_t> pollAddresses;
+    uint8_t activePoll = 0;      // Index du dernier périphérique ayant répondu
+    uint8_t nextPoll = 0;        // Index de la prochaine interrogation automatique
+    bool polling = false;        // Transaction en cours issue de l'interrogation automatique
+};
+
+/**
+ * @brief Événement clavier scripté
+ */
+struct KeyEvent {
+    uint64_t at;      // Date d'apparition (ns)
+    uint8_t code;     // Code de touche ADB
+    bool released;    // Relâchement
+};
+
+/**
+ * @brief Clavier ADB étendu (adresse 2, handler 2, handlers 1-3 acceptés)
+ */
+class Keyboard : public DeviceModel {
+public:
+    Keyboard() : DeviceModel(2, 2) {}
+
+    /**
+     * @brief Ajoute un événement au flux scripté
+     * @param atUs Date d'apparition (µs de temps virtuel)
+     */
+    void script(uint64_t atUs, uint8_t code, bool released);
+
+    /**
+     * @brief Événements transmis à l'hôte, dans l'ordre
+     */
+    std::vector<KeyEvent>& delivered() { return sent; }
+
+    /**
+     * @brief Registre 2 (modificateurs et LEDs, actifs à l'état bas)
+     */
+    uint16_t register2() const { return reg2; }
+    uint32_t ledWrites() const { return ledWriteCount; }
+    size_t pendingEvents() const { return pending.size() + scripted.size(); }
+
+protected:
+    bool talk(uint8_t reg, uint16_t& value) override;
+    void talkDelivered(uint8_t reg) override;
+    void listen(uint8_t reg, uint16_t value) override;
+    void flush() override;
+    bool hasPendingData() override;
+    bool supportsHandler(uint8_t id) const override { return id >= 1 && id <= 3; }
+    void onReset() override;
+
+private:
+    void pump();
+    void applyModifier(uint8_t code, bool released);
+
+    std::deque<KeyEvent> scripted;
+    std::deque<KeyEvent> pending;
+    std::vector<KeyEvent> sent;
+    uint8_t inFlight = 0;
+    uint16_t reg2 = 0xFFFF;
+    uint32_t ledWriteCount = 0;
+};
+
+/**
+ * @brief Souris ADB (adresse 3, handler 1, handlers 1, 2 et 4 acceptés)
+ */
+class Mouse : public DeviceModel {
+public:
+    Mouse() : DeviceModel(3, 1) {}
+
+    /**
+     * @brief Ajoute un mouvement et un état de bouton au flux scripté
+     * @param atUs Date d'apparition (µs de temps virtuel)
+     */
+    void script(uint64_t atUs, int16_t dx, int16_t dy, bool buttonDown);
+
+    /**
+     * @brief Mouvement total transmis à l'hôte
+     */
+    int64_t deliveredX() const { return sentX; }
+    int64_t deliveredY() const { return sentY; }
+
+protected:
+    bool talk(uint8_t reg, uint16_t& value) override;
+    void talkDelivered(uint8_t reg) override;
+    void flush() override;
+    bool hasPendingData() override;
+    bool supportsHandler(uint8_t id) const override { return id == 1 || id == 2 || id == 4; }
+    void onReset() override;
+
+private:
+    struct Motion {
+        uint64_t at;
+        int16_t dx;
+        int16_t dy;
+        bool button;
+    };
+
+    void pump();
+
+    std::deque<Motion> scripted;
+    int32_t dx = 0;
+    int32_t dy = 0;
+    bool button = false;
+    bool reportedButton = false;
+    int8_t inFlightX = 0;
+    int8_t inFlightY = 0;
+    bool inFlightButton = false;
+    int64_t sentX = 0;
+    int64_t sentY = 0;
+};
+
+} // namespace ADBSim
+
+#endif // ADB_SIM_h
@@ -0,0 +1,134 @@
+/**
+ * @file Arduino.h
+ * @brief API Arduino minimale pour l'exécution de la bibliothèque ADB sur l'hôte
+ *
+ * Les fonctions d'entrée/sortie et de temps sont redirigées vers le simulateur
+ * de bus ADB (ADBSim.h) : digitalWrite/digitalRead pilotent et lisent une ligne
+ * open-drain virtuelle, micros()/delayMicroseconds() utilisent une horloge
+ * virtuelle qui n'avance qu'au rythme des appels. Le code de ADB.cpp s'exécute
+ * ainsi sans modification, bien plus vite que le temps réel.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#ifndef ADB_SIM_ARDUINO_h
+#define ADB_SIM_ARDUINO_h
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Niveaux et modes de broche
+#define LOW               0x0
+#define HIGH              0x1
+#define INPUT             0x0
+#define OUTPUT            0x1
+#define INPUT_PULLUP      0x2
+#define OUTPUT_OPEN_DRAIN 0x4
+
+// Modes d'interruption
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+// Bases d'affichage
+#define BIN 2
+#define OCT 8
+#define DEC 10
+#define HEX 16
+
+// Les chaînes restent en RAM sur l'hôte
+#define F(s) (s)
+#define PROGMEM
+
+// Broches et temps
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Interruptions
+void noInterrupts();
+void interrupts();
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(int interruptNum, void (*isr)(), int mode);
+void detachInterrupt(int interruptNum);
+
+// Minuterie à comparaison (propre au simulateur, rôle du timer 1 des AVR):
+// une échéance à la fois, en µs de micros(), servie comme une interruption
+void attachCompareInterrupt(void (*isr)());
+void armCompare(unsigned long atUs);
+void disarmCompare();
+
+/**
+ * @brief Sortie formatée compatible avec la classe Print d'Arduino
+ */
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write(reinterpret_cast<const uint8_t*>(str), strlen(str)) : 0; }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(unsigned char value, int base = DEC) { return printNumber(value, base); }
+    size_t print(int value, int base = DEC) { return printSigned(value, base); }
+    size_t print(unsigned int value, int base = DEC) { return printNumber(value, base); }
+    size_t print(long value, int base = DEC) { return printSigned(value, base); }
+    size_t print(unsigned long value, int base = DEC) { return printNumber(value, base); }
+    size_t print(long long value, int base = DEC) { return printSigned(value, base); }
+    size_t print(unsigned long long value, int base = DEC) { return printNumber(value, base); }
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+private:
+    size_t printNumber(unsigned long long value, int base);
+    size_t printSigned(long long value, int base);
+};
+
+/**
+ * @brief Port série redirigé vers la sortie standard
+ */
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    void flush();
+    operator bool() const { return true; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+};
+
+/**
+ * @brief Sortie Print vers un fichier de l'hôte (export de captures)
+ */
+class FileOutput : public Print {
+public:
+    explicit FileOutput(FILE* file) : file(file) {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+private:
+    FILE* file;
+};
+
+extern HardwareSerial Serial;
+
+#endif // ADB_SIM_ARDUINO_h
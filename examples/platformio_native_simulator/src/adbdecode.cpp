@@ -0,0 +1,541 @@
+/**
+ * @file adbdecode.cpp
+ * @brief Décodage hors ligne de captures ADB (VCD ou CSV d'analyseur logique)
+ *
+ * Les fronts de la ligne sont extraits en flux continu du fichier projeté en
+ * mémoire (ou de l'entrée standard) puis confiés à ADBFrameDecoder, le même
+ * décodeur que sur la cible. La mémoire utilisée ne dépend pas de la taille de
+ * la capture: les pages déjà lues sont rendues au système au fil de la lecture.
+ *
+ * Formats acceptés:
+ *   VCD  signal d'un bit (le premier, ou celui désigné par --signal)
+ *   CSV  "temps en secondes,valeur[,...]" (exports Saleae, sigrok...) ou, avec
+ *        --rate, un échantillon par ligne à fréquence fixe
+ *
+ * Usage: adbdecode [options] capture.vcd|capture.csv|-
+ *   --signal NOM   signal VCD (nom ou identifiant)
+ *   --column N     colonne CSV de la ligne ADB (0 = première; défaut 1, ou 0 avec --rate)
+ *   --rate HZ      CSV sans colonne de temps, échantillonné à HZ
+ *   --csv, --vcd   format imposé (sinon déduit de l'extension ou du contenu; VCD sur l'entrée standard)
+ *   --glitch US    écarte les impulsions plus courtes que US µs (ligne parasitée)
+ *   --anomalies    n'affiche que les trames présentant une anomalie
+ *   --summary      n'affiche que le bilan
+ *
+ * Code de retour: 0 sans anomalie, 3 si des anomalies ont été relevées.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBFrameDecoder.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t READ_CHUNK = 1 << 20;        // Lecture de l'entrée standard
+constexpr size_t RELEASE_CHUNK = 64 << 20;    // Pages projetées rendues par blocs
+
+enum class Format : uint8_t { AUTO, VCD, CSV };
+enum class Output : uint8_t { ALL, ANOMALIES, SUMMARY };
+
+struct Options {
+    const char* path = nullptr;
+    std::string signal;
+    int column = -1;
+    double rate = 0;
+    Format format = Format::AUTO;
+    Output output = Output::ALL;
+    int glitchUs = 0;
+};
+
+const char* const FLAG_NAMES[] = {
+    "ATTENTION", "SYNC", "BIT", "TRONQUEE", "TLT", "PAQUET", "DEBUT", "DONNEES_INATTENDUES", "DONNEES_MANQUANTES"
+};
+constexpr size_t FLAG_COUNT = sizeof(FLAG_NAMES) / sizeof(FLAG_NAMES[0]);
+
+/**
+ * @brief Bilan et affichage des trames décodées
+ */
+struct Report {
+    Output output = Output::ALL;
+    uint64_t lastEdgeNs = 0;     // Date absolue du dernier front transmis
+    uint32_t lastEdgeUs = 0;     // Même front dans l'horloge 32 bits du décodeur
+    uint64_t edges = 0;
+    uint64_t commands = 0;
+    uint64_t resets = 0;
+    uint64_t strays = 0;
+    uint64_t srqs = 0;
+    uint64_t anomalous = 0;
+    uint64_t flagCounts[FLAG_COUNT] = {};
+    uint64_t talks[16] = {};
+    uint64_t talkData[16] = {};
+    uint64_t listens[16] = {};
+
+    /**
+     * @brief Date absolue (ns) d'une date du décodeur antérieure au dernier front
+     */
+    uint64_t absoluteNs(uint32_t us) const {
+        return lastEdgeNs - static_cast<uint64_t>(lastEdgeUs - us) * 1000;
+    }
+
+    void frame(const adb_frame& f) {
+        switch (f.type) {
+            case ADBFrameType::RESET: resets++; break;
+            case ADBFrameType::STRAY: strays++; break;
+            case ADBFrameType::COMMAND: {
+                commands++;
+                if (f.srq()) srqs++;
+                uint8_t kind = f.command & 0x0C;
+                if (kind == ADBProtocol::CMD_TALK) {
+                    talks[f.address()]++;
+                    if (f.hasData()) talkData[f.address()]++;
+                } else if (kind == ADBProtocol::CMD_LISTEN) {
+                    listens[f.address()]++;
+                }
+                break;
+            }
+        }
+        if (f.flags) {
+            anomalous++;
+            for (size_t i = 0; i < FLAG_COUNT; i++) {
+                if (f.flags & (1u << i)) flagCounts[i]++;
+            }
+        }
+
+        if (output == Output::SUMMARY || (output == Output::ANOMALIES && f.flags == 0 && f.type == ADBFrameType::COMMAND)) {
+            return;
+        }
+        print(f);
+    }
+
+    void print(const adb_frame& f) const {
+        char line[160];
+        int n = snprintf(line, sizeof(line), "%16.6f  ", static_cast<double>(absoluteNs(f.startUs)) / 1e9);
+        switch (f.type) {
+            case ADBFrameType::RESET:
+                n += snprintf(line + n, sizeof(line) - n, "RESET      %u us", f.attentionUs);
+                break;
+            case ADBFrameType::STRAY:
+                n += snprintf(line + n, sizeof(line) - n, "IMPULSION  %u us", f.attentionUs);
+                break;
+            case ADBFrameType::COMMAND:
+                n += snprintf(line + n, sizeof(line) - n, "%-9s  a%-2u r%u  att=%u sync=%u",
+                              f.commandBits == 8 ? f.commandName() : "?", f.address(), f.reg(),
+                              f.attentionUs, f.syncUs);
+                if (f.srq()) n += snprintf(line + n, sizeof(line) - n, "  SRQ=%u", f.srqUs);
+                if (f.hasData()) {
+                    n += snprintf(line + n, sizeof(line) - n, "  tlt=%u  data=", f.tltUs);
+                    for (uint8_t i = 0; i < (f.dataBits + 7) / 8 && n < static_cast<int>(sizeof(line)) - 4; i++) {
+                        n += snprintf(line + n, sizeof(line) - n, "%02X", f.data[i]);
+                    }
+                }
+                break;
+        }
+        fputs(line, stdout);
+        if (f.flags) {
+            const char* separator = "  [";
+            for (size_t i = 0; i < FLAG_COUNT; i++) {
+                if (!(f.flags & (1u << i))) continue;
+                fputs(separator, stdout);
+                fputs(FLAG_NAMES[i], stdout);
+                separator = ",";
+            }
+            fputc(']', stdout);
+        }
+        fputc('\n', stdout);
+    }
+};
+
+/**
+ * @brief Transmet les changements de niveau au décodeur
+ */
+struct EdgeFeeder {
+    ADBFrameDecoder& decoder;
+    Report& report;
+    bool level = true;
+
+    void sample(uint64_t ns, bool newLevel) {
+        if (newLevel == level) return;
+        level = newLevel;
+        report.lastEdgeNs = ns;
+        report.lastEdgeUs = static_cast<uint32_t>(ns / 1000);
+        report.edges++;
+        decoder.edge(report.lastEdgeUs, newLevel);
+    }
+};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Lecture d'un entier décimal non signé
+ */
+uint64_t parseUnsigned(const char*& p, const char* end) {
+    uint64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9') value = value * 10 + static_cast<uint64_t>(*p++ - '0');
+    return value;
+}
+
+/**
+ * @brief Lecture d'une date en secondes (notation décimale ou scientifique) convertie en ns
+ */
+bool parseSeconds(const char* p, const char* end, uint64_t& ns) {
+    const char* start = p;
+    uint64_t whole = parseUnsigned(p, end);
+    uint64_t fraction = 0;
+    uint32_t digits = 0;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (digits < 9) {
+                fraction = fraction * 10 + static_cast<uint64_t>(*p - '0');
+                digits++;
+            }
+            p++;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        // Notation scientifique: voie lente
+        std::string text(start, end);
+        ns = static_cast<uint64_t>(strtod(text.c_str(), nullptr) * 1e9 + 0.5);
+        return true;
+    }
+    if (p == start) return false;
+    while (digits < 9) {
+        fraction *= 10;
+        digits++;
+    }
+    ns = whole * 1000000000ULL + fraction;
+    return true;
+}
+
+/**
+ * @brief Lecteur de VCD restreint à un signal d'un bit
+ */
+class VcdParser {
+public:
+    VcdParser(EdgeFeeder& feeder, const std::string& signal) : feeder(feeder), signal(signal) {}
+
+    bool line(const char* p, const char* end) {
+        while (p < end) {
+            while (p < end && isSpace(*p)) p++;
+            const char* token = p;
+            while (p < end && !isSpace(*p)) p++;
+            if (p > token && !this->token(token, p)) return false;
+        }
+        return true;
+    }
+
+    bool ready() const { return inBody; }
+    bool defined() const { return definitionsEnded; }
+
+private:
+    bool token(const char* t, const char* end) {
+        if (inBody) {
+            // Corps: "#date", "0id"/"1id"/"xid"/"zid", vecteurs "b... id" ignorés
+            char c = *t;
+            if (c == '#') {
+                const char* p = t + 1;
+                timeNs = parseUnsigned(p, end) * tickMul / tickDiv;
+            } else if (skipNext) {
+                skipNext = false;
+            } else if (c == 'b' || c == 'B' || c == 'r' || c == 'R') {
+                skipNext = true;
+            } else if (c == '0' || c == '1' || c == 'x' || c == 'X' || c == 'z' || c == 'Z') {
+                if (static_cast<size_t>(end - t - 1) == id.size() && memcmp(t + 1, id.data(), id.size()) == 0) {
+                    // Ligne open-drain: x et z se lisent comme le niveau de repos
+                    feeder.sample(timeNs, c != '0');
+                }
+            }
+            return true;
+        }
+        return headerToken(std::string(t, end));
+    }
+
+    bool headerToken(const std::string& t) {
+        if (t == "$end") {
+            finishDirective();
+            return true;
+        }
+        if (t[0] == '$') {
+            directive = t;
+            args.clear();
+            return true;
+        }
+        args.push_back(t);
+        return true;
+    }
+
+    void finishDirective() {
+        if (directive == "$timescale") {
+            std::string text;
+            for (const std::string& a : args) text += a;
+            uint64_t number = strtoull(text.c_str(), nullptr, 10);
+            size_t unit = text.find_first_not_of("0123456789");
+            std::string suffix = unit == std::string::npos ? "s" : text.substr(unit);
+            uint64_t fs = suffix == "fs" ? 1 : suffix == "ps" ? 1000 : suffix == "ns" ? 1000000 : suffix == "us" ? 1000000000ULL
+                        : suffix == "ms" ? 1000000000000ULL : 1000000000000000ULL;
+            // Durée d'un tick en ns: number x fs / 10^6, en fraction réduite
+            uint64_t scaleFs = (number ? number : 1) * fs;
+            uint64_t divisor = std::gcd(scaleFs, static_cast<uint64_t>(1000000));
+            tickMul = scaleFs / divisor;
+            tickDiv = 1000000 / divisor;
+        } else if (directive == "$var" && args.size() >= 4 && args[1] == "1" && id.empty()) {
+            if (signal.empty() || args[2] == signal || args[3] == signal) id = args[2];
+        } else if (directive == "$enddefinitions") {
+            definitionsEnded = true;
+            inBody = !id.empty();
+            if (!inBody) fprintf(stderr, "Signal VCD %s introuvable\n", signal.empty() ? "d'un bit" : signal.c_str());
+        }
+        directive.clear();
+        args.clear();
+    }
+
+    EdgeFeeder& feeder;
+    std::string signal;
+    std::string id;
+    std::string directive;
+    std::vector<std::string> args;
+    uint64_t tickMul = 1;      // Durée d'un tick en ns: tickMul / tickDiv (1 ns par défaut)
+    uint64_t tickDiv = 1;
+    uint64_t timeNs = 0;
+    bool definitionsEnded = false;
+    bool inBody = false;
+    bool skipNext = false;
+};
+
+/**
+ * @brief Lecteur de CSV: une ligne par échantillon ou par changement de niveau
+ */
+class CsvParser {
+public:
+    CsvParser(EdgeFeeder& feeder, int column, double rate)
+        : feeder(feeder), column(column >= 0 ? column : (rate > 0 ? 0 : 1)), rate(rate) {}
+
+    bool line(const char* p, const char* end) {
+        while (p < end && isSpace(*p)) p++;
+        if (p == end || *p == '#' || *p == ';') return true;
+
+        const char* fields[16];
+        const char* ends[16];
+        int count = 0;
+        while (count < 16) {
+            fields[count] = p;
+            const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+            ends[count] = comma ? comma : end;
+            count++;
+            if (!comma) break;
+            p = comma + 1;
+        }
+        if (column >= count) return true;
+
+        uint64_t ns;
+        if (rate > 0) {
+            ns = static_cast<uint64_t>(static_cast<double>(row) * 1e9 / rate);
+        } else if (!parseSeconds(fields[0], ends[0], ns)) {
+            return true;  // En-tête
+        }
+
+        const char* value = fields[column];
+        while (value < ends[column] && (isSpace(*value) || *value == '"')) value++;
+        if (value == ends[column] || *value < '0' || *value > '9') return true;
+        row++;
+        feeder.sample(ns, *value != '0');
+        return true;
+    }
+
+private:
+    EdgeFeeder& feeder;
+    int column;
+    double rate;
+    uint64_t row = 0;
+};
+
+/**
+ * @brief Parcourt l'entrée ligne par ligne (fichier projeté ou entrée standard)
+ * @return Nombre d'octets lus, ou -1 en cas d'erreur
+ */
+template <typename LineHandler>
+int64_t forEachLine(const char* path, LineHandler onLine) {
+    if (strcmp(path, "-") != 0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return -1;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return -1;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size == 0) {
+            close(fd);
+            return 0;
+        }
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) return -1;
+        madvise(map, size, MADV_SEQUENTIAL);
+
+        const char* base = static_cast<const char*>(map);
+        const char* p = base;
+        const char* end = base + size;
+        const char* released = base;
+        while (p < end) {
+            const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+            const char* lineEnd = eol ? eol : end;
+            if (!onLine(p, lineEnd)) break;
+            p = eol ? eol + 1 : end;
+
+            // Rend les pages déjà traitées pour garder une empreinte constante
+            if (static_cast<size_t>(p - released) >= RELEASE_CHUNK) {
+                const char* upTo = released + RELEASE_CHUNK;
+                madvise(const_cast<char*>(released), RELEASE_CHUNK, MADV_DONTNEED);
+                released = upTo;
+            }
+        }
+        munmap(map, size);
+        return static_cast<int64_t>(size);
+    }
+
+    // Entrée standard: tampon fixe, la ligne incomplète est reportée au bloc suivant
+    std::vector<char> buffer(READ_CHUNK * 2);
+    size_t kept = 0;
+    int64_t total = 0;
+    for (;;) {
+        size_t n = fread(buffer.data() + kept, 1, buffer.size() - kept, stdin);
+        if (n == 0) break;
+        total += static_cast<int64_t>(n);
+        const char* p = buffer.data();
+        const char* end = buffer.data() + kept + n;
+        const char* eol;
+        while ((eol = static_cast<const char*>(memchr(p, '\n', end - p))) != nullptr) {
+            if (!onLine(p, eol)) return total;
+            p = eol + 1;
+        }
+        kept = static_cast<size_t>(end - p);
+        if (kept == buffer.size()) kept = 0;  // Ligne démesurée: abandonnée
+        memmove(buffer.data(), p, kept);
+    }
+    if (kept > 0) onLine(buffer.data(), buffer.data() + kept);
+    return total;
+}
+
+/**
+ * @brief Déduit le format du premier caractère significatif
+ */
+Format sniffFormat(const char* path) {
+    if (strcmp(path, "-") == 0) return Format::VCD;
+    size_t length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".csv") == 0) return Format::CSV;
+    if (length > 4 && strcmp(path + length - 4, ".vcd") == 0) return Format::VCD;
+    FILE* file = fopen(path, "r");
+    if (!file) return Format::VCD;
+    int c;
+    while ((c = fgetc(file)) != EOF && (c == ' ' || c == '\n' || c == '\r' || c == '\t')) {}
+    fclose(file);
+    return c == '$' ? Format::VCD : Format::CSV;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--signal" && hasValue) options.signal = argv[++i];
+        else if (arg == "--column" && hasValue) options.column = atoi(argv[++i]);
+        else if (arg == "--rate" && hasValue) options.rate = atof(argv[++i]);
+        else if (arg == "--glitch" && hasValue) options.glitchUs = atoi(argv[++i]);
+        else if (arg == "--csv") options.format = Format::CSV;
+        else if (arg == "--vcd") options.format = Format::VCD;
+        else if (arg == "--anomalies") options.output = Output::ANOMALIES;
+        else if (arg == "--summary") options.output = Output::SUMMARY;
+        else if (arg[0] != '-' || arg == "-") options.path = argv[i];
+        else return false;
+    }
+    return options.path != nullptr;
+}
+
+void printSummary(const Report& report, const ADBFrameDecoder& decoder, int64_t bytes, double wallSeconds) {
+    double spanSeconds = static_cast<double>(report.lastEdgeNs) / 1e9;
+    printf("\nBilan\n");
+    printf("  Fronts      : %llu sur %.3f s de capture (%.1f Mo)\n",
+           static_cast<unsigned long long>(report.edges), spanSeconds, static_cast<double>(bytes) / 1e6);
+    printf("  Trames      : %llu commandes, %llu resets, %llu impulsions isolées, %llu SRQ\n",
+           static_cast<unsigned long long>(report.commands), static_cast<unsigned long long>(report.resets),
+           static_cast<unsigned long long>(report.strays), static_cast<unsigned long long>(report.srqs));
+    for (uint8_t addr = 0; addr < 16; addr++) {
+        if (report.talks[addr] == 0 && report.listens[addr] == 0) continue;
+        printf("  Adresse %-3u : %llu Talk (%llu avec données), %llu Listen\n", addr,
+               static_cast<unsigned long long>(report.talks[addr]), static_cast<unsigned long long>(report.talkData[addr]),
+               static_cast<unsigned long long>(report.listens[addr]));
+    }
+    printf("  Anomalies   : %llu trames\n", static_cast<unsigned long long>(report.anomalous));
+    if (decoder.glitches()) printf("  Parasites   : %lu impulsions écartées\n", static_cast<unsigned long>(decoder.glitches()));
+    for (size_t i = 0; i < FLAG_COUNT; i++) {
+        if (report.flagCounts[i] == 0) continue;
+        printf("    %-20s %llu\n", FLAG_NAMES[i], static_cast<unsigned long long>(report.flagCounts[i]));
+    }
+    printf("  Décodage    : %.3f s, %.0f Mo/s", wallSeconds, static_cast<double>(bytes) / 1e6 / wallSeconds);
+    if (spanSeconds > 0) printf(", x%.0f temps réel", spanSeconds / wallSeconds);
+    printf("\n");
+}
+
+void onFrame(void* context, const adb_frame& frame) {
+    static_cast<Report*>(context)->frame(frame);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s [--signal NOM] [--column N] [--rate HZ] [--csv|--vcd] [--glitch US] "
+                        "[--anomalies|--summary] capture.vcd|capture.csv|-\n", argv[0]);
+        return 2;
+    }
+    static char outputBuffer[1 << 16];
+    setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+    Report report;
+    report.output = options.output;
+    ADBFrameDecoder decoder(onFrame, &report);
+    if (options.glitchUs > 0) decoder.setGlitchFilter(static_cast<uint8_t>(options.glitchUs > 255 ? 255 : options.glitchUs));
+    EdgeFeeder feeder{decoder, report};
+
+    Format format = options.format == Format::AUTO ? sniffFormat(options.path) : options.format;
+    auto wallStart = std::chrono::steady_clock::now();
+    int64_t bytes;
+    if (format == Format::VCD) {
+        VcdParser parser(feeder, options.signal);
+        bytes = forEachLine(options.path, [&](const char* p, const char* end) { return parser.line(p, end); });
+        if (bytes >= 0 && !parser.ready()) {
+            // Signal introuvable déjà signalé; sinon entrée vide ou qui n'est pas un VCD
+            if (!parser.defined()) fprintf(stderr, "%s: aucune définition VCD ($enddefinitions absent)\n", options.path);
+            return 1;
+        }
+    } else {
+        CsvParser parser(feeder, options.column, options.rate);
+        bytes = forEachLine(options.path, [&](const char* p, const char* end) { return parser.line(p, end); });
+    }
+    if (bytes < 0) {
+        fprintf(stderr, "Impossible de lire %s\n", options.path);
+        return 1;
+    }
+    decoder.finish();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    printSummary(report, decoder, bytes, wallSeconds);
+    return report.anomalous == 0 ? 0 : 3;
+}
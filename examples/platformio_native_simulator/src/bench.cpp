@@ -0,0 +1,54 @@
+/**
+ * @file bench.cpp
+ * @brief Mesure des opérations ADB sur le simulateur de bus
+ *
+ * Les durées d'appel et d'occupation du bus sont exactes (temps virtuel); les
+ * cycles sont ceux de l'hôte et incluent le coût du simulateur. Pour comparer
+ * les cibles, utiliser examples/platformio_benchmark.
+ *
+ * Usage: bench [itérations]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBBench.h>
+
+namespace {
+
+constexpr uint8_t ADB_PIN = 2;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint16_t iterations = argc > 1 ? static_cast<uint16_t>(atoi(argv[1])) : 200;
+
+    ADBSim::Bus bus(ADB_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    bus.attach(keyboard);
+    bus.attach(mouse);
+
+    // Trafic continu: les lectures du clavier et de la souris renvoient des données
+    for (uint64_t t = 10000; t < 600000000; t += 1000) {
+        keyboard.script(t, static_cast<uint8_t>((t / 1000) % 0x60), (t / 1000) & 1);
+        mouse.script(t, 3, -2, false);
+    }
+
+    ADB adb(ADB_PIN);
+    ADBDevices devices(adb);
+    if (!adb.init(ADB_PIN, true)) {
+        Serial.println(F("Initialisation du bus impossible"));
+        return 1;
+    }
+
+    ADBBench bench(ADB_PIN);
+    bench.begin();
+    bench.runProtocolSuite(adb, devices, iterations);
+    bench.end();
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file calibrate.cpp
+ * @brief Calibration des cellules par adresse face à des périphériques hors tolérance
+ *
+ * Clavier et souris simulés répondent avec une horloge de bits décalée
+ * (70 à 130 µs par cellule) et des fronts montants retardés (câble long).
+ * Pour chaque cas, l'hôte interroge les deux périphériques avec la
+ * calibration désactivée (demi-cellule maximale fixe, comparaison directe)
+ * puis activée: touches et mouvements reçus sont comparés à ceux émis, et
+ * le profil appris (période, seuil, marges) est affiché.
+ *
+ * Usage: calibrate [secondes simulées par essai]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ADBProtocol;
+
+constexpr uint8_t HOST_PIN = 2;
+constexpr uint32_t POLL_INTERVAL_MS = 5;
+
+struct Case {
+    const char* label;
+    uint32_t cellUs;      // Période de cellule du périphérique
+    uint32_t skewUs;      // Allongement des parties basses
+};
+
+struct Result {
+    uint32_t errors;      // Erreurs de bit
+    bool intact;
+    adb_timing_profile keyboard;
+    adb_timing_profile mouse;
+};
+
+/**
+ * @brief Interroge clavier et souris pendant la durée donnée
+ */
+Result run(const Case& c, bool adaptive, double seconds, uint32_t seed) {
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    bus.attach(keyboard);
+    bus.attach(mouse);
+    keyboard.setTransmitTiming(c.cellUs * ADBSim::NS_PER_US, c.skewUs * ADBSim::NS_PER_US);
+    mouse.setTransmitTiming(c.cellUs * ADBSim::NS_PER_US, c.skewUs * ADBSim::NS_PER_US);
+
+    uint64_t base = ADBSim::now() / ADBSim::NS_PER_US;
+    uint64_t end = base + static_cast<uint64_t>(seconds * 1e6);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(20000, 80000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng))) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(t + 30000, code, true);
+    }
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), false);
+    }
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    host.setAdaptiveTiming(adaptive);
+    host.init(HOST_PIN, true);
+
+    std::vector<uint8_t> received;
+    int64_t movedX = 0;
+    int64_t movedY = 0;
+    while (ADBSim::now() < (end + 200000) * ADBSim::NS_PER_US) {
+        bool error = false;
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) {
+            received.push_back(static_cast<uint8_t>(keyPress.raw >> 8));
+            if ((keyPress.raw & 0xFF) != 0xFF) received.push_back(static_cast<uint8_t>(keyPress.raw & 0xFF));
+        }
+        auto data = devices.mouseReadData(&error);
+        if (!error) {
+            movedX += static_cast<int8_t>((data.raw & 0x7F) << 1) >> 1;
+            movedY += static_cast<int8_t>(((data.raw >> 8) & 0x7F) << 1) >> 1;
+        }
+        delay(POLL_INTERVAL_MS);
+    }
+
+    std::vector<uint8_t> sent;
+    for (const ADBSim::KeyEvent& event : keyboard.delivered()) {
+        sent.push_back(static_cast<uint8_t>(event.code | (event.released ? 0x80 : 0x00)));
+    }
+    Result result = {};
+    result.errors = host.addressStats(ADBKey::Address::KEYBOARD).bitErrors +
+                    host.addressStats(ADBKey::Address::MOUSE).bitErrors;
+    result.intact = received == sent && !sent.empty() && movedX == mouse.deliveredX() && movedY == mouse.deliveredY();
+    result.keyboard = host.timingProfile(ADBKey::Address::KEYBOARD);
+    result.mouse = host.timingProfile(ADBKey::Address::MOUSE);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    const Case cases[] = {
+        {"nominal", 100, 0},
+        {"horloge rapide -30%", 70, 0},
+        {"horloge lente +25%", 125, 0},
+        {"horloge lente +30%", 130, 0},
+        {"câble long (+15 µs bas)", 100, 15},
+        {"lente +20%, câble long", 120, 12},
+        {"lente +30%, câble long", 130, 10},
+        {"rapide -20%, câble long", 80, 10},
+    };
+
+    bool ok = true;
+    printf("%-26s %-22s %-44s\n", "Périphérique", "Sans calibration", "Avec calibration");
+    for (const Case& c : cases) {
+        Result fixed = run(c, false, seconds, 1);
+        Result adaptive = run(c, true, seconds, 1);
+        const adb_timing_profile& profile = adaptive.mouse;   // Profil affiché: la souris répond le plus souvent
+        double learnedUs = profile.cellUs16 / 16.0;
+        bool learned = std::fabs(learnedUs - c.cellUs) <= c.cellUs * 0.03 &&
+                       std::fabs(adaptive.keyboard.cellUs16 / 16.0 - c.cellUs) <= c.cellUs * 0.03;
+        bool caseOk = adaptive.errors == 0 && adaptive.intact && learned && profile.minMargin >= 30;
+        ok &= caseOk;
+
+        printf("%-26s %5lu erreurs, %-8s  cellule %6.1f µs, seuil %3u‰, marge min. %3u%%, %5lu erreurs, %-8s %s\n",
+               c.label, static_cast<unsigned long>(fixed.errors), fixed.intact ? "intact" : "pertes", learnedUs,
+               profile.thresholdPermille, profile.minMargin, static_cast<unsigned long>(adaptive.errors),
+               adaptive.intact ? "intact" : "pertes", caseOk ? "" : "<-");
+    }
+
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
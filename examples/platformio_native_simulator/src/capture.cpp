@@ -0,0 +1,91 @@
+/**
+ * @file capture.cpp
+ * @brief Capture d'une transaction ADB en VCD sur le simulateur de bus
+ *
+ * Écrit deux chronogrammes de la même séquence (Talk R0 du clavier, Listen R2
+ * des LEDs), lisibles dans GTKWave ou PulseView:
+ *   <préfixe>_bus.vcd   fronts réels de la ligne simulée (référence, 1 ns)
+ *   <préfixe>_host.vcd  fronts vus par ADB via ADBCapture (1 µs)
+ * ainsi que <préfixe>_host.adbc, la même capture au format binaire transmis
+ * par une cible (convertible avec capture2vcd).
+ *
+ * Usage: capture [préfixe]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBCapture.h>
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+constexpr uint8_t ADB_PIN = 2;
+
+/**
+ * @brief Écrit la capture de l'hôte dans un fichier
+ */
+bool saveCapture(const ADBCapture& capture, const std::string& path, bool binary) {
+    FILE* file = fopen(path.c_str(), binary ? "wb" : "w");
+    if (!file) return false;
+    FileOutput out(file);
+    if (binary) {
+        capture.writeBinary(out);
+    } else {
+        capture.writeVCD(out);
+    }
+    fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string prefix = argc > 1 ? argv[1] : "adb";
+
+    ADBSim::Bus bus(ADB_PIN);
+    ADBSim::Keyboard keyboard;
+    bus.attach(keyboard);
+    keyboard.script(5000, 0x00, false);   // Appui sur A
+
+    ADB adb(ADB_PIN);
+    ADBDevices devices(adb);
+    if (!adb.init(ADB_PIN, true)) {
+        printf("Initialisation du bus impossible\n");
+        return 1;
+    }
+    delay(10);
+
+    ADBCaptureBuffer<256> capture;
+    ADBSim::VcdWriter reference;
+    if (!reference.open((prefix + "_bus.vcd").c_str(), bus)) {
+        printf("Impossible de créer %s_bus.vcd\n", prefix.c_str());
+        return 1;
+    }
+    adb.setCapture(&capture);
+
+    bool error = false;
+    devices.keyboardReadKeyPress(&error);
+    devices.keyboardWriteLEDs(true, false, false);
+    devices.flushPendingWrites();
+
+    adb.setCapture(nullptr);
+    reference.close();
+
+    bool saved = saveCapture(capture, prefix + "_host.vcd", false) &&
+                 saveCapture(capture, prefix + "_host.adbc", true);
+    printf("Ligne simulée : %llu fronts -> %s_bus.vcd\n",
+           static_cast<unsigned long long>(reference.edges()), prefix.c_str());
+    printf("Capture ADB   : %u fronts (%u perdus) -> %s_host.vcd, %s_host.adbc\n",
+           capture.count(), capture.droppedEdges(), prefix.c_str(), prefix.c_str());
+
+    bool ok = saved && !error && capture.count() == reference.edges() && capture.droppedEdges() == 0;
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
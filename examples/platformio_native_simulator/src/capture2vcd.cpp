@@ -0,0 +1,55 @@
+/**
+ * @file capture2vcd.cpp
+ * @brief Conversion d'une capture binaire ADBCapture en VCD
+ *
+ * Convertit le flux écrit par ADBCapture::writeBinary (sur la cible, via la
+ * liaison série par exemple) en chronogramme VCD.
+ *
+ * Usage: capture2vcd capture.adbc [sortie.vcd]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBCapture.h>
+
+#include <cstdio>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s capture.adbc [sortie.vcd]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (!in) {
+        fprintf(stderr, "Impossible d'ouvrir %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(in);
+
+    size_t capacity = data.size() > ADBCapture::HEADER_SIZE ? (data.size() - ADBCapture::HEADER_SIZE) / 4 : 0;
+    std::vector<uint32_t> storage(capacity > 0 ? capacity : 1);
+    ADBCapture capture(storage.data(), static_cast<uint16_t>(capacity > 0xFFFF ? 0xFFFF : capacity));
+    if (!capture.loadBinary(data.data(), data.size())) {
+        fprintf(stderr, "%s: capture ADBC invalide\n", argv[1]);
+        return 1;
+    }
+
+    FILE* out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Impossible de créer %s\n", argv[2]);
+        return 1;
+    }
+    FileOutput output(out);
+    capture.writeVCD(output);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file emulate.cpp
+ * @brief Mode périphérique de la bibliothèque face à un hôte simulé
+ *
+ * ADBDeviceEmulator (clavier et souris émulés) s'exécute par interruption
+ * sur la broche du bus. Un hôte comportemental (ADBSim::HostModel) lit et
+ * modifie les registres 3, écrit les LEDs, puis interroge le bus à la manière
+ * d'un Macintosh pendant que la boucle principale produit des frappes et des
+ * mouvements. Vérifications: séquence de touches et déplacement total reçus
+ * par l'hôte, Tlt de chaque réponse dans la fenêtre 140-260 µs, SRQ, et
+ * résolution d'un conflit d'adresse avec une souris simulée (Listen R3 0xFE).
+ *
+ * Usage: emulate [secondes] [--verbose]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBDeviceEmulator.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t EMULATOR_PIN = 2;
+constexpr uint32_t POLL_INTERVAL_US = 11000;   // Interrogation d'un Macintosh (environ 11 ms)
+constexpr uint8_t KEYBOARD = ADBKey::Address::KEYBOARD;
+constexpr uint8_t MOUSE = ADBKey::Address::MOUSE;
+
+using Transaction = ADBSim::HostModel::Transaction;
+
+/**
+ * @brief Avance le temps simulé jusqu'à ce que l'hôte ait traité sa file
+ */
+void settle(ADBSim::HostModel& host) {
+    while (!host.idle()) delay(1);
+    delay(1);
+}
+
+/**
+ * @brief Dernière transaction de l'hôte
+ */
+const Transaction& last(ADBSim::HostModel& host) {
+    return host.transactions().back();
+}
+
+bool check(const char* label, bool ok) {
+    printf("%-46s %s\n", label, ok ? "ok" : "ÉCHEC");
+    return ok;
+}
+
+int8_t axis(uint16_t value, uint8_t shift) {
+    uint8_t raw = (value >> shift) & 0x7F;
+    return static_cast<int8_t>(raw & 0x40 ? raw | 0x80 : raw);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = 20.0;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            seconds = atof(argv[i]);
+        }
+    }
+    uint64_t durationUs = static_cast<uint64_t>(seconds * 1e6);
+
+    ADBSim::Bus bus(EMULATOR_PIN);
+    ADBSim::HostModel host;
+    bus.attach(host);
+
+    ADBEmulatedKeyboard keyboard;
+    ADBEmulatedMouse mouse;
+    ADBDeviceEmulator emulator(EMULATOR_PIN);
+    emulator.attach(keyboard);
+    emulator.attach(mouse);
+    if (!emulator.begin()) {
+        printf("Émulation impossible\n");
+        return 1;
+    }
+
+    bool ok = true;
+
+    // Registres 3: adresse aléatoire à chaque lecture, handler et SRQ activé
+    host.resetBus();
+    host.talk(KEYBOARD, 3);
+    host.talk(MOUSE, 3);
+    settle(host);
+    const std::vector<Transaction>& log = host.transactions();
+    const Transaction& kbReg3 = log[log.size() - 2];
+    const Transaction& mouseReg3 = log[log.size() - 1];
+    ok &= check("Talk R3 clavier (handler 2, SRQ activé)",
+                kbReg3.responded && (kbReg3.value & 0xFF) == 2 && (kbReg3.value & 0x2000));
+    ok &= check("Talk R3 souris (handler 1, adresse aléatoire)",
+                mouseReg3.responded && (mouseReg3.value & 0xFF) == 1 && ((mouseReg3.value >> 8) & 0x0F) >= 8);
+
+    // Changement de handler: accepté s'il est pris en charge, ignoré sinon
+    host.listen(MOUSE, 3, 0x6002);
+    host.listen(MOUSE, 3, 0x6004);
+    host.talk(MOUSE, 3);
+    settle(host);
+    ok &= check("Listen R3 handler 2 accepté, 4 refusé", last(host).responded && (last(host).value & 0xFF) == 2);
+    host.listen(MOUSE, 3, 0x6001);
+
+    // LEDs: Caps Lock allumé (bit actif à l'état bas)
+    host.listen(KEYBOARD, 2, 0xFFFD);
+    host.talk(KEYBOARD, 2);
+    settle(host);
+    ok &= check("Listen R2 LEDs (Caps Lock)", keyboard.leds() == 0x02 && (last(host).value & 0x07) == 0x05);
+
+    // Aucun événement en attente: Talk R0 sans réponse
+    host.talk(KEYBOARD, 0);
+    settle(host);
+    ok &= check("Talk R0 sans données: pas de réponse", !last(host).responded && !last(host).error);
+
+    // Interrogation automatique, frappes et mouvements produits par la boucle principale
+    size_t firstPolled = host.transactions().size();
+    host.setPolling(POLL_INTERVAL_US, {KEYBOARD, MOUSE});
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapMs(5, 120);
+    std::uniform_int_distribution<int> motion(-90, 90);
+    std::vector<uint8_t> typed;
+    int32_t movedX = 0;
+    int32_t movedY = 0;
+    uint32_t fullQueue = 0;
+
+    while (ADBSim::now() < durationUs * ADBSim::NS_PER_US) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        for (bool released : {false, true}) {
+            if (keyboard.keyEvent(code, released)) {
+                typed.push_back(static_cast<uint8_t>(code | (released ? 0x80 : 0x00)));
+            } else {
+                fullQueue++;
+            }
+            int16_t x = static_cast<int16_t>(motion(rng));
+            int16_t y = static_cast<int16_t>(motion(rng));
+            mouse.move(x, y);
+            movedX += x;
+            movedY += y;
+            delay(gapMs(rng));
+        }
+    }
+    // Vidage des données restantes
+    while (keyboard.pendingEvents() || mouse.hasPendingData()) delay(POLL_INTERVAL_US / 1000);
+    host.setPolling(0, {});
+    settle(host);
+
+    std::vector<uint8_t> received;
+    int32_t receivedX = 0;
+    int32_t receivedY = 0;
+    uint32_t responses = 0;
+    uint32_t outsideWindow = 0;
+    uint32_t errors = 0;
+    uint32_t hostSrqs = 0;
+    for (size_t i = firstPolled; i < host.transactions().size(); i++) {
+        const Transaction& tr = host.transactions()[i];
+        if (tr.srq) hostSrqs++;
+        if (tr.error) errors++;
+        if (!tr.responded) continue;
+        responses++;
+        if (tr.tltUs < ADBProtocol::TLT_MIN || tr.tltUs > ADBProtocol::TLT_MAX) outsideWindow++;
+        if (verbose) printf("%12.6f cmd %02X %04X tlt %u%s\n", tr.at / 1e9, tr.command, tr.value, tr.tltUs,
+                            tr.srq ? " SRQ" : "");
+        if (tr.command >> 4 == KEYBOARD) {
+            received.push_back(static_cast<uint8_t>(tr.value >> 8));
+            if ((tr.value & 0xFF) != 0xFF) received.push_back(static_cast<uint8_t>(tr.value & 0xFF));
+        } else if (tr.command >> 4 == MOUSE) {
+            receivedX += axis(tr.value, 0);
+            receivedY += axis(tr.value, 8);
+        }
+    }
+
+    const adb_emulator_stats& stats = emulator.stats();
+    printf("Temps simulé : %.1f s, %zu transactions, %lu réponses, %lu SRQ\n", ADBSim::now() / 1e9,
+           host.transactions().size() - firstPolled, static_cast<unsigned long>(responses),
+           static_cast<unsigned long>(hostSrqs));
+    printf("Touches : %zu émises, %zu reçues, file pleine %lu fois\n", typed.size(), received.size(),
+           static_cast<unsigned long>(fullQueue));
+    printf("Souris : (%ld, %ld) émis, (%ld, %ld) reçus\n", static_cast<long>(movedX), static_cast<long>(movedY),
+           static_cast<long>(receivedX), static_cast<long>(receivedY));
+    printf("Émulateur : %lu commandes, %lu réponses, %lu Listen, %lu SRQ, %lu réponses tardives\n",
+           static_cast<unsigned long>(stats.commands), static_cast<unsigned long>(stats.talks),
+           static_cast<unsigned long>(stats.listens), static_cast<unsigned long>(stats.srqs),
+           static_cast<unsigned long>(stats.lateResponses));
+
+    ok &= check("Séquence de touches identique", received == typed);
+    ok &= check("Déplacement total identique", receivedX == movedX && receivedY == movedY);
+    ok &= check("Tlt dans la fenêtre 140-260 µs", outsideWindow == 0 && stats.lateResponses == 0);
+    ok &= check("SRQ émis et vus par l'hôte", hostSrqs > 0 && hostSrqs == stats.srqs);
+    ok &= check("Aucune réponse interrompue", errors == 0 && stats.collisions == 0);
+
+    // Conflit d'adresse: une souris simulée rejoint l'adresse 3. Les deux répondent au
+    // Talk R3; celle qui constate la collision reste en place au Listen R3 0xFE
+    ADBSim::Mouse other;
+    bus.attach(other);
+    host.talk(MOUSE, 3);
+    host.listen(MOUSE, 3, 0x09FE);
+    settle(host);
+    uint32_t collisions = stats.collisions + other.stats().collisions;
+    bool emulatedMoved = mouse.address() == 9;
+    bool oneMoved = emulatedMoved != (other.address() == 9);
+    printf("Conflit : %lu collision(s) côté émulateur, %lu côté souris simulée, %s déplacée\n",
+           static_cast<unsigned long>(stats.collisions), static_cast<unsigned long>(other.stats().collisions),
+           emulatedMoved ? "souris émulée" : "souris simulée");
+    ok &= check("Collision détectée pendant le Talk R3", collisions == 1);
+    ok &= check("Listen R3 0xFE: seul le gagnant est déplacé", oneMoved && emulatedMoved == (stats.collisions == 0));
+    host.talk(MOUSE, 3);
+    host.talk(9, 3);
+    settle(host);
+    const Transaction& atOld = log[log.size() - 2];
+    const Transaction& atNew = log[log.size() - 1];
+    ok &= check("Un périphérique à chaque adresse", atOld.responded && !atOld.error && atNew.responded &&
+                                                      !atNew.error &&
+                                                      stats.collisions + other.stats().collisions == collisions);
+
+    emulator.end();
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
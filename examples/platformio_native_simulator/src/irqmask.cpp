@@ -0,0 +1,168 @@
+/**
+ * @file irqmask.cpp
+ * @brief Masquage des interruptions face à une charge concurrente
+ *
+ * Une routine d'interruption de durée fixe (pile USB ou BLE) se déclenche à
+ * dates aléatoires pendant que l'hôte interroge clavier et souris. Pour
+ * chaque politique (aucun masquage, par cellule, par paquet avec plusieurs
+ * durées maximales), on relève les erreurs de bit, l'intégrité des touches
+ * et mouvements reçus, la plus longue section masquée mesurée par ADB et la
+ * plus longue latence subie par la routine. Par cellule, aucune section ne
+ * doit couvrir la scrutation du bit de début. Les routines durent 15 µs et
+ * leurs déclenchements sont espacés d'au moins 100 µs: deux routines servies
+ * coup sur coup dans une fenêtre tiennent encore dans la partie courte d'une
+ * cellule (35 µs), une troisième supposerait une attente plus longue qu'une
+ * section par cellule. Sans masquage, la charge doit altérer la réception
+ * (erreurs ou données fausses).
+ *
+ * Usage: irqmask [secondes simulées par essai]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ADBProtocol;
+
+constexpr uint8_t HOST_PIN = 2;
+constexpr uint8_t LOAD_PIN = 9;
+constexpr uint32_t POLL_INTERVAL_MS = 5;
+constexpr uint32_t LOAD_PER_SECOND = 4000;
+constexpr uint32_t ISR_US = 15;
+constexpr uint32_t LOAD_GAP_MIN_US = 100;
+constexpr uint32_t RESPONSE_POLL_US = 240;
+
+struct Case {
+    const char* label;
+    adb_irq_policy policy;
+    bool loaded;
+};
+
+struct Result {
+    uint32_t errors;        // Erreurs de bit
+    bool intact;            // Données reçues identiques aux données émises
+    uint32_t maxMaskedUs;   // Plus longue section masquée mesurée par ADB
+    uint64_t maxLatencyUs;  // Plus longue attente de la routine
+    uint64_t served;        // Routines exécutées
+    uint64_t raised;        // Déclenchements
+};
+
+Result run(const Case& c, double seconds) {
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    ADBSim::Load load(LOAD_PIN, 17);
+    bus.attach(keyboard);
+    bus.attach(mouse);
+    bus.attach(load);
+
+    uint64_t base = ADBSim::now() / ADBSim::NS_PER_US;
+    uint64_t end = base + static_cast<uint64_t>(seconds * 1e6);
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(20000, 80000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng))) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(t + 30000, code, true);
+    }
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), false);
+    }
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    host.init(HOST_PIN, true);
+    host.setInterruptPolicy(c.policy);
+    host.resetStats();
+    if (c.loaded) load.setLoad(LOAD_PER_SECOND, ISR_US * ADBSim::NS_PER_US, LOAD_GAP_MIN_US * ADBSim::NS_PER_US);
+
+    std::vector<uint8_t> received;
+    int64_t movedX = 0;
+    int64_t movedY = 0;
+    while (ADBSim::now() < (end + 200000) * ADBSim::NS_PER_US) {
+        bool error = false;
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) {
+            received.push_back(static_cast<uint8_t>(keyPress.raw >> 8));
+            if ((keyPress.raw & 0xFF) != 0xFF) received.push_back(static_cast<uint8_t>(keyPress.raw & 0xFF));
+        }
+        auto data = devices.mouseReadData(&error);
+        if (!error) {
+            movedX += static_cast<int8_t>((data.raw & 0x7F) << 1) >> 1;
+            movedY += static_cast<int8_t>(((data.raw >> 8) & 0x7F) << 1) >> 1;
+        }
+        delay(POLL_INTERVAL_MS);
+    }
+    load.setLoad(0, 0);
+
+    std::vector<uint8_t> sent;
+    for (const ADBSim::KeyEvent& event : keyboard.delivered()) {
+        sent.push_back(static_cast<uint8_t>(event.code | (event.released ? 0x80 : 0x00)));
+    }
+    Result result = {};
+    result.errors = host.addressStats(ADBKey::Address::KEYBOARD).bitErrors +
+                    host.addressStats(ADBKey::Address::MOUSE).bitErrors;
+    result.intact = received == sent && !sent.empty() && movedX == mouse.deliveredX() && movedY == mouse.deliveredY();
+    result.maxMaskedUs = host.maxMaskedUs();
+    result.maxLatencyUs = load.maxLatencyNs() / ADBSim::NS_PER_US;
+    result.served = load.served();
+    result.raised = load.raised();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    const Case cases[] = {
+        {"sans charge", {IrqMask::NONE, IRQ_MASK_MAX}, false},
+        {"aucun masquage", {IrqMask::NONE, IRQ_MASK_MAX}, true},
+        {"par cellule, 250 µs", {IrqMask::PER_BIT, 250}, true},
+        {"par paquet, 300 µs", {IrqMask::PER_PACKET, 300}, true},
+        {"par paquet, 1000 µs", {IrqMask::PER_PACKET, 1000}, true},
+    };
+
+    bool ok = true;
+    bool loadEffective = false;
+    printf("Charge: %lu routines/s de %lu µs\n", static_cast<unsigned long>(LOAD_PER_SECOND),
+           static_cast<unsigned long>(ISR_US));
+    printf("%-22s %8s %-8s %14s %16s %s\n", "Politique", "Erreurs", "Données", "Masquage max.", "Latence routine",
+           "Routines");
+    for (const Case& c : cases) {
+        Result r = run(c, seconds);
+        bool rowOk = true;
+        if (c.policy.mode == IrqMask::NONE) {
+            rowOk = r.maxMaskedUs == 0;
+            if (!c.loaded) rowOk &= r.errors == 0 && r.intact;
+            else loadEffective = r.errors != 0 || !r.intact;
+        } else {
+            // Réception intacte, sections bornées, latence au plus une section plus deux routines
+            rowOk = r.errors == 0 && r.intact && r.maxMaskedUs > 0 && r.maxMaskedUs <= c.policy.maxMaskedUs &&
+                    r.maxLatencyUs <= c.policy.maxMaskedUs + 2 * ISR_US;
+            // Par cellule, la scrutation du bit de début (240 µs après Tlt) reste ouverte
+            if (c.policy.mode == IrqMask::PER_BIT) rowOk &= r.maxMaskedUs < RESPONSE_POLL_US;
+        }
+        ok &= rowOk;
+        printf("%-22s %8lu %-8s %11lu µs %13llu µs %8llu/%-8llu %s\n", c.label, static_cast<unsigned long>(r.errors),
+               r.intact ? "intact" : "pertes", static_cast<unsigned long>(r.maxMaskedUs),
+               static_cast<unsigned long long>(r.maxLatencyUs), static_cast<unsigned long long>(r.served),
+               static_cast<unsigned long long>(r.raised), rowOk ? "" : "<-");
+    }
+    ok &= loadEffective;
+
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
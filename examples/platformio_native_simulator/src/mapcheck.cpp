@@ -0,0 +1,189 @@
+/**
+ * @file mapcheck.cpp
+ * @brief Vérifie dans un fichier .map que le chemin critique est hors de la flash
+ *
+ * Relève dans les sources de la bibliothèque les fonctions marquées ADB_HOT
+ * et les tables marquées ADB_HOT_DATA (ADBPlatform.h), puis cherche leurs
+ * symboles dans le fichier .map produit par l'éditeur de liens GNU
+ * (-Wl,-Map, voir examples/platformio_benchmark). Chaque symbole est rattaché
+ * à sa section de sortie: .text, .rodata, .flash.text, .flash.rodata ou
+ * .text.progmem sont en flash, les autres (.iram0.text, .dram0.data,
+ * .text.itcm, .data pour .RamFunc, .ccmram...) en mémoire interne. Une
+ * fonction incorporée partout n'a pas de symbole: elle est signalée absente
+ * sans faire échouer la vérification. Sur AVR, le code s'exécute toujours
+ * depuis la flash, sans cache: la vérification y est sans objet.
+ *
+ * Usage: mapcheck firmware.map [dossier de la bibliothèque]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Fonction ou table marquée dans les sources
+ */
+struct HotSymbol {
+    std::string name;          // Nom qualifié (ADB::readCell)
+    std::string prefix;        // Début du nom décoré (_ZN3ADB8readCellE)
+    std::string constPrefix;   // Même préfixe pour une fonction membre const
+};
+
+struct Placement {
+    std::string section;
+    std::string address;
+};
+
+const char* const FLASH_SECTIONS[] = {".text", ".rodata", ".flash.text", ".flash.rodata", ".text.progmem",
+                                      ".irom0.text"};
+
+bool isFlash(const std::string& section) {
+    for (const char* flash : FLASH_SECTIONS) {
+        if (section == flash) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Préfixe décoré selon l'ABI Itanium (nom imbriqué ou libre)
+ */
+void mangle(HotSymbol& symbol) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    size_t sep;
+    while ((sep = symbol.name.find("::", start)) != std::string::npos) {
+        parts.push_back(symbol.name.substr(start, sep - start));
+        start = sep + 2;
+    }
+    parts.push_back(symbol.name.substr(start));
+
+    if (parts.size() == 1) {
+        symbol.prefix = "_Z" + std::to_string(parts[0].size()) + parts[0];
+        return;
+    }
+    std::string nested;
+    for (const std::string& part : parts) nested += std::to_string(part.size()) + part;
+    symbol.prefix = "_ZN" + nested + "E";
+    symbol.constPrefix = "_ZNK" + nested + "E";
+}
+
+std::vector<HotSymbol> scanSources(const std::filesystem::path& dir) {
+    static const std::regex marked(R"(\bADB_HOT(?:_DATA)?\s+((?:\w+::)*~?\w+)\s*[\(\[])");
+    std::vector<std::filesystem::path> sources;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().extension() == ".cpp") sources.push_back(entry.path());
+    }
+    std::sort(sources.begin(), sources.end());
+
+    std::vector<HotSymbol> symbols;
+    for (const std::filesystem::path& source : sources) {
+        std::ifstream in(source);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::smatch m;
+            if (!std::regex_search(line, m, marked)) continue;
+            HotSymbol symbol = {m[1].str(), "", ""};
+            mangle(symbol);
+            symbols.push_back(symbol);
+        }
+    }
+    return symbols;
+}
+
+/**
+ * @brief Section de sortie et adresse de chaque symbole du .map
+ */
+std::map<std::string, Placement> parseMap(std::ifstream& in) {
+    static const std::regex outputSection(R"(^(\.\S+)(\s|$))");
+    static const std::regex symbolLine(R"(^\s+0x([0-9a-fA-F]+)\s+([^0\s].*?)\s*$)");
+    std::map<std::string, Placement> symbols;
+    std::string line;
+    std::string section;
+    bool layout = false;
+    while (std::getline(in, line)) {
+        // Les symboles ne sont datés qu'après la configuration mémoire
+        if (!layout) {
+            layout = line.find("Linker script and memory map") != std::string::npos;
+            continue;
+        }
+        std::smatch m;
+        if (std::regex_search(line, m, outputSection)) {
+            section = m[1].str();
+            continue;
+        }
+        if (std::regex_match(line, m, symbolLine) && line.find('=') == std::string::npos) {
+            symbols.emplace(m[2].str(), Placement{section, "0x" + m[1].str()});
+        }
+    }
+    return symbols;
+}
+
+bool matches(const HotSymbol& hot, const std::string& symbol) {
+    // Nom décoré, ou démêlé si l'éditeur de liens a reçu --demangle
+    if (symbol.compare(0, hot.prefix.size(), hot.prefix) == 0) return true;
+    if (!hot.constPrefix.empty() && symbol.compare(0, hot.constPrefix.size(), hot.constPrefix) == 0) return true;
+    if (symbol == hot.name) return true;
+    return symbol.compare(0, hot.name.size() + 1, hot.name + "(") == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s firmware.map [dossier de la bibliothèque]\n", argv[0]);
+        return 2;
+    }
+    std::ifstream in(argv[1]);
+    if (!in) {
+        fprintf(stderr, "Impossible d'ouvrir %s\n", argv[1]);
+        return 1;
+    }
+    std::filesystem::path library = argc > 2 ? argv[2] : "../..";
+    std::error_code error;
+    if (!std::filesystem::is_directory(library, error)) {
+        fprintf(stderr, "%s: dossier de la bibliothèque introuvable\n", library.string().c_str());
+        return 1;
+    }
+
+    std::vector<HotSymbol> hot = scanSources(library);
+    std::map<std::string, Placement> placed = parseMap(in);
+    if (hot.empty() || placed.empty()) {
+        fprintf(stderr, "%s\n", hot.empty() ? "Aucun symbole ADB_HOT dans les sources" : "Aucun symbole dans le fichier .map");
+        return 1;
+    }
+
+    uint32_t inFlash = 0;
+    uint32_t found = 0;
+    printf("%-36s %-18s %-12s %s\n", "Symbole", "Section", "Adresse", "Placement");
+    for (const HotSymbol& symbol : hot) {
+        bool seen = false;
+        for (const auto& entry : placed) {
+            if (!matches(symbol, entry.first)) continue;
+            bool flash = isFlash(entry.second.section);
+            seen = true;
+            found++;
+            if (flash) inFlash++;
+            printf("%-36s %-18s %-12s %s\n", symbol.name.c_str(), entry.second.section.c_str(),
+                   entry.second.address.c_str(), flash ? "FLASH" : "interne");
+        }
+        if (!seen) printf("%-36s %-18s %-12s %s\n", symbol.name.c_str(), "-", "-", "absent (incorporé)");
+    }
+
+    bool ok = found > 0 && inFlash == 0;
+    printf("%lu symboles critiques trouvés, %lu en flash\n", static_cast<unsigned long>(found),
+           static_cast<unsigned long>(inFlash));
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+/**
+ * @file multibus.cpp
+ * @brief Plusieurs bus ADB pilotés par ADBMultiBus sur le simulateur
+ *
+ * Deux bus indépendants portent chacun un clavier et une souris simulés.
+ * 1. Référence: deux instances ADB bloquantes interrogées à tour de rôle.
+ * 2. ADBMultiBus sérialisé (maxActive = 1) puis entrelacé (maxActive = 2):
+ *    touches, mouvements, écritures de LEDs et registres 3 doivent arriver
+ *    intacts sur chaque bus, et le débit entrelacé doit approcher le double.
+ * 3. Équité: parts 3 et 1 sur un seul créneau, bus toujours demandeurs.
+ *
+ * Usage: multibus [secondes simulées par essai]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBMultiBus.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ADBProtocol;
+
+constexpr uint8_t PINS[] = {2, 3};
+constexpr uint8_t BUS_COUNT = sizeof(PINS);
+constexpr uint8_t KEYBOARD = ADBKey::Address::KEYBOARD;
+constexpr uint8_t MOUSE = ADBKey::Address::MOUSE;
+
+/**
+ * @brief Un bus simulé et ce que l'hôte en a reçu
+ */
+struct Port {
+    std::unique_ptr<ADBSim::Bus> bus;
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    std::vector<uint8_t> keys;
+    int64_t movedX = 0;
+    int64_t movedY = 0;
+    uint32_t reg3Errors = 0;
+    uint32_t results = 0;
+    uint8_t leds = 0;
+    uint32_t ledRequests = 0;
+};
+
+/**
+ * @brief Branche les périphériques et prépare leurs événements à partir de maintenant
+ */
+void setUp(Port* ports, double seconds, uint32_t seed) {
+    uint64_t base = ADBSim::now() / ADBSim::NS_PER_US;
+    uint64_t end = base + static_cast<uint64_t>(seconds * 1e6);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(10000, 60000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+    for (uint8_t i = 0; i < BUS_COUNT; i++) {
+        Port& port = ports[i];
+        port.bus.reset(new ADBSim::Bus(PINS[i]));
+        port.bus->attach(port.keyboard);
+        port.bus->attach(port.mouse);
+        for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng))) {
+            uint8_t code = static_cast<uint8_t>(keyCode(rng));
+            port.keyboard.script(t, code, false);
+            port.keyboard.script(t + 30000, code, true);
+        }
+        for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+            port.mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), false);
+        }
+    }
+}
+
+void collectKeys(Port& port, uint16_t raw) {
+    port.keys.push_back(static_cast<uint8_t>(raw >> 8));
+    if ((raw & 0xFF) != 0xFF) port.keys.push_back(static_cast<uint8_t>(raw & 0xFF));
+}
+
+void collectMotion(Port& port, uint16_t raw) {
+    port.movedX += static_cast<int8_t>((raw & 0x7F) << 1) >> 1;
+    port.movedY += static_cast<int8_t>(((raw >> 8) & 0x7F) << 1) >> 1;
+}
+
+/**
+ * @brief Tout ce qui a été émis par les périphériques a été reçu, sans erreur
+ */
+bool verify(Port& port, uint32_t errors, bool checkLeds) {
+    std::vector<uint8_t> sent;
+    for (const ADBSim::KeyEvent& event : port.keyboard.delivered()) {
+        sent.push_back(static_cast<uint8_t>(event.code | (event.released ? 0x80 : 0x00)));
+    }
+    bool ok = port.keys == sent && !sent.empty() && port.movedX == port.mouse.deliveredX() &&
+              port.movedY == port.mouse.deliveredY() && errors == 0 && port.reg3Errors == 0;
+    if (checkLeds) {
+        ok &= port.keyboard.ledWrites() == port.ledRequests &&
+              (port.keyboard.register2() & REG2_LED_MASK) == (~port.leds & REG2_LED_MASK);
+    }
+    return ok;
+}
+
+/**
+ * @brief Référence: deux instances ADB bloquantes, interrogées à tour de rôle
+ * @return Transactions par seconde
+ */
+double runBlocking(double seconds) {
+    Port ports[BUS_COUNT];
+    setUp(ports, seconds, 1);
+    std::unique_ptr<ADB> hosts[BUS_COUNT];
+    for (uint8_t i = 0; i < BUS_COUNT; i++) {
+        hosts[i].reset(new ADB(PINS[i]));
+        hosts[i]->init(PINS[i], true);
+    }
+
+    uint64_t start = ADBSim::now();
+    uint64_t end = start + static_cast<uint64_t>((seconds + 0.2) * 1e9);
+    uint32_t transactions = 0;
+    uint32_t errors = 0;
+    while (ADBSim::now() < end) {
+        for (uint8_t i = 0; i < BUS_COUNT; i++) {
+            for (uint8_t addr : {KEYBOARD, MOUSE}) {
+                uint16_t data = 0;
+                hosts[i]->writeCommand(CMD_TALK | ADDRESS(addr) | REGISTER(0));
+                hosts[i]->waitTLT(true);
+                if (hosts[i]->readDataPacket(&data, 16)) {
+                    if (addr == KEYBOARD) collectKeys(ports[i], data);
+                    else collectMotion(ports[i], data);
+                }
+                if (hosts[i]->lastStatus() == Status::BIT_ERROR) errors++;
+                transactions++;
+                delayMicroseconds(200);
+            }
+        }
+    }
+    double rate = transactions / ((ADBSim::now() - start) / 1e9);
+    bool ok = verify(ports[0], errors, false) && verify(ports[1], errors, false);
+    printf("Bloquant, deux instances ADB  : %6.0f transactions/s, %s\n", rate, ok ? "données intactes" : "ÉCART");
+    return ok ? rate : 0;
+}
+
+struct Session {
+    Port* ports;
+    ADBMultiBus* scheduler;
+    bool draining;
+};
+
+void onResult(void* context, const adb_multibus_result& result) {
+    Session* session = static_cast<Session*>(context);
+    Port& port = session->ports[result.bus];
+    port.results++;
+    uint8_t addr = (result.command >> 4) & 0x0F;
+    uint8_t reg = result.command & 0x03;
+    bool isTalk = (result.command & 0x0C) == CMD_TALK;
+
+    if (isTalk && reg == 0 && result.status == Status::OK) {
+        if (addr == KEYBOARD) collectKeys(port, result.data);
+        else if (addr == MOUSE) collectMotion(port, result.data);
+    }
+    if (isTalk && reg == 3) {
+        uint8_t expected = addr == KEYBOARD ? 2 : 1;
+        if (result.status != Status::OK || (result.data & REG3_HANDLER_MASK) != expected) port.reg3Errors++;
+    }
+
+    // Une écriture des LEDs et une lecture de registre 3 toutes les 50 transactions
+    if (port.results % 50 == 0 && !session->draining) {
+        port.leds = static_cast<uint8_t>((port.leds + 1) & 0x07);
+        port.ledRequests++;
+        session->scheduler->listen(result.bus, KEYBOARD, 2, static_cast<uint16_t>(0xFFF8 | (~port.leds & 0x07)));
+        session->scheduler->talk(result.bus, (port.results / 50) & 1 ? MOUSE : KEYBOARD, 3);
+    }
+}
+
+struct Outcome {
+    adb_multibus_throughput throughput;
+    uint32_t transactions[BUS_COUNT];
+    uint16_t maxLateUs;
+    bool ok;
+};
+
+/**
+ * @brief Interrogation des deux bus par ADBMultiBus
+ */
+Outcome runScheduler(double seconds, uint8_t maxActive, const uint8_t* weights, uint16_t pollIntervalUs,
+                     bool withDevices) {
+    Port ports[BUS_COUNT];
+    setUp(ports, withDevices ? seconds : 0, 2);
+    std::unique_ptr<ADB> hosts[BUS_COUNT];
+    Session session = {ports, nullptr, false};
+    ADBMultiBus scheduler(onResult, &session);
+    session.scheduler = &scheduler;
+    for (uint8_t i = 0; i < BUS_COUNT; i++) {
+        hosts[i].reset(new ADB(PINS[i]));
+        scheduler.addBus(*hosts[i], weights[i]);
+        scheduler.pollDevice(i, KEYBOARD);
+        scheduler.pollDevice(i, MOUSE);
+    }
+    scheduler.setConfig({maxActive, pollIntervalUs, 200});
+    Outcome outcome = {};
+    outcome.ok = scheduler.begin();
+
+    uint64_t end = ADBSim::now() + static_cast<uint64_t>((seconds + 0.2) * 1e9);
+    while (ADBSim::now() < end) {
+        // Temps rendu à la boucle principale pendant les attentes longues
+        uint32_t wait = scheduler.service();
+        delayMicroseconds(wait > 50 ? 50 : wait);
+    }
+    session.draining = true;
+    for (uint8_t i = 0; i < BUS_COUNT; i++) {
+        scheduler.pollDevice(i, KEYBOARD, false);
+        scheduler.pollDevice(i, MOUSE, false);
+    }
+    while (!scheduler.idle()) scheduler.service();
+    outcome.throughput = scheduler.throughput();
+
+    uint32_t errors = 0;
+    for (uint8_t i = 0; i < BUS_COUNT; i++) {
+        const adb_multibus_stats& stats = scheduler.busStats(i);
+        outcome.transactions[i] = stats.transactions;
+        if (stats.maxLateUs > outcome.maxLateUs) outcome.maxLateUs = stats.maxLateUs;
+        errors += stats.bitErrors + stats.busFaults;
+        if (withDevices) outcome.ok &= verify(ports[i], stats.bitErrors + stats.busFaults, true);
+    }
+    if (!withDevices) outcome.ok &= errors == 0;
+    return outcome;
+}
+
+void report(const char* label, const Outcome& outcome) {
+    printf("%-30s: %6lu transactions/s, occupation %lu µs/s sur %lu µs/s actifs (x%.2f), retard maximal %u µs, %s\n",
+           label, static_cast<unsigned long>(outcome.throughput.transactionsPerSecond),
+           static_cast<unsigned long>(outcome.throughput.busyUsPerSecond),
+           static_cast<unsigned long>(outcome.throughput.activeUsPerSecond), outcome.throughput.parallelism / 100.0,
+           outcome.maxLateUs, outcome.ok ? "données intactes" : "ÉCART");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    bool ok = true;
+
+    double blocking = runBlocking(seconds);
+    ok &= blocking > 0;
+
+    const uint8_t equal[BUS_COUNT] = {1, 1};
+    Outcome serial = runScheduler(seconds, 1, equal, 0, true);
+    report("ADBMultiBus, maxActive = 1", serial);
+    Outcome interleaved = runScheduler(seconds, 2, equal, 0, true);
+    report("ADBMultiBus, maxActive = 2", interleaved);
+    double gain = static_cast<double>(interleaved.throughput.transactionsPerSecond) /
+                  serial.throughput.transactionsPerSecond;
+    printf("Gain de l'entrelacement       : x%.2f (x%.2f sur la référence bloquante)\n", gain,
+           interleaved.throughput.transactionsPerSecond / blocking);
+    ok &= serial.ok && interleaved.ok && gain > 1.6 && interleaved.maxLateUs <= 10;
+
+    // Équité: un seul créneau, parts 3 et 1, périphériques sans données (Talk R0 sans réponse)
+    const uint8_t weighted[BUS_COUNT] = {3, 1};
+    Outcome fair = runScheduler(1.0, 1, weighted, 0, false);
+    double ratio = static_cast<double>(fair.transactions[0]) / fair.transactions[1];
+    printf("Parts 3 et 1, maxActive = 1   : %lu et %lu transactions (rapport %.2f)\n",
+           static_cast<unsigned long>(fair.transactions[0]), static_cast<unsigned long>(fair.transactions[1]), ratio);
+    ok &= fair.ok && ratio > 2.8 && ratio < 3.2;
+
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file replay.cpp
+ * @brief Relecture accélérée d'un journal ADBRecorder
+ *
+ * Rejoue un journal d'événements (enregistré sur la cible ou par soak) à
+ * travers ADBHIDReport et ADBKeymap, sans attente entre les événements: le
+ * registre 0 du clavier produit les rapports clavier, celui de la souris les
+ * rapports souris et les écritures Listen du registre 2 l'état des LEDs.
+ * L'empreinte des rapports émis permet de comparer deux versions de la
+ * logique du pont; le débit en événements par seconde sert de mesure de
+ * performance.
+ *
+ * Usage: replay [--repeat N] [--verbose] journal.adbr
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADB.h>
+#include <ADBHIDReport.h>
+#include <ADBRecorder.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t KEYBOARD_TALK_R0 = ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(0);
+constexpr uint8_t MOUSE_TALK_R0 = ADBProtocol::CMD_TALK | ADBProtocol::ADDRESS(ADBKey::Address::MOUSE) | ADBProtocol::REGISTER(0);
+constexpr uint8_t KEYBOARD_LISTEN_R2 = ADBProtocol::CMD_LISTEN | ADBProtocol::ADDRESS(ADBKey::Address::KEYBOARD) | ADBProtocol::REGISTER(2);
+
+/**
+ * @brief Résultat d'une relecture
+ */
+struct ReplayResult {
+    uint64_t events = 0;
+    uint64_t keyboardReports = 0;
+    uint64_t mouseReports = 0;
+    uint64_t ledWrites = 0;
+    uint64_t ignored = 0;         // Événements sans effet sur les rapports (registre 3...)
+    int64_t mouseX = 0;           // Somme des déplacements rapportés
+    int64_t mouseY = 0;
+    uint32_t fingerprint = 2166136261u;  // FNV-1a des rapports émis
+    uint32_t durationUs = 0;      // Durée couverte par le journal
+    bool truncated = false;
+};
+
+void fingerprint(uint32_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+}
+
+ReplayResult replay(const std::vector<uint8_t>& log, bool verbose) {
+    ReplayResult result;
+    ADBHIDReport bridge;
+    ADBRecordReader reader(log.data(), log.size());
+    adb_recorded_event event;
+
+    while (reader.next(event)) {
+        result.events++;
+        result.durationUs = event.atUs;
+
+        if (event.command == KEYBOARD_TALK_R0) {
+            if (bridge.keyboardRegister0(event.value)) {
+                const adb_hid_keyboard_report& report = bridge.keyboardReport();
+                fingerprint(result.fingerprint, &report, sizeof(report));
+                result.keyboardReports++;
+                if (verbose) {
+                    printf("%10lu clavier %02X [%02X %02X %02X %02X %02X %02X]\n",
+                           static_cast<unsigned long>(event.atUs), report.modifiers, report.keys[0], report.keys[1],
+                           report.keys[2], report.keys[3], report.keys[4], report.keys[5]);
+                }
+            }
+        } else if (event.command == MOUSE_TALK_R0) {
+            bridge.mouseRegister0(event.value);
+            adb_hid_mouse_report report;
+            while (bridge.takeMouseReport(report)) {
+                fingerprint(result.fingerprint, &report, sizeof(report));
+                result.mouseReports++;
+                result.mouseX += report.x;
+                result.mouseY += report.y;
+                if (verbose) {
+                    printf("%10lu souris  %u (%d, %d)\n", static_cast<unsigned long>(event.atUs),
+                           report.buttons, report.x, report.y);
+                }
+            }
+        } else if (event.command == KEYBOARD_LISTEN_R2) {
+            bridge.keyboardRegister2Written(event.value);
+            uint8_t leds = bridge.leds();
+            fingerprint(result.fingerprint, &leds, sizeof(leds));
+            result.ledWrites++;
+        } else {
+            result.ignored++;
+        }
+    }
+    result.truncated = reader.truncated();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    unsigned long repeat = 1;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = strtoul(argv[++i], nullptr, 0);
+            if (repeat == 0) repeat = 1;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s [--repeat N] [--verbose] journal.adbr\n", argv[0]);
+        return 2;
+    }
+
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        fprintf(stderr, "Impossible d'ouvrir %s\n", path);
+        return 1;
+    }
+    std::vector<uint8_t> log;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) log.insert(log.end(), chunk, chunk + n);
+    fclose(in);
+
+    if (!ADBRecordReader(log.data(), log.size()).valid()) {
+        fprintf(stderr, "%s: journal ADBR invalide\n", path);
+        return 1;
+    }
+
+    // Chaque passe repart d'un état vide et doit produire la même empreinte
+    ReplayResult result = replay(log, verbose);
+    bool stable = true;
+    auto wallStart = std::chrono::steady_clock::now();
+    for (unsigned long pass = 0; pass < repeat; pass++) {
+        stable &= replay(log, false).fingerprint == result.fingerprint;
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double eventsPerSecond = wallSeconds > 0 ? static_cast<double>(result.events) * repeat / wallSeconds : 0;
+
+    printf("Journal : %zu octets, %llu événements sur %.1f s%s\n", log.size(),
+           static_cast<unsigned long long>(result.events), result.durationUs / 1e6,
+           result.truncated ? " (dernier événement tronqué)" : "");
+    printf("Rapports : %llu clavier, %llu souris, %llu écritures des LEDs, %llu événements ignorés\n",
+           static_cast<unsigned long long>(result.keyboardReports), static_cast<unsigned long long>(result.mouseReports),
+           static_cast<unsigned long long>(result.ledWrites), static_cast<unsigned long long>(result.ignored));
+    printf("Souris : déplacement total (%lld, %lld)\n",
+           static_cast<long long>(result.mouseX), static_cast<long long>(result.mouseY));
+    printf("Empreinte : %08lx%s\n", static_cast<unsigned long>(result.fingerprint), stable ? "" : " (instable)");
+    printf("Débit : %.0f événements/s (%lu passes, %.3f s)\n", eventsPerSecond, repeat, wallSeconds);
+    return stable && !result.truncated ? 0 : 1;
+}
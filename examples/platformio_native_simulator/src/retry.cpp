@@ -0,0 +1,256 @@
+/**
+ * @file retry.cpp
+ * @brief Reprise des lectures en erreur sur une ligne parasitée
+ *
+ * L'hôte interroge clavier et souris sur une ligne parasitée (impulsions de
+ * 0,5 à 5 µs, sans filtre) avec plusieurs réglages d'ADBDevices::setRetryConfig.
+ * Pour chacun, on relève les erreurs de bit rendues à l'appelant et les
+ * reprises: avec un budget suffisant, les erreurs rendues doivent être au
+ * moins dix fois moins nombreuses; avec un budget serré, chaque reprise
+ * réémet au moins une commande complète (attention, synchronisation, 8 bits
+ * et bit d'arrêt), ce qui borne leur nombre par seconde. Sur une ligne
+ * saine, les Talk sans réponse ne sont jamais repris. Sans filtre, un
+ * parasite peut aussi insérer une cellule sans erreur détectable: les pertes
+ * de données sont affichées, seule la ligne saine doit rester intacte.
+ * Enfin, le registre 3 de la souris est relu en boucle, avec et sans double
+ * lecture: les valeurs fausses acceptées doivent être au moins dix fois
+ * moins nombreuses avec la double lecture. Sur une ligne saine, un
+ * changement de handler avec double lecture coûte quatre transactions
+ * (lecture double, Listen, vérification simple) et un handler refusé par la
+ * souris est signalé.
+ *
+ * Usage: retry [secondes simulées par essai]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ADBProtocol;
+
+constexpr uint8_t HOST_PIN = 2;
+constexpr uint32_t POLL_INTERVAL_MS = 5;
+constexpr uint32_t SPIKES_PER_SECOND = 300;
+constexpr uint64_t SPIKE_MIN_NS = 500;
+constexpr uint64_t SPIKE_MAX_NS = 5000;
+constexpr uint32_t REG3_READS = 2000;
+
+// Plus courte reprise: attention, synchronisation, commande et bit d'arrêt
+constexpr uint32_t MIN_RETRY_US = HOST_ATTENTION_US + HOST_SYNC_US + 8 * HOST_CELL_US + 65;
+
+struct Case {
+    const char* label;
+    adb_retry_config config;
+    uint32_t spikesPerSecond;
+};
+
+struct Result {
+    uint32_t errors;    // Erreurs de bit rendues à l'appelant
+    uint32_t retries;   // Reprises comptées par ADB
+    bool intact;        // Données reçues identiques aux données émises
+};
+
+Result run(const Case& c, double seconds) {
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    ADBSim::Noise noise(HOST_PIN, 5);
+    bus.attach(keyboard);
+    bus.attach(mouse);
+    bus.attach(noise);
+
+    uint64_t base = ADBSim::now() / ADBSim::NS_PER_US;
+    uint64_t end = base + static_cast<uint64_t>(seconds * 1e6);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(20000, 80000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng))) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(t + 30000, code, true);
+    }
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), false);
+    }
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    host.init(HOST_PIN, true);
+    devices.setRetryConfig(c.config);
+    host.resetStats();
+    noise.setSpikes(c.spikesPerSecond, SPIKE_MIN_NS, SPIKE_MAX_NS);
+
+    Result result = {};
+    std::vector<uint8_t> received;
+    int64_t movedX = 0;
+    int64_t movedY = 0;
+    while (ADBSim::now() < (end + 200000) * ADBSim::NS_PER_US) {
+        bool error = false;
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) {
+            received.push_back(static_cast<uint8_t>(keyPress.raw >> 8));
+            if ((keyPress.raw & 0xFF) != 0xFF) received.push_back(static_cast<uint8_t>(keyPress.raw & 0xFF));
+        } else if (host.lastStatus() == Status::BIT_ERROR) {
+            result.errors++;
+        }
+        auto data = devices.mouseReadData(&error);
+        if (!error) {
+            movedX += static_cast<int8_t>((data.raw & 0x7F) << 1) >> 1;
+            movedY += static_cast<int8_t>(((data.raw >> 8) & 0x7F) << 1) >> 1;
+        } else if (host.lastStatus() == Status::BIT_ERROR) {
+            result.errors++;
+        }
+        delay(POLL_INTERVAL_MS);
+    }
+    noise.setSpikes(0, 0, 0);
+
+    std::vector<uint8_t> sent;
+    for (const ADBSim::KeyEvent& event : keyboard.delivered()) {
+        sent.push_back(static_cast<uint8_t>(event.code | (event.released ? 0x80 : 0x00)));
+    }
+    result.retries = host.addressStats(ADBKey::Address::KEYBOARD).retries +
+                     host.addressStats(ADBKey::Address::MOUSE).retries;
+    result.intact = received == sent && !sent.empty() && movedX == mouse.deliveredX() && movedY == mouse.deliveredY();
+    return result;
+}
+
+/**
+ * @brief Relectures du registre 3 de la souris sur une ligne parasitée
+ * @param wrong Valeurs fausses acceptées sans erreur
+ * @return Lectures en erreur
+ */
+uint32_t readRegister3(bool readTwice, uint32_t& wrong) {
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Mouse mouse;
+    ADBSim::Noise noise(HOST_PIN, 23);
+    bus.attach(mouse);
+    bus.attach(noise);
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    host.init(HOST_PIN, true);
+    devices.setRetryConfig({3, 30000, 500000, readTwice});
+
+    // Référence lue sur une ligne saine
+    bool error = false;
+    devices.deviceUpdateRegister3(ADBKey::Address::MOUSE, {0}, 0, &error);
+    uint16_t expected = devices.registerShadow(ADBKey::Address::MOUSE).reg3;
+
+    noise.setSpikes(SPIKES_PER_SECOND, SPIKE_MIN_NS, SPIKE_MAX_NS);
+    uint32_t failures = 0;
+    wrong = 0;
+    for (uint32_t i = 0; i < REG3_READS; i++) {
+        // Masque vide: lecture seule, sans écriture
+        devices.invalidateShadow(ADBKey::Address::MOUSE);
+        bool ok = devices.deviceUpdateRegister3(ADBKey::Address::MOUSE, {0}, 0, &error) && !error;
+        if (!ok) failures++;
+        else if (devices.registerShadow(ADBKey::Address::MOUSE).reg3 != expected) wrong++;
+        delay(1);
+    }
+    noise.setSpikes(0, 0, 0);
+    return failures;
+}
+
+/**
+ * @brief Changement de handler de la souris avec double lecture, ligne saine
+ * @param accepted Mise à jour vérifiée
+ * @return Transactions émises vers la souris
+ */
+uint32_t writeHandler(uint8_t handler, bool& accepted) {
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Mouse mouse;
+    bus.attach(mouse);
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    host.init(HOST_PIN, true);
+    devices.setRetryConfig({3, 30000, 500000, true});
+    host.resetStats();
+
+    bool error = false;
+    adb_data<adb_register3> reg3 = {0};
+    reg3.data.device_handler_id = handler;
+    accepted = devices.deviceUpdateRegister3(ADBKey::Address::MOUSE, reg3, REG3_HANDLER_MASK, &error) && !error;
+    return host.addressStats(ADBKey::Address::MOUSE).transactions;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    const Case cases[] = {
+        {"sans reprise", {0, 6000, 20000, false}, SPIKES_PER_SECOND},
+        {"3 reprises", {3, 6000, 100000, false}, SPIKES_PER_SECOND},
+        {"3 reprises, 5 ms/s", {3, 6000, 5000, false}, SPIKES_PER_SECOND},
+        {"ligne saine", {3, 6000, 100000, false}, 0},
+    };
+
+    bool ok = true;
+    printf("Parasites: %lu/s de %llu à %llu ns, sans filtre\n", static_cast<unsigned long>(SPIKES_PER_SECOND),
+           static_cast<unsigned long long>(SPIKE_MIN_NS), static_cast<unsigned long long>(SPIKE_MAX_NS));
+    printf("%-22s %8s %8s %s\n", "Réglage", "Erreurs", "Reprises", "Données");
+    Result baseline = {};
+    for (const Case& c : cases) {
+        Result r = run(c, seconds);
+        bool rowOk = true;
+        if (c.config.maxRetries == 0) {
+            baseline = r;
+            rowOk = r.errors > 0 && r.retries == 0;
+        } else if (c.spikesPerSecond == 0) {
+            // Talk sans réponse (aucune donnée) jamais repris
+            rowOk = r.errors == 0 && r.retries == 0 && r.intact;
+        } else {
+            // Au moins dix fois moins d'erreurs rendues, reprises bornées par le budget par seconde
+            uint32_t allowed = static_cast<uint32_t>(std::ceil(seconds + 0.2)) * (c.config.budgetUsPerSecond / MIN_RETRY_US + 1);
+            rowOk = r.retries > 0 && r.retries <= allowed;
+            if (c.config.budgetUsPerSecond >= 100000) rowOk &= r.errors * 10 <= baseline.errors;
+        }
+        ok &= rowOk;
+        printf("%-22s %8lu %8lu %-8s %s\n", c.label, static_cast<unsigned long>(r.errors),
+               static_cast<unsigned long>(r.retries), r.intact ? "intact" : "pertes", rowOk ? "" : "<-");
+    }
+
+    printf("\nRegistre 3 de la souris, %lu lectures, %lu parasites/s\n", static_cast<unsigned long>(REG3_READS),
+           static_cast<unsigned long>(SPIKES_PER_SECOND));
+    printf("%-22s %8s %8s\n", "Lecture", "Échecs", "Fausses");
+    uint32_t singleWrong = 0;
+    for (bool readTwice : {false, true}) {
+        uint32_t wrong = 0;
+        uint32_t failures = readRegister3(readTwice, wrong);
+        // Double lecture: au moins dix fois moins de valeurs fausses acceptées
+        bool rowOk = failures < REG3_READS / 10;
+        if (!readTwice) rowOk &= (singleWrong = wrong) > 0;
+        else rowOk &= wrong * 10 <= singleWrong;
+        ok &= rowOk;
+        printf("%-22s %8lu %8lu %s\n", readTwice ? "double" : "simple", static_cast<unsigned long>(failures),
+               static_cast<unsigned long>(wrong), rowOk ? "" : "<-");
+    }
+
+    printf("\nChangement de handler de la souris, double lecture\n");
+    printf("%-22s %12s %s\n", "Handler", "Transactions", "Vérifié");
+    for (uint8_t handler : {2, 3}) {
+        bool accepted = false;
+        uint32_t transactions = writeHandler(handler, accepted);
+        // Handler 3 refusé par la souris: la vérification le signale
+        bool rowOk = transactions == 4 && accepted == (handler == 2);
+        ok &= rowOk;
+        printf("%-22u %12lu %-8s %s\n", handler, static_cast<unsigned long>(transactions), accepted ? "oui" : "non",
+               rowOk ? "" : "<-");
+    }
+
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
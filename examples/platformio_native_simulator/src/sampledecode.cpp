@@ -0,0 +1,394 @@
+/**
+ * @file sampledecode.cpp
+ * @brief Décodeur d'échantillons ADBSampleDecoder: fuzzing, mesure et réception simulée
+ *
+ * 1. Fuzzing: paquets synthétiques (gigue des cellules, phase et cadence
+ *    d'échantillonnage, deux rangs d'échantillons) et tampons aléatoires ou
+ *    tronqués. Les paliers extraits mot par mot et le résultat du décodage sont
+ *    comparés à une implémentation de référence échantillon par échantillon.
+ * 2. Mesure: durée de décodage d'un paquet de 16 bits, mot par mot et
+ *    échantillon par échantillon (horloge réelle de la machine).
+ * 3. Réception: un hôte ADB dont readDataPacket passe par un échantillonneur
+ *    simulé interroge le clavier et la souris du simulateur.
+ *
+ * Usage: sampledecode [itérations de fuzzing] [secondes simulées]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBSampleDecoder.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ADBProtocol;
+
+constexpr uint8_t HOST_PIN = 2;
+constexpr uint32_t POLL_INTERVAL_MS = 10;
+
+/**
+ * @brief Tampon d'échantillons en construction
+ */
+struct SampleBuffer {
+    std::vector<uint32_t> words;
+    size_t samples = 0;
+    ADBSampleOrder order = ADBSampleOrder::MSB_FIRST;
+
+    void push(bool level) {
+        if (samples % 32 == 0) words.push_back(0);
+        if (level) {
+            uint8_t bit = samples % 32;
+            words.back() |= order == ADBSampleOrder::MSB_FIRST ? 0x80000000UL >> bit : 1UL << bit;
+        }
+        samples++;
+    }
+
+    bool at(size_t i) const {
+        uint8_t bit = i % 32;
+        uint32_t word = words[i / 32];
+        return order == ADBSampleOrder::MSB_FIRST ? (word >> (31 - bit)) & 1 : (word >> bit) & 1;
+    }
+};
+
+/**
+ * @brief Paliers extraits échantillon par échantillon (référence)
+ */
+std::vector<uint32_t> referenceRuns(const SampleBuffer& buffer, bool& firstLevel) {
+    std::vector<uint32_t> runs;
+    if (buffer.samples == 0) return runs;
+    firstLevel = buffer.at(0);
+    bool level = firstLevel;
+    uint32_t run = 0;
+    for (size_t i = 0; i < buffer.samples; i++) {
+        if (buffer.at(i) != level) {
+            runs.push_back(run);
+            run = 0;
+            level = !level;
+        }
+        run++;
+    }
+    runs.push_back(run);
+    return runs;
+}
+
+/**
+ * @brief Décodage de référence, échantillon par échantillon, mêmes règles que decodePacket
+ */
+Status referenceDecode(const SampleBuffer& buffer, uint32_t rateHz, uint16_t* value, uint8_t length) {
+    uint32_t phaseMax = static_cast<uint32_t>((static_cast<uint64_t>(BIT_PHASE_MAX) * rateHz + 999999) / 1000000);
+    bool first = true;
+    std::vector<uint32_t> runs = referenceRuns(buffer, first);
+    size_t r = 0;
+    if (buffer.samples == 0) return Status::NO_RESPONSE;
+    if (first) {
+        if (runs.size() == 1) return Status::NO_RESPONSE;
+        r++;
+    }
+    uint16_t result = 0;
+    for (uint8_t cell = 0; cell <= length; cell++) {
+        Status failure = cell ? Status::BIT_ERROR : Status::NO_RESPONSE;
+        // Un palier n'est complet que s'il est suivi d'un autre
+        if (r + 1 >= runs.size() || runs[r] > phaseMax) return failure;
+        uint32_t low = runs[r++];
+        if (r + 1 >= runs.size() || runs[r] > phaseMax) return failure;
+        uint32_t high = runs[r++];
+        uint8_t bit = low < high ? 1 : 0;
+        if (cell == 0) {
+            if (!bit) return Status::NO_RESPONSE;
+        } else {
+            result = static_cast<uint16_t>((result << 1) | bit);
+        }
+    }
+    *value = result;
+    return Status::OK;
+}
+
+/**
+ * @brief Paquet synthétique échantillonné: Tlt partiel, bit de début, données, bit d'arrêt, repos
+ */
+SampleBuffer synthesize(std::mt19937& rng, uint32_t rateHz, ADBSampleOrder order, uint16_t value,
+                        uint8_t length, uint32_t leadHighNs) {
+    std::uniform_int_distribution<int> jitter(-4000, 4000);
+    std::uniform_int_distribution<int> cellNs(90000, 110000);
+    std::uniform_real_distribution<double> phase(0.0, 1.0);
+
+    // Fronts en ns: (date, niveau)
+    std::vector<std::pair<uint64_t, bool>> edges;
+    uint64_t t = leadHighNs;
+    auto cell = [&](bool bit) {
+        int64_t period = cellNs(rng);
+        int64_t low = (bit ? 35000 : 65000) * period / 100000 + jitter(rng);
+        edges.push_back({t, false});
+        edges.push_back({t + low, true});
+        t += period;
+    };
+    cell(true);
+    for (int8_t i = length - 1; i >= 0; i--) cell((value >> i) & 1);
+    cell(false);
+    uint64_t end = t + 200000;
+
+    SampleBuffer buffer;
+    buffer.order = order;
+    double periodNs = 1e9 / rateHz;
+    double sampleAt = phase(rng) * periodNs;
+    size_t e = 0;
+    bool level = true;
+    while (sampleAt < end) {
+        while (e < edges.size() && edges[e].first <= sampleAt) level = edges[e++].second;
+        buffer.push(level);
+        sampleAt += periodNs;
+    }
+    return buffer;
+}
+
+/**
+ * @brief Échantillonneur simulé: lit la ligne du bus à cadence fixe sur l'horloge virtuelle
+ */
+class SimSampler : public ADBLineSampler {
+public:
+    SimSampler(ADBSim::Bus& bus, uint32_t rateHz, ADBSampleOrder order)
+        : ADBLineSampler(storage, WORDS, rateHz, order), bus(bus) {}
+
+    size_t capture(size_t samples) override {
+        if (samples > capacity()) samples = capacity();
+        uint64_t start = ADBSim::now();
+        double periodNs = 1e9 / sampleDecoder.sampleRate();
+        for (size_t i = 0; i < (samples + 31) / 32; i++) storage[i] = 0;
+        for (size_t i = 0; i < samples; i++) {
+            uint64_t at = start + static_cast<uint64_t>(i * periodNs);
+            if (ADBSim::now() < at) ADBSim::advance(at - ADBSim::now());
+            if (!bus.line()) continue;
+            uint8_t bit = i % 32;
+            storage[i / 32] |= sampleDecoder.order() == ADBSampleOrder::MSB_FIRST ? 0x80000000UL >> bit : 1UL << bit;
+        }
+        return samples;
+    }
+
+private:
+    static constexpr size_t WORDS = 160;
+    uint32_t storage[WORDS];
+    ADBSim::Bus& bus;
+};
+
+/**
+ * @brief Fuzzing: paquets synthétiques et tampons arbitraires
+ */
+bool fuzz(uint32_t iterations) {
+    std::mt19937 rng(41);
+    std::uniform_int_distribution<int> word(0, 0xFFFF);
+    std::uniform_int_distribution<int> lengthDist(1, 16);
+    std::uniform_int_distribution<int> rateDist(0, 2);
+    std::uniform_int_distribution<int> leadDist(0, 60000);
+    std::uniform_int_distribution<int> density(1, 40);
+    const uint32_t rates[] = {1000000, 2000000, 4000000};
+
+    uint32_t runMismatches = 0;
+    uint32_t decodeMismatches = 0;
+    uint32_t wrongValues = 0;
+    uint32_t synthesized = 0;
+
+    auto compare = [&](const SampleBuffer& buffer, uint32_t rate, uint8_t length) {
+        // Paliers mot par mot contre paliers échantillon par échantillon
+        bool firstLevel = true;
+        std::vector<uint32_t> expected = referenceRuns(buffer, firstLevel);
+        ADBRunReader reader(buffer.words.data(), buffer.samples, buffer.order);
+        bool ok = buffer.samples == 0 || reader.level() == firstLevel;
+        size_t n = 0;
+        for (uint32_t run = reader.next(); run; run = reader.next(), n++) {
+            if (n >= expected.size() || expected[n] != run) ok = false;
+        }
+        if (!ok || n != expected.size()) runMismatches++;
+
+        ADBSampleDecoder decoder(rate, buffer.order);
+        uint16_t fast = 0;
+        uint16_t slow = 0;
+        Status a = decoder.decodePacket(buffer.words.data(), buffer.samples, &fast, length);
+        Status b = referenceDecode(buffer, rate, &slow, length);
+        if (a != b || (a == Status::OK && fast != slow)) decodeMismatches++;
+        return a == Status::OK ? fast : -1;
+    };
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        ADBSampleOrder order = i & 1 ? ADBSampleOrder::LSB_FIRST : ADBSampleOrder::MSB_FIRST;
+        uint32_t rate = rates[rateDist(rng)];
+        uint8_t length = static_cast<uint8_t>(lengthDist(rng));
+        uint16_t value = static_cast<uint16_t>(word(rng) & ((1u << length) - 1));
+
+        // Paquet conforme: la valeur doit être retrouvée
+        SampleBuffer packet = synthesize(rng, rate, order, value, length, static_cast<uint32_t>(leadDist(rng)));
+        if (compare(packet, rate, length) != value) wrongValues++;
+        synthesized++;
+
+        // Même paquet tronqué à une longueur arbitraire
+        SampleBuffer truncated = packet;
+        truncated.samples = std::uniform_int_distribution<size_t>(0, packet.samples)(rng);
+        truncated.words.resize((truncated.samples + 31) / 32);
+        compare(truncated, rate, length);
+
+        // Bruit: probabilité de changement de niveau variable
+        SampleBuffer noise;
+        noise.order = order;
+        size_t samples = std::uniform_int_distribution<size_t>(0, 4000)(rng);
+        bool level = rng() & 1;
+        std::uniform_int_distribution<int> flip(0, 99);
+        int chance = density(rng);
+        for (size_t s = 0; s < samples; s++) {
+            if (flip(rng) < chance) level = !level;
+            noise.push(level);
+        }
+        compare(noise, rate, length);
+    }
+
+    printf("Fuzzing : %lu itérations (%lu paquets, %lu tampons tronqués ou bruités)\n",
+           static_cast<unsigned long>(iterations), static_cast<unsigned long>(synthesized),
+           static_cast<unsigned long>(2 * iterations));
+    printf("  paliers différents : %lu, décodages différents : %lu, valeurs erronées : %lu\n",
+           static_cast<unsigned long>(runMismatches), static_cast<unsigned long>(decodeMismatches),
+           static_cast<unsigned long>(wrongValues));
+    return runMismatches == 0 && decodeMismatches == 0 && wrongValues == 0;
+}
+
+/**
+ * @brief Mesure du décodage d'un paquet de 16 bits
+ */
+void benchmark() {
+    std::mt19937 rng(3);
+    for (uint32_t rate : {1000000u, 2000000u}) {
+        std::vector<SampleBuffer> packets;
+        std::vector<uint16_t> values;
+        for (int i = 0; i < 256; i++) {
+            uint16_t value = static_cast<uint16_t>(rng());
+            packets.push_back(synthesize(rng, rate, ADBSampleOrder::MSB_FIRST, value, 16, 0));
+            values.push_back(value);
+        }
+        ADBSampleDecoder decoder(rate);
+        const int rounds = 200;
+        uint32_t checksum = 0;
+        uint16_t out = 0;
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (const SampleBuffer& p : packets) {
+                decoder.decodePacket(p.words.data(), p.samples, &out, 16);
+                checksum += out;
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (const SampleBuffer& p : packets) {
+                referenceDecode(p, rate, &out, 16);
+                checksum -= out;
+            }
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double count = static_cast<double>(rounds) * packets.size();
+        double fastNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+        double slowNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / count;
+        printf("Mesure %u MHz : %zu échantillons par paquet, %.0f ns mot par mot, %.0f ns échantillon par échantillon (x%.1f)%s\n",
+               rate / 1000000, packets[0].samples, fastNs, slowNs, slowNs / fastNs, checksum ? " ÉCART" : "");
+    }
+}
+
+/**
+ * @brief Réception par échantillonnage face au clavier et à la souris simulés
+ */
+bool simulate(double seconds, ADBSampleOrder order) {
+    uint64_t durationUs = static_cast<uint64_t>(seconds * 1e6);
+    uint64_t startNs = ADBSim::now();
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    bus.attach(keyboard);
+    bus.attach(mouse);
+
+    uint64_t startUs = startNs / ADBSim::NS_PER_US;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(20000, 200000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+    size_t typed = 0;
+    for (uint64_t t = startUs + 100000; t < startUs + durationUs; t += static_cast<uint64_t>(gapUs(rng))) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(t + 50000, code, true);
+        typed += 2;
+    }
+    for (uint64_t t = startUs + 100000; t < startUs + durationUs; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), false);
+    }
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    SimSampler sampler(bus, 1000000, order);
+    host.setSampler(&sampler);
+    if (!host.init(HOST_PIN, true)) {
+        printf("Initialisation du bus impossible\n");
+        return false;
+    }
+    host.resetStats();
+
+    std::vector<uint8_t> received;
+    int64_t movedX = 0;
+    int64_t movedY = 0;
+    while (ADBSim::now() < startNs + (durationUs + 300000) * ADBSim::NS_PER_US) {
+        bool error = false;
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) {
+            received.push_back(static_cast<uint8_t>(keyPress.raw >> 8));
+            if ((keyPress.raw & 0xFF) != 0xFF) received.push_back(static_cast<uint8_t>(keyPress.raw & 0xFF));
+        }
+        auto data = devices.mouseReadData(&error);
+        if (!error) {
+            int8_t x = static_cast<int8_t>((data.raw & 0x7F) << 1) >> 1;
+            int8_t y = static_cast<int8_t>(((data.raw >> 8) & 0x7F) << 1) >> 1;
+            movedX += x;
+            movedY += y;
+        }
+        delay(POLL_INTERVAL_MS);
+    }
+
+    std::vector<uint8_t> sent;
+    for (const ADBSim::KeyEvent& event : keyboard.delivered()) {
+        sent.push_back(static_cast<uint8_t>(event.code | (event.released ? 0x80 : 0x00)));
+    }
+    uint32_t bitErrors = 0;
+    uint32_t talks = 0;
+    for (uint8_t addr = 0; addr < MAX_ADDRESSES; addr++) {
+        bitErrors += host.addressStats(addr).bitErrors;
+        talks += host.addressStats(addr).talks;
+    }
+    bool ok = received == sent && sent.size() == typed && movedX == mouse.deliveredX() &&
+              movedY == mouse.deliveredY() && bitErrors == 0;
+    printf("Réception %s : %lu réponses, %zu touches sur %zu, souris (%lld, %lld) sur (%lld, %lld), %lu erreurs de bit\n",
+           order == ADBSampleOrder::MSB_FIRST ? "MSB" : "LSB", static_cast<unsigned long>(talks), received.size(), typed,
+           static_cast<long long>(movedX), static_cast<long long>(movedY),
+           static_cast<long long>(mouse.deliveredX()), static_cast<long long>(mouse.deliveredY()),
+           static_cast<unsigned long>(bitErrors));
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t iterations = argc > 1 ? static_cast<uint32_t>(atol(argv[1])) : 20000;
+    double seconds = argc > 2 ? atof(argv[2]) : 10.0;
+
+    bool ok = fuzz(iterations);
+    benchmark();
+    ok &= simulate(seconds, ADBSampleOrder::MSB_FIRST);
+    ok &= simulate(seconds, ADBSampleOrder::LSB_FIRST);
+
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,344 @@
+/**
+ * @file shiftout.cpp
+ * @brief Émission par décalage (ADBWaveform, ADBShiftDriver) sur le simulateur
+ *
+ * 1. Motifs: pour chaque commande et des paquets de données aléatoires, à
+ *    plusieurs cadences de décalage, les fronts relus avec ADBRunReader sont
+ *    comparés aux dates nominales (écart au plus d'une demi-période), puis
+ *    décodés par ADBFrameDecoder et ADBSampleDecoder.
+ *    Un motif dont un palier sort de ±3% doit être signalé (distorted).
+ * 2. Émission: writeCommand rend la main avant la fin du motif, waitTLT
+ *    attend le périphérique; à 125 kHz les motifs sont refusés.
+ * 3. Bus: un hôte ADB dont writeCommand et writeDataPacket passent par un
+ *    périphérique de décalage simulé interroge le clavier et la souris,
+ *    écrit les LEDs et lit les registres 3.
+ *
+ * Usage: shiftout [secondes simulées]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBFrameDecoder.h>
+#include <ADBWaveform.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ADBProtocol;
+
+constexpr uint8_t HOST_PIN = 2;
+constexpr uint32_t POLL_INTERVAL_MS = 10;
+constexpr size_t PATTERN_WORDS = 256;
+
+/**
+ * @brief Fronts d'un motif: (date en µs, niveau après le front)
+ */
+std::vector<std::pair<double, bool>> edgesOf(const ADBWaveform& pattern) {
+    std::vector<std::pair<double, bool>> edges;
+    ADBRunReader runs(pattern.data(), pattern.bits(), pattern.order());
+    double periodUs = 1e6 / pattern.shiftRate();
+    size_t position = 0;
+    bool level = runs.level();
+    for (uint32_t run = runs.next(); run; run = runs.next()) {
+        edges.push_back({position * periodUs, level});
+        position += run;
+        level = !level;
+    }
+    edges.push_back({position * periodUs, true});
+    return edges;
+}
+
+/**
+ * @brief Fronts nominaux d'une suite de cellules à partir de t
+ */
+void nominalCells(std::vector<std::pair<double, bool>>& edges, double& t, uint32_t bits, uint8_t length) {
+    for (int8_t i = length - 1; i >= 0; i--) {
+        bool bit = (bits >> i) & 1;
+        edges.push_back({t, false});
+        edges.push_back({t + (bit ? 35 : 65), true});
+        t += 100;
+    }
+}
+
+/**
+ * @brief Plus grand écart entre fronts obtenus et nominaux (infini si leur nombre diffère)
+ */
+double worstError(const std::vector<std::pair<double, bool>>& actual,
+                  const std::vector<std::pair<double, bool>>& nominal, double* worstPhase = nullptr) {
+    // Le dernier front nominal (remontée du bit d'arrêt) suffit: la fin du motif est au repos
+    if (actual.size() != nominal.size() + 1) return INFINITY;
+    double worst = 0;
+    for (size_t i = 0; i < nominal.size(); i++) {
+        if (actual[i].second != nominal[i].second) return INFINITY;
+        worst = std::max(worst, std::fabs(actual[i].first - nominal[i].first));
+        // Écart relatif de chaque palier à sa durée nominale
+        if (worstPhase && i > 0) {
+            double length = nominal[i].first - nominal[i - 1].first;
+            double emitted = actual[i].first - actual[i - 1].first;
+            *worstPhase = std::max(*worstPhase, std::fabs(emitted - length) / length);
+        }
+    }
+    return worst;
+}
+
+struct DecodedFrame {
+    bool seen = false;
+    adb_frame frame = {};
+};
+
+void onFrame(void* context, const adb_frame& frame) {
+    DecodedFrame* decoded = static_cast<DecodedFrame*>(context);
+    decoded->seen = true;
+    decoded->frame = frame;
+}
+
+/**
+ * @brief Vérifie les motifs de toutes les commandes et de paquets aléatoires à une cadence
+ */
+bool checkPatterns(uint32_t rateHz) {
+    static uint32_t storage[PATTERN_WORDS];
+    ADBWaveform pattern(storage, PATTERN_WORDS, rateHz);
+    double halfPeriodUs = 0.5e6 / rateHz + 1e-6;
+    double worst = 0;
+    double worstPhase = 0;
+    bool distorted = false;
+    uint32_t failures = 0;
+
+    for (uint16_t command = 0; command < 256; command++) {
+        pattern.command(static_cast<uint8_t>(command));
+        std::vector<std::pair<double, bool>> nominal = {{0, false}, {800, true}};
+        double t = 870;
+        nominalCells(nominal, t, static_cast<uint32_t>(command << 1), 9);
+        double error = worstError(edgesOf(pattern), nominal, &worstPhase);
+        worst = std::max(worst, error);
+        distorted |= pattern.distorted();
+
+        // Relecture par le décodeur de trames, avec les dates arrondies à la microseconde
+        DecodedFrame decoded;
+        ADBFrameDecoder decoder(onFrame, &decoded);
+        for (const auto& edge : edgesOf(pattern)) decoder.edge(static_cast<uint32_t>(edge.first + 0.5), edge.second);
+        decoder.finish();
+        uint16_t timing = ADBFrameFlag::ATTENTION_TIMING | ADBFrameFlag::SYNC_TIMING | ADBFrameFlag::BIT_TIMING |
+                          ADBFrameFlag::COMMAND_TRUNCATED;
+        if (error > halfPeriodUs || pattern.overflowed() || !decoded.seen || decoded.frame.command != command ||
+            (decoded.frame.flags & timing)) {
+            failures++;
+        }
+    }
+
+    std::mt19937 rng(rateHz);
+    ADBSampleDecoder sampleDecoder(rateHz, pattern.order());
+    for (int i = 0; i < 256; i++) {
+        uint16_t value = static_cast<uint16_t>(rng());
+        pattern.dataPacket(value, 16);
+        std::vector<std::pair<double, bool>> nominal;
+        double t = 0;
+        nominalCells(nominal, t, (1u << 17) | (static_cast<uint32_t>(value) << 1), 18);
+        double error = worstError(edgesOf(pattern), nominal, &worstPhase);
+        worst = std::max(worst, error);
+        distorted |= pattern.distorted();
+
+        uint16_t decoded = 0;
+        Status status = sampleDecoder.decodePacket(pattern.data(), pattern.bits(), &decoded, 16);
+        if (error > halfPeriodUs || status != Status::OK || decoded != value) failures++;
+    }
+
+    // Refus du motif exactement quand un palier sort de ±3%
+    bool consistent = distorted == (worstPhase * 1000 > HOST_TOLERANCE_PERMILLE + 1e-6);
+    pattern.command(0x2C);
+    printf("Motifs %7lu Hz : %4zu bits par commande, écart maximal %.2f µs (demi-période %.2f µs), "
+           "palier %.1f%% %s, %lu échecs\n",
+           static_cast<unsigned long>(rateHz), pattern.bits(), worst, halfPeriodUs, worstPhase * 100,
+           distorted ? "refusé" : "émis", static_cast<unsigned long>(failures));
+    return failures == 0 && consistent;
+}
+
+/**
+ * @brief Périphérique de décalage simulé: restitue le motif sur la ligne du bus
+ */
+class SimShiftDriver : public ADBSim::Device, public ADBShiftDriver {
+public:
+    SimShiftDriver(uint32_t rateHz) : ADBShiftDriver(storage, PATTERN_WORDS, rateHz, ADBSampleOrder::LSB_FIRST) {}
+
+    bool start(uint32_t* words, size_t bits) override {
+        uint64_t periodNs = 1000000000ULL / pattern.shiftRate();
+        uint64_t t = ADBSim::now();
+        ADBRunReader runs(words, bits, pattern.order());
+        bool level = runs.level();
+        for (uint32_t run = runs.next(); run; run = runs.next()) {
+            drive(t, level);
+            t += run * periodNs;
+            level = !level;
+        }
+        drive(t, true);
+        end = t;
+        shifts++;
+        return true;
+    }
+
+    bool busy() override {
+        // Le processeur est libre: seul le temps passe pendant le décalage
+        micros();
+        return ADBSim::now() < end;
+    }
+
+    uint32_t transfers() const { return shifts; }
+    uint64_t endNs() const { return end; }
+
+private:
+    uint32_t storage[PATTERN_WORDS];
+    uint64_t end = 0;
+    uint32_t shifts = 0;
+};
+
+/**
+ * @brief Transactions complètes émises par décalage face au clavier et à la souris simulés
+ */
+bool simulate(double seconds) {
+    uint64_t durationUs = static_cast<uint64_t>(seconds * 1e6);
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    SimShiftDriver shifter(200000);
+    bus.attach(keyboard);
+    bus.attach(mouse);
+    bus.attach(shifter);
+
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(20000, 200000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+    for (uint64_t t = 100000; t < durationUs; t += static_cast<uint64_t>(gapUs(rng))) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(t + 50000, code, true);
+    }
+    for (uint64_t t = 100000; t < durationUs; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), false);
+    }
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    host.setTransmitter(&shifter);
+    if (!host.init(HOST_PIN, true)) {
+        printf("Initialisation du bus impossible\n");
+        return false;
+    }
+    host.resetStats();
+
+    std::vector<uint8_t> received;
+    int64_t movedX = 0;
+    int64_t movedY = 0;
+    uint64_t polls = 0;
+    uint8_t leds = 0;
+    uint32_t reg3Errors = 0;
+    while (ADBSim::now() < (durationUs + 300000) * ADBSim::NS_PER_US) {
+        bool error = false;
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) {
+            received.push_back(static_cast<uint8_t>(keyPress.raw >> 8));
+            if ((keyPress.raw & 0xFF) != 0xFF) received.push_back(static_cast<uint8_t>(keyPress.raw & 0xFF));
+        }
+        auto data = devices.mouseReadData(&error);
+        if (!error) {
+            movedX += static_cast<int8_t>((data.raw & 0x7F) << 1) >> 1;
+            movedY += static_cast<int8_t>(((data.raw >> 8) & 0x7F) << 1) >> 1;
+        }
+
+        if (++polls % 100 == 0) {
+            // Listen R2 (paquet de données émis par décalage) puis relecture du registre 3 de la souris
+            leds = static_cast<uint8_t>((leds + 1) & 0x07);
+            devices.keyboardWriteLEDs(leds & 0x01, leds & 0x02, leds & 0x04);
+            devices.flushPendingWrites();
+            uint16_t reg3 = 0;
+            host.writeCommand(CMD_TALK | ADDRESS(ADBKey::Address::MOUSE) | REGISTER(3));
+            host.waitTLT(true);
+            if (!host.readDataPacket(&reg3, 16) || (reg3 & REG3_HANDLER_MASK) != 1) reg3Errors++;
+        }
+        delay(POLL_INTERVAL_MS);
+    }
+
+    std::vector<uint8_t> sent;
+    for (const ADBSim::KeyEvent& event : keyboard.delivered()) {
+        sent.push_back(static_cast<uint8_t>(event.code | (event.released ? 0x80 : 0x00)));
+    }
+    uint32_t transactions = 0;
+    uint32_t bitErrors = 0;
+    for (uint8_t addr = 0; addr < MAX_ADDRESSES; addr++) {
+        transactions += host.addressStats(addr).transactions;
+        bitErrors += host.addressStats(addr).bitErrors;
+    }
+    uint32_t deviceCommands = keyboard.stats().commands + mouse.stats().commands;
+    uint8_t expectedLeds = static_cast<uint8_t>(~leds & 0x07);
+    bool ok = received == sent && !sent.empty() && movedX == mouse.deliveredX() && movedY == mouse.deliveredY() &&
+              bitErrors == 0 && reg3Errors == 0 && (keyboard.register2() & 0x07) == expectedLeds &&
+              keyboard.ledWrites() == polls / 100 && deviceCommands == transactions;
+
+    printf("Bus : %lu transactions, %lu décalages, %lu commandes reçues par les périphériques\n",
+           static_cast<unsigned long>(transactions), static_cast<unsigned long>(shifter.transfers()),
+           static_cast<unsigned long>(deviceCommands));
+    printf("      %zu touches sur %zu, souris (%lld, %lld) sur (%lld, %lld), %lu écritures de LEDs, %lu erreurs\n",
+           received.size(), sent.size(), static_cast<long long>(movedX), static_cast<long long>(movedY),
+           static_cast<long long>(mouse.deliveredX()), static_cast<long long>(mouse.deliveredY()),
+           static_cast<unsigned long>(keyboard.ledWrites()), static_cast<unsigned long>(bitErrors + reg3Errors));
+    return ok;
+}
+
+/**
+ * @brief Émission rendue avant la fin du motif, motifs refusés à une cadence trop lente
+ */
+bool checkTransmitter() {
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Keyboard keyboard;
+    SimShiftDriver fast(200000);
+    SimShiftDriver slow(125000);
+    bus.attach(keyboard);
+    bus.attach(fast);
+    bus.attach(slow);
+
+    ADB host(HOST_PIN);
+    host.setTransmitter(&fast);
+    host.init(HOST_PIN, true);
+
+    // writeCommand rend la main pendant le décalage, waitTLT attend sa fin
+    uint16_t reg3 = 0;
+    host.writeCommand(CMD_TALK | ADDRESS(ADBKey::Address::KEYBOARD) | REGISTER(3));
+    bool returned = ADBSim::now() < fast.endNs();
+    uint64_t commandEnd = fast.endNs();
+    host.waitTLT(true);
+    bool answered = ADBSim::now() > commandEnd && host.readDataPacket(&reg3, 16);
+
+    // 8 µs par bit: la partie courte d'une cellule ne tombe pas à ±3%, rien n'est émis
+    host.setTransmitter(&slow);
+    host.writeCommand(CMD_TALK | ADDRESS(ADBKey::Address::KEYBOARD) | REGISTER(3));
+    host.waitTLT(true);
+    bool refused = host.lastStatus() == Status::BUS_FAULT && slow.transfers() == 0;
+
+    printf("Émission : retour avant la fin du motif %s, réponse %s, 125 kHz %s\n", returned ? "oui" : "non",
+           answered ? "lue" : "absente", refused ? "refusé" : "accepté");
+    return returned && answered && refused;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 10.0;
+
+    bool ok = true;
+    for (uint32_t rate : {100000u, 200000u, 230400u, 281250u, 1000000u, 1125000u, 3000000u}) ok &= checkPatterns(rate);
+    ok &= checkTransmitter();
+    ok &= simulate(seconds);
+
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file sniff.cpp
+ * @brief Écoute passive d'un bus ADB sur le simulateur
+ *
+ * Un premier hôte (ADB sur la broche 2) interroge un clavier et une souris
+ * simulés, écrit les LEDs et lit les registres 3. Une seconde instance ADB,
+ * reliée à la même ligne par la broche 3, l'écoute en mode passif: les
+ * transactions décodées par interruption sont comparées à celles que l'hôte
+ * a effectivement échangées (réponses aux Talk, données des Listen, SRQ).
+ *
+ * Usage: sniff [secondes] [--verbose]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBSniffer.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t HOST_PIN = 2;
+constexpr uint8_t SNIFFER_PIN = 3;
+constexpr uint32_t POLL_INTERVAL_MS = 10;
+
+using namespace ADBProtocol;
+constexpr uint8_t KEYBOARD_TALK_R0 = CMD_TALK | ADDRESS(ADBKey::Address::KEYBOARD) | REGISTER(0);
+constexpr uint8_t MOUSE_TALK_R0 = CMD_TALK | ADDRESS(ADBKey::Address::MOUSE) | REGISTER(0);
+constexpr uint8_t MOUSE_TALK_R3 = CMD_TALK | ADDRESS(ADBKey::Address::MOUSE) | REGISTER(3);
+
+/**
+ * @brief Registre échangé (vu par l'hôte ou par l'écoute)
+ */
+struct Exchange {
+    uint8_t command;
+    uint16_t value;
+};
+
+/**
+ * @brief Génère un flux de frappes et de mouvements
+ */
+void scriptTraffic(ADBSim::Keyboard& keyboard, ADBSim::Mouse& mouse, uint64_t durationUs) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(20000, 250000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+
+    for (uint64_t t = 100000; t < durationUs; t += static_cast<uint64_t>(gapUs(rng))) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(t + 60000, code, true);
+        t += 60000;
+    }
+    for (uint64_t t = 100000; t < durationUs; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), (t / 1000000) % 2);
+    }
+}
+
+void printFrame(const adb_frame& frame) {
+    printf("%10lu %-9s", static_cast<unsigned long>(frame.startUs), frame.commandName());
+    if (frame.type == ADBFrameType::COMMAND) {
+        printf(" adr %2u R%u", frame.address(), frame.reg());
+        for (uint8_t i = 0; i < frame.dataBytes(); i++) printf(" %02X", frame.data[i]);
+        if (frame.srq()) printf(" SRQ");
+    }
+    if (frame.flags) printf(" anomalies 0x%04X", frame.flags);
+    printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = 30.0;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            seconds = atof(argv[i]);
+        }
+    }
+    uint64_t durationUs = static_cast<uint64_t>(seconds * 1e6);
+
+    ADBSim::Bus bus(HOST_PIN);
+    bus.addPin(SNIFFER_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    bus.attach(keyboard);
+    bus.attach(mouse);
+    scriptTraffic(keyboard, mouse, durationUs);
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    if (!host.init(HOST_PIN, true)) {
+        printf("Initialisation du bus impossible\n");
+        return 1;
+    }
+
+    // Écoute passive sur la même ligne: aucune commande ne doit sortir de cette instance
+    ADB listener(SNIFFER_PIN);
+    static ADBSnifferBuffer<32> sniffer;
+    if (!listener.beginSniffing(sniffer)) {
+        printf("Écoute impossible\n");
+        return 1;
+    }
+    uint64_t edgesBefore = bus.edgeCount();
+    listener.writeCommand(CMD_TALK | ADDRESS(ADBKey::Address::KEYBOARD) | REGISTER(3));
+    bool refused = !listener.waitTLT(true) && listener.lastStatus() == Status::BUS_FAULT &&
+                   !listener.reset() && bus.edgeCount() == edgesBefore;
+
+    std::vector<Exchange> hostSide;
+    std::vector<Exchange> sniffed;
+    uint32_t sniffedSrqs = 0;
+    uint32_t anomalies = 0;
+    uint32_t listens = 0;
+    uint64_t polls = 0;
+    bool caps = false;
+    adb_frame frame;
+
+    while (ADBSim::now() < durationUs * ADBSim::NS_PER_US) {
+        bool error = false;
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) hostSide.push_back({KEYBOARD_TALK_R0, keyPress.raw});
+        auto mouseData = devices.mouseReadData(&error);
+        if (!error) hostSide.push_back({MOUSE_TALK_R0, mouseData.raw});
+
+        polls++;
+        if (polls % 200 == 0) {
+            // Lecture directe du registre 3 de la souris et écriture des LEDs
+            uint16_t reg3 = 0;
+            host.writeCommand(MOUSE_TALK_R3);
+            host.waitTLT(true);
+            if (host.readDataPacket(&reg3, 16)) hostSide.push_back({MOUSE_TALK_R3, reg3});
+            caps = !caps;
+            devices.keyboardWriteLEDs(false, caps, false);
+            devices.flushPendingWrites();
+            listens++;
+        }
+
+        delay(POLL_INTERVAL_MS);
+        sniffer.service();
+        while (sniffer.read(frame)) {
+            if (verbose) printFrame(frame);
+            if (frame.flags) anomalies++;
+            if (frame.type != ADBFrameType::COMMAND) continue;
+            if (frame.srq()) sniffedSrqs++;
+            if (frame.dataBits == 16) {
+                uint16_t value = static_cast<uint16_t>((frame.data[0] << 8) | frame.data[1]);
+                if ((frame.command & 0x0C) == CMD_LISTEN) {
+                    // Les Listen sont comptés à part: l'hôte ne les consigne pas
+                    if ((frame.command & 0x03) == 2) listens--;
+                    continue;
+                }
+                sniffed.push_back({frame.command, value});
+            }
+        }
+    }
+    listener.endSniffing();
+
+    size_t mismatches = hostSide.size() > sniffed.size() ? hostSide.size() - sniffed.size()
+                                                         : sniffed.size() - hostSide.size();
+    for (size_t i = 0; i < hostSide.size() && i < sniffed.size(); i++) {
+        if (hostSide[i].command != sniffed[i].command || hostSide[i].value != sniffed[i].value) mismatches++;
+    }
+    uint32_t hostSrqs = host.srqs();
+
+    printf("Temps simulé : %.1f s, %lu fronts, %lu transactions observées, %lu perdues\n",
+           ADBSim::now() / 1e9, static_cast<unsigned long>(sniffer.edges()),
+           static_cast<unsigned long>(sniffer.frames()), static_cast<unsigned long>(sniffer.overruns()));
+    printf("Réponses : %zu côté hôte, %zu décodées par l'écoute, %zu écarts\n",
+           hostSide.size(), sniffed.size(), mismatches);
+    printf("SRQ : %lu vus par l'hôte, %lu par l'écoute\n",
+           static_cast<unsigned long>(hostSrqs), static_cast<unsigned long>(sniffedSrqs));
+    printf("Listen R2 non décodés : %lu, anomalies : %lu\n",
+           static_cast<unsigned long>(listens), static_cast<unsigned long>(anomalies));
+    printf("Commande refusée en écoute : %s\n", refused ? "oui" : "non");
+
+    bool ok = mismatches == 0 && hostSrqs == sniffedSrqs && listens == 0 && anomalies == 0 &&
+              sniffer.overruns() == 0 && refused;
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
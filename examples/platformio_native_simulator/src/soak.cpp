@@ -0,0 +1,211 @@
+/**
+ * @file soak.cpp
+ * @brief Test d'endurance de la bibliothèque ADB sur le simulateur de bus
+ *
+ * Un clavier et une souris simulés reçoivent des flux aléatoires de frappes et
+ * de mouvements couvrant plusieurs heures de temps virtuel. Le code réel de
+ * ADB et ADBDevices les interroge comme sur la cible; les événements décodés
+ * par l'hôte sont comparés à ceux effectivement émis par les périphériques,
+ * de même que le mouvement cumulé de l'état publié (readSnapshot).
+ *
+ * Usage: soak [heures] [graine] [journal.adbr]
+ *
+ * Avec un chemin de journal, les événements reçus sont consignés par
+ * ADBRecorder pour être rejoués par le programme replay.
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBTrace.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+constexpr uint8_t ADB_PIN = 2;
+constexpr uint32_t POLL_INTERVAL_MS = 10;
+constexpr size_t RECORDER_SIZE = 65536;
+
+/**
+ * @brief Génère les flux scriptés du clavier et de la souris
+ */
+void scriptTraffic(ADBSim::Keyboard& keyboard, ADBSim::Mouse& mouse, uint64_t durationUs, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::exponential_distribution<double> keyGap(1.0 / 150000.0);   // Une frappe toutes les 150 ms en moyenne
+    std::exponential_distribution<double> moveGap(1.0 / 30000.0);   // Un mouvement toutes les 30 ms en moyenne
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);         // 0x7F est réservé (Power / emplacement vide)
+    std::uniform_int_distribution<int> holdUs(20000, 200000);
+    std::uniform_int_distribution<int> motion(-90, 90);
+    std::bernoulli_distribution toggleButton(0.05);
+
+    // Les appuis sont relâchés avant l'appui suivant pour garder un flux ordonné
+    uint64_t t = 1000000;
+    while (t < durationUs) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        uint64_t release = t + static_cast<uint64_t>(holdUs(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(release, code, true);
+        t = release + static_cast<uint64_t>(keyGap(rng));
+    }
+
+    bool button = false;
+    t = 1000000;
+    while (t < durationUs) {
+        if (toggleButton(rng)) button = !button;
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), button);
+        t += static_cast<uint64_t>(moveGap(rng));
+    }
+    mouse.script(durationUs, 0, 0, false);
+}
+
+/**
+ * @brief Valeur signée sur 7 bits transmise par la souris
+ */
+int8_t mouseAxis(uint8_t value) {
+    return static_cast<int8_t>(static_cast<uint8_t>(value << 1)) >> 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 1.0;
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : 1;
+    uint64_t durationUs = static_cast<uint64_t>(hours * 3600.0 * 1e6);
+
+    ADBSim::Bus bus(ADB_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    bus.attach(keyboard);
+    bus.attach(mouse);
+    scriptTraffic(keyboard, mouse, durationUs, seed);
+
+    ADB adb(ADB_PIN);
+    ADBDevices devices(adb);
+    ADBLatencyTracker latency;
+    devices.setLatencyTracker(&latency);
+
+    // Journal optionnel, vidé dans le fichier à mi-capacité
+    static ADBRecorderBuffer<RECORDER_SIZE> recorder;
+    FILE* logFile = argc > 3 ? fopen(argv[3], "wb") : nullptr;
+    if (argc > 3 && !logFile) {
+        printf("Impossible de créer %s\n", argv[3]);
+        return 1;
+    }
+    FileOutput logOutput(logFile);
+    if (logFile) devices.setRecorder(&recorder);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    if (!adb.init(ADB_PIN, true)) {
+        printf("Initialisation du bus impossible\n");
+        return 1;
+    }
+
+    std::vector<ADBSim::KeyEvent> received;
+    int64_t mouseX = 0;
+    int64_t mouseY = 0;
+    uint64_t polls = 0;
+    uint64_t errors = 0;
+    uint64_t ledToggles = 0;
+    bool caps = false;
+
+    // Boucle de lecture, puis vidange des événements restants
+    while (ADBSim::now() < durationUs * ADBSim::NS_PER_US || keyboard.pendingEvents() > 0) {
+        bool error = false;
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) {
+            // Un emplacement vide vaut 0xFF (code 0x7F relâché)
+            if (!(keyPress.data.key0 == 0x7F && keyPress.data.released0)) {
+                received.push_back({ADBSim::now(), keyPress.data.key0, keyPress.data.released0});
+            }
+            if (!(keyPress.data.key1 == 0x7F && keyPress.data.released1)) {
+                received.push_back({ADBSim::now(), keyPress.data.key1, keyPress.data.released1});
+            }
+            latency.reportSent(ADBLatencyPath::KEYBOARD);
+        } else if (adb.lastStatus() != ADBProtocol::Status::NO_RESPONSE) {
+            // Chronologie de la première transaction en échec (env:soak_trace)
+            if (errors++ == 0) adbTraceDump(Serial);
+        }
+
+        auto mouseData = devices.mouseReadData(&error);
+        if (!error) {
+            mouseX += mouseAxis(mouseData.data.x_offset);
+            mouseY += mouseAxis(mouseData.data.y_offset);
+            latency.reportSent(ADBLatencyPath::MOUSE);
+        } else if (adb.lastStatus() != ADBProtocol::Status::NO_RESPONSE) {
+            if (errors++ == 0) adbTraceDump(Serial);
+        }
+
+        // Écriture périodique des LEDs (différée puis vidée après une lecture)
+        if (++polls % 1000 == 0) {
+            caps = !caps;
+            devices.keyboardWriteLEDs(false, caps, false);
+            ledToggles++;
+        }
+        if (logFile && recorder.pending() > RECORDER_SIZE / 2) recorder.drain(logOutput);
+
+        delay(POLL_INTERVAL_MS);
+    }
+    devices.flushPendingWrites();
+    if (logFile) {
+        recorder.drain(logOutput);
+        fclose(logFile);
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simSeconds = static_cast<double>(ADBSim::now()) / 1e9;
+
+    // Comparaison des flux émis et décodés
+    const std::vector<ADBSim::KeyEvent>& sent = keyboard.delivered();
+    size_t keyMismatches = sent.size() > received.size() ? sent.size() - received.size() : received.size() - sent.size();
+    for (size_t i = 0; i < sent.size() && i < received.size(); i++) {
+        if (sent[i].code != received[i].code || sent[i].released != received[i].released) keyMismatches++;
+    }
+    // Cumul local et état publié par ADBDevices
+    adb_device_snapshot snapshot;
+    devices.readSnapshot(snapshot);
+    bool mouseMatches = mouseX == mouse.deliveredX() && mouseY == mouse.deliveredY() &&
+                        snapshot.mouseX == mouse.deliveredX() && snapshot.mouseY == mouse.deliveredY();
+    bool ledsMatch = ((~keyboard.register2() >> 1) & 0x01) == (caps ? 1u : 0u);
+
+    printf("Temps simulé : %.1f s (%.2f h)\n", simSeconds, simSeconds / 3600.0);
+    printf("Temps réel   : %.2f s (x%.0f)\n", wallSeconds, simSeconds / wallSeconds);
+    printf("Interrogations : %llu, erreurs de bit : %llu\n",
+           static_cast<unsigned long long>(polls), static_cast<unsigned long long>(errors));
+    printf("Clavier : %zu événements émis, %zu décodés, %zu écarts\n", sent.size(), received.size(), keyMismatches);
+    printf("Souris  : émis (%lld, %lld), décodés (%lld, %lld), publiés (%ld, %ld)\n",
+           static_cast<long long>(mouse.deliveredX()), static_cast<long long>(mouse.deliveredY()),
+           static_cast<long long>(mouseX), static_cast<long long>(mouseY), static_cast<long>(snapshot.mouseX),
+           static_cast<long>(snapshot.mouseY));
+    printf("LEDs    : %llu écritures demandées, %u reçues, état %s\n",
+           static_cast<unsigned long long>(ledToggles), keyboard.ledWrites(), ledsMatch ? "cohérent" : "incohérent");
+    printf("SRQ     : clavier %u, souris %u\n", keyboard.stats().srqs, mouse.stats().srqs);
+    for (uint8_t addr : {ADBKey::Address::KEYBOARD, ADBKey::Address::MOUSE}) {
+        const adb_address_stats& st = adb.addressStats(addr);
+        printf("Adresse %u : %lu transactions, %lu réponses, %lu sans réponse, %lu erreurs de bit, %lu µs/s\n",
+               addr, static_cast<unsigned long>(st.transactions), static_cast<unsigned long>(st.talks),
+               static_cast<unsigned long>(st.noResponse), static_cast<unsigned long>(st.bitErrors),
+               static_cast<unsigned long>(st.busyUsPerSecond));
+    }
+    printf("SRQ vus par l'hôte : %lu\n", static_cast<unsigned long>(adb.srqs()));
+    uint8_t statsBuffer[sizeof(adb_stats_header) + ADBProtocol::MAX_ADDRESSES * sizeof(adb_stats_record)];
+    printf("Export des statistiques : %zu octets, bus occupé %lu µs/s\n",
+           adb.exportStats(statsBuffer, sizeof(statsBuffer)), static_cast<unsigned long>(adb.busyUsPerSecond()));
+    if (logFile) {
+        printf("Journal : %lu événements consignés, %lu perdus\n",
+               static_cast<unsigned long>(recorder.recorded()), static_cast<unsigned long>(recorder.dropped()));
+    }
+    printf("Latence événement -> lecture (µs, classes log2) :\n");
+    latency.dump(Serial);
+    Serial.flush();
+
+    bool ok = keyMismatches == 0 && mouseMatches && ledsMatch && errors == 0 && recorder.dropped() == 0;
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file timing.cpp
+ * @brief Précision et conformité des temporisations émises sur le simulateur
+ *
+ * 1. Auto-test: rapport d'ADBClock::selfTest, avec une broche libre pilotée
+ *    à chaque demi-cellule comme la broche ADB.
+ * 2. Bus: pour chaque profil (ADBHostTiming::DEFAULT et FAST), l'hôte émet
+ *    une commande Listen puis un paquet de 16 bits sur une ligne sans
+ *    périphérique, avec et sans capture des fronts. Les fronts observés sur
+ *    la ligne sont comparés aux durées du profil (attention, synchronisation,
+ *    chaque cellule, commande de 8 cellules, paquet de 17 cellules jusqu'au
+ *    bit d'arrêt), puis aux tolérances de la spécification: attention,
+ *    synchronisation et cellules à ±3%, part courte entre 30 et 40%.
+ * 3. Périphériques: pour chaque profil, l'hôte change le handler de la
+ *    souris puis interroge clavier et souris; les données reçues doivent être
+ *    intactes. La durée du changement de handler et celle d'une commande
+ *    sont comparées d'un profil à l'autre.
+ *
+ * Usage: timing [secondes simulées par essai]
+ *
+ * @author Clément SAILLANT - L'électron rare
+ * @copyright Copyright (C) 2025 Clément SAILLANT
+ * @license GNU GPL v3
+ */
+
+#include <Arduino.h>
+#include <ADBSim.h>
+#include <ADB.h>
+#include <ADBTiming.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ADBProtocol;
+
+constexpr uint8_t HOST_PIN = 2;
+constexpr uint8_t SELF_TEST_PIN = 5;
+constexpr uint32_t POLL_INTERVAL_MS = 5;
+constexpr int64_t TOLERANCE_NS = 1000;
+constexpr int64_t US = ADBSim::NS_PER_US;
+
+struct Profile {
+    const char* label;
+    adb_host_timing timing;
+};
+
+struct Edge {
+    uint64_t t;
+    bool level;
+};
+
+void recordEdge(void* context, uint64_t t, bool level) {
+    static_cast<std::vector<Edge>*>(context)->push_back({t, level});
+}
+
+/**
+ * @brief Écarts mesurés sur la ligne (ns)
+ */
+struct Result {
+    bool complete;        // Nombre de fronts attendu
+    int64_t attention;    // Écart à l'attention du profil
+    int64_t sync;         // Écart à la synchronisation du profil
+    int64_t worstCell;    // Pire écart d'une cellule
+    int64_t command;      // Écart sur les 8 cellules de commande
+    int64_t packet;       // Écart sur le bit de début et les 16 bits de données
+    bool conforms;        // Durées mesurées dans les tolérances de la spécification
+};
+
+int64_t absNs(int64_t ns) { return ns < 0 ? -ns : ns; }
+
+/**
+ * @brief Durée mesurée dans ±3% de la valeur nominale
+ */
+bool withinSpec(int64_t ns, int64_t nominalUs) {
+    return ns * 1000 >= nominalUs * US * (1000 - HOST_TOLERANCE_PERMILLE) &&
+           ns * 1000 <= nominalUs * US * (1000 + HOST_TOLERANCE_PERMILLE);
+}
+
+/**
+ * @brief Émet Listen registre 2 et un paquet de données, relève les fronts
+ */
+Result runWaveform(const adb_host_timing& timing, bool captured) {
+    ADBSim::Bus bus(HOST_PIN);
+    std::vector<Edge> edges;
+    bus.setEdgeObserver(recordEdge, &edges);
+
+    ADB host(HOST_PIN);
+    static ADBCaptureBuffer<128> capture;
+    capture.clear();
+    host.init(HOST_PIN, true);
+    host.setHostTiming(timing);
+    if (captured) host.setCapture(&capture);
+    delay(5);
+
+    edges.clear();
+    host.writeCommand(static_cast<uint8_t>((ADBKey::Address::KEYBOARD << 4) | CMD_LISTEN | 2));
+    host.waitTLT(false);
+    host.writeDataPacket(0xA55A, 16);
+    delay(1);
+
+    // Attention (2 fronts), 9 cellules de commande puis 18 cellules de données (2 fronts chacune)
+    Result result = {};
+    result.complete = edges.size() == 2 + 2 * 9 + 2 * 18;
+    if (!result.complete) return result;
+
+    auto at = [&](size_t i) { return static_cast<int64_t>(edges[i].t); };
+    const int64_t cellNs = timing.cellUs() * US;
+    result.attention = at(1) - at(0) - timing.attentionUs * US;
+    result.sync = at(2) - at(1) - timing.syncUs * US;
+    result.conforms = withinSpec(at(1) - at(0), HOST_ATTENTION_US) && withinSpec(at(2) - at(1), HOST_SYNC_US);
+    for (size_t first : {size_t(2), size_t(20)}) {
+        size_t cells = first == 2 ? 8 : 17;
+        for (size_t cell = 0; cell < cells; cell++) {
+            size_t fall = first + 2 * cell;
+            int64_t period = at(fall + 2) - at(fall);
+            int64_t low = at(fall + 1) - at(fall);
+            int64_t shortLow = std::min(low, period - low);
+            result.worstCell = std::max(result.worstCell, absNs(period - cellNs));
+            result.conforms &= withinSpec(period, HOST_CELL_US) && shortLow * 1000 >= period * HOST_SHORT_PHASE_MIN &&
+                               shortLow * 1000 <= period * HOST_SHORT_PHASE_MAX;
+        }
+    }
+    result.command = at(18) - at(2) - 8 * cellNs;
+    result.packet = at(54) - at(20) - 17 * cellNs;
+    return result;
+}
+
+/**
+ * @brief Bilan des échanges avec de vrais périphériques simulés
+ */
+struct Exchange {
+    bool handlerChanged;  // Handler de la souris modifié et relu
+    uint32_t updateUs;    // Durée de initializeDevice
+    uint32_t commandUs;   // Durée d'une commande Talk sans réponse
+    uint32_t errors;      // Erreurs de bit
+    bool intact;          // Touches et mouvements reçus identiques à ceux émis
+};
+
+Exchange runDevices(const adb_host_timing& timing, double seconds) {
+    ADBSim::Bus bus(HOST_PIN);
+    ADBSim::Keyboard keyboard;
+    ADBSim::Mouse mouse;
+    bus.attach(keyboard);
+    bus.attach(mouse);
+
+    uint64_t base = ADBSim::now() / ADBSim::NS_PER_US;
+    uint64_t end = base + static_cast<uint64_t>(seconds * 1e6);
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> keyCode(0x00, 0x7E);
+    std::uniform_int_distribution<int> gapUs(20000, 80000);
+    std::uniform_int_distribution<int> motion(-60, 60);
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng))) {
+        uint8_t code = static_cast<uint8_t>(keyCode(rng));
+        keyboard.script(t, code, false);
+        keyboard.script(t + 30000, code, true);
+    }
+    for (uint64_t t = base + 50000; t < end; t += static_cast<uint64_t>(gapUs(rng)) / 4) {
+        mouse.script(t, static_cast<int16_t>(motion(rng)), static_cast<int16_t>(motion(rng)), false);
+    }
+
+    ADB host(HOST_PIN);
+    ADBDevices devices(host);
+    host.init(HOST_PIN, true);
+    host.setHostTiming(timing);
+
+    Exchange result = {};
+    uint32_t start = micros();
+    bool present = false;
+    devices.initializeDevice(ADBKey::Address::MOUSE, 2, present);
+    result.updateUs = micros() - start;
+    host.writeCommand(static_cast<uint8_t>(ADDRESS(ADBKey::Address::MOUSE) | CMD_TALK | 3));
+    host.waitTLT(true);
+    uint16_t reg3 = 0;
+    result.handlerChanged = present && host.readDataPacket(&reg3, 16) && (reg3 & REG3_HANDLER_MASK) == 2;
+    bool error = false;
+
+    // Adresse libre: la commande se termine à l'expiration de la fenêtre Tlt
+    start = micros();
+    host.writeCommand(static_cast<uint8_t>(ADDRESS(0x07) | CMD_TALK | 3));
+    host.waitTLT(true);
+    result.commandUs = micros() - start;
+
+    std::vector<uint8_t> received;
+    int64_t movedX = 0;
+    int64_t movedY = 0;
+    while (ADBSim::now() < (end + 200000) * ADBSim::NS_PER_US) {
+        auto keyPress = devices.keyboardReadKeyPress(&error);
+        if (!error) {
+            received.push_back(static_cast<uint8_t>(keyPress.raw >> 8));
+            if ((keyPress.raw & 0xFF) != 0xFF) received.push_back(static_cast<uint8_t>(keyPress.raw & 0xFF));
+        }
+        auto data = devices.mouseReadData(&error);
+        if (!error) {
+            movedX += static_cast<int8_t>((data.raw & 0x7F) << 1) >> 1;
+            movedY += static_cast<int8_t>(((data.raw >> 8) & 0x7F) << 1) >> 1;
+        }
+        delay(POLL_INTERVAL_MS);
+    }
+
+    std::vector<uint8_t> sent;
+    for (const ADBSim::KeyEvent& event : keyboard.delivered()) {
+        sent.push_back(static_cast<uint8_t>(event.code | (event.released ? 0x80 : 0x00)));
+    }
+    result.errors = host.addressStats(ADBKey::Address::KEYBOARD).bitErrors +
+                    host.addressStats(ADBKey::Address::MOUSE).bitErrors;
+    result.intact = received == sent && !sent.empty() && movedX == mouse.deliveredX() && movedY == mouse.deliveredY();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    const Profile profiles[] = {
+        {"DEFAULT", ADBHostTiming::DEFAULT},
+        {"FAST", ADBHostTiming::FAST},
+    };
+    bool ok = true;
+
+    // Auto-test hors de toute instance ADB: horloge initialisée comme par ADB::init
+    ADBClock::begin();
+    adb_timing_report report = ADBClock::selfTest(SELF_TEST_PIN);
+    ADBClock::printReport(Serial, report);
+    printf("\n");
+    ok &= absNs(report.shortWaitErrorNs) < TOLERANCE_NS && absNs(report.longWaitErrorNs) < TOLERANCE_NS;
+    ok &= absNs(report.deadlineDriftNs) < TOLERANCE_NS && report.deadlineDriftNs < report.delayDriftNs;
+
+    printf("%-24s %10s %10s %12s %12s %12s %s\n", "Émission", "Attention", "Synchro", "Pire cellule", "Commande",
+           "Paquet", "Spécification");
+    for (const Profile& profile : profiles) {
+        for (bool captured : {false, true}) {
+            Result r = runWaveform(profile.timing, captured);
+            bool rowOk = r.complete && r.conforms && absNs(r.attention) < TOLERANCE_NS && absNs(r.sync) < TOLERANCE_NS &&
+                         r.worstCell < TOLERANCE_NS && absNs(r.command) < TOLERANCE_NS && absNs(r.packet) < TOLERANCE_NS;
+            ok &= rowOk;
+            printf("%-8s %-15s %7lld ns %7lld ns %9lld ns %9lld ns %9lld ns %-13s %s\n", profile.label,
+                   captured ? "avec capture" : "sans capture", static_cast<long long>(r.attention),
+                   static_cast<long long>(r.sync), static_cast<long long>(r.worstCell), static_cast<long long>(r.command),
+                   static_cast<long long>(r.packet), r.conforms ? "conforme" : "hors tolérance", rowOk ? "" : "<-");
+        }
+    }
+    printf("\n");
+
+    printf("%-8s %-22s %-20s %-10s %s\n", "Profil", "Changement de handler", "Commande sans réponse", "Erreurs", "Données");
+    Exchange reference = {};
+    for (const Profile& profile : profiles) {
+        Exchange e = runDevices(profile.timing, seconds);
+        bool rowOk = e.handlerChanged && e.errors == 0 && e.intact;
+        // Le profil rapide doit raccourcir les deux opérations
+        if (&profile != &profiles[0]) rowOk &= e.updateUs < reference.updateUs && e.commandUs < reference.commandUs;
+        else reference = e;
+        ok &= rowOk;
+        printf("%-8s %8lu µs %-11s %10lu µs %8s %5lu %-8s %s\n", profile.label, static_cast<unsigned long>(e.updateUs),
+               e.handlerChanged ? "(relu)" : "(échec)", static_cast<unsigned long>(e.commandUs), "",
+               static_cast<unsigned long>(e.errors), e.intact ? "intact" : "pertes", rowOk ? "" : "<-");
+    }
+
+    printf("%s\n", ok ? "SUCCÈS" : "ÉCHEC");
+    return ok ? 0 : 1;
+}